@@ -0,0 +1,94 @@
+//
+// Created by Joseph Hurdle on 10/19/26.
+//
+
+/*
+ * persisting a token list between runs as one line per token, written with
+ * stdio and read back with file_reader_read_line, versus a buffer array
+ * image written with buffer_array_save and mapped back
+ *
+ * arrayImageBench -n [tokens] -text [text file] -image [image file]
+*/
+
+#include "bench.h"
+#include "../../src/mappedbufferarray.h"
+#include "../../src/filereader.h"
+
+int main(int argc, const char **argv) {
+
+    const size_t n = bench_arg(argc, argv, "-n", 2000000);
+    const char *text = bench_arg_str(argc, argv, "-text", "tokens.txt");
+    const char *image = bench_arg_str(argc, argv, "-image", "tokens.img");
+
+    BufferArray tokens;
+    buffer_array_init(&tokens);
+    buffer_array_reserve(&tokens, n);
+    uint64_t seed = 0x2545f4914f6cdd1dULL;
+    char tmp[32];
+    for (size_t i = 0; i < n; ++i) {
+        const size_t len = 2 + bench_rand(&seed) % 10;
+        for (size_t j = 0; j < len; ++j) tmp[j] = 'a' + bench_rand(&seed) % 26;
+        buffer_push_bytes(buffer_array_emplace(&tokens), (unsigned char *) tmp,
+                          len);
+    }
+
+    double start = bench_now();
+    FILE *f = fopen(text, "w");
+    if (NULL == f) return 5;
+    for (size_t i = 0; i < n; ++i) {
+        const Buffer *b = buffer_array_get_buffer(&tokens, i);
+        fwrite(b->data, 1, b->len, f);
+        fputc('\n', f);
+    }
+    fclose(f);
+    bench_report("save text", n, bench_now() - start);
+
+    start = bench_now();
+    if (!buffer_array_save(&tokens, image)) return 5;
+    bench_report("buffer_array_save", n, bench_now() - start);
+
+    start = bench_now();
+    FileReader reader;
+    file_reader_init(&reader);
+    if (!file_reader_open(&reader, text)) return 5;
+    BufferArray loaded;
+    buffer_array_init(&loaded);
+    Buffer line;
+    buffer_init(&line);
+    while (file_reader_read_line(&reader, &line, '\n')) {
+        if (line.len > 0 && '\n' == line.data[line.len - 1]) line.len--;
+        buffer_array_push(&loaded, &line);
+        buffer_clear(&line);
+    }
+    file_reader_close(&reader);
+    bench_report("load text", n, bench_now() - start);
+
+    start = bench_now();
+    MappedBufferArray mba;
+    if (!buffer_array_open_mapped(&mba, image)) return 5;
+    const double openTime = bench_now() - start;
+    printf("buffer_array_open_mapped %.1f us for %zu tokens\n", openTime * 1e6,
+           mapped_buffer_array_get_count(&mba));
+
+    size_t bytes = 0;
+    BufferView view;
+    start = bench_now();
+    for (size_t i = 0; i < mapped_buffer_array_get_count(&mba); ++i) {
+        if (mapped_buffer_array_get_view(&mba, i, &view)) bytes += view.len;
+    }
+    bench_report("mapped views", n, bench_now() - start);
+
+    start = bench_now();
+    const bool intact = mapped_buffer_array_verify(&mba);
+    bench_report("mapped_buffer_array_verify", n, bench_now() - start);
+    printf("loaded %zu lines, %zu bytes viewed, intact %d\n",
+           buffer_array_get_buffer_count(&loaded), bytes, intact);
+
+    mapped_buffer_array_close(&mba);
+    buffer_array_free(&loaded);
+    buffer_array_free(&tokens);
+    buffer_free(&line);
+    remove(text);
+    remove(image);
+    return 0;
+}
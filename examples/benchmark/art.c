@@ -0,0 +1,158 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+/*
+ * an adaptive radix tree against a HashTable for point lookups and against
+ * sorting the keys then binary searching them for range scans
+ *
+ * artBench -n [keys] -lookups [lookups] -ranges [ranges] -width [keys per range]
+ *
+ * keys look like "user/<region>/<id>" so they share prefixes the way the
+ * keys of a real index tend to
+*/
+
+#include <malloc.h>
+#include "bench.h"
+#include "../../src/hashtable.h"
+#include "../../src/art.h"
+
+// bytes currently allocated from the heap
+static size_t heap_in_use(void) {
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+// index of the first of [count] sorted keys not less than [key]
+static size_t lower_bound(const Buffer *sorted, size_t count,
+                          const Buffer *key) {
+    size_t lo = 0, hi = count;
+    while(lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if(buffer_cmp_bytes(&sorted[mid], key) < 0) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+int main(int argc, const char **argv) {
+
+    const size_t n = bench_arg(argc, argv, "-n", 500000);
+    const size_t lookups = bench_arg(argc, argv, "-lookups", 1000000);
+    const size_t ranges = bench_arg(argc, argv, "-ranges", 10000);
+    const size_t width = bench_arg(argc, argv, "-width", 100);
+
+    uint64_t seed = 0x2545f4914f6cdd1dULL;
+    BufferArray keys;
+    buffer_array_init(&keys);
+    Buffer key;
+    buffer_init(&key);
+    char tmp[64];
+    size_t keyBytes = 0;
+    for(size_t i = 0; i < n; ++i) {
+        const int len = snprintf(tmp, sizeof(tmp), "user/%02u/%010llu",
+                                 (unsigned) (bench_rand(&seed) % 16),
+                                 (unsigned long long) (bench_rand(&seed) % 10000000000ULL));
+        buffer_clear(&key);
+        buffer_push_bytes(&key, (unsigned char *) tmp, (size_t) len);
+        buffer_array_push(&keys, &key);
+        keyBytes += (size_t) len;
+    }
+    Buffer *k = (Buffer *) keys.array.data;
+    printf("%zu keys, %zu bytes of keys\n", n, keyBytes);
+
+    size_t base = heap_in_use();
+    double start = bench_now();
+    Art art;
+    art_init(&art);
+    for(size_t i = 0; i < n; ++i)
+        if(!art_insert(&art, &k[i], i, NULL)) return 5;
+    bench_report("art_insert", n, bench_now() - start);
+    ArtStats stats;
+    art_get_stats(&art, &stats);
+    printf("art %zu keys, %.2f bytes per key, heap %.2f, nodes 4/16/48/256 "
+           "%zu/%zu/%zu/%zu, depth %zu\n", art_get_count(&art),
+           (double) art_get_memory(&art) / (double) n,
+           (double) (heap_in_use() - base) / (double) n, stats.node4,
+           stats.node16, stats.node48, stats.node256, stats.maxDepth);
+
+    base = heap_in_use();
+    start = bench_now();
+    HashTable ht;
+    hashtable_init(&ht);
+    if(!hashtable_set_size(&ht, n | 1)) return 5;
+    Buffer value;
+    buffer_init(&value);
+    for(size_t i = 0; i < n; ++i) {
+        buffer_clear(&value);
+        buffer_push_bytes(&value, (unsigned char *) &i, sizeof(i));
+        if(!hashtable_add(&ht, &k[i], &value)) return 5;
+    }
+    bench_report("hashtable_add", n, bench_now() - start);
+    printf("hashtable heap %.2f bytes per key\n",
+           (double) (heap_in_use() - base) / (double) n);
+
+    size_t *probe = malloc(sizeof(size_t) * lookups);
+    if(NULL == probe) return 5;
+    for(size_t i = 0; i < lookups; ++i) probe[i] = bench_rand(&seed) % n;
+
+    size_t found = 0;
+    start = bench_now();
+    for(size_t i = 0; i < lookups; ++i) found += art_get(&art, &k[probe[i]], NULL);
+    bench_report("art_get", lookups, bench_now() - start);
+
+    size_t foundHt = 0;
+    start = bench_now();
+    for(size_t i = 0; i < lookups; ++i)
+        foundHt += NULL != hashtable_get(&ht, &k[probe[i]]);
+    bench_report("hashtable_get", lookups, bench_now() - start);
+
+    // ranges start at a random key and take the next [width] keys
+    start = bench_now();
+    Buffer *sorted = malloc(sizeof(Buffer) * n);
+    if(NULL == sorted) return 5;
+    memcpy(sorted, k, sizeof(Buffer) * n);
+    qsort(sorted, n, sizeof(Buffer), buffer_cmp_bytes);
+    bench_report("qsort keys", n, bench_now() - start);
+
+    size_t scanned = 0;
+    start = bench_now();
+    for(size_t r = 0; r < ranges; ++r) {
+        size_t i = lower_bound(sorted, n, &k[probe[r % lookups]]);
+        for(size_t w = 0; w < width && i < n; ++w, ++i)
+            scanned += sorted[i].len;
+    }
+    bench_report("sorted array ranges", ranges, bench_now() - start);
+
+    ArtIterator it;
+    BufferView view;
+    art_iterator_init(&it, &art);
+    size_t scannedArt = 0;
+    start = bench_now();
+    for(size_t r = 0; r < ranges; ++r) {
+        buffer_view_from_buffer(&view, &k[probe[r % lookups]]);
+        art_iterator_seek(&it, &view);
+        for(size_t w = 0; w < width && art_iterator_next(&it, &view, NULL); ++w)
+            scannedArt += view.len;
+    }
+    bench_report("art ranges", ranges, bench_now() - start);
+
+    art_iterator_init(&it, &art);
+    size_t walked = 0;
+    start = bench_now();
+    while(art_iterator_next(&it, &view, NULL)) ++walked;
+    bench_report("art ordered walk", walked, bench_now() - start);
+
+    printf("found %zu/%zu art, %zu hashtable, range bytes %zu array %zu art\n",
+           found, lookups, foundHt, scanned, scannedArt);
+
+    art_iterator_free(&it);
+    art_free(&art);
+    hashtable_free(&ht);
+    buffer_array_free(&keys);
+    buffer_free(&key);
+    buffer_free(&value);
+    free(sorted);
+    free(probe);
+    return 0;
+}
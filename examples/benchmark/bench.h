@@ -0,0 +1,68 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#ifndef SEARCHFILEC_BENCH_H
+#define SEARCHFILEC_BENCH_H
+
+/*
+ * tiny helpers shared by the benchmark programs, every benchmark is its own
+ * executable which prints one line per measurement to stdout
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+// current monotonic time in seconds
+static inline double bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+// find a numeric argument named [arg_name] in [argv], returning [def] when
+// the argument is absent
+// [argc] - number of arguments
+// [argv] - array of argument pointers
+// [arg_name] - name of argument searched for
+// [def] - value returned when argument is not present
+static inline size_t bench_arg(int argc, const char **argv,
+                               const char *arg_name, size_t def) {
+    for (int i = 0; i < argc - 1; ++i) {
+        if (strcmp(arg_name, argv[i]) == 0) return strtoull(argv[i + 1], NULL, 0);
+    }
+    return def;
+}
+
+// find a string argument named [arg_name] in [argv], returning [def] when
+// the argument is absent
+static inline const char *bench_arg_str(int argc, const char **argv,
+                                        const char *arg_name,
+                                        const char *def) {
+    for (int i = 0; i < argc - 1; ++i) {
+        if (strcmp(arg_name, argv[i]) == 0) return argv[i + 1];
+    }
+    return def;
+}
+
+// small xorshift generator so runs are repeatable across platforms
+static inline uint64_t bench_rand(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+// print one result line, [ops] operations took [secs] seconds
+static inline void bench_report(const char *name, size_t ops, double secs) {
+    printf("%-32s %12zu ops %10.3f s %10.1f ns/op %12.0f ops/s\n", name, ops,
+           secs, ops ? secs * 1e9 / (double) ops : 0.0,
+           secs > 0 ? (double) ops / secs : 0.0);
+}
+
+#endif //SEARCHFILEC_BENCH_H
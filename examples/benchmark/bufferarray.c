@@ -0,0 +1,109 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+/*
+ * building a BufferArray of many short tokens by pushing copies, by filling
+ * emplaced buffers in place with and without reserving first, and by
+ * extending it in batches, then clearing and refilling it
+ *
+ * arrayBench -n [tokens] -batch [tokens per extend]
+*/
+
+#include "bench.h"
+#include "../../src/buffer.h"
+#include "../../src/bufferarray.h"
+
+// a short word of 3 to 10 lowercase letters
+static size_t make_token(uint64_t *seed, char *tmp) {
+    const size_t len = 3 + bench_rand(seed) % 8;
+    for (size_t i = 0; i < len; ++i) tmp[i] = (char) ('a' + bench_rand(seed) % 26);
+    return len;
+}
+
+// fill the array by emplacing each token
+static bool fill_emplace(BufferArray *ba, size_t n) {
+    uint64_t seed = 0x2545f4914f6cdd1dULL;
+    char tmp[16];
+    for (size_t i = 0; i < n; ++i) {
+        const size_t len = make_token(&seed, tmp);
+        Buffer *slot = buffer_array_emplace(ba);
+        if (NULL == slot || !buffer_push_bytes(slot, (unsigned char *) tmp, len))
+            return false;
+    }
+    return true;
+}
+
+int main(int argc, const char **argv) {
+
+    const size_t n = bench_arg(argc, argv, "-n", 10000000);
+    const size_t batch = bench_arg(argc, argv, "-batch", 1024);
+    char tmp[16];
+    uint64_t seed;
+
+    BufferArray ba;
+    buffer_array_init(&ba);
+    Buffer token;
+    buffer_init(&token);
+
+    seed = 0x2545f4914f6cdd1dULL;
+    double start = bench_now();
+    for (size_t i = 0; i < n; ++i) {
+        const size_t len = make_token(&seed, tmp);
+        buffer_clear(&token);
+        buffer_push_bytes(&token, (unsigned char *) tmp, len);
+        if (!buffer_array_push(&ba, &token)) return 5;
+    }
+    bench_report("buffer_array_push", n, bench_now() - start);
+    buffer_array_free(&ba);
+
+    start = bench_now();
+    if (!fill_emplace(&ba, n)) return 5;
+    bench_report("buffer_array_emplace", n, bench_now() - start);
+    buffer_array_free(&ba);
+
+    start = bench_now();
+    if (!buffer_array_reserve(&ba, n) || !fill_emplace(&ba, n)) return 5;
+    bench_report("reserve + emplace", n, bench_now() - start);
+
+    // clearing keeps the header array so the refill never grows it
+    start = bench_now();
+    buffer_array_clear(&ba);
+    if (!fill_emplace(&ba, n)) return 5;
+    bench_report("clear + emplace", n, bench_now() - start);
+    buffer_array_free(&ba);
+
+    BufferArray chunk;
+    buffer_array_init(&chunk);
+    seed = 0x2545f4914f6cdd1dULL;
+    start = bench_now();
+    for (size_t done = 0; done < n; done += batch) {
+        buffer_array_clear(&chunk);
+        for (size_t i = 0; i < batch && done + i < n; ++i) {
+            const size_t len = make_token(&seed, tmp);
+            buffer_push_bytes(buffer_array_emplace(&chunk),
+                              (unsigned char *) tmp, len);
+        }
+        if (!buffer_array_extend(&ba, buffer_array_get_buffer(&chunk, 0),
+                                 buffer_array_get_buffer_count(&chunk)))
+            return 5;
+    }
+    bench_report("buffer_array_extend", n, bench_now() - start);
+
+    start = bench_now();
+    size_t removed = 0;
+    while (buffer_array_get_buffer_count(&ba) > n / 2) {
+        buffer_array_swap_remove(&ba, bench_rand(&seed) %
+                                      buffer_array_get_buffer_count(&ba));
+        ++removed;
+    }
+    bench_report("buffer_array_swap_remove", removed, bench_now() - start);
+
+    printf("%zu tokens left, capacity %zu\n", buffer_array_get_buffer_count(&ba),
+           buffer_array_get_capacity(&ba));
+
+    buffer_array_free(&chunk);
+    buffer_array_free(&ba);
+    buffer_free(&token);
+    return 0;
+}
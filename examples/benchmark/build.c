@@ -0,0 +1,96 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+/*
+ * loads a dictionary into a hash table one line at a time with
+ * hashtable_add, the way load_hashtable in searchFile does, and with
+ * hashtable_build_parallel_file at 1 up to [max threads] threads
+ *
+ * buildBench -n [words] -dict [dictionary file] -threads [max threads]
+ *
+ * when no dictionary is given one with [words] random words is written
+*/
+
+#include "bench.h"
+#include "../../src/hashtable.h"
+#include "../../src/filereader.h"
+#include "../../src/threadpool.h"
+
+// write a dictionary of [n] random lower case words to [fileName]
+static int write_dictionary(const char *fileName, size_t n) {
+    FILE *f = fopen(fileName, "w");
+    if (NULL == f) return 0;
+    uint64_t seed = 0x2545f4914f6cdd1dULL;
+    for (size_t i = 0; i < n; ++i) {
+        const size_t len = 3 + bench_rand(&seed) % 10;
+        for (size_t j = 0; j < len; ++j) fputc('a' + bench_rand(&seed) % 26, f);
+        fprintf(f, "%zu\n", i);
+    }
+    fclose(f);
+    return 1;
+}
+
+int main(int argc, const char **argv) {
+
+    const size_t n = bench_arg(argc, argv, "-n", 1000000);
+    const size_t maxThreads = bench_arg(argc, argv, "-threads", 32);
+    const char *dict = bench_arg_str(argc, argv, "-dict", NULL);
+
+    if (NULL == dict) {
+        dict = "dictionary.txt";
+        if (!write_dictionary(dict, n)) return 5;
+    }
+
+    const size_t defaultCount = 0;
+    Buffer line, value;
+    buffer_init(&line);
+    buffer_init(&value);
+    buffer_push_bytes(&value, (unsigned char *) &defaultCount, sizeof(size_t));
+
+    double start = bench_now();
+
+    HashTable ht;
+    hashtable_init(&ht);
+    if (!hashtable_set_size(&ht, n | 1)) return 5;
+
+    FileReader reader;
+    file_reader_init(&reader);
+    if (!file_reader_open(&reader, dict)) return 5;
+
+    size_t words = 0;
+    while (file_reader_read_line(&reader, &line, '\n')) {
+        if (!hashtable_add(&ht, &line, &value)) return 5;
+        ++words;
+    }
+    file_reader_close(&reader);
+    bench_report("read_line + hashtable_add", words, bench_now() - start);
+    const size_t expected = hashtable_get_entry_count(&ht);
+    hashtable_free(&ht);
+
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        ThreadPool tp;
+        if (!threadpool_init(&tp, threads)) return 5;
+
+        start = bench_now();
+        hashtable_init(&ht);
+        if (!hashtable_set_size(&ht, n | 1)) return 5;
+        if (!hashtable_build_parallel_file(&ht, dict, '\n', &value, &tp))
+            return 5;
+        char name[64];
+        snprintf(name, sizeof(name), "build_parallel %zu threads", threads);
+        bench_report(name, words, bench_now() - start);
+
+        if (hashtable_get_entry_count(&ht) != expected) {
+            fprintf(stderr, "mismatch: %zu keys built, %zu expected\n",
+                    hashtable_get_entry_count(&ht), expected);
+            return 5;
+        }
+        hashtable_free(&ht);
+        threadpool_free(&tp);
+    }
+
+    buffer_free(&line);
+    buffer_free(&value);
+    return 0;
+}
@@ -0,0 +1,62 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+/*
+ * drives a Cache with a skewed stream of keys, the way a cache of per word
+ * results sees a text, and reports time per access and the hit rate
+ *
+ * cacheBench -n [distinct keys] -ops [accesses] -cap [entries cached]
+*/
+
+#include "bench.h"
+#include "../../src/cache.h"
+
+int main(int argc, const char **argv) {
+
+    const size_t n = bench_arg(argc, argv, "-n", 1000000);
+    const size_t ops = bench_arg(argc, argv, "-ops", 1 << 22);
+    const size_t cap = bench_arg(argc, argv, "-cap", 65536);
+
+    // squaring a uniform draw favours small ids, a cheap stand in for the
+    // skew of word frequencies
+    uint64_t *ids = malloc(sizeof(uint64_t) * ops);
+    if (NULL == ids) return 5;
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < ops; ++i) {
+        double u = (double) (bench_rand(&seed) >> 11) / (double) (1ULL << 53);
+        ids[i] = (uint64_t) (u * u * u * (double) n);
+    }
+
+    Cache c;
+    cache_init(&c);
+    if (!cache_create(&c, cap, 0, 0)) return 5;
+
+    Buffer key, value;
+    buffer_init(&key);
+    buffer_init(&value);
+    char tmp[32];
+
+    double start = bench_now();
+    for (size_t i = 0; i < ops; ++i) {
+        snprintf(tmp, sizeof(tmp), "word-%llu", (unsigned long long) ids[i]);
+        buffer_strcpy(&key, tmp);
+        if (NULL != cache_get(&c, &key)) continue;
+        buffer_clear(&value);
+        buffer_push_bytes(&value, (unsigned char *) &ids[i], sizeof(ids[i]));
+        if (!cache_put(&c, &key, &value)) return 5;
+    }
+    bench_report("cache get or put", ops, bench_now() - start);
+
+    CacheStats stats;
+    cache_get_stats(&c, &stats);
+    printf("hits %zu misses %zu evictions %zu hit rate %.1f%%\n", stats.hits,
+           stats.misses, stats.evictions,
+           100.0 * (double) stats.hits / (double) (stats.hits + stats.misses));
+
+    cache_free(&c);
+    buffer_free(&key);
+    buffer_free(&value);
+    free(ids);
+    return 0;
+}
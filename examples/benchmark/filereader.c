@@ -0,0 +1,138 @@
+//
+// Created by Joseph Hurdle on 10/19/26.
+//
+
+/*
+ * line iteration throughput of a FileReader in each of its modes, every pass
+ * run against a cold page cache (the file dropped with posix_fadvise first)
+ * and then a warm one, then READ mode with blocks of 4K up to 16M
+ *
+ * readerBench -mb [size of generated file] -file [file to read instead]
+ *
+ * the generated file holds lines of 1 to 16 made up words, like text
+*/
+
+#include <fcntl.h>
+#include <unistd.h>
+#include "bench.h"
+#include "../../src/filereader.h"
+
+// write about [mb] megabytes of lines of words to [fileName]
+static bool write_text(const char *fileName, size_t mb) {
+    FILE *f = fopen(fileName, "w");
+    if (NULL == f) return false;
+    uint64_t seed = 0x2545f4914f6cdd1dULL;
+    size_t written = 0;
+    while (written < mb << 20) {
+        const size_t words = 1 + bench_rand(&seed) % 16;
+        for (size_t w = 0; w < words; ++w) {
+            const size_t len = 1 + bench_rand(&seed) % 9;
+            for (size_t i = 0; i < len; ++i) fputc('a' + bench_rand(&seed) % 26, f);
+            fputc(w + 1 == words ? '\n' : ' ', f);
+            written += len + 1;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+// ask the kernel to forget the cached pages of [fileName]
+static void drop_cache(const char *fileName) {
+    const int fd = open(fileName, O_RDONLY);
+    if (-1 == fd) return;
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+// ways of reading each line
+typedef enum eReadHow {
+    READ_LINE,
+    READ_VIEW,
+    READ_BLOCK
+} ReadHow;
+
+// read every line of [fileName] as [opts] says, copying each into a Buffer,
+// taking a view of it or splitting it from a block, and report the time taken
+static void run(const char *name, const char *fileName,
+                const FileReaderOptions *opts, ReadHow how, bool cold) {
+    if (cold) drop_cache(fileName);
+
+    FileReader reader;
+    file_reader_init(&reader);
+    Buffer line;
+    buffer_init(&line);
+    BufferView view, block;
+    size_t lines = 0, bytes = 0;
+
+    const double start = bench_now();
+    if (!file_reader_open_options(&reader, fileName, opts)) return;
+    if (READ_BLOCK == how) {
+        while (file_reader_read_block(&reader, &block, '\n')) {
+            while (file_reader_next_line(&block, &view, '\n')) {
+                ++lines;
+                bytes += view.len;
+            }
+        }
+    } else if (READ_VIEW == how) {
+        while (file_reader_read_line_view(&reader, &view, '\n')) {
+            ++lines;
+            bytes += view.len;
+        }
+    } else {
+        while (file_reader_read_line(&reader, &line, '\n')) {
+            ++lines;
+            bytes += line.len;
+        }
+    }
+    FileReaderStats stats;
+    file_reader_get_stats(&reader, &stats);
+    file_reader_close(&reader);
+    const double secs = bench_now() - start;
+
+    char label[64];
+    snprintf(label, sizeof(label), "%s %s", name, cold ? "cold" : "warm");
+    bench_report(label, lines, secs);
+    printf("%-32s %12.1f MB/s", label, (double) bytes / secs / 1e6);
+    if (stats.reads > 0)
+        printf(" %12.0f reads/GB", (double) stats.reads * 1e9 / (double) bytes);
+    printf("\n");
+    buffer_free(&line);
+}
+
+int main(int argc, const char **argv) {
+
+    const size_t mb = bench_arg(argc, argv, "-mb", 256);
+    const char *fileName = bench_arg_str(argc, argv, "-file", NULL);
+    const bool generated = NULL == fileName;
+
+    if (generated) {
+        fileName = "reader_bench.txt";
+        if (!write_text(fileName, mb)) return 5;
+    }
+
+    FileReaderOptions read, mapped;
+    file_reader_options_init(&read);
+    file_reader_options_init(&mapped);
+    mapped.mode = FILE_READER_MODE_MMAP;
+
+    for (int cold = 1; cold >= 0; --cold) {
+        run("read read_line", fileName, &read, READ_LINE, cold);
+        run("read read_line_view", fileName, &read, READ_VIEW, cold);
+        run("read read_block", fileName, &read, READ_BLOCK, cold);
+        run("mmap read_line", fileName, &mapped, READ_LINE, cold);
+        run("mmap read_line_view", fileName, &mapped, READ_VIEW, cold);
+        run("mmap read_block", fileName, &mapped, READ_BLOCK, cold);
+    }
+
+    // how the size of the block read at a time tells, warm
+    for (size_t block = 4096; block <= FILE_READER_BLOCK_MAX; block *= 4) {
+        char name[64];
+        snprintf(name, sizeof(name), "read block %zuK", block >> 10);
+        read.blockSize = block;
+        run(name, fileName, &read, READ_BLOCK, false);
+    }
+
+    if (generated) remove(fileName);
+    return 0;
+}
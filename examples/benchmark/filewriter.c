@@ -0,0 +1,127 @@
+//
+// Created by Joseph Hurdle on 10/19/26.
+//
+
+/*
+ * writing many short records, each followed by a newline, through stdio and
+ * through FileWriter
+ *
+ * writerBench -lines [records written by each run] -file [file written]
+ *
+ * records are the short, varied lines an index or a log is made of, the
+ * file goes to the page cache so it measures the cost a record
+*/
+
+#include "bench.h"
+#include "../../src/filewriter.h"
+
+#define RECORDS 4096
+
+typedef enum eWriterRun {
+    RUN_FPRINTF,
+    RUN_FPUTS,
+    RUN_WRITER,
+    RUN_WRITER_BACKGROUND,
+    RUN_WRITER_VIEWS
+} WriterRun;
+
+static char records[RECORDS][32];
+static size_t lengths[RECORDS];
+
+// write [lines] records to [fileName] the way [run] says
+static void run(const char *name, WriterRun how, const char *fileName,
+                size_t lines) {
+    FileWriterOptions opts;
+    file_writer_options_init(&opts);
+    opts.background = RUN_WRITER_BACKGROUND == how;
+
+    FileWriter writer;
+    file_writer_init(&writer);
+    FILE *f = NULL;
+    BufferView views[2 * FILE_WRITER_IOV];
+
+    const double start = bench_now();
+    if (RUN_FPRINTF == how || RUN_FPUTS == how) {
+        f = fopen(fileName, "w");
+        if (NULL == f) return;
+    } else if (!file_writer_open_options(&writer, fileName, &opts)) {
+        return;
+    }
+
+    bool ok = true;
+    for (size_t i = 0; ok && i < lines;) {
+        const size_t r = i % RECORDS;
+        switch (how) {
+            case RUN_FPRINTF:
+                ok = fprintf(f, "%s\n", records[r]) > 0;
+                ++i;
+                break;
+            case RUN_FPUTS:
+                ok = EOF != fputs(records[r], f) && EOF != fputc('\n', f);
+                ++i;
+                break;
+            case RUN_WRITER:
+            case RUN_WRITER_BACKGROUND:
+                ok = file_writer_write_bytes(&writer,
+                                             (const unsigned char *) records[r],
+                                             lengths[r]) &&
+                     file_writer_write_byte(&writer, '\n');
+                ++i;
+                break;
+            case RUN_WRITER_VIEWS: {
+                // a batch of records and their delimiters in one call
+                size_t count = 0;
+                for (; count < 2 * FILE_WRITER_IOV && i < lines; count += 2, ++i) {
+                    buffer_view_set(&views[count],
+                                    (const unsigned char *) records[i % RECORDS],
+                                    lengths[i % RECORDS]);
+                    buffer_view_set(&views[count + 1],
+                                    (const unsigned char *) "\n", 1);
+                }
+                ok = file_writer_write_views(&writer, views, count);
+                break;
+            }
+        }
+    }
+
+    size_t writes = 0;
+    if (NULL != f) {
+        ok = 0 == fclose(f) && ok;
+    } else {
+        ok = file_writer_close(&writer) && ok;
+        FileWriterStats stats;
+        file_writer_get_stats(&writer, &stats);
+        writes = stats.writes;
+    }
+    const double secs = bench_now() - start;
+    if (!ok) {
+        printf("%-32s failed\n", name);
+        return;
+    }
+
+    bench_report(name, lines, secs);
+    if (NULL == f && writes > 0) printf("%-32s %12zu writes\n", name, writes);
+}
+
+int main(int argc, const char **argv) {
+
+    const size_t lines = bench_arg(argc, argv, "-lines", 100000000);
+    const char *fileName = bench_arg_str(argc, argv, "-file", "writer_bench.txt");
+
+    uint64_t seed = 0x2545f4914f6cdd1dULL;
+    for (size_t i = 0; i < RECORDS; ++i) {
+        lengths[i] = 4 + bench_rand(&seed) % 24;
+        for (size_t j = 0; j < lengths[i]; ++j)
+            records[i][j] = (char) ('a' + bench_rand(&seed) % 26);
+        records[i][lengths[i]] = '\0';
+    }
+
+    run("fprintf", RUN_FPRINTF, fileName, lines);
+    run("fputs fputc", RUN_FPUTS, fileName, lines);
+    run("writer bytes byte", RUN_WRITER, fileName, lines);
+    run("writer background", RUN_WRITER_BACKGROUND, fileName, lines);
+    run("writer views", RUN_WRITER_VIEWS, fileName, lines);
+
+    remove(fileName);
+    return 0;
+}
@@ -0,0 +1,105 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+/*
+ * measures how much a membership filter in front of a hash table saves on
+ * lookups that mostly miss, the common case when probing a dictionary with
+ * words from a large text
+ *
+ * filterBench -n [entries] -lookups [lookups] -hit [percent of hits]
+*/
+
+#include "bench.h"
+#include "../../src/hashtable.h"
+#include "../../src/filter.h"
+
+// write the key for entry [i] into [key]
+static void make_key(Buffer *key, uint64_t i) {
+    char tmp[32];
+    snprintf(tmp, sizeof(tmp), "key-%llu", (unsigned long long) i);
+    buffer_strcpy(key, tmp);
+}
+
+// time [lookups] hashtable_get calls over [probes]
+static size_t run(const char *name, HashTable *ht, Buffer *probes,
+                  size_t lookups) {
+    size_t found = 0;
+    double start = bench_now();
+    for (size_t i = 0; i < lookups; ++i) {
+        if (NULL != hashtable_get(ht, &probes[i])) ++found;
+    }
+    bench_report(name, lookups, bench_now() - start);
+    return found;
+}
+
+int main(int argc, const char **argv) {
+
+    const size_t n = bench_arg(argc, argv, "-n", 1048573);
+    const size_t lookups = bench_arg(argc, argv, "-lookups", 1 << 22);
+    const size_t hit = bench_arg(argc, argv, "-hit", 10);
+
+    HashTable ht;
+    hashtable_init(&ht);
+    if (!hashtable_set_size(&ht, n)) return 5;
+
+    Buffer key, value;
+    buffer_init(&key);
+    buffer_init(&value);
+
+    for (uint64_t i = 0; i < n; ++i) {
+        make_key(&key, i);
+        buffer_clear(&value);
+        buffer_push_bytes(&value, (unsigned char *) &i, sizeof(i));
+        if (!hashtable_add(&ht, &key, &value)) return 5;
+    }
+
+    Buffer *probes = malloc(sizeof(Buffer) * lookups);
+    if (NULL == probes) return 5;
+
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < lookups; ++i) {
+        buffer_init(&probes[i]);
+        uint64_t r = bench_rand(&seed);
+        if (r % 100 < hit) make_key(&probes[i], (r >> 8) % n);
+        else make_key(&probes[i], n + (r >> 8) % n);
+    }
+
+    const size_t expected = run("unfiltered", &ht, probes, lookups);
+
+    MembershipFilter bloom, cuckoo;
+    membership_filter_init(&bloom, MEMBERSHIP_FILTER_BLOOM);
+    membership_filter_init(&cuckoo, MEMBERSHIP_FILTER_CUCKOO);
+    if (!membership_filter_create(&bloom, n, 0.01)) return 5;
+    if (!membership_filter_create(&cuckoo, n, 0.01)) return 5;
+
+    double start = bench_now();
+    hashtable_attach_filter(&ht, &bloom);
+    bench_report("bloom attach", n, bench_now() - start);
+    printf("bloom filter %.2f bytes per key\n",
+           (double) (bloom.bloom.blockCount * BLOOM_FILTER_BLOCK_WORDS * 4) / n);
+    const size_t foundBloom = run("bloom filtered", &ht, probes, lookups);
+
+    start = bench_now();
+    hashtable_attach_filter(&ht, &cuckoo);
+    bench_report("cuckoo attach", n, bench_now() - start);
+    printf("cuckoo filter %.2f bytes per key\n",
+           (double) (cuckoo.cuckoo.bucketCount * CUCKOO_FILTER_BUCKET_SIZE * 2) / n);
+    const size_t foundCuckoo = run("cuckoo filtered", &ht, probes, lookups);
+
+    if (foundBloom != expected || foundCuckoo != expected) {
+        fprintf(stderr, "mismatch: %zu unfiltered, %zu bloom, %zu cuckoo\n",
+                expected, foundBloom, foundCuckoo);
+        return 5;
+    }
+
+    hashtable_attach_filter(&ht, NULL);
+    membership_filter_free(&bloom);
+    membership_filter_free(&cuckoo);
+    for (size_t i = 0; i < lookups; ++i) buffer_free(&probes[i]);
+    free(probes);
+    buffer_free(&key);
+    buffer_free(&value);
+    hashtable_free(&ht);
+    return 0;
+}
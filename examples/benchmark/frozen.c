@@ -0,0 +1,99 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+/*
+ * memory and lookup latency of a frozen hash table against the mutable
+ * HashTable it was built from
+ *
+ * frozenBench -n [entries] -lookups [lookups]
+*/
+
+#include <malloc.h>
+#include "bench.h"
+#include "../../src/hashtable.h"
+#include "../../src/frozenhashtable.h"
+
+// bytes currently allocated from the heap
+static size_t heap_in_use(void) {
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+static void make_key(Buffer *key, uint64_t i) {
+    char tmp[32];
+    snprintf(tmp, sizeof(tmp), "key-%llu", (unsigned long long) i);
+    buffer_strcpy(key, tmp);
+}
+
+int main(int argc, const char **argv) {
+
+    const size_t n = bench_arg(argc, argv, "-n", 1048573);
+    const size_t lookups = bench_arg(argc, argv, "-lookups", 1 << 22);
+
+    Buffer key, value;
+    buffer_init(&key);
+    buffer_init(&value);
+
+    const size_t heapBefore = heap_in_use();
+
+    HashTable ht;
+    hashtable_init(&ht);
+    if (!hashtable_set_size(&ht, n)) return 5;
+    for (uint64_t i = 0; i < n; ++i) {
+        make_key(&key, i);
+        buffer_clear(&value);
+        buffer_push_bytes(&value, (unsigned char *) &i, sizeof(i));
+        if (!hashtable_add(&ht, &key, &value)) return 5;
+    }
+    const size_t heapTable = heap_in_use() - heapBefore;
+
+    double start = bench_now();
+    FrozenHashTable fht;
+    if (!hashtable_freeze(&ht, &fht)) return 5;
+    bench_report("hashtable_freeze", n, bench_now() - start);
+
+    printf("hashtable memory  %12zu bytes %8.1f bytes/entry\n", heapTable,
+           (double) heapTable / n);
+    printf("frozen memory     %12zu bytes %8.1f bytes/entry\n",
+           frozen_hashtable_get_memory(&fht),
+           (double) frozen_hashtable_get_memory(&fht) / n);
+    printf("perfect hash      %12.2f bits/key (pilots)\n",
+           16.0 * fht.header->bucketCount / n);
+
+    Buffer *probes = malloc(sizeof(Buffer) * lookups);
+    if (NULL == probes) return 5;
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < lookups; ++i) {
+        buffer_init(&probes[i]);
+        make_key(&probes[i], bench_rand(&seed) % n);
+    }
+
+    size_t found = 0;
+    start = bench_now();
+    for (size_t i = 0; i < lookups; ++i) {
+        if (NULL != hashtable_get(&ht, &probes[i])) ++found;
+    }
+    bench_report("hashtable_get", lookups, bench_now() - start);
+
+    size_t foundFrozen = 0;
+    start = bench_now();
+    for (size_t i = 0; i < lookups; ++i) {
+        if (frozen_hashtable_has(&fht, &probes[i])) ++foundFrozen;
+    }
+    bench_report("frozen_hashtable_get", lookups, bench_now() - start);
+
+    if (found != foundFrozen) {
+        fprintf(stderr, "mismatch: %zu found mutable, %zu frozen\n", found,
+                foundFrozen);
+        return 5;
+    }
+
+    for (size_t i = 0; i < lookups; ++i) buffer_free(&probes[i]);
+    free(probes);
+    frozen_hashtable_free(&fht);
+    hashtable_free(&ht);
+    buffer_free(&key);
+    buffer_free(&value);
+    return 0;
+}
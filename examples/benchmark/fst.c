@@ -0,0 +1,195 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+/*
+ * memory and lookup speed of a dictionary held in an Fst versus a HashTable
+ * mapping each word to a size_t, plus ordered and prefix walks of the Fst
+ *
+ * fstBench -n [words] -lookups [lookups] -dict [file of one word per line]
+ *
+ * when no dictionary is given [words] made up words are generated from
+ * common stems and endings, the way natural language words share both
+*/
+
+#include <malloc.h>
+#include "bench.h"
+#include "../../src/hashtable.h"
+#include "../../src/fst.h"
+#include "../../src/mappedfile.h"
+
+// bytes currently allocated from the heap
+static size_t heap_in_use(void) {
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+static const char *syllables[] = {
+    "al", "an", "ar", "be", "co", "de", "di", "en", "er", "fo", "ga", "in",
+    "is", "ka", "la", "li", "ma", "mo", "ne", "no", "on", "or", "pa", "pre",
+    "ra", "re", "ri", "sa", "se", "si", "sta", "te", "ti", "to", "tra", "un",
+    "ve", "vi", "wa", "zo"
+};
+
+static const char *endings[] = {
+    "", "s", "ed", "er", "ers", "ing", "ings", "ly", "ness", "tion", "tions",
+    "able", "ment", "ments", "ist", "ists"
+};
+
+#define SYLLABLES (sizeof(syllables) / sizeof(syllables[0]))
+#define ENDINGS (sizeof(endings) / sizeof(endings[0]))
+
+// push [n] generated words onto [words]
+static void make_words(BufferArray *words, size_t n) {
+    uint64_t seed = 0x2545f4914f6cdd1dULL;
+    char tmp[64];
+    Buffer w;
+    buffer_init(&w);
+    for (size_t i = 0; i < n; ++i) {
+        size_t len = 0;
+        const size_t parts = 2 + bench_rand(&seed) % 3;
+        for (size_t p = 0; p < parts; ++p)
+            len += (size_t) snprintf(tmp + len, sizeof(tmp) - len, "%s",
+                                     syllables[bench_rand(&seed) % SYLLABLES]);
+        len += (size_t) snprintf(tmp + len, sizeof(tmp) - len, "%s",
+                                 endings[bench_rand(&seed) % ENDINGS]);
+        buffer_clear(&w);
+        buffer_push_bytes(&w, (unsigned char *) tmp, len);
+        buffer_array_push(words, &w);
+    }
+    buffer_free(&w);
+}
+
+// push every line of [fileName] onto [words]
+static bool read_words(BufferArray *words, const char *fileName) {
+    MappedFile mf;
+    if (!mapped_file_open(&mf, fileName)) return false;
+    const unsigned char *p = mf.data, *end = mf.data + mf.len;
+    Buffer w;
+    buffer_init(&w);
+    while (p < end) {
+        const unsigned char *nl = memchr(p, '\n', (size_t) (end - p));
+        if (NULL == nl) nl = end;
+        BufferView v;
+        buffer_view_set(&v, p, (size_t) (nl - p));
+        if (v.len) {
+            buffer_cpy_view(&w, &v);
+            buffer_array_push(words, &w);
+        }
+        p = nl + 1;
+    }
+    buffer_free(&w);
+    mapped_file_close(&mf);
+    return true;
+}
+
+int main(int argc, const char **argv) {
+
+    const size_t n = bench_arg(argc, argv, "-n", 500000);
+    const size_t lookups = bench_arg(argc, argv, "-lookups", 1000000);
+    const char *dict = bench_arg_str(argc, argv, "-dict", NULL);
+
+    BufferArray words;
+    buffer_array_init(&words);
+    if (NULL != dict) {
+        if (!read_words(&words, dict)) return 5;
+    } else {
+        make_words(&words, n);
+    }
+
+    // sort and drop repeats, the dictionary takes each word once
+    size_t count = buffer_array_get_buffer_count(&words);
+    Buffer *w = (Buffer *) words.array.data;
+    qsort(w, count, sizeof(Buffer), buffer_cmp_bytes);
+    size_t unique = 0;
+    size_t wordBytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (unique > 0 && 0 == buffer_cmp_bytes(&w[unique - 1], &w[i])) {
+            buffer_free(&w[i]);
+            continue;
+        }
+        w[unique++] = w[i];
+        wordBytes += w[i].len;
+    }
+    words.count = unique;
+    words.array.len = unique * sizeof(Buffer);
+    count = unique;
+    printf("%zu words, %zu bytes of text\n", count, wordBytes);
+
+    size_t base = heap_in_use();
+    double start = bench_now();
+    Fst fst;
+    if (!fst_build(&fst, &words, NULL)) return 5;
+    bench_report("fst_build", count, bench_now() - start);
+    printf("fst %zu states, %zu bytes, %.2f bytes per word, heap %.2f\n",
+           fst_get_state_count(&fst), fst_get_memory(&fst),
+           (double) fst_get_memory(&fst) / (double) count,
+           (double) (heap_in_use() - base) / (double) count);
+
+    base = heap_in_use();
+    start = bench_now();
+    HashTable ht;
+    hashtable_init(&ht);
+    if (!hashtable_set_size(&ht, count | 1)) return 5;
+    Buffer value;
+    buffer_init(&value);
+    for (size_t i = 0; i < count; ++i) {
+        buffer_clear(&value);
+        buffer_push_bytes(&value, (unsigned char *) &i, sizeof(i));
+        if (!hashtable_add(&ht, &w[i], &value)) return 5;
+    }
+    bench_report("hashtable_add", count, bench_now() - start);
+    printf("hashtable heap %.2f bytes per word\n",
+           (double) (heap_in_use() - base) / (double) count);
+
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    size_t *probe = malloc(sizeof(size_t) * lookups);
+    if (NULL == probe) return 5;
+    for (size_t i = 0; i < lookups; ++i) probe[i] = bench_rand(&seed) % count;
+
+    size_t found = 0;
+    start = bench_now();
+    for (size_t i = 0; i < lookups; ++i) {
+        uint64_t payload;
+        found += fst_get(&fst, &w[probe[i]], &payload) && payload == probe[i];
+    }
+    bench_report("fst_get", lookups, bench_now() - start);
+
+    size_t foundHt = 0;
+    start = bench_now();
+    for (size_t i = 0; i < lookups; ++i) {
+        Buffer *v = hashtable_get(&ht, &w[probe[i]]);
+        foundHt += NULL != v && *(size_t *) v->data == probe[i];
+    }
+    bench_report("hashtable_get", lookups, bench_now() - start);
+
+    FstIterator it;
+    BufferView view;
+    fst_iterator_init(&it, &fst);
+    size_t walked = 0;
+    start = bench_now();
+    while (fst_iterator_next(&it, &view, NULL)) ++walked;
+    bench_report("fst ordered walk", walked, bench_now() - start);
+
+    // every word starting with the first three bytes of a random word
+    size_t prefixed = 0;
+    const size_t prefixes = 10000;
+    start = bench_now();
+    for (size_t i = 0; i < prefixes; ++i) {
+        const Buffer *p = &w[bench_rand(&seed) % count];
+        buffer_view_set(&view, p->data, p->len < 3 ? p->len : 3);
+        if (!fst_iterator_seek_prefix(&it, &view)) continue;
+        while (fst_iterator_next(&it, &view, NULL)) ++prefixed;
+    }
+    bench_report("fst prefix walks", prefixes, bench_now() - start);
+    printf("found %zu/%zu fst, %zu hashtable, %zu walked, %zu by prefix\n",
+           found, lookups, foundHt, walked, prefixed);
+
+    fst_iterator_free(&it);
+    fst_free(&fst);
+    hashtable_free(&ht);
+    buffer_array_free(&words);
+    buffer_free(&value);
+    free(probe);
+    return 0;
+}
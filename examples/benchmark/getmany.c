@@ -0,0 +1,93 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+/*
+ * compares a loop of hashtable_get calls with hashtable_get_many on a table
+ * sized well past the last level cache
+ *
+ * getManyBench -n [entries] -lookups [lookups] -batch [keys per call]
+ *
+ * the bucket index is the hash modulo the table size, so prime sizes spread
+ * keys far better than powers of two or ten
+*/
+
+#include "bench.h"
+#include "../../src/hashtable.h"
+
+// write the key for entry [i] into [key]
+static void make_key(Buffer *key, uint64_t i) {
+    char tmp[32];
+    snprintf(tmp, sizeof(tmp), "key-%llu", (unsigned long long) i);
+    buffer_strcpy(key, tmp);
+}
+
+int main(int argc, const char **argv) {
+
+    const size_t n = bench_arg(argc, argv, "-n", 1048573);
+    const size_t lookups = bench_arg(argc, argv, "-lookups", 1 << 22);
+    const size_t batch = bench_arg(argc, argv, "-batch", 1024);
+
+    HashTable ht;
+    hashtable_init(&ht);
+    if (!hashtable_set_size(&ht, n)) return 5;
+
+    Buffer key, value;
+    buffer_init(&key);
+    buffer_init(&value);
+
+    double start = bench_now();
+    for (uint64_t i = 0; i < n; ++i) {
+        make_key(&key, i);
+        buffer_clear(&value);
+        buffer_push_bytes(&value, (unsigned char *) &i, sizeof(i));
+        if (!hashtable_add(&ht, &key, &value)) return 5;
+    }
+    bench_report("build", n, bench_now() - start);
+
+    // half of the probes hit, half miss, in a random order, and there are
+    // enough of them that their buckets cannot stay cached between passes
+    Buffer *probes = malloc(sizeof(Buffer) * lookups);
+    BufferView *views = malloc(sizeof(BufferView) * lookups);
+    Buffer **results = malloc(sizeof(Buffer *) * batch);
+    if (NULL == probes || NULL == views || NULL == results) return 5;
+
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < lookups; ++i) {
+        buffer_init(&probes[i]);
+        make_key(&probes[i], bench_rand(&seed) % (n * 2));
+        buffer_view_from_buffer(&views[i], &probes[i]);
+    }
+
+    size_t found = 0;
+    start = bench_now();
+    for (size_t i = 0; i < lookups; ++i) {
+        if (NULL != hashtable_get(&ht, &probes[i]))
+            ++found;
+    }
+    bench_report("hashtable_get loop", lookups, bench_now() - start);
+
+    size_t foundMany = 0;
+    start = bench_now();
+    for (size_t done = 0; done < lookups; done += batch) {
+        size_t count = lookups - done;
+        if (count > batch) count = batch;
+        foundMany += hashtable_get_many_views(&ht, &views[done], count, results);
+    }
+    bench_report("hashtable_get_many", lookups, bench_now() - start);
+
+    if (found != foundMany) {
+        fprintf(stderr, "mismatch: %zu found singly, %zu batched\n", found,
+                foundMany);
+        return 5;
+    }
+
+    for (size_t i = 0; i < lookups; ++i) buffer_free(&probes[i]);
+    free(probes);
+    free(views);
+    free(results);
+    buffer_free(&key);
+    buffer_free(&value);
+    hashtable_free(&ht);
+    return 0;
+}
@@ -0,0 +1,87 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+/*
+ * deduplicates a stream of tokens with a HashSet and with a HashTable holding
+ * an empty value per key, reporting time and heap bytes per distinct key
+ *
+ * hashSetBench -n [distinct tokens] -tokens [tokens in the stream]
+*/
+
+#include <malloc.h>
+#include "bench.h"
+#include "../../src/hashtable.h"
+#include "../../src/hashset.h"
+
+// bytes currently allocated from the heap
+static size_t heap_in_use(void) {
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+int main(int argc, const char **argv) {
+
+    const size_t n = bench_arg(argc, argv, "-n", 200003);
+    const size_t tokens = bench_arg(argc, argv, "-tokens", 1 << 21);
+
+    BufferView *stream = malloc(sizeof(BufferView) * tokens);
+    char *text = malloc(tokens * 24);
+    if (NULL == stream || NULL == text) return 5;
+
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    for (size_t i = 0; i < tokens; ++i) {
+        char *t = text + i * 24;
+        int len = snprintf(t, 24, "token-%llu",
+                           (unsigned long long) (bench_rand(&seed) % n));
+        buffer_view_set(&stream[i], (unsigned char *) t, (size_t) len);
+    }
+
+    size_t base = heap_in_use();
+    HashSet hs;
+    hashset_init(&hs);
+    size_t distinctSet = 0;
+    double start = bench_now();
+    for (size_t i = 0; i < tokens; ++i) {
+        bool added;
+        if (!hashset_insert_bytes(&hs, stream[i].data, stream[i].len, &added))
+            return 5;
+        distinctSet += added;
+    }
+    bench_report("hashset dedup", tokens, bench_now() - start);
+    printf("hashset %.1f bytes per key\n",
+           (double) (heap_in_use() - base) / (double) distinctSet);
+    hashset_free(&hs);
+
+    base = heap_in_use();
+    HashTable ht;
+    hashtable_init(&ht);
+    if (!hashtable_set_size(&ht, n)) return 5;
+    Buffer key, empty;
+    buffer_init(&key);
+    buffer_init(&empty);
+    size_t distinctTable = 0;
+    start = bench_now();
+    for (size_t i = 0; i < tokens; ++i) {
+        buffer_clear(&key);
+        buffer_push_bytes(&key, stream[i].data, stream[i].len);
+        if (NULL != hashtable_get(&ht, &key)) continue;
+        if (!hashtable_add(&ht, &key, &empty)) return 5;
+        ++distinctTable;
+    }
+    bench_report("hashtable dedup", tokens, bench_now() - start);
+    printf("hashtable %.1f bytes per key\n",
+           (double) (heap_in_use() - base) / (double) distinctTable);
+
+    if (distinctSet != distinctTable) {
+        fprintf(stderr, "mismatch: %zu in set, %zu in table\n", distinctSet,
+                distinctTable);
+        return 5;
+    }
+
+    buffer_free(&key);
+    hashtable_free(&ht);
+    free(stream);
+    free(text);
+    return 0;
+}
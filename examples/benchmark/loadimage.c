@@ -0,0 +1,95 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+/*
+ * startup time of loading a dictionary from text, the way load_hashtable in
+ * searchFile does, versus mapping a saved hash table image
+ *
+ * loadImageBench -n [words] -dict [dictionary file] -image [image file]
+ *
+ * when no dictionary is given one with [words] random words is written
+*/
+
+#include "bench.h"
+#include "../../src/hashtable.h"
+#include "../../src/filereader.h"
+#include "../../src/mappedhashtable.h"
+
+// write a dictionary of [n] random lower case words to [fileName]
+static int write_dictionary(const char *fileName, size_t n) {
+    FILE *f = fopen(fileName, "w");
+    if (NULL == f) return 0;
+    uint64_t seed = 0x2545f4914f6cdd1dULL;
+    for (size_t i = 0; i < n; ++i) {
+        const size_t len = 3 + bench_rand(&seed) % 10;
+        for (size_t j = 0; j < len; ++j) fputc('a' + bench_rand(&seed) % 26, f);
+        fprintf(f, "%zu\n", i);
+    }
+    fclose(f);
+    return 1;
+}
+
+int main(int argc, const char **argv) {
+
+    const size_t n = bench_arg(argc, argv, "-n", 500000);
+    const char *dict = bench_arg_str(argc, argv, "-dict", NULL);
+    const char *image = bench_arg_str(argc, argv, "-image", "dictionary.img");
+
+    if (NULL == dict) {
+        dict = "dictionary.txt";
+        if (!write_dictionary(dict, n)) return 5;
+    }
+
+    double start = bench_now();
+
+    HashTable ht;
+    hashtable_init(&ht);
+    if (!hashtable_set_size(&ht, n | 1)) return 5;
+
+    FileReader reader;
+    file_reader_init(&reader);
+    if (!file_reader_open(&reader, dict)) return 5;
+
+    const size_t defaultCount = 0;
+    Buffer line, value, probe;
+    buffer_init(&line);
+    buffer_init(&value);
+    buffer_init(&probe);
+    buffer_push_bytes(&value, (unsigned char *) &defaultCount, sizeof(size_t));
+
+    size_t words = 0;
+    while (file_reader_read_line(&reader, &line, '\n')) {
+        buffer_cleanse_text(&line);
+        if (!hashtable_add(&ht, &line, &value)) return 5;
+        if (0 == words) buffer_cpy(&probe, &line);
+        ++words;
+    }
+    file_reader_close(&reader);
+    bench_report("text load", words, bench_now() - start);
+
+    start = bench_now();
+    if (!hashtable_save(&ht, image)) return 5;
+    bench_report("hashtable_save", words, bench_now() - start);
+
+    // time from nothing to the first answered query
+    start = bench_now();
+    MappedHashTable mht;
+    if (!hashtable_open_mapped(&mht, image)) return 5;
+    const bool found = mapped_hashtable_has(&mht, &probe);
+    bench_report("open mapped + first get", 1, bench_now() - start);
+
+    start = bench_now();
+    const bool intact = mapped_hashtable_verify(&mht);
+    bench_report("mapped_hashtable_verify", 1, bench_now() - start);
+
+    printf("entries %zu found %d intact %d\n",
+           mapped_hashtable_get_entry_count(&mht), found, intact);
+
+    mapped_hashtable_close(&mht);
+    buffer_free(&line);
+    buffer_free(&value);
+    buffer_free(&probe);
+    hashtable_free(&ht);
+    return 0;
+}
@@ -0,0 +1,118 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+/*
+ * merges per thread word count tables the old way, iterating one table and
+ * adding every pair to another, and with hashtable_merge_all on a pool
+ *
+ * mergeBench -tables [tables] -n [distinct words] -words [words per table]
+ *            -threads [threads]
+*/
+
+#include "bench.h"
+#include "../../src/hashtable.h"
+#include "../../src/threadpool.h"
+
+static bool add_counts(Buffer *dest, Buffer *src, void *ctx) {
+    size_t a, b;
+    memcpy(&a, dest->data, sizeof(a));
+    memcpy(&b, src->data, sizeof(b));
+    a += b;
+    memcpy(dest->data, &a, sizeof(a));
+    (void) ctx;
+    return true;
+}
+
+// count [words] random words out of [n] into each of [count] tables
+static void fill(HashTable *tables, size_t count, size_t size, size_t n,
+                 size_t words) {
+    Buffer key, value;
+    buffer_init(&key);
+    buffer_init(&value);
+    char tmp[32];
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    for (size_t t = 0; t < count; ++t) {
+        hashtable_init(&tables[t]);
+        hashtable_set_size(&tables[t], size);
+        for (size_t i = 0; i < words; ++i) {
+            snprintf(tmp, sizeof(tmp), "word-%llu",
+                     (unsigned long long) (bench_rand(&seed) % n));
+            buffer_strcpy(&key, tmp);
+            Buffer *v = hashtable_get(&tables[t], &key);
+            if (NULL != v) {
+                (*(size_t *) v->data)++;
+                continue;
+            }
+            const size_t one = 1;
+            buffer_clear(&value);
+            buffer_push_bytes(&value, (unsigned char *) &one, sizeof(one));
+            hashtable_add(&tables[t], &key, &value);
+        }
+    }
+    buffer_free(&key);
+    buffer_free(&value);
+}
+
+int main(int argc, const char **argv) {
+
+    const size_t count = bench_arg(argc, argv, "-tables", 8);
+    const size_t n = bench_arg(argc, argv, "-n", 100000);
+    const size_t words = bench_arg(argc, argv, "-words", 100000);
+    const size_t threads = bench_arg(argc, argv, "-threads", 0);
+    const size_t size = 100003;
+
+    HashTable *tables = malloc(sizeof(HashTable) * count);
+    HashTable **ptrs = malloc(sizeof(HashTable *) * count);
+    if (NULL == tables || NULL == ptrs) return 5;
+
+    fill(tables, count, size, n, words);
+    size_t pairs = 0;
+    for (size_t t = 0; t < count; ++t) pairs += hashtable_get_entry_count(&tables[t]);
+
+    // iterate and add, the only way before hashtable_merge
+    double start = bench_now();
+    for (size_t t = 1; t < count; ++t) {
+        HashTableIterator it;
+        HashValue *hv;
+        hashtable_iterator_init(&it, &tables[t]);
+        while (NULL != (hv = hashtable_iterator_next(&it))) {
+            Buffer *v = hashtable_get(&tables[0], &hv->key);
+            if (NULL != v) add_counts(v, &hv->data, NULL);
+            else hashtable_add(&tables[0], &hv->key, &hv->data);
+        }
+    }
+    bench_report("iterate and add", pairs, bench_now() - start);
+    const size_t expected = hashtable_get_entry_count(&tables[0]);
+    for (size_t t = 0; t < count; ++t) hashtable_free(&tables[t]);
+
+    fill(tables, count, size, n, words);
+    start = bench_now();
+    for (size_t t = 1; t < count; ++t)
+        hashtable_merge(&tables[0], &tables[t], add_counts, NULL, NULL);
+    bench_report("hashtable_merge serial", pairs, bench_now() - start);
+    for (size_t t = 0; t < count; ++t) hashtable_free(&tables[t]);
+
+    ThreadPool tp;
+    if (!threadpool_init(&tp, threads)) return 5;
+    fill(tables, count, size, n, words);
+    for (size_t t = 0; t < count; ++t) ptrs[t] = &tables[t];
+    start = bench_now();
+    if (!hashtable_merge_all(ptrs, count, add_counts, NULL, &tp)) return 5;
+    char name[64];
+    snprintf(name, sizeof(name), "hashtable_merge_all %zu threads",
+             threadpool_get_thread_count(&tp));
+    bench_report(name, pairs, bench_now() - start);
+
+    if (hashtable_get_entry_count(&tables[0]) != expected) {
+        fprintf(stderr, "mismatch: %zu keys merged, %zu expected\n",
+                hashtable_get_entry_count(&tables[0]), expected);
+        return 5;
+    }
+
+    for (size_t t = 0; t < count; ++t) hashtable_free(&tables[t]);
+    threadpool_free(&tp);
+    free(tables);
+    free(ptrs);
+    return 0;
+}
@@ -0,0 +1,142 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+/*
+ * allocations and bytes allocated per insert when every key and value is
+ * copied in with hashtable_add and buffer_array_push versus moved in with
+ * hashtable_add_move and buffer_array_push_move.  every copy lands in
+ * memory allocated for it, so bytes allocated also counts bytes copied.
+ * only the insert itself is counted, not the caller building its pair
+ *
+ * moveBench -n [inserts]
+*/
+
+#include "bench.h"
+#include "../../src/hashtable.h"
+#include "../../src/bufferarray.h"
+
+#if defined(__GLIBC__)
+// count every allocation made by the program by wrapping glibc's allocator
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *p, size_t size);
+extern void __libc_free(void *p);
+
+static size_t allocations = 0;
+static size_t allocated = 0;
+
+void *malloc(size_t size) {
+    ++allocations;
+    allocated += size;
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    ++allocations;
+    allocated += count * size;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, size_t size) {
+    ++allocations;
+    allocated += size;
+    return __libc_realloc(p, size);
+}
+
+void free(void *p) {
+    __libc_free(p);
+}
+#else
+static size_t allocations = 0;
+static size_t allocated = 0;
+#endif
+
+// allocations and bytes made by inserts alone
+static size_t insertCalls = 0;
+static size_t insertBytes = 0;
+
+// count the allocations made by [insert], a single insert call
+#define COUNT_INSERT(insert) do { \
+        const size_t calls = allocations, bytes = allocated; \
+        const bool ok = (insert); \
+        insertCalls += allocations - calls; \
+        insertBytes += allocated - bytes; \
+        if (!ok) return 5; \
+    } while (0)
+
+// print the allocations counted for [n] inserts and start counting afresh
+static void report(const char *name, size_t n, double secs) {
+    bench_report(name, n, secs);
+    printf("%-32s %12.2f allocs/op %8.1f bytes/op\n", "",
+           (double) insertCalls / (double) n, (double) insertBytes / (double) n);
+    insertCalls = 0;
+    insertBytes = 0;
+}
+
+// fill [key] and [value] with the [i]th pair, the way a caller reading
+// records would build them
+static void make_pair(Buffer *key, Buffer *value, size_t i) {
+    char tmp[32];
+    const int len = snprintf(tmp, sizeof(tmp), "key-%zu", i);
+    BufferView view;
+    buffer_view_set(&view, (unsigned char *) tmp, (size_t) len);
+    buffer_cpy_view(key, &view);
+    buffer_view_set(&view, (unsigned char *) &i, sizeof(i));
+    buffer_cpy_view(value, &view);
+}
+
+int main(int argc, const char **argv) {
+
+    const size_t n = bench_arg(argc, argv, "-n", 1000000);
+
+    Buffer key, value;
+    buffer_init(&key);
+    buffer_init(&value);
+
+    HashTable ht;
+    hashtable_init(&ht);
+    if (!hashtable_set_size(&ht, n | 1)) return 5;
+
+    // the caller reuses its buffers, the table copies each pair
+    double start = bench_now();
+    for (size_t i = 0; i < n; ++i) {
+        make_pair(&key, &value, i);
+        COUNT_INSERT(hashtable_add(&ht, &key, &value));
+    }
+    report("hashtable_add", n, bench_now() - start);
+    hashtable_free(&ht);
+
+    hashtable_init(&ht);
+    if (!hashtable_set_size(&ht, n | 1)) return 5;
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i) {
+        make_pair(&key, &value, i);
+        COUNT_INSERT(hashtable_add_move(&ht, &key, &value));
+    }
+    report("hashtable_add_move", n, bench_now() - start);
+    if (hashtable_get_entry_count(&ht) != n) return 5;
+    hashtable_free(&ht);
+
+    BufferArray ba;
+    buffer_array_init(&ba);
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i) {
+        make_pair(&key, &value, i);
+        COUNT_INSERT(buffer_array_push(&ba, &key));
+    }
+    report("buffer_array_push", n, bench_now() - start);
+    buffer_array_free(&ba);
+
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i) {
+        make_pair(&key, &value, i);
+        COUNT_INSERT(buffer_array_push_move(&ba, &key));
+    }
+    report("buffer_array_push_move", n, bench_now() - start);
+    buffer_array_free(&ba);
+
+    buffer_free(&key);
+    buffer_free(&value);
+    return 0;
+}
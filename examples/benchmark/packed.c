@@ -0,0 +1,93 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+/*
+ * memory and time to hold many short tokens in a BufferArray, where every
+ * token is a Buffer with its own allocation, versus a PackedBufferArray
+ * where they sit back to back in one pool
+ *
+ * packedBench -n [tokens]
+*/
+
+#include <malloc.h>
+#include "bench.h"
+#include "../../src/buffer.h"
+#include "../../src/bufferarray.h"
+
+// bytes currently allocated from the heap
+static size_t heap_in_use(void) {
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+// a short word of 3 to 10 lowercase letters
+static size_t make_token(uint64_t *seed, char *tmp) {
+    const size_t len = 3 + bench_rand(seed) % 8;
+    for (size_t i = 0; i < len; ++i) tmp[i] = (char) ('a' + bench_rand(seed) % 26);
+    return len;
+}
+
+int main(int argc, const char **argv) {
+
+    const size_t n = bench_arg(argc, argv, "-n", 5000000);
+    char tmp[16];
+    uint64_t seed;
+    size_t bytes = 0;
+
+    Buffer token;
+    buffer_init(&token);
+    BufferArray ba;
+    buffer_array_init(&ba);
+    size_t base = heap_in_use();
+    seed = 0x2545f4914f6cdd1dULL;
+    double start = bench_now();
+    for (size_t i = 0; i < n; ++i) {
+        const size_t len = make_token(&seed, tmp);
+        buffer_clear(&token);
+        buffer_push_bytes(&token, (unsigned char *) tmp, len);
+        if (!buffer_array_push(&ba, &token)) return 5;
+        bytes += len;
+    }
+    bench_report("buffer_array_push", n, bench_now() - start);
+    printf("%zu tokens, %zu bytes, buffer array %.2f heap bytes per token\n",
+           n, bytes, (double) (heap_in_use() - base) / (double) n);
+
+    size_t sum = 0;
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i) {
+        const Buffer *b = buffer_array_get_buffer(&ba, i);
+        sum += b->data[b->len - 1];
+    }
+    bench_report("buffer array scan", n, bench_now() - start);
+    buffer_array_free(&ba);
+
+    PackedBufferArray pa;
+    packed_buffer_array_init(&pa);
+    base = heap_in_use();
+    seed = 0x2545f4914f6cdd1dULL;
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i) {
+        const size_t len = make_token(&seed, tmp);
+        if (!packed_buffer_array_push_bytes(&pa, (unsigned char *) tmp, len))
+            return 5;
+    }
+    bench_report("packed_buffer_array_push_bytes", n, bench_now() - start);
+    printf("packed buffer array %.2f heap bytes per token, %zu allocated\n",
+           (double) (heap_in_use() - base) / (double) n,
+           packed_buffer_array_get_memory(&pa));
+
+    size_t sumPacked = 0;
+    BufferView view;
+    start = bench_now();
+    for (size_t i = 0; i < n; ++i) {
+        packed_buffer_array_get_view(&pa, i, &view);
+        sumPacked += view.data[view.len - 1];
+    }
+    bench_report("packed buffer array scan", n, bench_now() - start);
+    printf("checksums %zu %zu\n", sum, sumPacked);
+
+    packed_buffer_array_free(&pa);
+    buffer_free(&token);
+    return 0;
+}
@@ -0,0 +1,126 @@
+//
+// Created by Joseph Hurdle on 10/19/26.
+//
+
+/*
+ * what each FileReader hint costs in throughput and leaves behind in the
+ * page cache, reading a file once from a cold cache
+ *
+ * pageCacheBench -mb [size of generated file] -file [file to read instead]
+ *
+ * resident is how much of the file is still cached when the reader is done,
+ * the footprint a scan of a huge file leaves pushing other data out
+*/
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "bench.h"
+#include "../../src/filereader.h"
+
+// ask the kernel to forget the cached pages of [fileName]
+static void drop_cache(const char *fileName) {
+    const int fd = open(fileName, O_RDONLY);
+    if (-1 == fd) return;
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+// bytes of [fileName] in the page cache
+static size_t resident(const char *fileName) {
+    const int fd = open(fileName, O_RDONLY);
+    if (-1 == fd) return 0;
+    struct stat fi;
+    size_t count = 0;
+    if (0 == fstat(fd, &fi) && fi.st_size > 0) {
+        const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+        const size_t pages = ((size_t) fi.st_size + page - 1) / page;
+        void *p = mmap(NULL, (size_t) fi.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        unsigned char *vec = malloc(pages);
+        if (MAP_FAILED != p && NULL != vec &&
+            0 == mincore(p, (size_t) fi.st_size, vec)) {
+            for (size_t i = 0; i < pages; ++i) count += vec[i] & 1;
+        }
+        free(vec);
+        if (MAP_FAILED != p) munmap(p, (size_t) fi.st_size);
+    }
+    close(fd);
+    return count * (size_t) sysconf(_SC_PAGESIZE);
+}
+
+// read every line of [fileName] as [opts] says from a cold cache
+static void run(const char *name, const char *fileName,
+                const FileReaderOptions *opts) {
+    drop_cache(fileName);
+
+    FileReader reader;
+    file_reader_init(&reader);
+    BufferView block, line;
+    size_t lines = 0, bytes = 0;
+
+    const double start = bench_now();
+    if (!file_reader_open_options(&reader, fileName, opts)) return;
+    while (file_reader_read_block(&reader, &block, '\n')) {
+        while (file_reader_next_line(&block, &line, '\n')) {
+            ++lines;
+            bytes += line.len;
+        }
+    }
+    file_reader_close(&reader);
+    const double secs = bench_now() - start;
+
+    printf("%-28s %10.1f MB/s %10.1f MB resident\n", name,
+           (double) bytes / secs / 1e6, (double) resident(fileName) / 1e6);
+}
+
+int main(int argc, const char **argv) {
+
+    const size_t mb = bench_arg(argc, argv, "-mb", 512);
+    const char *fileName = bench_arg_str(argc, argv, "-file", NULL);
+    const bool generated = NULL == fileName;
+
+    if (generated) {
+        fileName = "page_cache_bench.txt";
+        FILE *f = fopen(fileName, "w");
+        if (NULL == f) return 5;
+        uint64_t seed = 0x2545f4914f6cdd1dULL;
+        for (size_t i = 0; i < mb << 20; ++i) {
+            const uint64_t r = bench_rand(&seed) % 64;
+            fputc(0 == r ? '\n' : r < 10 ? ' ' : 'a' + (int) (r % 26), f);
+        }
+        fclose(f);
+    }
+
+    static const struct {
+        const char *name;
+        FileReaderMode mode;
+        unsigned int advice;
+    } runs[] = {
+            {"read",                   FILE_READER_MODE_READ,  FILE_READER_ADVISE_NONE},
+            {"read sequential",        FILE_READER_MODE_READ,  FILE_READER_ADVISE_SEQUENTIAL},
+            {"read willneed",          FILE_READER_MODE_READ,  FILE_READER_ADVISE_WILLNEED},
+            {"read drop behind",       FILE_READER_MODE_READ,  FILE_READER_ADVISE_DROP_BEHIND},
+            {"read willneed drop",     FILE_READER_MODE_READ,  FILE_READER_ADVISE_WILLNEED |
+                                                               FILE_READER_ADVISE_DROP_BEHIND},
+            {"read direct",            FILE_READER_MODE_READ,  FILE_READER_ADVISE_DIRECT},
+            {"async",                  FILE_READER_MODE_ASYNC, FILE_READER_ADVISE_NONE},
+            {"async drop behind",      FILE_READER_MODE_ASYNC, FILE_READER_ADVISE_DROP_BEHIND},
+            {"async direct",           FILE_READER_MODE_ASYNC, FILE_READER_ADVISE_DIRECT},
+            {"mmap",                   FILE_READER_MODE_MMAP,  FILE_READER_ADVISE_NONE},
+            {"mmap willneed drop",     FILE_READER_MODE_MMAP,  FILE_READER_ADVISE_WILLNEED |
+                                                               FILE_READER_ADVISE_DROP_BEHIND},
+    };
+
+    for (size_t i = 0; i < sizeof(runs) / sizeof(runs[0]); ++i) {
+        FileReaderOptions opts;
+        file_reader_options_init(&opts);
+        opts.mode = runs[i].mode;
+        opts.advice = runs[i].advice;
+        opts.mapWindow = (size_t) 64 << 20;
+        run(runs[i].name, fileName, &opts);
+    }
+
+    if (generated) remove(fileName);
+    return 0;
+}
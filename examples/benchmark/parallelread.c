@@ -0,0 +1,115 @@
+//
+// Created by Joseph Hurdle on 10/19/26.
+//
+
+/*
+ * counting the words of one file with its lines split between threads, a
+ * FileReader per range, against the number of threads
+ *
+ * parallelReadBench -mb [size of generated file] -file [file to read instead]
+ *                   -threads [most threads, default one per processor]
+ *
+ * every pass reads from the page cache, so it measures how the work scales
+*/
+
+#include "bench.h"
+#include "../../src/filereader.h"
+#include "../../src/threadpool.h"
+
+typedef struct stCountJob {
+    const char *fileName;
+    const FileRange *ranges;
+    size_t *words;
+    bool failed;
+} CountJob;
+
+// count the words in range [task] of the job
+static void count_range(void *ctx, size_t task) {
+    CountJob *job = (CountJob *) ctx;
+    FileReaderOptions opts;
+    file_reader_options_init(&opts);
+
+    FileReader reader;
+    file_reader_init(&reader);
+    if (!file_reader_open_range(&reader, job->fileName, &opts,
+                                job->ranges[task].start,
+                                job->ranges[task].end)) {
+        job->failed = true;
+        return;
+    }
+
+    size_t words = 0;
+    BufferView block, line;
+    while (file_reader_read_block(&reader, &block, '\n')) {
+        while (file_reader_next_line(&block, &line, '\n')) {
+            bool inWord = false;
+            for (size_t i = 0; i < line.len; ++i) {
+                const bool space = ' ' == line.data[i] || '\n' == line.data[i];
+                words += !space && !inWord;
+                inWord = !space;
+            }
+        }
+    }
+    file_reader_close(&reader);
+    job->words[task] = words;
+}
+
+int main(int argc, const char **argv) {
+
+    const size_t mb = bench_arg(argc, argv, "-mb", 512);
+    const char *fileName = bench_arg_str(argc, argv, "-file", NULL);
+    const size_t most = bench_arg(argc, argv, "-threads", threadpool_cpu_count());
+    const bool generated = NULL == fileName;
+
+    if (generated) {
+        fileName = "parallel_read_bench.txt";
+        FILE *f = fopen(fileName, "w");
+        if (NULL == f) return 5;
+        uint64_t seed = 0x2545f4914f6cdd1dULL;
+        for (size_t i = 0; i < mb << 20; ++i) {
+            const uint64_t r = bench_rand(&seed) % 64;
+            fputc(0 == r ? '\n' : r < 10 ? ' ' : 'a' + (int) (r % 26), f);
+        }
+        fclose(f);
+    }
+
+    double single = 0;
+    for (size_t threads = 1; threads <= most; threads *= 2) {
+        ThreadPool tp;
+        if (!threadpool_init(&tp, threads)) return 5;
+
+        // a few ranges a thread evens out how fast each goes
+        const size_t count = threads * 4;
+        FileRange *ranges = malloc(sizeof(FileRange) * count);
+        size_t *words = calloc(count, sizeof(size_t));
+        size_t found;
+        if (NULL == ranges || NULL == words ||
+            !file_reader_split(fileName, '\n', count, ranges, &found) ||
+            0 == found)
+            return 5;
+
+        CountJob job = {fileName, ranges, words, false};
+        const double start = bench_now();
+        if (!threadpool_run(&tp, found, count_range, &job) || job.failed)
+            return 5;
+        const double secs = bench_now() - start;
+
+        size_t total = 0, bytes = ranges[found - 1].end;
+        for (size_t i = 0; i < found; ++i) total += words[i];
+        if (1 == threads) single = secs;
+
+        char name[64];
+        snprintf(name, sizeof(name), "count words %zu threads", threads);
+        bench_report(name, total, secs);
+        printf("%-32s %12.1f MB/s %8.2fx\n", name, (double) bytes / secs / 1e6,
+               single / secs);
+
+        free(ranges);
+        free(words);
+        threadpool_free(&tp);
+        if (threads < most && threads * 2 > most) threads = most / 2;
+    }
+
+    if (generated) remove(fileName);
+    return 0;
+}
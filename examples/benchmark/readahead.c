@@ -0,0 +1,149 @@
+//
+// Created by Joseph Hurdle on 10/19/26.
+//
+
+/*
+ * a FileReader reading ahead on a background thread against the plain
+ * synchronous reader, over a slow file and with work done on every line
+ *
+ * readAheadBench -mb [size of text] -rate [MB/s of the slow file]
+ *                -work [hashes of every line]
+ *
+ * the slow file is a fifo fed by a thread which waits as long as the rate
+ * says before writing each 64K, through a pipe of one page so almost nothing
+ * is read ahead unless the reader does it.  The same text is then read from
+ * an ordinary file in the page cache for the cost with nothing to wait on.
+*/
+
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "bench.h"
+#include "../../src/filereader.h"
+#include "../../src/hash.h"
+
+#define READ_AHEAD_BENCH_CHUNK (64 * 1024)
+
+typedef struct stSlowFile {
+    const char *fileName;
+    const unsigned char *text;
+    size_t len;
+    double rate;
+} SlowFile;
+
+// write the text to the fifo no faster than its rate allows
+static void *slow_file_writer(void *arg) {
+    SlowFile *slow = (SlowFile *) arg;
+    const int fd = open(slow->fileName, O_WRONLY);
+    if (-1 == fd) return NULL;
+#if defined(F_SETPIPE_SZ)
+    fcntl(fd, F_SETPIPE_SZ, 4096);
+#endif
+    const double latency = READ_AHEAD_BENCH_CHUNK / (slow->rate * 1e6);
+    const struct timespec wait = {0, (long) (latency * 1e9)};
+    for (size_t off = 0; off < slow->len; off += READ_AHEAD_BENCH_CHUNK) {
+        size_t n = slow->len - off;
+        if (n > READ_AHEAD_BENCH_CHUNK) n = READ_AHEAD_BENCH_CHUNK;
+        nanosleep(&wait, NULL);
+        for (size_t done = 0; done < n;) {
+            const ssize_t ret = write(fd, slow->text + off + done, n - done);
+            if (ret <= 0) break;
+            done += (size_t) ret;
+        }
+    }
+    close(fd);
+    return NULL;
+}
+
+// read [fileName] as [opts] says hashing each line [work] times, report the
+// throughput and return a sum of the hashes so none of it is optimised out
+static uint64_t run(const char *name, const char *fileName,
+                    const FileReaderOptions *opts, size_t work) {
+    FileReader reader;
+    file_reader_init(&reader);
+    BufferView block, line;
+    size_t lines = 0, bytes = 0;
+    uint64_t sum = 0;
+
+    const double start = bench_now();
+    if (!file_reader_open_options(&reader, fileName, opts)) return 0;
+    while (file_reader_read_block(&reader, &block, '\n')) {
+        while (file_reader_next_line(&block, &line, '\n')) {
+            for (size_t i = 0; i < work; ++i)
+                sum += hash_bytes(line.data, line.len, i);
+            ++lines;
+            bytes += line.len;
+        }
+    }
+    file_reader_close(&reader);
+    const double secs = bench_now() - start;
+
+    bench_report(name, lines, secs);
+    printf("%-32s %12.1f MB/s\n", name, (double) bytes / secs / 1e6);
+    return sum;
+}
+
+// read the slow file fed with [slow] as [opts] says
+static uint64_t run_slow(const char *name, SlowFile *slow,
+                         const FileReaderOptions *opts, size_t work) {
+    pthread_t writer;
+    if (0 != pthread_create(&writer, NULL, slow_file_writer, slow)) return 0;
+    const uint64_t sum = run(name, slow->fileName, opts, work);
+    pthread_join(writer, NULL);
+    return sum;
+}
+
+int main(int argc, const char **argv) {
+
+    const size_t mb = bench_arg(argc, argv, "-mb", 64);
+    const size_t rate = bench_arg(argc, argv, "-rate", 200);
+    const size_t work = bench_arg(argc, argv, "-work", 4);
+
+    // lines of 1 to 16 made up words
+    const size_t len = mb << 20;
+    unsigned char *text = malloc(len);
+    if (NULL == text) return 5;
+    uint64_t seed = 0x2545f4914f6cdd1dULL;
+    for (size_t i = 0; i < len; ++i) {
+        const uint64_t r = bench_rand(&seed) % 64;
+        text[i] = 0 == r ? '\n' : r < 10 ? ' ' : (unsigned char) ('a' + r % 26);
+    }
+
+    const char *plain = "read_ahead_bench.txt";
+    FILE *f = fopen(plain, "wb");
+    if (NULL == f) return 5;
+    fwrite(text, 1, len, f);
+    fclose(f);
+
+    SlowFile slow = {"read_ahead_bench.fifo", text, len, (double) rate};
+    remove(slow.fileName);
+    if (0 != mkfifo(slow.fileName, 0600)) return 5;
+
+    FileReaderOptions sync, async;
+    file_reader_options_init(&sync);
+    file_reader_options_init(&async);
+    async.mode = FILE_READER_MODE_ASYNC;
+
+    uint64_t sum = 0;
+    char name[64];
+    sum += run_slow("slow read", &slow, &sync, work);
+    for (size_t depth = 2; depth <= 8; depth *= 2) {
+        async.depth = depth;
+        snprintf(name, sizeof(name), "slow async depth %zu", depth);
+        sum += run_slow(name, &slow, &async, work);
+    }
+
+    sum += run("cached read", plain, &sync, work);
+    async.depth = FILE_READER_DEPTH;
+    sum += run("cached async", plain, &async, work);
+    sum += run("cached read no work", plain, &sync, 0);
+    sum += run("cached async no work", plain, &async, 0);
+
+    printf("checksum %llu\n", (unsigned long long) sum);
+    remove(slow.fileName);
+    remove(plain);
+    free(text);
+    return 0;
+}
@@ -0,0 +1,78 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+/*
+ * sorting a BufferArray of tokens with qsort and the buffer comparators
+ * versus buffer_array_sort on the calling thread and on thread pools
+ *
+ * sortBench -n [tokens] -threads [largest pool]
+*/
+
+#include "bench.h"
+#include "../../src/buffer.h"
+#include "../../src/bufferarray.h"
+
+// refill [ba] with the same [n] tokens every time, words drawn from a small
+// vocabulary of stems so keys share prefixes the way real text does
+static void fill(BufferArray *ba, size_t n) {
+    static const char *stems[] = { "inter", "trans", "pre", "con", "re",
+                                   "under", "over", "de", "un", "sub" };
+    uint64_t seed = 0x2545f4914f6cdd1dULL;
+    char tmp[32];
+    buffer_array_clear(ba);
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t r = bench_rand(&seed);
+        const int len = snprintf(tmp, sizeof(tmp), "%s%c%c%u", stems[r % 10],
+                                 (char) ('a' + (r >> 8) % 26),
+                                 (char) ('a' + (r >> 16) % 26),
+                                 (unsigned) ((r >> 24) % 1000));
+        buffer_push_bytes(buffer_array_emplace(ba), (unsigned char *) tmp,
+                          (size_t) len);
+    }
+}
+
+int main(int argc, const char **argv) {
+
+    const size_t n = bench_arg(argc, argv, "-n", 5000000);
+    const size_t maxThreads = bench_arg(argc, argv, "-threads", 8);
+
+    BufferArray ba;
+    buffer_array_init(&ba);
+    buffer_array_reserve(&ba, n);
+
+    fill(&ba, n);
+    double start = bench_now();
+    qsort(ba.array.data, n, sizeof(Buffer), buffer_cmp_bytes);
+    bench_report("qsort buffer_cmp_bytes", n, bench_now() - start);
+
+    fill(&ba, n);
+    start = bench_now();
+    qsort(ba.array.data, n, sizeof(Buffer), buffer_cmp);
+    bench_report("qsort buffer_cmp", n, bench_now() - start);
+
+    fill(&ba, n);
+    start = bench_now();
+    if (!buffer_array_sort(&ba, BUFFER_ARRAY_ORDER_BYTES, NULL)) return 5;
+    bench_report("buffer_array_sort bytes", n, bench_now() - start);
+
+    fill(&ba, n);
+    start = bench_now();
+    if (!buffer_array_sort(&ba, BUFFER_ARRAY_ORDER_LENGTH, NULL)) return 5;
+    bench_report("buffer_array_sort length", n, bench_now() - start);
+
+    char name[64];
+    for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+        ThreadPool tp;
+        if (!threadpool_init(&tp, threads)) return 5;
+        fill(&ba, n);
+        start = bench_now();
+        if (!buffer_array_sort(&ba, BUFFER_ARRAY_ORDER_BYTES, &tp)) return 5;
+        snprintf(name, sizeof(name), "buffer_array_sort %zu threads", threads);
+        bench_report(name, n, bench_now() - start);
+        threadpool_free(&tp);
+    }
+
+    buffer_array_free(&ba);
+    return 0;
+}
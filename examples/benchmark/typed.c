@@ -0,0 +1,128 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+/*
+ * word counting with the generic Buffer valued HashTable versus a typed
+ * ShortString -> size_t table, and uint64_t -> uint32_t lookups on both
+ *
+ * typedBench -vocab [distinct words] -tokens [tokens counted]
+*/
+
+#include <malloc.h>
+#include "bench.h"
+#include "../../src/hashtable.h"
+#include "../../src/typedhashtable.h"
+
+TYPED_HASHTABLE_DEFINE(WordCountTable, ShortString, size_t,
+                       typed_hash_short_string, typed_equal_short_string)
+
+TYPED_HASHTABLE_DEFINE(U64U32Table, uint64_t, uint32_t, typed_hash_u64,
+                       typed_equal_u64)
+
+static size_t heap_in_use(void) {
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+int main(int argc, const char **argv) {
+
+    const size_t vocab = bench_arg(argc, argv, "-vocab", 100003);
+    const size_t tokens = bench_arg(argc, argv, "-tokens", 4000000);
+
+    // the token stream, words drawn at random from the vocabulary
+    Buffer *stream = malloc(sizeof(Buffer) * tokens);
+    if (NULL == stream) return 5;
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    char tmp[32];
+    for (size_t i = 0; i < tokens; ++i) {
+        buffer_init(&stream[i]);
+        snprintf(tmp, sizeof(tmp), "w%llu",
+                 (unsigned long long) (bench_rand(&seed) % vocab));
+        buffer_push_bytes(&stream[i], (unsigned char *) tmp, strlen(tmp));
+    }
+
+    size_t heap = heap_in_use();
+    HashTable ht;
+    hashtable_init(&ht);
+    if (!hashtable_set_size(&ht, vocab)) return 5;
+    Buffer zero;
+    buffer_init(&zero);
+    const size_t z = 0;
+    buffer_push_bytes(&zero, (unsigned char *) &z, sizeof(z));
+
+    double start = bench_now();
+    for (size_t i = 0; i < tokens; ++i) {
+        Buffer *count = hashtable_get(&ht, &stream[i]);
+        if (NULL == count) {
+            if (!hashtable_add(&ht, &stream[i], &zero)) return 5;
+            count = hashtable_get(&ht, &stream[i]);
+        }
+        ++*(size_t *) count->data;
+    }
+    bench_report("HashTable word count", tokens, bench_now() - start);
+    printf("HashTable memory     %8.1f bytes/word\n",
+           (double) (heap_in_use() - heap) / hashtable_get_entry_count(&ht));
+
+    heap = heap_in_use();
+    WordCountTable wc;
+    WordCountTable_init(&wc);
+    start = bench_now();
+    for (size_t i = 0; i < tokens; ++i) {
+        ShortString ss;
+        short_string_from_buffer(&ss, &stream[i]);
+        size_t *count = WordCountTable_get_or_add(&wc, ss, 0);
+        if (NULL == count) return 5;
+        ++*count;
+    }
+    bench_report("typed word count", tokens, bench_now() - start);
+    printf("typed memory         %8.1f bytes/word\n",
+           (double) (heap_in_use() - heap) / WordCountTable_get_entry_count(&wc));
+
+    // integer keys, every lookup hits
+    U64U32Table ints;
+    U64U32Table_init(&ints);
+    HashTable intTable;
+    hashtable_init(&intTable);
+    if (!hashtable_set_size(&intTable, vocab)) return 5;
+    Buffer key, value;
+    buffer_init(&key);
+    buffer_init(&value);
+    for (uint64_t i = 0; i < vocab; ++i) {
+        const uint32_t v = (uint32_t) i;
+        U64U32Table_put(&ints, i, v);
+        buffer_clear(&key);
+        buffer_clear(&value);
+        buffer_push_bytes(&key, (unsigned char *) &i, sizeof(i));
+        buffer_push_bytes(&value, (unsigned char *) &v, sizeof(v));
+        hashtable_add(&intTable, &key, &value);
+    }
+
+    size_t sum = 0;
+    start = bench_now();
+    for (size_t i = 0; i < tokens; ++i) {
+        const uint64_t k = bench_rand(&seed) % vocab;
+        buffer_clear(&key);
+        buffer_push_bytes(&key, (unsigned char *) &k, sizeof(k));
+        sum += *(uint32_t *) hashtable_get(&intTable, &key)->data;
+    }
+    bench_report("HashTable u64 -> u32 get", tokens, bench_now() - start);
+
+    start = bench_now();
+    for (size_t i = 0; i < tokens; ++i) {
+        sum -= *U64U32Table_get(&ints, bench_rand(&seed) % vocab);
+    }
+    bench_report("typed u64 -> u32 get", tokens, bench_now() - start);
+    printf("checksum %zu\n", sum);
+
+    for (size_t i = 0; i < tokens; ++i) buffer_free(&stream[i]);
+    free(stream);
+    WordCountTable_free(&wc);
+    U64U32Table_free(&ints);
+    hashtable_free(&ht);
+    hashtable_free(&intTable);
+    buffer_free(&zero);
+    buffer_free(&key);
+    buffer_free(&value);
+    return 0;
+}
@@ -0,0 +1,1016 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#include <assert.h>
+#include <string.h>
+#include "art.h"
+#include "log.h"
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define ART_SSE2
+#endif
+
+#define ART_NODE4 0
+#define ART_NODE16 1
+#define ART_NODE48 2
+#define ART_NODE256 3
+
+// size classes are this many bytes apart
+#define ART_CLASS_BYTES 16
+
+// bytes in each slab nodes and leaves are carved from
+#define ART_SLAB_BYTES 65536
+
+// what stops an iterator early
+#define ART_BOUND_NONE 0
+#define ART_BOUND_PREFIX 1
+#define ART_BOUND_BELOW 2
+
+/* every node starts with this header, [leaf] holds the key ending exactly
+ * where the node's prefix ends, if there is one.  Children and leaves are
+ * told apart by the low bit of their pointer, which is set for leaves
+ */
+typedef struct stArtNode {
+    uint8_t type;
+    uint16_t count;
+    uint32_t prefixLen;
+    unsigned char prefix[ART_MAX_PREFIX];
+    void *leaf;
+} ArtNode;
+
+typedef struct stArtNode4 {
+    ArtNode n;
+    unsigned char keys[4];
+    void *children[4];
+} ArtNode4;
+
+typedef struct stArtNode16 {
+    ArtNode n;
+    unsigned char keys[16];
+    void *children[16];
+} ArtNode16;
+
+// index holds one more than the slot of each byte's child, 0 when absent
+typedef struct stArtNode48 {
+    ArtNode n;
+    unsigned char index[256];
+    void *children[48];
+} ArtNode48;
+
+typedef struct stArtNode256 {
+    ArtNode n;
+    void *children[256];
+} ArtNode256;
+
+typedef struct stArtLeaf {
+    uint64_t value;
+    size_t len;
+    unsigned char key[];
+} ArtLeaf;
+
+typedef struct stArtFrame {
+    const void *node;
+    int pos;
+} ArtFrame;
+
+static const size_t art_node_bytes[] = {
+        sizeof(ArtNode4), sizeof(ArtNode16), sizeof(ArtNode48),
+        sizeof(ArtNode256)
+};
+
+static bool art_is_leaf(const void *p) {
+    return 0 != ((uintptr_t) p & 1);
+}
+
+static ArtLeaf * art_leaf(const void *p) {
+    return (ArtLeaf *) ((uintptr_t) p & ~(uintptr_t) 1);
+}
+
+static void * art_tag(ArtLeaf *l) {
+    return (void *) ((uintptr_t) l | 1);
+}
+
+static size_t art_min(size_t a, size_t b) {
+    return a < b ? a : b;
+}
+
+static bool art_leaf_matches(const ArtLeaf *l, const unsigned char *key,
+                             size_t len) {
+    return l->len == len && (0 == len || 0 == memcmp(l->key, key, len));
+}
+
+// byte order of the key of leaf [l] against [len] bytes at [key]
+static int art_leaf_cmp(const ArtLeaf *l, const unsigned char *key,
+                        size_t len) {
+    const size_t n = art_min(l->len, len);
+    const int c = 0 == n ? 0 : memcmp(l->key, key, n);
+    if(0 != c) return c;
+    return l->len < len ? -1 : l->len > len;
+}
+
+static size_t art_class(size_t bytes) {
+    return (bytes + ART_CLASS_BYTES - 1) / ART_CLASS_BYTES;
+}
+
+static bool art_new_slab(Art *art) {
+    if(art->slabCount == art->slabCap) {
+        const size_t cap = 0 == art->slabCap ? 16 : art->slabCap * 2;
+        void **slabs = realloc(art->slabs, cap * sizeof(void *));
+        if(NULL == slabs) {
+            log_message("Unable to track %zu tree slabs", cap);
+            return false;
+        }
+        art->slabs = slabs;
+        art->slabCap = cap;
+    }
+    void *slab = NULL != art->recycler ?
+                 recycler_get_exact(art->recycler, ART_SLAB_BYTES) :
+                 malloc(ART_SLAB_BYTES);
+    if(NULL == slab) {
+        log_message("Unable to allocate a %d byte tree slab", ART_SLAB_BYTES);
+        return false;
+    }
+    art->slabs[art->slabCount++] = slab;
+    art->slabNext = slab;
+    art->slabLeft = ART_SLAB_BYTES;
+    return true;
+}
+
+// allocate [bytes] from the free list of their size class, or the current
+// slab.  Anything too big for a size class is allocated on its own
+static void * art_alloc(Art *art, size_t bytes) {
+    const size_t c = art_class(bytes);
+    void *p;
+    if(c >= ART_SIZE_CLASSES) {
+        p = NULL != art->recycler ? recycler_get_exact(art->recycler, bytes)
+                                  : malloc(bytes);
+        if(NULL == p) log_message("Unable to allocate %zu tree bytes", bytes);
+        else art->largeBytes += bytes;
+        return p;
+    }
+    p = art->freeList[c];
+    if(NULL != p) {
+        art->freeList[c] = *(void **) p;
+        return p;
+    }
+    const size_t size = c * ART_CLASS_BYTES;
+    if(art->slabLeft < size && !art_new_slab(art)) return NULL;
+    p = art->slabNext;
+    art->slabNext += size;
+    art->slabLeft -= size;
+    return p;
+}
+
+static void art_release(Art *art, void *p, size_t bytes) {
+    const size_t c = art_class(bytes);
+    if(c >= ART_SIZE_CLASSES) {
+        if(NULL != art->recycler) recycler_return(art->recycler, bytes, p);
+        else free(p);
+        art->largeBytes -= bytes;
+        return;
+    }
+    *(void **) p = art->freeList[c];
+    art->freeList[c] = p;
+}
+
+static ArtLeaf * art_leaf_new(Art *art, const unsigned char *key, size_t len,
+                              uint64_t value) {
+    ArtLeaf *l = art_alloc(art, sizeof(ArtLeaf) + len);
+    if(NULL == l) return NULL;
+    l->value = value;
+    l->len = len;
+    if(len > 0) memcpy(l->key, key, len);
+    return l;
+}
+
+static void art_leaf_release(Art *art, ArtLeaf *l) {
+    art_release(art, l, sizeof(ArtLeaf) + l->len);
+}
+
+static ArtNode * art_node_new(Art *art, uint8_t type) {
+    ArtNode *n = art_alloc(art, art_node_bytes[type]);
+    if(NULL == n) return NULL;
+    memset(n, 0, art_node_bytes[type]);
+    n->type = type;
+    return n;
+}
+
+static void art_node_release(Art *art, ArtNode *n) {
+    art_release(art, n, art_node_bytes[n->type]);
+}
+
+static void art_copy_header(ArtNode *dest, const ArtNode *src) {
+    dest->count = src->count;
+    dest->prefixLen = src->prefixLen;
+    memcpy(dest->prefix, src->prefix, ART_MAX_PREFIX);
+    dest->leaf = src->leaf;
+}
+
+// position of the first key of a Node16 greater than [c]
+static unsigned art_node16_upper(const ArtNode16 *p, unsigned char c) {
+#if defined(ART_SSE2)
+    // SSE2 only compares signed bytes, flipping the top bit orders them
+    const __m128i flip = _mm_set1_epi8((char) 0x80);
+    const __m128i keys = _mm_xor_si128(
+            _mm_loadu_si128((const __m128i *) p->keys), flip);
+    const __m128i key = _mm_xor_si128(_mm_set1_epi8((char) c), flip);
+    const unsigned mask = (unsigned) _mm_movemask_epi8(
+            _mm_cmplt_epi8(key, keys)) & ((1u << p->n.count) - 1);
+    return 0 != mask ? (unsigned) __builtin_ctz(mask) : p->n.count;
+#else
+    unsigned i = 0;
+    while(i < p->n.count && p->keys[i] <= c) ++i;
+    return i;
+#endif
+}
+
+static void ** art_find_child(ArtNode *n, unsigned char c) {
+    switch(n->type) {
+        case ART_NODE4: {
+            ArtNode4 *p = (ArtNode4 *) n;
+            for(unsigned i=0; i<n->count; ++i)
+                if(p->keys[i] == c) return &p->children[i];
+            return NULL;
+        }
+        case ART_NODE16: {
+            ArtNode16 *p = (ArtNode16 *) n;
+#if defined(ART_SSE2)
+            const __m128i cmp = _mm_cmpeq_epi8(
+                    _mm_set1_epi8((char) c),
+                    _mm_loadu_si128((const __m128i *) p->keys));
+            const unsigned mask = (unsigned) _mm_movemask_epi8(cmp) &
+                                  ((1u << n->count) - 1);
+            return 0 != mask ? &p->children[__builtin_ctz(mask)] : NULL;
+#else
+            for(unsigned i=0; i<n->count; ++i)
+                if(p->keys[i] == c) return &p->children[i];
+            return NULL;
+#endif
+        }
+        case ART_NODE48: {
+            ArtNode48 *p = (ArtNode48 *) n;
+            return 0 != p->index[c] ? &p->children[p->index[c] - 1] : NULL;
+        }
+        default: {
+            ArtNode256 *p = (ArtNode256 *) n;
+            return NULL != p->children[c] ? &p->children[c] : NULL;
+        }
+    }
+}
+
+// iteration position just past the child of [n] for byte [c]
+static int art_upper_pos(const ArtNode *n, unsigned char c) {
+    switch(n->type) {
+        case ART_NODE4: {
+            const ArtNode4 *p = (const ArtNode4 *) n;
+            int i = 0;
+            while(i < n->count && p->keys[i] <= c) ++i;
+            return i;
+        }
+        case ART_NODE16:
+            return (int) art_node16_upper((const ArtNode16 *) n, c);
+        default:
+            return c + 1;
+    }
+}
+
+// the first child of [n] at or after iteration position [pos], which is
+// moved past it.  returns NULL once there are no more children
+static void * art_next_child(const ArtNode *n, int *pos) {
+    switch(n->type) {
+        case ART_NODE4:
+            if(*pos >= n->count) return NULL;
+            return ((const ArtNode4 *) n)->children[(*pos)++];
+        case ART_NODE16:
+            if(*pos >= n->count) return NULL;
+            return ((const ArtNode16 *) n)->children[(*pos)++];
+        case ART_NODE48: {
+            const ArtNode48 *p = (const ArtNode48 *) n;
+            for(int b = *pos; b < 256; ++b) {
+                if(0 != p->index[b]) {
+                    *pos = b + 1;
+                    return p->children[p->index[b] - 1];
+                }
+            }
+            *pos = 256;
+            return NULL;
+        }
+        default: {
+            const ArtNode256 *p = (const ArtNode256 *) n;
+            for(int b = *pos; b < 256; ++b) {
+                if(NULL != p->children[b]) {
+                    *pos = b + 1;
+                    return p->children[b];
+                }
+            }
+            *pos = 256;
+            return NULL;
+        }
+    }
+}
+
+// the leftmost leaf below [p], every leaf below a node shares its prefix
+static const ArtLeaf * art_minimum(const void *p) {
+    while(!art_is_leaf(p)) {
+        const ArtNode *n = p;
+        if(NULL != n->leaf) return art_leaf(n->leaf);
+        int pos = 0;
+        p = art_next_child(n, &pos);
+    }
+    return art_leaf(p);
+}
+
+// number of leading bytes of the prefix of [n] matching the key at [depth],
+// at most the prefix length or what is left of the key
+static size_t art_prefix_match(const ArtNode *n, const unsigned char *key,
+                               size_t len, size_t depth) {
+    const size_t max = art_min(n->prefixLen, len - depth);
+    const size_t stored = art_min(max, ART_MAX_PREFIX);
+    size_t i;
+    for(i=0; i<stored; ++i)
+        if(n->prefix[i] != key[depth + i]) return i;
+    if(i < max) {
+        const ArtLeaf *l = art_minimum(n);
+        for(; i<max; ++i)
+            if(l->key[depth + i] != key[depth + i]) return i;
+    }
+    return i;
+}
+
+// byte [i] of the prefix of [n], which starts at [depth]
+static unsigned char art_prefix_byte(const ArtNode *n, size_t depth,
+                                     size_t i) {
+    if(i < ART_MAX_PREFIX) return n->prefix[i];
+    return art_minimum(n)->key[depth + i];
+}
+
+static void art_node4_add(ArtNode4 *p, unsigned char c, void *child) {
+    unsigned i = 0;
+    while(i < p->n.count && p->keys[i] < c) ++i;
+    memmove(p->keys + i + 1, p->keys + i, p->n.count - i);
+    memmove(p->children + i + 1, p->children + i,
+            (p->n.count - i) * sizeof(void *));
+    p->keys[i] = c;
+    p->children[i] = child;
+    ++p->n.count;
+}
+
+// add [child] under byte [c] of [n], which [ref] points to, moving to the
+// next bigger node type when [n] is full
+static bool art_add_child(Art *art, void **ref, ArtNode *n, unsigned char c,
+                          void *child) {
+    switch(n->type) {
+        case ART_NODE4: {
+            ArtNode4 *p = (ArtNode4 *) n;
+            if(n->count < 4) {
+                art_node4_add(p, c, child);
+                return true;
+            }
+            ArtNode16 *g = (ArtNode16 *) art_node_new(art, ART_NODE16);
+            if(NULL == g) return false;
+            art_copy_header(&g->n, n);
+            memcpy(g->keys, p->keys, 4);
+            memcpy(g->children, p->children, 4 * sizeof(void *));
+            *ref = g;
+            art_node_release(art, n);
+            return art_add_child(art, ref, &g->n, c, child);
+        }
+        case ART_NODE16: {
+            ArtNode16 *p = (ArtNode16 *) n;
+            if(n->count < 16) {
+                const unsigned i = art_node16_upper(p, c);
+                memmove(p->keys + i + 1, p->keys + i, n->count - i);
+                memmove(p->children + i + 1, p->children + i,
+                        (n->count - i) * sizeof(void *));
+                p->keys[i] = c;
+                p->children[i] = child;
+                ++n->count;
+                return true;
+            }
+            ArtNode48 *g = (ArtNode48 *) art_node_new(art, ART_NODE48);
+            if(NULL == g) return false;
+            art_copy_header(&g->n, n);
+            for(unsigned i=0; i<16; ++i) {
+                g->index[p->keys[i]] = (unsigned char) (i + 1);
+                g->children[i] = p->children[i];
+            }
+            *ref = g;
+            art_node_release(art, n);
+            return art_add_child(art, ref, &g->n, c, child);
+        }
+        case ART_NODE48: {
+            ArtNode48 *p = (ArtNode48 *) n;
+            if(n->count < 48) {
+                // slots are kept packed so the next free one is count
+                p->children[n->count] = child;
+                p->index[c] = (unsigned char) (++n->count);
+                return true;
+            }
+            ArtNode256 *g = (ArtNode256 *) art_node_new(art, ART_NODE256);
+            if(NULL == g) return false;
+            art_copy_header(&g->n, n);
+            for(unsigned b=0; b<256; ++b)
+                if(0 != p->index[b]) g->children[b] = p->children[p->index[b] - 1];
+            *ref = g;
+            art_node_release(art, n);
+            return art_add_child(art, ref, &g->n, c, child);
+        }
+        default: {
+            ArtNode256 *p = (ArtNode256 *) n;
+            p->children[c] = child;
+            ++n->count;
+            return true;
+        }
+    }
+}
+
+// fold a Node4 left with one child and no leaf into that child
+static void art_collapse(Art *art, void **ref, ArtNode4 *p) {
+    void *child = p->children[0];
+    if(!art_is_leaf(child)) {
+        ArtNode *c = child;
+        unsigned char prefix[ART_MAX_PREFIX];
+        size_t len = art_min(p->n.prefixLen, ART_MAX_PREFIX);
+        memcpy(prefix, p->n.prefix, len);
+        if(len < ART_MAX_PREFIX) prefix[len++] = p->keys[0];
+        if(len < ART_MAX_PREFIX) {
+            const size_t more = art_min(c->prefixLen, ART_MAX_PREFIX - len);
+            memcpy(prefix + len, c->prefix, more);
+            len += more;
+        }
+        memcpy(c->prefix, prefix, len);
+        c->prefixLen += p->n.prefixLen + 1;
+    }
+    *ref = child;
+    art_node_release(art, &p->n);
+}
+
+// move [n] down to a smaller node type once it has few enough children,
+// staying put if memory for the smaller node can not be found
+static void art_shrink(Art *art, void **ref, ArtNode *n) {
+    switch(n->type) {
+        case ART_NODE4: {
+            ArtNode4 *p = (ArtNode4 *) n;
+            if(1 == n->count && NULL == n->leaf) {
+                art_collapse(art, ref, p);
+            } else if(0 == n->count) {
+                *ref = n->leaf;
+                art_node_release(art, n);
+            }
+            return;
+        }
+        case ART_NODE16: {
+            ArtNode16 *p = (ArtNode16 *) n;
+            if(n->count > 3) return;
+            ArtNode4 *s = (ArtNode4 *) art_node_new(art, ART_NODE4);
+            if(NULL == s) return;
+            art_copy_header(&s->n, n);
+            memcpy(s->keys, p->keys, n->count);
+            memcpy(s->children, p->children, n->count * sizeof(void *));
+            *ref = s;
+            art_node_release(art, n);
+            return;
+        }
+        case ART_NODE48: {
+            ArtNode48 *p = (ArtNode48 *) n;
+            if(n->count > 12) return;
+            ArtNode16 *s = (ArtNode16 *) art_node_new(art, ART_NODE16);
+            if(NULL == s) return;
+            art_copy_header(&s->n, n);
+            unsigned i = 0;
+            for(unsigned b=0; b<256; ++b) {
+                if(0 == p->index[b]) continue;
+                s->keys[i] = (unsigned char) b;
+                s->children[i++] = p->children[p->index[b] - 1];
+            }
+            *ref = s;
+            art_node_release(art, n);
+            return;
+        }
+        default: {
+            ArtNode256 *p = (ArtNode256 *) n;
+            if(n->count > 37) return;
+            ArtNode48 *s = (ArtNode48 *) art_node_new(art, ART_NODE48);
+            if(NULL == s) return;
+            art_copy_header(&s->n, n);
+            unsigned i = 0;
+            for(unsigned b=0; b<256; ++b) {
+                if(NULL == p->children[b]) continue;
+                s->children[i] = p->children[b];
+                s->index[b] = (unsigned char) ++i;
+            }
+            *ref = s;
+            art_node_release(art, n);
+            return;
+        }
+    }
+}
+
+// take the child for byte [c] out of [n], which [ref] points to
+static void art_remove_child(Art *art, void **ref, ArtNode *n,
+                             unsigned char c) {
+    switch(n->type) {
+        case ART_NODE4:
+        case ART_NODE16: {
+            unsigned char *keys = ART_NODE4 == n->type ?
+                                  ((ArtNode4 *) n)->keys :
+                                  ((ArtNode16 *) n)->keys;
+            void **children = ART_NODE4 == n->type ?
+                              ((ArtNode4 *) n)->children :
+                              ((ArtNode16 *) n)->children;
+            unsigned i = 0;
+            while(keys[i] != c) ++i;
+            memmove(keys + i, keys + i + 1, n->count - i - 1);
+            memmove(children + i, children + i + 1,
+                    (n->count - i - 1) * sizeof(void *));
+            --n->count;
+            break;
+        }
+        case ART_NODE48: {
+            ArtNode48 *p = (ArtNode48 *) n;
+            const unsigned slot = p->index[c] - 1u;
+            const unsigned last = n->count - 1u;
+            p->index[c] = 0;
+            // keep the slots packed by moving the last one into the hole
+            if(slot != last) {
+                p->children[slot] = p->children[last];
+                for(unsigned b=0; b<256; ++b) {
+                    if(p->index[b] == last + 1) {
+                        p->index[b] = (unsigned char) (slot + 1);
+                        break;
+                    }
+                }
+            }
+            p->children[last] = NULL;
+            --n->count;
+            break;
+        }
+        default:
+            ((ArtNode256 *) n)->children[c] = NULL;
+            --n->count;
+            break;
+    }
+    art_shrink(art, ref, n);
+}
+
+void art_init(Art *art) {
+    assert(NULL != art);
+    art->root = NULL;
+    art->count = 0;
+    for(size_t i=0; i<ART_SIZE_CLASSES; ++i) art->freeList[i] = NULL;
+    art->slabs = NULL;
+    art->slabCount = 0;
+    art->slabCap = 0;
+    art->slabNext = NULL;
+    art->slabLeft = 0;
+    art->largeBytes = 0;
+    art->recycler = NULL;
+}
+
+void art_assign_recycler(Art *art, Recycler *rc) {
+    assert(NULL != art);
+    art->recycler = rc;
+}
+
+// hand back the leaves too big for a size class, the rest go with the slabs
+static void art_free_large(Art *art, void *p) {
+    if(NULL == p) return;
+    if(art_is_leaf(p)) {
+        ArtLeaf *l = art_leaf(p);
+        if(art_class(sizeof(ArtLeaf) + l->len) >= ART_SIZE_CLASSES)
+            art_leaf_release(art, l);
+        return;
+    }
+    const ArtNode *n = p;
+    art_free_large(art, n->leaf);
+    int pos = 0;
+    void *child;
+    while(NULL != (child = art_next_child(n, &pos)))
+        art_free_large(art, child);
+}
+
+void art_free(Art *art) {
+    assert(NULL != art);
+
+    if(0 != art->largeBytes) art_free_large(art, art->root);
+    for(size_t i=0; i<art->slabCount; ++i) {
+        if(NULL != art->recycler)
+            recycler_return(art->recycler, ART_SLAB_BYTES, art->slabs[i]);
+        else
+            free(art->slabs[i]);
+    }
+    free(art->slabs);
+
+    Recycler *rc = art->recycler;
+    art_init(art);
+    art->recycler = rc;
+}
+
+size_t art_get_count(const Art *art) {
+    assert(NULL != art);
+    return art->count;
+}
+
+static bool art_insert_at(Art *art, void **ref, const unsigned char *key,
+                          size_t len, size_t depth, uint64_t value,
+                          bool *added) {
+    void *p = *ref;
+    ArtLeaf *nl;
+
+    if(NULL == p) {
+        if(NULL == (nl = art_leaf_new(art, key, len, value))) return false;
+        *ref = art_tag(nl);
+        *added = true;
+        return true;
+    }
+
+    if(art_is_leaf(p)) {
+        ArtLeaf *l = art_leaf(p);
+        if(art_leaf_matches(l, key, len)) {
+            l->value = value;
+            return true;
+        }
+        // both keys hang off a new node holding the bytes they share
+        if(NULL == (nl = art_leaf_new(art, key, len, value))) return false;
+        ArtNode4 *s = (ArtNode4 *) art_node_new(art, ART_NODE4);
+        if(NULL == s) {
+            art_leaf_release(art, nl);
+            return false;
+        }
+        size_t common = depth;
+        const size_t limit = art_min(l->len, len);
+        while(common < limit && l->key[common] == key[common]) ++common;
+        s->n.prefixLen = (uint32_t) (common - depth);
+        memcpy(s->n.prefix, key + depth,
+               art_min(s->n.prefixLen, ART_MAX_PREFIX));
+        if(l->len == common) s->n.leaf = p;
+        else art_node4_add(s, l->key[common], p);
+        if(len == common) s->n.leaf = art_tag(nl);
+        else art_node4_add(s, key[common], art_tag(nl));
+        *ref = s;
+        *added = true;
+        return true;
+    }
+
+    ArtNode *n = p;
+    if(0 != n->prefixLen) {
+        const size_t m = art_prefix_match(n, key, len, depth);
+        if(m < n->prefixLen) {
+            // the key leaves the prefix part way, split it at that byte
+            if(NULL == (nl = art_leaf_new(art, key, len, value)))
+                return false;
+            ArtNode4 *s = (ArtNode4 *) art_node_new(art, ART_NODE4);
+            if(NULL == s) {
+                art_leaf_release(art, nl);
+                return false;
+            }
+            s->n.prefixLen = (uint32_t) m;
+            memcpy(s->n.prefix, n->prefix, art_min(m, ART_MAX_PREFIX));
+            const unsigned char c = art_prefix_byte(n, depth, m);
+            if(n->prefixLen <= ART_MAX_PREFIX) {
+                n->prefixLen -= (uint32_t) (m + 1);
+                memmove(n->prefix, n->prefix + m + 1, n->prefixLen);
+            } else {
+                const ArtLeaf *ml = art_minimum(n);
+                n->prefixLen -= (uint32_t) (m + 1);
+                memcpy(n->prefix, ml->key + depth + m + 1,
+                       art_min(n->prefixLen, ART_MAX_PREFIX));
+            }
+            art_node4_add(s, c, n);
+            if(len == depth + m) s->n.leaf = art_tag(nl);
+            else art_node4_add(s, key[depth + m], art_tag(nl));
+            *ref = s;
+            *added = true;
+            return true;
+        }
+        depth += n->prefixLen;
+    }
+
+    if(len == depth) {
+        if(NULL != n->leaf) {
+            art_leaf(n->leaf)->value = value;
+            return true;
+        }
+        if(NULL == (nl = art_leaf_new(art, key, len, value))) return false;
+        n->leaf = art_tag(nl);
+        *added = true;
+        return true;
+    }
+
+    void **child = art_find_child(n, key[depth]);
+    if(NULL != child)
+        return art_insert_at(art, child, key, len, depth + 1, value, added);
+
+    if(NULL == (nl = art_leaf_new(art, key, len, value))) return false;
+    if(!art_add_child(art, ref, n, key[depth], art_tag(nl))) {
+        art_leaf_release(art, nl);
+        return false;
+    }
+    *added = true;
+    return true;
+}
+
+bool art_insert_bytes(Art *art, const unsigned char *data, size_t len,
+                      uint64_t value, bool *added) {
+    assert(NULL != art);
+    assert(NULL != data || 0 == len);
+
+    bool isNew = false;
+    if(!art_insert_at(art, &art->root, data, len, 0, value, &isNew))
+        return false;
+    if(isNew) ++art->count;
+    if(NULL != added) *added = isNew;
+    return true;
+}
+
+bool art_insert(Art *art, const Buffer *key, uint64_t value, bool *added) {
+    assert(NULL != key);
+    return art_insert_bytes(art, key->data, key->len, value, added);
+}
+
+bool art_get_bytes(const Art *art, const unsigned char *data, size_t len,
+                   uint64_t *value) {
+    assert(NULL != art);
+    assert(NULL != data || 0 == len);
+
+    const void *p = art->root;
+    size_t depth = 0;
+    const ArtLeaf *l = NULL;
+
+    // only the stored prefix bytes are checked on the way down, the leaf
+    // reached is compared whole
+    while(NULL != p) {
+        if(art_is_leaf(p)) {
+            l = art_leaf(p);
+            break;
+        }
+        const ArtNode *n = p;
+        if(0 != n->prefixLen) {
+            if(len - depth < n->prefixLen) return false;
+            if(0 != memcmp(n->prefix, data + depth,
+                           art_min(n->prefixLen, ART_MAX_PREFIX)))
+                return false;
+            depth += n->prefixLen;
+        }
+        if(len == depth) {
+            if(NULL != n->leaf) l = art_leaf(n->leaf);
+            break;
+        }
+        void **child = art_find_child((ArtNode *) n, data[depth]);
+        if(NULL == child) return false;
+        p = *child;
+        ++depth;
+    }
+
+    if(NULL == l || !art_leaf_matches(l, data, len)) return false;
+    if(NULL != value) *value = l->value;
+    return true;
+}
+
+bool art_get(const Art *art, const Buffer *key, uint64_t *value) {
+    assert(NULL != key);
+    return art_get_bytes(art, key->data, key->len, value);
+}
+
+static bool art_remove_at(Art *art, void **ref, const unsigned char *key,
+                          size_t len, size_t depth) {
+    void *p = *ref;
+    if(NULL == p) return false;
+
+    if(art_is_leaf(p)) {
+        ArtLeaf *l = art_leaf(p);
+        if(!art_leaf_matches(l, key, len)) return false;
+        *ref = NULL;
+        art_leaf_release(art, l);
+        return true;
+    }
+
+    ArtNode *n = p;
+    if(0 != n->prefixLen) {
+        if(len - depth < n->prefixLen) return false;
+        if(0 != memcmp(n->prefix, key + depth,
+                       art_min(n->prefixLen, ART_MAX_PREFIX)))
+            return false;
+        depth += n->prefixLen;
+    }
+
+    if(len == depth) {
+        if(NULL == n->leaf || !art_leaf_matches(art_leaf(n->leaf), key, len))
+            return false;
+        art_leaf_release(art, art_leaf(n->leaf));
+        n->leaf = NULL;
+        art_shrink(art, ref, n);
+        return true;
+    }
+
+    const unsigned char c = key[depth];
+    void **child = art_find_child(n, c);
+    if(NULL == child || !art_remove_at(art, child, key, len, depth + 1))
+        return false;
+    if(NULL == *child) art_remove_child(art, ref, n, c);
+    return true;
+}
+
+bool art_remove_bytes(Art *art, const unsigned char *data, size_t len) {
+    assert(NULL != art);
+    assert(NULL != data || 0 == len);
+
+    if(!art_remove_at(art, &art->root, data, len, 0)) return false;
+    --art->count;
+    return true;
+}
+
+bool art_remove(Art *art, const Buffer *key) {
+    assert(NULL != key);
+    return art_remove_bytes(art, key->data, key->len);
+}
+
+size_t art_get_memory(const Art *art) {
+    assert(NULL != art);
+    return art->slabCount * ART_SLAB_BYTES + art->largeBytes +
+           art->slabCap * sizeof(void *);
+}
+
+static void art_count(const void *p, size_t depth, ArtStats *stats) {
+    if(NULL == p) return;
+    if(depth > stats->maxDepth) stats->maxDepth = depth;
+    if(art_is_leaf(p)) {
+        ++stats->leaves;
+        return;
+    }
+    const ArtNode *n = p;
+    switch(n->type) {
+        case ART_NODE4: ++stats->node4; break;
+        case ART_NODE16: ++stats->node16; break;
+        case ART_NODE48: ++stats->node48; break;
+        default: ++stats->node256; break;
+    }
+    art_count(n->leaf, depth + 1, stats);
+    int pos = 0;
+    void *child;
+    while(NULL != (child = art_next_child(n, &pos)))
+        art_count(child, depth + 1, stats);
+}
+
+void art_get_stats(const Art *art, ArtStats *stats) {
+    assert(NULL != art);
+    assert(NULL != stats);
+    memset(stats, 0, sizeof(ArtStats));
+    art_count(art->root, 0, stats);
+}
+
+static bool art_iterator_push(ArtIterator *it, const void *node, int pos) {
+    const size_t need = (it->depth + 1) * sizeof(ArtFrame);
+    if(need > it->stack.cap) {
+        // reserve only keeps the bytes counted by len
+        it->stack.len = it->depth * sizeof(ArtFrame);
+        if(!buffer_reserve(&it->stack, (unsigned int) (need * 2))) {
+            log_message("Unable to allocate an iterator %zu deep",
+                        it->depth + 1);
+            return false;
+        }
+    }
+    ArtFrame *f = (ArtFrame *) it->stack.data + it->depth++;
+    f->node = node;
+    f->pos = pos;
+    return true;
+}
+
+// stack up the path to the first key not less than the [len] bytes at [key]
+static bool art_iterator_lower(ArtIterator *it, const unsigned char *key,
+                               size_t len) {
+    const void *p = it->art->root;
+    size_t depth = 0;
+    it->depth = 0;
+
+    while(NULL != p) {
+        if(art_is_leaf(p)) {
+            if(art_leaf_cmp(art_leaf(p), key, len) >= 0)
+                return art_iterator_push(it, p, -1);
+            return true;
+        }
+        const ArtNode *n = p;
+        if(0 != n->prefixLen) {
+            const size_t m = art_prefix_match(n, key, len, depth);
+            if(m < n->prefixLen) {
+                // every key below n is greater when the key ran out inside
+                // the prefix or the prefix byte is greater, else all less
+                if(m == len - depth ||
+                   art_prefix_byte(n, depth, m) > key[depth + m])
+                    return art_iterator_push(it, n, -1);
+                return true;
+            }
+            depth += n->prefixLen;
+        }
+        if(len == depth) return art_iterator_push(it, n, -1);
+
+        const unsigned char c = key[depth];
+        if(!art_iterator_push(it, n, art_upper_pos(n, c))) return false;
+        void **child = art_find_child((ArtNode *) n, c);
+        if(NULL == child) return true;
+        p = *child;
+        ++depth;
+    }
+    return true;
+}
+
+void art_iterator_init(ArtIterator *it, const Art *art) {
+    assert(NULL != it);
+    assert(NULL != art);
+
+    it->art = art;
+    buffer_init(&it->stack);
+    buffer_init(&it->bound);
+    it->depth = 0;
+    it->boundKind = ART_BOUND_NONE;
+    art_iterator_seek_range(it, NULL, NULL);
+}
+
+bool art_iterator_seek(ArtIterator *it, const BufferView *key) {
+    assert(NULL != it);
+    assert(NULL != key);
+
+    it->boundKind = ART_BOUND_NONE;
+    return art_iterator_lower(it, key->data, key->len);
+}
+
+bool art_iterator_seek_prefix(ArtIterator *it, const BufferView *prefix) {
+    assert(NULL != it);
+    assert(NULL != prefix);
+
+    it->depth = 0;
+    if(!buffer_cpy_view(&it->bound, prefix)) return false;
+    it->boundKind = ART_BOUND_PREFIX;
+    return art_iterator_lower(it, prefix->data, prefix->len);
+}
+
+bool art_iterator_seek_range(ArtIterator *it, const BufferView *low,
+                             const BufferView *high) {
+    assert(NULL != it);
+
+    it->depth = 0;
+    it->boundKind = ART_BOUND_NONE;
+    if(NULL != high) {
+        if(!buffer_cpy_view(&it->bound, high)) return false;
+        it->boundKind = ART_BOUND_BELOW;
+    }
+    if(NULL == low) return art_iterator_lower(it, NULL, 0);
+    return art_iterator_lower(it, low->data, low->len);
+}
+
+// hand out leaf [l] unless it lies past the iterator's bound
+static bool art_iterator_yield(ArtIterator *it, const ArtLeaf *l,
+                               BufferView *key, uint64_t *value) {
+    bool inside = true;
+    if(ART_BOUND_PREFIX == it->boundKind) {
+        inside = l->len >= it->bound.len &&
+                 (0 == it->bound.len ||
+                  0 == memcmp(l->key, it->bound.data, it->bound.len));
+    } else if(ART_BOUND_BELOW == it->boundKind) {
+        inside = art_leaf_cmp(l, it->bound.data, it->bound.len) < 0;
+    }
+    if(!inside) {
+        it->depth = 0;
+        return false;
+    }
+    buffer_view_set(key, l->key, l->len);
+    if(NULL != value) *value = l->value;
+    return true;
+}
+
+bool art_iterator_next(ArtIterator *it, BufferView *key, uint64_t *value) {
+    assert(NULL != it);
+    assert(NULL != key);
+
+    while(it->depth > 0) {
+        ArtFrame *f = (ArtFrame *) it->stack.data + it->depth - 1;
+        if(art_is_leaf(f->node)) {
+            --it->depth;
+            return art_iterator_yield(it, art_leaf(f->node), key, value);
+        }
+        const ArtNode *n = f->node;
+        if(f->pos < 0) {
+            f->pos = 0;
+            if(NULL != n->leaf)
+                return art_iterator_yield(it, art_leaf(n->leaf), key, value);
+        }
+        const void *child = art_next_child(n, &f->pos);
+        if(NULL == child) {
+            --it->depth;
+        } else if(art_is_leaf(child)) {
+            return art_iterator_yield(it, art_leaf(child), key, value);
+        } else if(!art_iterator_push(it, child, -1)) {
+            return false;
+        }
+    }
+    return false;
+}
+
+void art_iterator_free(ArtIterator *it) {
+    assert(NULL != it);
+    buffer_free(&it->stack);
+    buffer_free(&it->bound);
+    it->depth = 0;
+}
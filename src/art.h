@@ -0,0 +1,160 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#ifndef SEARCHFILEC_ART_H
+#define SEARCHFILEC_ART_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "buffer.h"
+#include "recycler.h"
+
+/*
+ * Art
+ * a mutable ordered index mapping byte string keys to 64 bit values, stored
+ * as an adaptive radix tree.  Each inner node branches on one key byte and
+ * is the smallest of four layouts able to hold its children
+ *
+ *   Node4    up to 4 sorted key bytes beside 4 children
+ *   Node16   up to 16 sorted key bytes, searched with one SSE2 compare
+ *   Node48   a 256 entry byte index into 48 children
+ *   Node256  256 children indexed directly
+ *
+ * so sparse nodes stay small and dense ones are a single array lookup.  A
+ * run of nodes with one child is collapsed into the prefix of the node below
+ * (path compression), the first ART_MAX_PREFIX bytes of which are kept in
+ * the node and the rest checked against a leaf.  Leaves hold the whole key,
+ * a key which is a prefix of other keys hangs off the node where it ends.
+ *
+ * Nodes and leaves are carved out of slabs with a free list per size class,
+ * the slabs come from the tree's recycler when it has one.  Keys are walked
+ * in byte order (see buffer_cmp_bytes) by an ArtIterator, from a key
+ * onwards, below a key or by prefix.
+*/
+
+// number of prefix bytes stored in a node
+#define ART_MAX_PREFIX 8
+
+// number of allocation size classes, 16 bytes apart
+#define ART_SIZE_CLASSES 132
+
+typedef struct stArt {
+    void *root;
+    size_t count;
+    void *freeList[ART_SIZE_CLASSES];
+    void **slabs;
+    size_t slabCount;
+    size_t slabCap;
+    unsigned char *slabNext;
+    size_t slabLeft;
+    size_t largeBytes;
+    Recycler *recycler;
+} Art;
+
+typedef struct stArtStats {
+    size_t leaves;
+    size_t node4;
+    size_t node16;
+    size_t node48;
+    size_t node256;
+    size_t maxDepth;
+} ArtStats;
+
+/* ArtIterator
+ * walks the keys of a tree in byte order.  Changing the tree invalidates
+ * every iterator over it
+ */
+
+typedef struct stArtIterator {
+    const Art *art;
+    Buffer stack;
+    size_t depth;
+    Buffer bound;
+    int boundKind;
+} ArtIterator;
+
+// initialize tree [art] so that it is empty and holds no memory
+void art_init(Art *art);
+
+// assign recycler [rc] to tree [art], call before anything is inserted
+void art_assign_recycler(Art *art, Recycler *rc);
+
+// free all memory held by tree [art] leaving it empty
+void art_free(Art *art);
+
+// returns the number of keys in tree [art]
+size_t art_get_count(const Art *art);
+
+/* insert the [len] bytes at [data] into tree [art] with value [value],
+ * replacing the value when the key is already present
+ * [added] - if not NULL, set to true when the key was not already present
+ * returns false only on memory exhaustion
+ */
+bool art_insert_bytes(Art *art, const unsigned char *data, size_t len,
+                      uint64_t value, bool *added);
+
+// insert the data held by [key] into tree [art], see art_insert_bytes
+bool art_insert(Art *art, const Buffer *key, uint64_t value, bool *added);
+
+/* look up the [len] bytes at [data] in tree [art]
+ * [value] - receives the key's value when found, may be NULL
+ * returns true if the key was found
+ */
+bool art_get_bytes(const Art *art, const unsigned char *data, size_t len,
+                   uint64_t *value);
+
+// look up the data of [key] in tree [art], see art_get_bytes
+bool art_get(const Art *art, const Buffer *key, uint64_t *value);
+
+// remove the [len] bytes at [data] from tree [art]
+// returns true if the key was present
+bool art_remove_bytes(Art *art, const unsigned char *data, size_t len);
+
+// remove the data of [key] from tree [art]
+// returns true if the key was present
+bool art_remove(Art *art, const Buffer *key);
+
+// returns the number of bytes tree [art] has allocated
+size_t art_get_memory(const Art *art);
+
+// count the leaves and nodes of each type in tree [art] into [stats]
+void art_get_stats(const Art *art, ArtStats *stats);
+
+/* prepare iterator [it] to walk every key of tree [art] in order
+ * [it] - iterator to initialize
+ * [art] - tree to walk
+ */
+void art_iterator_init(ArtIterator *it, const Art *art);
+
+/* position iterator [it] on the first key which is not less than [key],
+ * iteration then carries on to the end of the tree
+ * returns false on memory exhaustion
+ */
+bool art_iterator_seek(ArtIterator *it, const BufferView *key);
+
+/* restrict iterator [it] to the keys starting with [prefix], in order
+ * returns false on memory exhaustion
+ */
+bool art_iterator_seek_prefix(ArtIterator *it, const BufferView *prefix);
+
+/* restrict iterator [it] to the keys from [low] up to but not including
+ * [high], in order.  Either bound may be NULL to leave that end open
+ * returns false on memory exhaustion
+ */
+bool art_iterator_seek_range(ArtIterator *it, const BufferView *low,
+                             const BufferView *high);
+
+/* advance iterator [it] to the next key
+ * [it] - iterator to advance
+ * [key] - view set to the key, valid until the tree next changes
+ * [value] - receives the key's value, may be NULL
+ * returns false once every key has been visited
+ */
+bool art_iterator_next(ArtIterator *it, BufferView *key, uint64_t *value);
+
+// free memory held by iterator [it]
+void art_iterator_free(ArtIterator *it);
+
+#endif //SEARCHFILEC_ART_H
@@ -9,6 +9,7 @@
 #include <string.h>
 #include "recycler.h"
 #include <ctype.h>
+#include <limits.h>
 #include <stdio.h>
 #include "log.h"
 
@@ -19,11 +20,24 @@ void buffer_to_memchunk(Buffer *buf, MemoryChunk *mc) {
     mc->p = buf->data;
 }
 
+bool buffer_grow(Buffer *buf, size_t need) {
+    assert(NULL != buf);
+    if(buf->cap >= need) return true;
+    size_t cap = buf->cap * 2;
+    if(cap < need) cap = need;
+    if(cap > UINT_MAX) cap = UINT_MAX;
+    if(need > cap) {
+        log_message("Unable to grow buffer past %u bytes to %zu", UINT_MAX, need);
+        return false;
+    }
+    return buffer_reserve(buf, (unsigned int) cap);
+}
+
 bool buffer_push_null(Buffer *dest) {
 
     bool allocated = false;
 
-    if (!buffer_reserve(dest, dest->len + 1)) {
+    if (!buffer_grow(dest, dest->len + 1)) {
         log_message("Unable to expand buffer to hold %zu bytes.", dest->len + 1);
         return false;
     }
@@ -80,6 +94,15 @@ int buffer_cmp(const void *a, const void*b) {
                   ((Buffer *) b)->data, ((Buffer *) a)->len);
 }
 
+int buffer_cmp_bytes(const void *a, const void *b) {
+    const Buffer *x = (const Buffer *) a;
+    const Buffer *y = (const Buffer *) b;
+    const size_t len = x->len < y->len ? x->len : y->len;
+    const int ret = len ? memcmp(x->data, y->data, len) : 0;
+    if(ret != 0) return ret;
+    return (x->len > y->len) - (x->len < y->len);
+}
+
 bool buffer_reserve(Buffer *buf, unsigned int bytes) {
 
     assert(NULL != buf);
@@ -182,6 +205,20 @@ void buffer_clone(Buffer *dest, const Buffer *src) {
     dest->recycler = src->recycler;
 }
 
+void buffer_move(Buffer *dest, Buffer *src) {
+
+    assert(NULL != dest);
+    assert(NULL != src);
+
+    if(dest == src) return;
+
+    Recycler *r = src->recycler;
+    buffer_free(dest);
+    buffer_clone(dest, src);
+    buffer_init(src);
+    src->recycler = r;
+}
+
 
 bool buffer_append(Buffer *dest, const Buffer *src) {
 
@@ -192,7 +229,7 @@ bool buffer_append(Buffer *dest, const Buffer *src) {
 
     const size_t reqLen = dest->len + src->len;
 
-    if(!buffer_reserve(dest, reqLen)) {
+    if(!buffer_grow(dest, reqLen)) {
         log_message("Unable to expand buffer to hold %d bytes.", reqLen);
         return false;
     }
@@ -212,12 +249,12 @@ bool buffer_push_byte(Buffer *dest, unsigned char c) {
 
     bool allocated = false;
 
-    if (!buffer_reserve(dest, dest->len + 1)) {
+    if (!buffer_grow(dest, dest->len + 1)) {
         log_message("Unable to expand buffer to hold %zu bytes.", dest->len + 1);
         return false;
     }
     if (dest->nullTerminated) {
-        if(0 == dest->data[dest->len - 1])
+        if(dest->len > 0 && 0 == dest->data[dest->len - 1])
             dest->data[dest->len - 1] = c;
         else dest->data[dest->len++] = c;
         return buffer_push_null(dest);
@@ -248,7 +285,10 @@ bool buffer_strcpy(Buffer *buf, const char *str) {
 
     memcpy(buf->data, str, len);
 
+    // the terminator was copied along with the string, so don't let
+    // buffer_make_string push a second one
     buf->len = len;
+    buf->nullTerminated = true;
 
     return buffer_make_string(buf);
 }
@@ -459,13 +499,32 @@ bool buffer_push_bytes(Buffer *dest, const unsigned char *src, size_t count)
     assert(NULL != dest);
     assert(NULL != src);
 
-    for(size_t i = 0; i < count; ++i) {
-        if(!buffer_push_byte(dest, src[i]))
-        {
-            log_message("Unable to push byte %zu", i);
+    if(0 == count) return true;
+
+    // a string keeps its terminator last, push it a byte at a time
+    if(dest->nullTerminated) {
+        if(!buffer_grow(dest, dest->len + count + 1)) {
+            log_message("Unable to expand buffer to hold %zu bytes.",
+                        dest->len + count + 1);
             return false;
         }
+        for(size_t i = 0; i < count; ++i) {
+            if(!buffer_push_byte(dest, src[i]))
+            {
+                log_message("Unable to push byte %zu", i);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    if(!buffer_grow(dest, dest->len + count)) {
+        log_message("Unable to expand buffer to hold %zu bytes.",
+                    dest->len + count);
+        return false;
     }
+    memcpy(dest->data + dest->len, src, count);
+    dest->len += count;
 
     return true;
 }
@@ -541,4 +600,43 @@ char * buffer_memchr(Buffer *src, char c) {
 char * buffer_get_data(Buffer * src) {
     assert(NULL != src);
     return (char *) src->data;
-}
\ No newline at end of file
+}
+
+void buffer_view_init(BufferView *view) {
+    assert(NULL != view);
+    view->data = NULL;
+    view->len = 0;
+}
+
+void buffer_view_set(BufferView *view, const unsigned char *data, size_t len) {
+    assert(NULL != view);
+    view->data = data;
+    view->len = (NULL == data) ? 0 : len;
+}
+
+void buffer_view_from_buffer(BufferView *view, const Buffer *buf) {
+    assert(NULL != view);
+    assert(NULL != buf);
+    buffer_view_set(view, buf->data, buf->len);
+}
+
+bool buffer_cpy_view(Buffer *dest, const BufferView *src) {
+    assert(NULL != dest);
+    assert(NULL != src);
+
+    if(0 == src->len || NULL == src->data) {
+        dest->len = 0;
+        return true;
+    }
+
+    if(!buffer_reserve(dest, src->len)) {
+        log_message("Unable to expand dest buffer to hold %zu bytes", src->len);
+        return false;
+    }
+
+    memcpy(dest->data, src->data, src->len);
+    dest->len = src->len;
+    dest->nullTerminated = false;
+
+    return true;
+}
@@ -21,6 +21,16 @@ typedef struct stBuffer {
     Recycler *recycler;
 } Buffer;
 
+/*
+ * a BufferView is a read only window onto bytes owned by someone else
+ * (a Buffer, a mapped file, a string literal).  it never owns or frees memory
+ * and is only valid for as long as the memory it points at
+*/
+typedef struct stBufferView {
+    const unsigned char *data;
+    size_t len;
+} BufferView;
+
 #include "bufferarray.h"
 
 /*
@@ -40,6 +50,13 @@ void buffer_init(Buffer *buf);
 // returns a <=> b
 int buffer_cmp(const void *a, const void*b);
 
+// compare buffers [a] and [b] in byte order, a buffer which is a prefix of
+// another sorts first.  suitable for qsort and for sorted dictionaries
+// [a] - buffer a
+// [b] - buffer b
+// returns a <=> b
+int buffer_cmp_bytes(const void *a, const void *b);
+
 // swap the internals buffer [a] and buffer [b]
 // [a] - first buffer
 // [b] - second buffer
@@ -52,6 +69,12 @@ void buffer_swap(Buffer *a, Buffer *b);
 // returns true if data successfully expanded
 bool buffer_reserve(Buffer *buf, unsigned int bytes);
 
+// reserve room for [need] bytes in [buf], at least doubling its capacity so
+// that appending a little at a time costs amortized O(1) copies per byte
+// returns false, leaving [buf] as it was, when [need] is past UINT_MAX bytes
+// or memory runs out
+bool buffer_grow(Buffer *buf, size_t need);
+
 // free internal memory held by buffer [data]
 // [buf] - buffer which owns internal meomry to be freed
 // if a recycler is attached, the memory is recycled
@@ -88,6 +111,13 @@ bool buffer_cpy(Buffer *dest, const Buffer *src);
 // returns true if the copy worked, false if not
 void buffer_clone(Buffer *dest, const Buffer *src);
 
+// move the data of buffer [src] into buffer [dest] without copying it.  dest
+// frees whatever it held and takes over src's memory along with the
+// recycler it must be returned to, src is left empty but keeps its recycler
+// [dest] - buffer to take the data
+// [src] - buffer to take the data from
+void buffer_move(Buffer *dest, Buffer *src);
+
 // append buffer [src] to buffer [dest], increasing capacity of [dest] if needed
 // [dest] - buffer to get new data
 // [src] - buffer whose data will be appended to dest
@@ -107,7 +137,7 @@ void buffer_clear(Buffer *buf);
 
 // copy a null terminated string [str] into a buffer [buf]
 // overwrites conents of buffer on copy
-// this action does not make the buffer null terminated
+// the buffer holds the string and exactly one terminator afterwards
 // [buf] - buffer to copy into
 // [str] - null terminated string to copy
 // returns true on success, false on failure
@@ -184,5 +214,28 @@ char * buffer_get_data(Buffer * src);
 
 char * buffer_memchr(Buffer *src, char c);
 
+// initialize a buffer view [view] so it points at nothing
+// [view] - view to be initialized
+void buffer_view_init(BufferView *view);
+
+// point a buffer view [view] at [len] bytes starting at [data]
+// [view] - view to set
+// [data] - first byte the view should see
+// [len] - number of bytes visible through the view
+void buffer_view_set(BufferView *view, const unsigned char *data, size_t len);
+
+// point a buffer view [view] at the data currently held by buffer [buf]
+// the view is invalidated by anything which reallocates or frees [buf]
+// [view] - view to set
+// [buf] - buffer to view
+void buffer_view_from_buffer(BufferView *view, const Buffer *buf);
+
+// copy the bytes visible through view [src] into buffer [dest], overwriting
+// the contents of dest and allocating memory as needed
+// [dest] - buffer to get new data
+// [src] - view whose bytes will be copied
+// returns true on success, false on failure
+bool buffer_cpy_view(Buffer *dest, const BufferView *src);
+
 
 #endif //SEARCHFILEC_BUFFER_H
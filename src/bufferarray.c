@@ -9,6 +9,7 @@
 #include "recycler.h"
 #include "bufferarray.h"
 #include "log.h"
+#include <limits.h>
 #include <string.h>
 
 size_t buffer_array_get_buffer_count(BufferArray *ba) {
@@ -40,33 +41,86 @@ bool buffer_array_push(BufferArray *ba, const Buffer *buf) {
     assert(NULL != ba);
     assert(NULL != buf);
 
-    Buffer *tmp;
+    Buffer tmp;
+    buffer_init(&tmp);
+    tmp.recycler = ba->recycler;
 
-    tmp = malloc(sizeof(Buffer));
-
-    if(NULL == tmp) {
-        log_message("Unable to allocate %zu bytes to hold buffer", sizeof(Buffer));
+    if(!buffer_cpy(&tmp, buf)) {
+        log_message("Unable to copy buffer");
         return false;
     }
 
-    buffer_init(tmp);
-    tmp->recycler = ba->recycler;
-
-    if(!buffer_cpy(tmp, buf)) {
-        log_message("Unable to copy buffer");
+    if(!buffer_array_push_move(ba, &tmp)) {
+        buffer_free(&tmp);
         return false;
     }
 
-    if(!buffer_push_bytes(&ba->array, (unsigned char *) tmp, sizeof(Buffer))) {
+    return true;
+}
+
+bool buffer_array_push_move(BufferArray *ba, Buffer *buf) {
+    assert(NULL != ba);
+    assert(NULL != buf);
+
+    if(!buffer_grow(&ba->array, ba->array.len + sizeof(Buffer))) {
         log_message("Unable to add buffer to array");
         return false;
     }
 
+    Buffer *slot = (Buffer *) (ba->array.data + ba->array.len);
+    buffer_init(slot);
+    buffer_move(slot, buf);
+    ba->array.len += sizeof(Buffer);
     ba->count++;
 
     return true;
 }
 
+bool buffer_array_reserve(BufferArray *ba, size_t count) {
+    assert(NULL != ba);
+
+    if(count > UINT_MAX / sizeof(Buffer) ||
+       !buffer_reserve(&ba->array, (unsigned int) (count * sizeof(Buffer)))) {
+        log_message("Unable to reserve room for %zu buffers", count);
+        return false;
+    }
+    return true;
+}
+
+Buffer * buffer_array_emplace(BufferArray *ba) {
+    assert(NULL != ba);
+
+    Buffer tmp;
+    buffer_init(&tmp);
+    tmp.recycler = ba->recycler;
+    if(!buffer_array_push_move(ba, &tmp)) return NULL;
+    return buffer_array_get_buffer(ba, ba->count - 1);
+}
+
+bool buffer_array_extend(BufferArray *ba, const Buffer *bufs, size_t count) {
+    assert(NULL != ba);
+    assert(NULL != bufs || 0 == count);
+
+    if(count > UINT_MAX / sizeof(Buffer) ||
+       !buffer_grow(&ba->array, ba->array.len + count * sizeof(Buffer))) {
+        log_message("Unable to reserve room for %zu more buffers", count);
+        return false;
+    }
+    for(size_t i=0; i<count; ++i) {
+        if(!buffer_array_push(ba, &bufs[i])) return false;
+    }
+    return true;
+}
+
+void buffer_array_clear(BufferArray *ba) {
+    assert(NULL != ba);
+
+    for(size_t i=0; i<ba->count; ++i)
+        buffer_free(buffer_array_get_buffer(ba, i));
+    ba->count = 0;
+    ba->array.len = 0;
+}
+
 bool buffer_array_cpy_buffer(BufferArray *ba, size_t idx, Buffer *out) {
     assert(NULL != ba);
     assert(NULL != out);
@@ -105,11 +159,29 @@ void buffer_array_remove_buffer(BufferArray * ba, size_t idx)
     // buffers to move is addr of last buffer (2) - add of deleted (0) = 2
 
     size_t buffersToMove = buffer_array_get_buffer_count(ba) - 1 - idx;
-    size_t memToMove = buffersToMove + sizeof(Buffer);
+    size_t memToMove = buffersToMove * sizeof(Buffer);
 
-    memmove(old, moveStart, memToMove);
+    if(memToMove > 0) memmove(old, moveStart, memToMove);
 
     ba->count -= 1;
+    ba->array.len -= sizeof(Buffer);
+}
+
+void buffer_array_swap_remove(BufferArray *ba, size_t idx) {
+    assert(NULL != ba);
+    if(idx >= ba->count) {
+        log_message("attempt to remove buffer at idx[%zu] past"
+            "length of buffer array %zu", idx, ba->count);
+        return;
+    }
+
+    Buffer *old = buffer_array_get_buffer(ba, idx);
+    buffer_free(old);
+    if(idx != ba->count - 1)
+        *old = *buffer_array_get_buffer(ba, ba->count - 1);
+
+    ba->count -= 1;
+    ba->array.len -= sizeof(Buffer);
 }
 
 void buffer_array_assign_recycler(BufferArray *ba, Recycler *rc) {
@@ -141,4 +213,572 @@ void buffer_array_clone(BufferArray *dest, BufferArray *src) {
     dest->recycler = src->recycler;
     dest->count = src->count;
     buffer_clone(&dest->array, &src->array);
-}
\ No newline at end of file
+}
+// byte size of one entry of the index of [pa]
+static size_t packed_buffer_array_end_bytes(const PackedBufferArray *pa) {
+    return pa->wide ? sizeof(uint64_t) : sizeof(uint32_t);
+}
+
+static size_t packed_buffer_array_end(const PackedBufferArray *pa, size_t i) {
+    if(pa->wide) return (size_t) ((const uint64_t *) pa->ends)[i];
+    return ((const uint32_t *) pa->ends)[i];
+}
+
+/* grow the block at [*mem] holding [used] bytes to at least [need] bytes,
+ * at least doubling it, taking memory from recycler [rc] when there is one
+ */
+static bool packed_buffer_array_grow(Recycler *rc, void **mem, size_t *cap,
+                                     size_t used, size_t need) {
+    if(need <= *cap) return true;
+    size_t bytes = *cap * 2;
+    if(bytes < need) bytes = need;
+
+    void *p;
+    if(NULL != rc) {
+        MemoryChunk chunk;
+        mem_chunk_init(&chunk);
+        if(!recycler_get(rc, &chunk, bytes)) return false;
+        p = chunk.p;
+        bytes = chunk.cap;
+        if(used > 0) memcpy(p, *mem, used);
+        if(NULL != *mem) recycler_return(rc, *cap, *mem);
+    } else {
+        p = realloc(*mem, bytes);
+        if(NULL == p) {
+            log_message("Unable to grow packed buffer array to %zu bytes",
+                        bytes);
+            return false;
+        }
+    }
+    *mem = p;
+    *cap = bytes;
+    return true;
+}
+
+// move the index of [pa] to 64 bit offsets, widening in place from the end
+static bool packed_buffer_array_widen(PackedBufferArray *pa, size_t spare) {
+    if(!packed_buffer_array_grow(pa->recycler, &pa->ends, &pa->endsCap,
+                                 pa->count * sizeof(uint32_t),
+                                 (pa->count + spare) * sizeof(uint64_t)))
+        return false;
+    const uint32_t *narrow = pa->ends;
+    uint64_t *wide = pa->ends;
+    for(size_t i = pa->count; i-- > 0;) wide[i] = narrow[i];
+    pa->wide = true;
+    return true;
+}
+
+void packed_buffer_array_init(PackedBufferArray *pa) {
+    assert(NULL != pa);
+    pa->pool = NULL;
+    pa->len = 0;
+    pa->cap = 0;
+    pa->ends = NULL;
+    pa->count = 0;
+    pa->endsCap = 0;
+    pa->wide = false;
+    pa->recycler = NULL;
+}
+
+void packed_buffer_array_assign_recycler(PackedBufferArray *pa, Recycler *rc) {
+    assert(NULL != pa);
+    pa->recycler = rc;
+}
+
+void packed_buffer_array_free(PackedBufferArray *pa) {
+    assert(NULL != pa);
+    Recycler *rc = pa->recycler;
+    if(NULL != rc) {
+        if(NULL != pa->pool) recycler_return(rc, pa->cap, pa->pool);
+        if(NULL != pa->ends) recycler_return(rc, pa->endsCap, pa->ends);
+    } else {
+        free(pa->pool);
+        free(pa->ends);
+    }
+    packed_buffer_array_init(pa);
+    pa->recycler = rc;
+}
+
+void packed_buffer_array_clear(PackedBufferArray *pa) {
+    assert(NULL != pa);
+    pa->len = 0;
+    pa->count = 0;
+}
+
+bool packed_buffer_array_reserve(PackedBufferArray *pa, size_t count,
+                                 size_t bytes) {
+    assert(NULL != pa);
+
+    if(!pa->wide && pa->len + bytes > PACKED_BUFFER_ARRAY_NARROW_MAX &&
+       !packed_buffer_array_widen(pa, count))
+        return false;
+    void *pool = pa->pool;
+    const bool ok =
+            packed_buffer_array_grow(pa->recycler, &pool, &pa->cap, pa->len,
+                                     pa->len + bytes) &&
+            packed_buffer_array_grow(pa->recycler, &pa->ends, &pa->endsCap,
+                                     pa->count * packed_buffer_array_end_bytes(pa),
+                                     (pa->count + count) *
+                                     packed_buffer_array_end_bytes(pa));
+    pa->pool = pool;
+    return ok;
+}
+
+bool packed_buffer_array_push_bytes(PackedBufferArray *pa,
+                                    const unsigned char *data, size_t len) {
+    assert(NULL != pa);
+    assert(NULL != data || 0 == len);
+
+    if(!packed_buffer_array_reserve(pa, 1, len)) return false;
+    if(len > 0) memcpy(pa->pool + pa->len, data, len);
+    pa->len += len;
+    if(pa->wide) ((uint64_t *) pa->ends)[pa->count] = pa->len;
+    else ((uint32_t *) pa->ends)[pa->count] = (uint32_t) pa->len;
+    pa->count++;
+    return true;
+}
+
+bool packed_buffer_array_push(PackedBufferArray *pa, const Buffer *buf) {
+    assert(NULL != buf);
+    return packed_buffer_array_push_bytes(pa, buf->data, buf->len);
+}
+
+bool packed_buffer_array_push_view(PackedBufferArray *pa,
+                                   const BufferView *view) {
+    assert(NULL != view);
+    return packed_buffer_array_push_bytes(pa, view->data, view->len);
+}
+
+bool packed_buffer_array_pack(PackedBufferArray *dest, BufferArray *src) {
+    assert(NULL != dest);
+    assert(NULL != src);
+
+    const size_t count = buffer_array_get_buffer_count(src);
+    size_t bytes = 0;
+    for(size_t i=0; i<count; ++i)
+        bytes += buffer_array_get_buffer(src, i)->len;
+    if(!packed_buffer_array_reserve(dest, count, bytes)) return false;
+    for(size_t i=0; i<count; ++i)
+        packed_buffer_array_push(dest, buffer_array_get_buffer(src, i));
+    return true;
+}
+
+bool packed_buffer_array_get_view(const PackedBufferArray *pa, size_t idx,
+                                  BufferView *out) {
+    assert(NULL != pa);
+    assert(NULL != out);
+    if(idx >= pa->count) return false;
+
+    const size_t start = 0 == idx ? 0 : packed_buffer_array_end(pa, idx - 1);
+    buffer_view_set(out, pa->pool + start,
+                    packed_buffer_array_end(pa, idx) - start);
+    return true;
+}
+
+size_t packed_buffer_array_get_count(const PackedBufferArray *pa) {
+    assert(NULL != pa);
+    return pa->count;
+}
+
+size_t packed_buffer_array_get_size(const PackedBufferArray *pa) {
+    assert(NULL != pa);
+    return pa->len;
+}
+
+size_t packed_buffer_array_get_memory(const PackedBufferArray *pa) {
+    assert(NULL != pa);
+    return pa->cap + pa->endsCap;
+}
+
+// buckets smaller than this are left to the multikey quicksort
+#define BUFFER_SORT_RADIX_MIN 64
+
+// ranges this small are finished by insertion sort
+#define BUFFER_SORT_INSERTION_MAX 12
+
+// arrays smaller than this are sorted on the calling thread
+#define BUFFER_SORT_PARALLEL_MIN 65536
+
+// one bucket per byte value plus one, bucket 0, for keys which have ended
+#define BUFFER_SORT_BUCKETS 257
+
+// how many items ahead key bytes are prefetched
+#define BUFFER_SORT_PREFETCH_AHEAD 8
+
+#if defined(__GNUC__)
+#define BUFFER_SORT_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define BUFFER_SORT_PREFETCH(p)
+#endif
+
+/* a buffer being sorted.  [cache] holds the 8 key bytes starting at the
+ * current depth rounded down to a multiple of 8, zero past the key's end,
+ * so bytes are read from the item rather than the buffer.  A key in LENGTH
+ * order is the buffer's length in 4 big endian bytes followed by its data
+ */
+typedef struct stBufferSortItem {
+    uint64_t cache;
+    const unsigned char *data;
+    uint32_t len;
+    uint32_t idx;
+} BufferSortItem;
+
+typedef struct stBufferSortCtx {
+    const Buffer *bufs;
+    size_t off;
+    BufferSortItem *items;
+    BufferSortItem *aux;
+    size_t n;
+    size_t chunks;
+    size_t depth;
+    size_t *counts;
+    size_t ends[BUFFER_SORT_BUCKETS];
+} BufferSortCtx;
+
+// fill the cache of [it] with the key bytes starting at [base]
+static void buffer_sort_load(const BufferSortCtx *ctx, BufferSortItem *it,
+                             size_t base) {
+    const unsigned char *data = it->data;
+    uint64_t c = 0;
+    if(base >= ctx->off && base - ctx->off + 8 <= it->len) {
+        const unsigned char *p = data + base - ctx->off;
+        for(size_t i=0; i<8; ++i) c = c << 8 | p[i];
+        it->cache = c;
+        return;
+    }
+    for(size_t i=0; i<8; ++i) {
+        const size_t pos = base + i;
+        unsigned char b = 0;
+        if(pos < ctx->off) b = (unsigned char) (it->len >> (8 * (ctx->off - 1 - pos)));
+        else if(pos - ctx->off < it->len) b = data[pos - ctx->off];
+        c = c << 8 | b;
+    }
+    it->cache = c;
+}
+
+static void buffer_sort_load_all(const BufferSortCtx *ctx, BufferSortItem *a,
+                                 size_t n, size_t d) {
+    if(0 != (d & 7)) return;
+    for(size_t i=0; i<n; ++i) {
+        if(i + BUFFER_SORT_PREFETCH_AHEAD < n)
+            BUFFER_SORT_PREFETCH(a[i + BUFFER_SORT_PREFETCH_AHEAD].data + d);
+        buffer_sort_load(ctx, &a[i], d);
+    }
+}
+
+// bucket of [it] at depth [d], 0 once its key has ended
+static unsigned buffer_sort_key(const BufferSortCtx *ctx,
+                                const BufferSortItem *it, size_t d) {
+    if(d >= it->len + ctx->off) return 0;
+    return 1 + (unsigned) ((it->cache >> (56 - 8 * (d & 7))) & 0xff);
+}
+
+// order of the keys of [x] and [y], which are equal before depth [d]
+static int buffer_sort_cmp(const BufferSortCtx *ctx, const BufferSortItem *x,
+                           const BufferSortItem *y, size_t d) {
+    // a key ending inside the window is padded with zeros, which only makes
+    // the windows equal when the longer key goes on with zeros
+    if(x->cache != y->cache) return x->cache < y->cache ? -1 : 1;
+    const size_t from = (d | 7) + 1 - ctx->off;
+    const size_t xl = x->len > from ? x->len - from : 0;
+    const size_t yl = y->len > from ? y->len - from : 0;
+    const size_t m = xl < yl ? xl : yl;
+    if(m > 0) {
+        const int c = memcmp(x->data + from, y->data + from, m);
+        if(0 != c) return c;
+    }
+    return (x->len > y->len) - (x->len < y->len);
+}
+
+static void buffer_sort_insertion(const BufferSortCtx *ctx, BufferSortItem *a,
+                                  size_t n, size_t d) {
+    for(size_t i=1; i<n; ++i) {
+        const BufferSortItem t = a[i];
+        size_t j = i;
+        while(j > 0 && buffer_sort_cmp(ctx, &a[j - 1], &t, d) > 0) {
+            a[j] = a[j - 1];
+            --j;
+        }
+        a[j] = t;
+    }
+}
+
+static void buffer_sort_swap(BufferSortItem *a, BufferSortItem *b) {
+    const BufferSortItem t = *a;
+    *a = *b;
+    *b = t;
+}
+
+// multikey quicksort, a three way partition on the byte at depth [d]
+static void buffer_sort_mkqs(const BufferSortCtx *ctx, BufferSortItem *a,
+                             size_t n, size_t d) {
+    while(n > BUFFER_SORT_INSERTION_MAX) {
+        const unsigned x = buffer_sort_key(ctx, &a[0], d);
+        const unsigned y = buffer_sort_key(ctx, &a[n / 2], d);
+        const unsigned z = buffer_sort_key(ctx, &a[n - 1], d);
+        const unsigned p = x < y ? (y < z ? y : (x < z ? z : x))
+                                 : (x < z ? x : (y < z ? z : y));
+        size_t lt = 0, i = 0, gt = n;
+        while(i < gt) {
+            const unsigned k = buffer_sort_key(ctx, &a[i], d);
+            if(k < p) buffer_sort_swap(&a[lt++], &a[i++]);
+            else if(k > p) buffer_sort_swap(&a[i], &a[--gt]);
+            else ++i;
+        }
+        buffer_sort_mkqs(ctx, a, lt, d);
+        buffer_sort_mkqs(ctx, a + gt, n - gt, d);
+        // keys which have ended are all equal
+        if(0 == p) return;
+        a += lt;
+        n = gt - lt;
+        ++d;
+        buffer_sort_load_all(ctx, a, n, d);
+    }
+    buffer_sort_insertion(ctx, a, n, d);
+}
+
+// number of key bytes from depth [d] which all [n] items at [a] share, as
+// far as the cached window and the shortest key allow
+static size_t buffer_sort_common(const BufferSortCtx *ctx,
+                                 const BufferSortItem *a, size_t n, size_t d) {
+    uint64_t diff = 0;
+    size_t minLen = SIZE_MAX;
+    for(size_t i=0; i<n; ++i) {
+        diff |= a[i].cache ^ a[0].cache;
+        if(a[i].len + ctx->off < minLen) minLen = a[i].len + ctx->off;
+    }
+    size_t k = 0;
+    while((d & 7) + k < 8 && d + k < minLen &&
+          0 == ((diff >> (56 - 8 * ((d & 7) + k))) & 0xff))
+        ++k;
+    return k;
+}
+
+/* MSD radix sort of [n] items at [a] on the byte at depth [d].  [aux] is
+ * scratch space of the same size and [out], either a or aux, is where the
+ * sorted items must end up.  Each pass scatters into the other array, so the
+ * two swap roles at every level rather than copying back
+ */
+static void buffer_sort_radix(const BufferSortCtx *ctx, BufferSortItem *a,
+                              BufferSortItem *aux, BufferSortItem *out,
+                              size_t n, size_t d) {
+    size_t ends[BUFFER_SORT_BUCKETS];
+    while(n >= BUFFER_SORT_RADIX_MIN) {
+        // bytes every key shares need no pass, only the next depth
+        const size_t skip = buffer_sort_common(ctx, a, n, d);
+        if(skip > 0) {
+            d += skip;
+            buffer_sort_load_all(ctx, a, n, d);
+            continue;
+        }
+
+        memset(ends, 0, sizeof(ends));
+        for(size_t i=0; i<n; ++i) ++ends[buffer_sort_key(ctx, &a[i], d)];
+        // keys which have all ended are equal
+        if(ends[0] == n) break;
+
+        // counts become starts, then scattering moves each to its end
+        size_t sum = 0;
+        for(unsigned b=0; b<BUFFER_SORT_BUCKETS; ++b) {
+            const size_t c = ends[b];
+            ends[b] = sum;
+            sum += c;
+        }
+        for(size_t i=0; i<n; ++i)
+            aux[ends[buffer_sort_key(ctx, &a[i], d)]++] = a[i];
+
+        for(unsigned b=0; b<BUFFER_SORT_BUCKETS; ++b) {
+            const size_t start = 0 == b ? 0 : ends[b - 1];
+            const size_t count = ends[b] - start;
+            BufferSortItem *dest = (out == a ? a : aux) + start;
+            if(0 == b || count < 2) {
+                if(dest != aux + start && count > 0)
+                    memcpy(dest, aux + start, count * sizeof(BufferSortItem));
+                continue;
+            }
+            buffer_sort_load_all(ctx, aux + start, count, d + 1);
+            buffer_sort_radix(ctx, aux + start, a + start, dest, count, d + 1);
+        }
+        return;
+    }
+    buffer_sort_mkqs(ctx, a, n, d);
+    if(out != a) memcpy(out, a, n * sizeof(BufferSortItem));
+}
+
+static void buffer_sort_chunk(const BufferSortCtx *ctx, size_t chunk,
+                              size_t *lo, size_t *hi) {
+    *lo = ctx->n * chunk / ctx->chunks;
+    *hi = ctx->n * (chunk + 1) / ctx->chunks;
+}
+
+static void buffer_sort_init_task(void *arg, size_t chunk) {
+    BufferSortCtx *ctx = arg;
+    size_t lo, hi;
+    buffer_sort_chunk(ctx, chunk, &lo, &hi);
+    for(size_t i=lo; i<hi; ++i) {
+        ctx->items[i].idx = (uint32_t) i;
+        ctx->items[i].data = ctx->bufs[i].data;
+        ctx->items[i].len = (uint32_t) ctx->bufs[i].len;
+        buffer_sort_load(ctx, &ctx->items[i], 0);
+    }
+}
+
+static void buffer_sort_load_task(void *arg, size_t chunk) {
+    BufferSortCtx *ctx = arg;
+    size_t lo, hi;
+    buffer_sort_chunk(ctx, chunk, &lo, &hi);
+    buffer_sort_load_all(ctx, ctx->items + lo, hi - lo, ctx->depth);
+}
+
+static void buffer_sort_count_task(void *arg, size_t chunk) {
+    BufferSortCtx *ctx = arg;
+    size_t lo, hi;
+    buffer_sort_chunk(ctx, chunk, &lo, &hi);
+    size_t *counts = ctx->counts + chunk * BUFFER_SORT_BUCKETS;
+    memset(counts, 0, BUFFER_SORT_BUCKETS * sizeof(size_t));
+    for(size_t i=lo; i<hi; ++i)
+        ++counts[buffer_sort_key(ctx, &ctx->items[i], ctx->depth)];
+}
+
+// scatter a chunk to the positions worked out for it, keeping input order
+static void buffer_sort_scatter_task(void *arg, size_t chunk) {
+    BufferSortCtx *ctx = arg;
+    size_t lo, hi;
+    buffer_sort_chunk(ctx, chunk, &lo, &hi);
+    size_t *pos = ctx->counts + chunk * BUFFER_SORT_BUCKETS;
+    for(size_t i=lo; i<hi; ++i)
+        ctx->aux[pos[buffer_sort_key(ctx, &ctx->items[i], ctx->depth)]++] =
+                ctx->items[i];
+}
+
+static void buffer_sort_bucket_task(void *arg, size_t bucket) {
+    BufferSortCtx *ctx = arg;
+    if(0 == bucket) return;
+    const size_t start = ctx->ends[bucket - 1];
+    const size_t count = ctx->ends[bucket] - start;
+    if(count < 2) return;
+    buffer_sort_load_all(ctx, ctx->items + start, count, ctx->depth + 1);
+    buffer_sort_radix(ctx, ctx->items + start, ctx->aux + start,
+                      ctx->items + start, count, ctx->depth + 1);
+}
+
+/* split every item on the first byte where keys differ with each chunk
+ * counted and scattered on the pool, then sort the buckets on the pool
+ */
+static bool buffer_sort_parallel(BufferSortCtx *ctx, ThreadPool *tp) {
+    for(;;) {
+        if(!threadpool_run(tp, ctx->chunks, buffer_sort_count_task, ctx))
+            return false;
+        size_t total[BUFFER_SORT_BUCKETS] = { 0 };
+        for(size_t c=0; c<ctx->chunks; ++c)
+            for(unsigned b=0; b<BUFFER_SORT_BUCKETS; ++b)
+                total[b] += ctx->counts[c * BUFFER_SORT_BUCKETS + b];
+        const unsigned first = buffer_sort_key(ctx, &ctx->items[0], ctx->depth);
+        if(total[first] != ctx->n) break;
+        if(0 == first) return true;
+        ++ctx->depth;
+        if(0 == (ctx->depth & 7) &&
+           !threadpool_run(tp, ctx->chunks, buffer_sort_load_task, ctx))
+            return false;
+    }
+
+    // each chunk writes its part of a bucket after the earlier chunks' parts
+    size_t sum = 0;
+    for(unsigned b=0; b<BUFFER_SORT_BUCKETS; ++b) {
+        for(size_t c=0; c<ctx->chunks; ++c) {
+            size_t *count = &ctx->counts[c * BUFFER_SORT_BUCKETS + b];
+            const size_t n = *count;
+            *count = sum;
+            sum += n;
+        }
+        ctx->ends[b] = sum;
+    }
+    if(!threadpool_run(tp, ctx->chunks, buffer_sort_scatter_task, ctx))
+        return false;
+    BufferSortItem *t = ctx->items;
+    ctx->items = ctx->aux;
+    ctx->aux = t;
+
+    return threadpool_run(tp, BUFFER_SORT_BUCKETS, buffer_sort_bucket_task,
+                          ctx);
+}
+
+bool buffer_array_sort(BufferArray *ba, BufferArrayOrder order, ThreadPool *tp) {
+    assert(NULL != ba);
+
+    const size_t n = ba->count;
+    if(n < 2) return true;
+    if(n > UINT32_MAX) {
+        log_message("Unable to sort %zu buffers, at most %u are supported",
+                    n, UINT32_MAX);
+        return false;
+    }
+
+    BufferSortCtx ctx;
+    ctx.bufs = (const Buffer *) ba->array.data;
+    ctx.off = BUFFER_ARRAY_ORDER_LENGTH == order ? 4 : 0;
+    ctx.n = n;
+    ctx.depth = 0;
+    ctx.chunks = NULL == tp || n < BUFFER_SORT_PARALLEL_MIN ? 1 :
+                 threadpool_get_thread_count(tp) * 4;
+    ctx.items = malloc(n * sizeof(BufferSortItem));
+    ctx.aux = malloc(n * sizeof(BufferSortItem));
+    ctx.counts = malloc(ctx.chunks * BUFFER_SORT_BUCKETS * sizeof(size_t));
+    if(NULL == ctx.items || NULL == ctx.aux || NULL == ctx.counts) {
+        log_message("Unable to allocate room to sort %zu buffers", n);
+        free(ctx.items);
+        free(ctx.aux);
+        free(ctx.counts);
+        return false;
+    }
+
+    bool ok = threadpool_run(tp, ctx.chunks, buffer_sort_init_task, &ctx);
+    if(ok) {
+        if(1 == ctx.chunks)
+            buffer_sort_radix(&ctx, ctx.items, ctx.aux, ctx.items, n, 0);
+        else ok = buffer_sort_parallel(&ctx, tp);
+    }
+
+    // gather the buffers into sorted order in a new header array, which
+    // lets the reads overlap, or follow permutation cycles in place when
+    // there is no memory for one or it cannot be reserved in one go
+    Buffer sorted;
+    buffer_init(&sorted);
+    sorted.recycler = ba->array.recycler;
+    if(ok && n <= UINT_MAX / sizeof(Buffer) &&
+       buffer_reserve(&sorted, (unsigned int) (n * sizeof(Buffer)))) {
+        const Buffer *bufs = ctx.bufs;
+        Buffer *out = (Buffer *) sorted.data;
+        for(size_t i=0; i<n; ++i) {
+            if(i + BUFFER_SORT_PREFETCH_AHEAD < n)
+                BUFFER_SORT_PREFETCH(&bufs[ctx.items[i + BUFFER_SORT_PREFETCH_AHEAD].idx]);
+            out[i] = bufs[ctx.items[i].idx];
+        }
+        sorted.len = ba->array.len;
+        buffer_swap(&sorted, &ba->array);
+        buffer_free(&sorted);
+    } else if(ok) {
+        Buffer *bufs = (Buffer *) ba->array.data;
+        BufferSortItem *items = ctx.items;
+        for(size_t i=0; i<n; ++i) {
+            if(items[i].idx == i) continue;
+            const Buffer tmp = bufs[i];
+            size_t j = i;
+            for(;;) {
+                const size_t k = items[j].idx;
+                items[j].idx = (uint32_t) j;
+                if(k == i) {
+                    bufs[j] = tmp;
+                    break;
+                }
+                bufs[j] = bufs[k];
+                j = k;
+            }
+        }
+    }
+
+    free(ctx.items);
+    free(ctx.aux);
+    free(ctx.counts);
+    return ok;
+}
@@ -5,8 +5,15 @@
 #ifndef SEARCHFILEC_BUFFERARRAY_H
 #define SEARCHFILEC_BUFFERARRAY_H
 
+#include <stdint.h>
 #include "buffer.h"
 #include "recycler.h"
+#include "threadpool.h"
+
+// largest pool a packed buffer array indexes with 32 bit offsets
+#ifndef PACKED_BUFFER_ARRAY_NARROW_MAX
+#define PACKED_BUFFER_ARRAY_NARROW_MAX UINT32_MAX
+#endif
 
 typedef struct stBufferArray {
     Buffer array;
@@ -14,6 +21,14 @@ typedef struct stBufferArray {
     Recycler * recycler;
 } BufferArray;
 
+/* orders buffer_array_sort can sort in, BYTES is the order of
+ * buffer_cmp_bytes and LENGTH the shorter first order of buffer_cmp
+ */
+typedef enum eBufferArrayOrder {
+    BUFFER_ARRAY_ORDER_BYTES,
+    BUFFER_ARRAY_ORDER_LENGTH
+} BufferArrayOrder;
+
 /* intialize a bufferarray [ba] with sane defaults */
 void buffer_array_init(BufferArray *ba);
 
@@ -24,6 +39,47 @@ void buffer_array_init(BufferArray *ba);
  * */
 bool buffer_array_push(BufferArray *ba, const Buffer *buf);
 
+/* push buffer [buf] onto buffer array [ba] without copying its data, the
+ * array takes over buf's memory and buf is left empty
+ * [ba] - ba to get new buffer
+ * [buf] - buf to move onto array
+ * returns true on success, fails on memory issues leaving buf untouched
+ * */
+bool buffer_array_push_move(BufferArray *ba, Buffer *buf);
+
+/* make room in buffer array [ba] for [count] buffers in total so they can be
+ * pushed without the array growing
+ * [ba] - buffer array to reserve room in
+ * [count] - number of buffers the array should hold
+ * returns true on success, fails on memory issues or when [count] buffers
+ * would take more than UINT_MAX bytes
+ * */
+bool buffer_array_reserve(BufferArray *ba, size_t count);
+
+/* add an empty buffer to the end of buffer array [ba] for the caller to fill
+ * in place, the buffer uses the array's recycler
+ * [ba] - buffer array to add to
+ * returns the new buffer, or NULL on memory issues.  the pointer is
+ * invalidated by the next push
+ * */
+Buffer * buffer_array_emplace(BufferArray *ba);
+
+/* push a copy of each of the [count] buffers at [bufs] onto buffer array
+ * [ba], growing the array once
+ * [ba] - buffer array to add to
+ * [bufs] - buffers to copy
+ * [count] - number of buffers to copy
+ * returns true on success, on memory issues false with the buffers copied so
+ * far left in the array
+ * */
+bool buffer_array_extend(BufferArray *ba, const Buffer *bufs, size_t count);
+
+/* remove every buffer from buffer array [ba], freeing their data but keeping
+ * the array's own memory for reuse
+ * [ba] - buffer array to clear
+ * */
+void buffer_array_clear(BufferArray *ba);
+
 /* copy data stored within a bufferarray [ba] at index [idx] to an
  * output buffer [out] use buffer_array_get_buffer to get a pointer
  * to the internally held buffer
@@ -47,6 +103,25 @@ Buffer * buffer_array_get_buffer(BufferArray *ba, size_t idx);
  */
 void buffer_array_remove_buffer(BufferArray *ba, size_t idx);
 
+/* remove the buffer at index [idx] from bufferarray [ba] in O(1) by moving
+ * the last buffer into its place, so the order of the array is not kept
+ * [ba] - buffer array to remove buffer from
+ * [idx] - index of buffer to remove
+ */
+void buffer_array_swap_remove(BufferArray *ba, size_t idx);
+
+/* sort the buffers of bufferarray [ba] into [order] with an MSD radix sort,
+ * which keeps the next 8 bytes of each key beside it so most steps never
+ * touch the buffers themselves, and hands small buckets to a multikey
+ * quicksort.  Equal buffers keep their order unless they fall in a small
+ * bucket
+ * [ba] - buffer array to sort
+ * [order] - BUFFER_ARRAY_ORDER_BYTES or BUFFER_ARRAY_ORDER_LENGTH
+ * [tp] - thread pool to sort buckets on, or NULL to sort on this thread
+ * returns true on success, false on memory issues leaving ba untouched
+ */
+bool buffer_array_sort(BufferArray *ba, BufferArrayOrder order, ThreadPool *tp);
+
 /* get the count of the buffers held within a bufferarray [ba]
  * [ba] - buffer array to get count from
  * returns count of buffers in array
@@ -82,4 +157,79 @@ void buffer_array_assign_recycler(BufferArray *ba, Recycler *rc);
 
 void buffer_array_clone(BufferArray *dest, BufferArray *src);
 
+/* PackedBufferArray
+ * an append only array of byte strings stored back to back in one pool, with
+ * an index holding where each one ends.  The index uses 32 bit offsets and
+ * widens to 64 bit ones once the pool passes 4 GiB, so an entry costs its
+ * bytes plus 4 and there are only two allocations however many entries are
+ * pushed.  Entries are read through views into the pool, which are
+ * invalidated by the next push.
+ */
+
+typedef struct stPackedBufferArray {
+    unsigned char *pool;
+    size_t len;
+    size_t cap;
+    void *ends;
+    size_t count;
+    size_t endsCap;
+    bool wide;
+    Recycler *recycler;
+} PackedBufferArray;
+
+// initialize packed buffer array [pa] so that it is empty and holds no memory
+void packed_buffer_array_init(PackedBufferArray *pa);
+
+/* assign recycler [rc] to packed buffer array [pa], call before anything is
+ * pushed
+ */
+void packed_buffer_array_assign_recycler(PackedBufferArray *pa, Recycler *rc);
+
+// free all memory held by packed buffer array [pa] leaving it empty
+void packed_buffer_array_free(PackedBufferArray *pa);
+
+// remove every entry from packed buffer array [pa] keeping its memory
+void packed_buffer_array_clear(PackedBufferArray *pa);
+
+/* make room in packed buffer array [pa] for [count] more entries holding
+ * [bytes] more bytes in total so they can be pushed without growing
+ * returns false on memory exhaustion
+ */
+bool packed_buffer_array_reserve(PackedBufferArray *pa, size_t count,
+                                 size_t bytes);
+
+/* push a copy of the [len] bytes at [data] onto packed buffer array [pa]
+ * returns false on memory exhaustion
+ */
+bool packed_buffer_array_push_bytes(PackedBufferArray *pa,
+                                    const unsigned char *data, size_t len);
+
+// push a copy of the data of [buf] onto packed buffer array [pa]
+bool packed_buffer_array_push(PackedBufferArray *pa, const Buffer *buf);
+
+// push a copy of the bytes of [view] onto packed buffer array [pa]
+bool packed_buffer_array_push_view(PackedBufferArray *pa,
+                                   const BufferView *view);
+
+/* push a copy of every buffer of [src] onto packed buffer array [dest],
+ * sizing it once up front
+ * returns false on memory exhaustion
+ */
+bool packed_buffer_array_pack(PackedBufferArray *dest, BufferArray *src);
+
+/* set view [out] to the entry at index [idx] of packed buffer array [pa]
+ * returns false if idx is out of bounds
+ */
+bool packed_buffer_array_get_view(const PackedBufferArray *pa, size_t idx,
+                                  BufferView *out);
+
+// returns the number of entries in packed buffer array [pa]
+size_t packed_buffer_array_get_count(const PackedBufferArray *pa);
+
+// returns the number of entry bytes held by packed buffer array [pa]
+size_t packed_buffer_array_get_size(const PackedBufferArray *pa);
+
+// returns the number of bytes packed buffer array [pa] has allocated
+size_t packed_buffer_array_get_memory(const PackedBufferArray *pa);
+
 #endif //SEARCHFILEC_BUFFERARRAY_H
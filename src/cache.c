@@ -0,0 +1,302 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include "cache.h"
+#include "log.h"
+
+// slots allocated up front when only bytes are bounded and no estimate given
+#define CACHE_DEFAULT_SLOTS 64
+
+static void * cache_alloc(Recycler *rc, size_t bytes) {
+    return NULL != rc ? recycler_get_exact(rc, bytes) : malloc(bytes);
+}
+
+static void cache_release(Recycler *rc, size_t bytes, void *mem) {
+    if(NULL == mem) return;
+    if(NULL != rc) recycler_return(rc, bytes, mem);
+    else free(mem);
+}
+
+// the index buckets by hash modulo its size, which spreads best when prime
+static size_t cache_index_size(size_t n) {
+    if(n < 11) n = 11;
+    n |= 1;
+    for(;; n += 2) {
+        bool prime = true;
+        for(size_t d = 3; d * d <= n; d += 2) {
+            if(0 == n % d) {
+                prime = false;
+                break;
+            }
+        }
+        if(prime) return n;
+    }
+}
+
+static void cache_entry_reset(Cache *c, CacheEntry *e) {
+    buffer_init(&e->key);
+    buffer_init(&e->value);
+    buffer_assign_recycler(&e->key, c->recycler);
+    buffer_assign_recycler(&e->value, c->recycler);
+    e->used = false;
+    e->referenced = false;
+}
+
+// grow the slot arrays of cache [c] to hold [slots] entries
+static bool cache_grow(Cache *c, size_t slots) {
+    CacheEntry *entries = cache_alloc(c->recycler, slots * sizeof(CacheEntry));
+    size_t *freeSlots = cache_alloc(c->recycler, slots * sizeof(size_t));
+    if(NULL == entries || NULL == freeSlots) {
+        log_message("Unable to allocate %zu cache slots", slots);
+        cache_release(c->recycler, slots * sizeof(CacheEntry), entries);
+        cache_release(c->recycler, slots * sizeof(size_t), freeSlots);
+        return false;
+    }
+
+    if(c->slots > 0) {
+        memcpy(entries, c->entries, c->slots * sizeof(CacheEntry));
+        memcpy(freeSlots, c->freeSlots, c->freeCount * sizeof(size_t));
+    }
+
+    // hand out the lowest new slot first
+    for(size_t i = slots; i > c->slots; --i) {
+        cache_entry_reset(c, &entries[i - 1]);
+        freeSlots[c->freeCount++] = i - 1;
+    }
+
+    cache_release(c->recycler, c->slots * sizeof(CacheEntry), c->entries);
+    cache_release(c->recycler, c->slots * sizeof(size_t), c->freeSlots);
+    c->entries = entries;
+    c->freeSlots = freeSlots;
+    c->slots = slots;
+    return true;
+}
+
+// drop the entry in slot [i], handing its buffers to the callback when
+// [evicted] is set
+static void cache_drop(Cache *c, size_t i, bool evicted) {
+    CacheEntry *e = &c->entries[i];
+
+    hashtable_remove(&c->index, &e->key);
+    c->bytes -= e->key.len + e->value.len;
+    c->count--;
+
+    if(evicted) {
+        c->evictions++;
+        if(NULL != c->onEvict) c->onEvict(&e->key, &e->value, c->evictCtx);
+        else {
+            buffer_free(&e->key);
+            buffer_free(&e->value);
+        }
+    } else {
+        buffer_free(&e->key);
+        buffer_free(&e->value);
+    }
+
+    cache_entry_reset(c, e);
+    c->freeSlots[c->freeCount++] = i;
+}
+
+// advance the clock hand to the first entry not referenced since the hand
+// last passed it, other than slot [keep], and evict it
+static void cache_evict_one(Cache *c, size_t keep) {
+    for(;;) {
+        const size_t i = c->hand;
+        c->hand = (c->hand + 1) % c->slots;
+
+        CacheEntry *e = &c->entries[i];
+        if(!e->used || i == keep) continue;
+        if(e->referenced) {
+            e->referenced = false;
+            continue;
+        }
+        cache_drop(c, i, true);
+        return;
+    }
+}
+
+// returns the slot holding [key] or SIZE_MAX
+static size_t cache_find(Cache *c, const Buffer *key) {
+    Buffer *slot = hashtable_get(&c->index, key);
+    if(NULL == slot || slot->len != sizeof(size_t)) return SIZE_MAX;
+    size_t i;
+    memcpy(&i, slot->data, sizeof(i));
+    return i;
+}
+
+void cache_init(Cache *c) {
+    assert(NULL != c);
+    hashtable_init(&c->index);
+    c->entries = NULL;
+    c->slots = 0;
+    c->freeSlots = NULL;
+    c->freeCount = 0;
+    c->count = 0;
+    c->hand = 0;
+    c->maxEntries = 0;
+    c->maxBytes = 0;
+    c->bytes = 0;
+    c->onEvict = NULL;
+    c->evictCtx = NULL;
+    c->hits = 0;
+    c->misses = 0;
+    c->evictions = 0;
+    c->recycler = NULL;
+}
+
+void cache_assign_recycler(Cache *c, Recycler *rc) {
+    assert(NULL != c);
+    c->recycler = rc;
+    hashtable_assign_recycler(&c->index, rc);
+}
+
+bool cache_create(Cache *c, size_t maxEntries, size_t maxBytes,
+                  size_t expectedEntries) {
+    assert(NULL != c);
+
+    if(0 == maxEntries && 0 == maxBytes) {
+        log_message("A cache needs an entry or a byte limit");
+        return false;
+    }
+
+    c->maxEntries = maxEntries;
+    c->maxBytes = maxBytes;
+
+    size_t slots = maxEntries;
+    if(0 == slots) slots = expectedEntries ? expectedEntries : CACHE_DEFAULT_SLOTS;
+
+    if(!hashtable_set_size(&c->index, cache_index_size(slots))) return false;
+    return cache_grow(c, slots);
+}
+
+void cache_set_evict_callback(Cache *c, CacheEvictFn fn, void *ctx) {
+    assert(NULL != c);
+    c->onEvict = fn;
+    c->evictCtx = ctx;
+}
+
+void cache_free(Cache *c) {
+    assert(NULL != c);
+
+    for(size_t i = 0; i < c->slots; ++i) {
+        buffer_free(&c->entries[i].key);
+        buffer_free(&c->entries[i].value);
+    }
+    cache_release(c->recycler, c->slots * sizeof(CacheEntry), c->entries);
+    cache_release(c->recycler, c->slots * sizeof(size_t), c->freeSlots);
+    hashtable_free(&c->index);
+
+    Recycler *rc = c->recycler;
+    cache_init(c);
+    cache_assign_recycler(c, rc);
+}
+
+Buffer * cache_get(Cache *c, const Buffer *key) {
+    assert(NULL != c);
+    assert(NULL != key);
+
+    const size_t i = cache_find(c, key);
+    if(SIZE_MAX == i) {
+        c->misses++;
+        return NULL;
+    }
+    c->hits++;
+    c->entries[i].referenced = true;
+    return &c->entries[i].value;
+}
+
+bool cache_put(Cache *c, const Buffer *key, const Buffer *value) {
+    assert(NULL != c);
+    assert(NULL != key);
+    assert(NULL != value);
+    assert(c->slots > 0);
+
+    const size_t size = key->len + value->len;
+    if(c->maxBytes && size > c->maxBytes) {
+        log_message("cache entry of %zu bytes exceeds the %zu byte limit",
+                    size, c->maxBytes);
+        return false;
+    }
+
+    size_t i = cache_find(c, key);
+
+    if(SIZE_MAX != i) {
+        CacheEntry *e = &c->entries[i];
+        const size_t old = e->value.len;
+        if(!buffer_cpy(&e->value, value)) return false;
+        c->bytes = c->bytes - old + value->len;
+        e->referenced = true;
+        while(c->maxBytes && c->bytes > c->maxBytes) cache_evict_one(c, i);
+        return true;
+    }
+
+    while((c->maxEntries && c->count >= c->maxEntries) ||
+          (c->maxBytes && c->count > 0 && c->bytes + size > c->maxBytes)) {
+        cache_evict_one(c, SIZE_MAX);
+    }
+
+    if(0 == c->freeCount && !cache_grow(c, c->slots * 2)) return false;
+
+    i = c->freeSlots[--c->freeCount];
+    CacheEntry *e = &c->entries[i];
+
+    Buffer slot;
+    buffer_init(&slot);
+    buffer_assign_recycler(&slot, c->recycler);
+
+    if(!buffer_cpy(&e->key, key) || !buffer_cpy(&e->value, value) ||
+       !buffer_reserve(&slot, sizeof(i)) ||
+       !buffer_push_bytes(&slot, (unsigned char *) &i, sizeof(i)) ||
+       !hashtable_add(&c->index, key, &slot)) {
+        log_message("Unable to add an entry to the cache");
+        buffer_free(&e->key);
+        buffer_free(&e->value);
+        buffer_free(&slot);
+        cache_entry_reset(c, e);
+        c->freeSlots[c->freeCount++] = i;
+        return false;
+    }
+
+    buffer_free(&slot);
+    e->used = true;
+    e->referenced = false;
+    c->bytes += size;
+    c->count++;
+    return true;
+}
+
+bool cache_remove(Cache *c, const Buffer *key) {
+    assert(NULL != c);
+    assert(NULL != key);
+
+    const size_t i = cache_find(c, key);
+    if(SIZE_MAX == i) return false;
+    cache_drop(c, i, false);
+    return true;
+}
+
+size_t cache_get_count(const Cache *c) {
+    assert(NULL != c);
+    return c->count;
+}
+
+void cache_get_stats(const Cache *c, CacheStats *stats) {
+    assert(NULL != c);
+    assert(NULL != stats);
+    stats->hits = c->hits;
+    stats->misses = c->misses;
+    stats->evictions = c->evictions;
+    stats->count = c->count;
+    stats->bytes = c->bytes;
+}
+
+void cache_reset_stats(Cache *c) {
+    assert(NULL != c);
+    c->hits = 0;
+    c->misses = 0;
+    c->evictions = 0;
+}
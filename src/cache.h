@@ -0,0 +1,112 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#ifndef SEARCHFILEC_CACHE_H
+#define SEARCHFILEC_CACHE_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include "buffer.h"
+#include "hashtable.h"
+#include "recycler.h"
+
+/* Cache
+ * a key/value cache of bounded size.  A HashTable maps each key to the slot
+ * holding its entry, so get and put are O(1).  When a put would go past the
+ * entry or byte limit, entries are evicted by the CLOCK policy: a hand sweeps
+ * the slots, an entry read since the hand last passed gets a second chance,
+ * the first one which was not is evicted.  That approximates least recently
+ * used without reordering a list on every hit.
+ *
+ * An eviction callback, if set, receives the key and value buffers of every
+ * evicted entry and owns them from then on, handy for giving their memory
+ * back to a Recycler.  Without one the cache frees them itself.
+ */
+
+// called with the [key] and [value] of an evicted entry, [ctx] is the
+// pointer passed to cache_set_evict_callback
+typedef void (*CacheEvictFn)(Buffer *key, Buffer *value, void *ctx);
+
+typedef struct stCacheEntry {
+    Buffer key;
+    Buffer value;
+    bool used;
+    bool referenced;
+} CacheEntry;
+
+typedef struct stCacheStats {
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    size_t count;
+    size_t bytes;
+} CacheStats;
+
+typedef struct stCache {
+    HashTable index;
+    CacheEntry *entries;
+    size_t slots;
+    size_t *freeSlots;
+    size_t freeCount;
+    size_t count;
+    size_t hand;
+    size_t maxEntries;
+    size_t maxBytes;
+    size_t bytes;
+    CacheEvictFn onEvict;
+    void *evictCtx;
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+    Recycler *recycler;
+} Cache;
+
+// initialize cache [c] so that it is empty and holds no memory
+void cache_init(Cache *c);
+
+// assign recycler [rc] to cache [c], must be called before create
+void cache_assign_recycler(Cache *c, Recycler *rc);
+
+/* prepare cache [c] to hold at most [maxEntries] entries and at most
+ * [maxBytes] bytes of keys plus values.  a limit of 0 means that dimension
+ * is unbounded, but at least one must be set
+ * [expectedEntries] - sizes the index when only bytes are bounded, may be 0
+ * returns false on bad limits or memory exhaustion
+ */
+bool cache_create(Cache *c, size_t maxEntries, size_t maxBytes,
+                  size_t expectedEntries);
+
+// have cache [c] call [fn] with [ctx] for every evicted entry
+void cache_set_evict_callback(Cache *c, CacheEvictFn fn, void *ctx);
+
+// free all entries (without calling the eviction callback) and memory held
+// by cache [c]
+void cache_free(Cache *c);
+
+/* look up [key] in cache [c], marking the entry as recently used
+ * returns the cached value, valid until the next put or remove, or NULL
+ */
+Buffer * cache_get(Cache *c, const Buffer *key);
+
+/* store a copy of [value] under a copy of [key] in cache [c], replacing any
+ * value already cached for key and evicting entries as needed
+ * returns false if the entry alone is larger than the byte limit or memory
+ * is exhausted
+ */
+bool cache_put(Cache *c, const Buffer *key, const Buffer *value);
+
+// drop [key] from cache [c] without calling the eviction callback
+// returns true if the key was cached
+bool cache_remove(Cache *c, const Buffer *key);
+
+// returns the number of entries held by cache [c]
+size_t cache_get_count(const Cache *c);
+
+// fill [stats] with the counters and current size of cache [c]
+void cache_get_stats(const Cache *c, CacheStats *stats);
+
+// zero the hit, miss and eviction counters of cache [c]
+void cache_reset_stats(Cache *c);
+
+#endif //SEARCHFILEC_CACHE_H
@@ -2,6 +2,9 @@
 // Created by Joseph Hurdle on 7/5/20.
 //
 
+// for O_DIRECT and readahead
+#define _GNU_SOURCE
+
 #include <assert.h>
 #include <fcntl.h>
 #include "filereader.h"
@@ -9,6 +12,7 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <assert.h>
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -16,22 +20,6 @@
 #include <string.h>
 
 
-#define FILE_READER_BUFFER 1024 * 1024
-blksize_t BLOCKSIZE;
-
-unsigned long long file_get_blocksize(FileReader *file)
-{
-    const blksize_t default_buf_size = 1024 * 4; // 4k is a good guess
-    struct stat fi;
-
-    if(buffer_is_empty(&file->fileName)) return default_buf_size;
-    if(!buffer_make_string(&file->fileName)) return default_buf_size;
-    const size_t ret = stat((char *) file->fileName.data, &fi);
-    if(0 != ret ) return default_buf_size;
-    return fi.st_blksize;
-}
-
-
 void file_reader_init(FileReader * file)
 {
     buffer_init(&file->fileName);
@@ -41,6 +29,38 @@ void file_reader_init(FileReader * file)
     file->offset = 0;
     file->eof = false;
     file->recycler = NULL;
+    file->mode = FILE_READER_MODE_READ;
+    file->map = NULL;
+    file->mapStart = 0;
+    file->mapLen = 0;
+    file->mapWindow = FILE_READER_MAP_WINDOW;
+    file->fileSize = 0;
+    buffer_init(&file->line);
+    file->blockSize = FILE_READER_BLOCK;
+    file->reads = 0;
+    file->bytesRead = 0;
+    file->data = NULL;
+    file->dataLen = 0;
+    file->ahead.running = false;
+    file->ahead.blocks = NULL;
+    file->advice = FILE_READER_ADVISE_NONE;
+    file->prefetch = FILE_READER_PREFETCH;
+    file->prefetched = 0;
+    file->dropped = 0;
+    file->position = 0;
+    file->skip = 0;
+    file->rangeEnd = FILE_READER_TO_END;
+    file->stream = false;
+}
+
+void file_reader_options_init(FileReaderOptions *opts) {
+    assert(NULL != opts);
+    opts->mode = FILE_READER_MODE_READ;
+    opts->mapWindow = FILE_READER_MAP_WINDOW;
+    opts->blockSize = FILE_READER_BLOCK;
+    opts->depth = FILE_READER_DEPTH;
+    opts->advice = FILE_READER_ADVISE_NONE;
+    opts->prefetch = FILE_READER_PREFETCH;
 }
 
 void file_reader_close(FileReader *file) {
@@ -48,21 +68,180 @@ void file_reader_close(FileReader *file) {
     assert(NULL != file);
 
     if(!file->open) return;
+    if(NULL != file->map) munmap((void *) file->map, file->mapLen);
+    if(FILE_READER_MODE_ASYNC == file->mode) {
+        file->reads = read_ahead_get_reads(&file->ahead);
+        read_ahead_stop(&file->ahead);
+    }
+    close(file->fd);
     buffer_free(&file->buf);
     buffer_free(&file->fileName);
+    buffer_free(&file->line);
     file->open = false;
     file->fd = -1;
+    file->map = NULL;
+    file->mapStart = 0;
+    file->mapLen = 0;
+    file->data = NULL;
+    file->dataLen = 0;
+}
+
+/* the page cache holds a file in folios of up to a few megabytes which are
+ * only dropped when wholly inside the range given, so each range dropped
+ * overlaps the one before by more than that to catch any left straddling
+ * its end
+ */
+static void file_reader_drop_overlap(FileReader *file) {
+    file->dropped = file->dropped > FILE_READER_DROP_OVERLAP ?
+                    file->dropped - FILE_READER_DROP_OVERLAP : 0;
+}
+
+/* map the window of [file] starting at the page holding file offset [start],
+ * at least [need] bytes and a whole window from start unless the file ends
+ * first, and point the read offset at start
+ */
+static bool file_reader_map(FileReader *file, size_t start, size_t need) {
+    const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    const size_t aligned = start - start % page;
+
+    // measured from start so every new window reaches past the old one
+    size_t len = need < file->mapWindow ? file->mapWindow : need;
+    len += start - aligned;
+    if(len > file->fileSize - aligned) len = file->fileSize - aligned;
+
+    if(NULL != file->map) munmap((void *) file->map, file->mapLen);
+    file->map = NULL;
+    file->mapLen = 0;
+
+    // pages can only be dropped once nothing maps them
+    if((file->advice & FILE_READER_ADVISE_DROP_BEHIND) &&
+       aligned > file->dropped) {
+        posix_fadvise(file->fd, (off_t) file->dropped,
+                      (off_t) (aligned - file->dropped), POSIX_FADV_DONTNEED);
+        file->dropped = aligned;
+        file_reader_drop_overlap(file);
+    }
+
+    void *p = mmap(NULL, len, PROT_READ, MAP_SHARED, file->fd, (off_t) aligned);
+    if(MAP_FAILED == p) {
+        log_message("Unable to map %zu bytes of [%s] at %zu, error [%s]", len,
+                    buffer_get_string(&file->fileName), aligned,
+                    strerror(errno));
+        return false;
+    }
+    madvise(p, len, MADV_SEQUENTIAL);
+    if(file->advice & FILE_READER_ADVISE_WILLNEED)
+        madvise(p, len < file->prefetch ? len : file->prefetch, MADV_WILLNEED);
+
+    file->map = (const unsigned char *) p;
+    file->mapStart = aligned;
+    file->mapLen = len;
+    file->offset = start - aligned;
+    return true;
+}
+
+// map the window following the current one, false at the end of the file
+static bool file_reader_next_window(FileReader *file) {
+    const size_t end = file->mapStart + file->mapLen;
+    if(end >= file->fileSize) {
+        file->eof = true;
+        return false;
+    }
+    return file_reader_map(file, end, 0);
+}
+
+
+/* reserve the block buffer of a READ mode [file], aligned when the file is
+ * read O_DIRECT.  Aligned memory is handed to the buffer to free like any
+ * other, back to the recycler if it has one
+ */
+static bool file_reader_reserve_block(FileReader *file) {
+    if(!(file->advice & FILE_READER_ADVISE_DIRECT)) {
+        if(buffer_reserve(&file->buf, (unsigned int) file->blockSize))
+            return true;
+    } else {
+        MemoryChunk mc;
+        buffer_free(&file->buf);
+        if(recycler_get_aligned(file->recycler, &mc, file->blockSize,
+                                FILE_READER_DIRECT_ALIGN)) {
+            file->buf.data = mc.p;
+            file->buf.cap = mc.cap;
+            return true;
+        }
+    }
+    log_message("Unable to reserve a buffer with %zu bytes for file [%s]",
+                file->blockSize, buffer_get_string(&file->fileName));
+    return false;
 }
 
+/* the reader of [file] is done with every byte before [pos], drop them from
+ * the page cache and ask for what follows as its advice says
+ */
+static void file_reader_advise(FileReader *file, size_t pos) {
+    if((file->advice & FILE_READER_ADVISE_DROP_BEHIND) && pos > file->dropped) {
+        posix_fadvise(file->fd, (off_t) file->dropped,
+                      (off_t) (pos - file->dropped), POSIX_FADV_DONTNEED);
+        file->dropped = pos;
+        file_reader_drop_overlap(file);
+    }
+
+    // ask again once half of what was asked for has been read
+    if((file->advice & FILE_READER_ADVISE_WILLNEED) &&
+       pos + file->prefetch / 2 >= file->prefetched) {
+        const size_t from = file->prefetched > pos ? file->prefetched : pos;
+        const size_t to = pos + file->prefetch;
+#if defined(__linux__)
+        readahead(file->fd, (off_t) from, to - from);
+#else
+        posix_fadvise(file->fd, (off_t) from, (off_t) (to - from),
+                      POSIX_FADV_WILLNEED);
+#endif
+        file->prefetched = to;
+    }
+}
 
 bool file_reader_open(FileReader *file, const char *fileName) {
 
+    FileReaderOptions opts;
+    file_reader_options_init(&opts);
+    return file_reader_open_options(file, fileName, &opts);
+}
+
+bool file_reader_open_options(FileReader *file, const char *fileName,
+                              const FileReaderOptions *opts) {
+    return file_reader_open_range(file, fileName, opts, 0, FILE_READER_TO_END);
+}
+
+bool file_reader_open_range(FileReader *file, const char *fileName,
+                            const FileReaderOptions *opts, size_t start,
+                            size_t end) {
+
     assert(NULL != file);
     assert(NULL != fileName);
+    assert(NULL != opts);
+    assert(start <= end);
 
     if(file->open) file_reader_close(file);
 
-    file->fd = open(fileName, O_RDONLY);
+    file->mode = opts->mode;
+    file->advice = opts->advice;
+    if(FILE_READER_MODE_MMAP == file->mode)
+        file->advice &= ~(unsigned int) FILE_READER_ADVISE_DIRECT;
+
+    int flags = O_RDONLY;
+#if defined(O_DIRECT)
+    if(file->advice & FILE_READER_ADVISE_DIRECT) flags |= O_DIRECT;
+#else
+    file->advice &= ~(unsigned int) FILE_READER_ADVISE_DIRECT;
+#endif
+
+    file->fd = open(fileName, flags);
+    if(file->fd == -1 && O_RDONLY != flags && EINVAL == errno) {
+        log_message("File [%s] cannot be opened O_DIRECT, reading it through "
+                    "the page cache", fileName);
+        file->advice &= ~(unsigned int) FILE_READER_ADVISE_DIRECT;
+        file->fd = open(fileName, O_RDONLY);
+    }
     if(file->fd == -1) {
         fprintf(stderr, "Unable to open file [%s] for reading, error [%s]\n",
                 fileName, strerror(errno));
@@ -70,6 +249,87 @@ bool file_reader_open(FileReader *file, const char *fileName) {
     }
     buffer_strcpy(&file->fileName, fileName);
 
+    // windows are mapped a page at a time
+    const size_t page = (size_t) sysconf(_SC_PAGESIZE);
+    file->mapWindow = 0 == opts->mapWindow ? FILE_READER_MAP_WINDOW :
+                      opts->mapWindow;
+    file->mapWindow += page - 1;
+    file->mapWindow -= file->mapWindow % page;
+    file->blockSize = 0 == opts->blockSize ? FILE_READER_BLOCK :
+                      opts->blockSize;
+    if(file->blockSize > FILE_READER_BLOCK_MAX)
+        file->blockSize = FILE_READER_BLOCK_MAX;
+    if(file->advice & FILE_READER_ADVISE_DIRECT) {
+        file->blockSize += FILE_READER_DIRECT_ALIGN - 1;
+        file->blockSize -= file->blockSize % FILE_READER_DIRECT_ALIGN;
+    }
+    file->prefetch = 0 == opts->prefetch ? FILE_READER_PREFETCH :
+                     opts->prefetch;
+
+    // direct reads start on an aligned offset and skip up to the range
+    const size_t aligned = file->advice & FILE_READER_ADVISE_DIRECT ?
+                           start - start % FILE_READER_DIRECT_ALIGN : start;
+    file->position = aligned;
+    file->skip = start - aligned;
+    file->rangeEnd = end;
+    file->stream = false;
+    file->prefetched = aligned;
+    file->dropped = aligned;
+    file->offset = 0;
+    file->eof = false;
+    file->reads = 0;
+    file->bytesRead = 0;
+    file->data = NULL;
+    file->dataLen = 0;
+    buffer_clear(&file->buf);
+
+    // the one block every read goes into, allocated once up front
+    bool ready = true;
+    if(FILE_READER_MODE_READ == file->mode)
+        ready = file_reader_reserve_block(file);
+    if(FILE_READER_MODE_ASYNC == file->mode)
+        ready = read_ahead_start(&file->ahead, file->fd, aligned, end,
+                                 opts->depth, file->blockSize);
+    if(!ready) {
+        close(file->fd);
+        file->fd = -1;
+        buffer_free(&file->fileName);
+        return false;
+    }
+
+    if(file->advice & FILE_READER_ADVISE_SEQUENTIAL)
+        posix_fadvise(file->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    if(FILE_READER_MODE_MMAP == file->mode) {
+        struct stat fi;
+        bool ok = 0 == fstat(file->fd, &fi);
+        if(ok) {
+            // the end of the range stands in for the end of the file
+            file->fileSize = (size_t) fi.st_size < end ? (size_t) fi.st_size :
+                             end;
+
+            // an empty range or one past the end holds nothing, leave the
+            // window ending where the range does so no read maps again
+            if(start >= file->fileSize) {
+                file->map = NULL;
+                file->mapStart = file->fileSize;
+                file->mapLen = 0;
+                file->eof = true;
+            } else {
+                ok = file_reader_map(file, start, 0);
+            }
+        } else {
+            log_message("Unable to stat file [%s], error [%s]", fileName,
+                        strerror(errno));
+        }
+        if(!ok) {
+            close(file->fd);
+            file->fd = -1;
+            buffer_free(&file->fileName);
+            return false;
+        }
+    }
+
     file->open = true;
     return true;
 }
@@ -80,64 +340,76 @@ const char * file_get_filename(FileReader *file)
     return (const char *) file->fileName.data;
 }
 
-bool file_refill_buffer(FileReader *file) {
+/* move [file] on to its next block, read straight into its buffer or
+ * handed over by the read ahead thread.  The old block holds nothing still to
+ * be read by then, so nothing is allocated or moved
+ */
+static bool file_refill_buffer(FileReader *file) {
 
     assert(NULL != file);
 
     if(file->eof) return false;
     if(!file->open) return false;
+    assert(file->offset >= file->dataLen);
 
-    Buffer tmp;
-    buffer_init(&tmp);
-    tmp.recycler = file->recycler;
-
-    const unsigned long long BS = file_get_blocksize(file);
-
-    if(!buffer_reserve(&tmp, BS)) {
-        log_message("Unable to reserve a buffer with %zu bytes for file", BS);
-        return false;
-    }
+    file->dataLen = 0;
+    file->offset = 0;
+    if(FILE_READER_ADVISE_NONE != file->advice)
+        file_reader_advise(file, file->position);
+
+    if(FILE_READER_MODE_ASYNC == file->mode) {
+        if(!read_ahead_next(&file->ahead, &file->data, &file->dataLen)) {
+            if(0 == file->ahead.error) {
+                file->eof = true;
+            } else {
+                log_message("Unable to read file [%s], error [%s]",
+                            buffer_get_string(&file->fileName),
+                            strerror(file->ahead.error));
+            }
+            return false;
+        }
+    } else {
+        if(file->position >= file->rangeEnd) {
+            file->eof = true;
+            return false;
+        }
 
-    // read those bytes
-    int ret = read(file->fd, tmp.data, BS);
+        // the last read of a range is cut back to it, after rounding up to
+        // a length O_DIRECT accepts
+        size_t want = file->blockSize;
+        const size_t left = file->rangeEnd - file->position;
+        if(left < want) {
+            want = left + FILE_READER_DIRECT_ALIGN - 1;
+            want -= want % FILE_READER_DIRECT_ALIGN;
+            if(want > file->blockSize) want = file->blockSize;
+        }
 
-    // 0 means eof
-    if(0 == ret) {
-        file->eof = true;
-        return false;
-    } else if (ret < 0)
-    {
-        // read error
-    }
+        const ssize_t ret = read_ahead_read_at(file->fd, file->buf.data, want,
+                                               file->position, &file->stream);
+        ++file->reads;
 
-    // tmp's actual length is equal to count of blocks read
-    tmp.len = ret;
+        // 0 means eof
+        if(0 == ret) {
+            file->eof = true;
+            return false;
+        } else if (ret < 0) {
+            log_message("Unable to read file [%s], error [%s]",
+                        buffer_get_string(&file->fileName), strerror(errno));
+            return false;
+        }
 
-    if(buffer_is_empty(&file->buf)) {
-        buffer_swap(&file->buf, &tmp);
-        file->offset = 0;
-        return true;
+        file->data = file->buf.data;
+        file->dataLen = (size_t) ret < left ? (size_t) ret : left;
     }
 
-    // remaining bytes in old buffer
-    const long long remainingBytes = (long long) (file->buf.len - file->offset);
+    file->position += file->dataLen;
+    file->bytesRead += file->dataLen;
 
-    // left shift so only remaining bytes are left in buffer
-    if(!buffer_lshift(&file->buf, file->offset)) {
-        log_message("Failure to lshift file buffer by %zu before appending %zu bytes",
-                    file->offset, BS);
-        return false;
+    // an aligned first block holds bytes from before the range
+    if(0 != file->skip) {
+        file->offset = file->skip < file->dataLen ? file->skip : file->dataLen;
+        file->skip = 0;
     }
-
-    // append the new block of file data to the file's buffer
-    if(!buffer_append(&file->buf, &tmp)) {
-        log_message("Failure to append temporary read buffer to file buffer");
-        return false;
-    }
-
-    // return tmp now that we are done
-    buffer_free(&tmp);
-
     return true;
 }
 
@@ -145,16 +417,22 @@ bool file_reader_read_byte(FileReader *file, unsigned char *byte) {
     assert(NULL != file);
     assert(NULL != byte);
 
-    if(file->offset >= file->buf.len) {
+    if(FILE_READER_MODE_MMAP == file->mode) {
+        if(file->offset >= file->mapLen && !file_reader_next_window(file))
+            return false;
+        *byte = file->map[file->offset++];
+        return true;
+    }
+
+    while(file->offset >= file->dataLen) {
         if(!file_refill_buffer(file)) {
             if(file_reader_eof(file)) return false;  // handle eof silently
             log_message("failure to refill file buffer, unable to read more");
             return false;
         }
-        return file_reader_read_byte(file, byte);
     }
 
-    *byte = file->buf.data[file->offset++];
+    *byte = file->data[file->offset++];
     return true;
 }
 
@@ -163,32 +441,247 @@ bool file_reader_read_line(FileReader *file, Buffer *buf, unsigned char delim) {
     assert(NULL != file);
     assert(NULL != buf);
 
-    bool delimFound = false;
-    bool error = false;
+    BufferView view;
+    buffer_clear(buf);
+    return file_reader_read_line_view(file, &view, delim) &&
+           buffer_push_bytes(buf, view.data, view.len);
+}
+
+/* read the next line of [file] out of the block it holds, the line is only
+ * copied, into file->line, when it runs on past the end of the block
+ */
+static bool file_reader_read_line_buffered(FileReader *file, BufferView *line,
+                                           unsigned char delim) {
+    bool spanned = false;
+    buffer_clear(&file->line);
+
+    for(;;) {
+        const size_t avail = file->dataLen - file->offset;
+        const unsigned char *start = avail > 0 ? file->data + file->offset : NULL;
+        const unsigned char *p = avail > 0 ? memchr(start, delim, avail) : NULL;
+
+        if(NULL != p) {
+            const size_t len = (size_t) (p - start) + 1;
+            file->offset += len;
+            if(!spanned) {
+                buffer_view_set(line, start, len);
+                return true;
+            }
+            if(!buffer_push_bytes(&file->line, start, len)) {
+                log_message("unable to push %zu bytes on file line buffer", len);
+                return false;
+            }
+            break;
+        }
 
-    unsigned char c;
+        // keep the start of the line before the buffer is refilled
+        if(avail > 0) {
+            if(!buffer_push_bytes(&file->line, start, avail)) {
+                log_message("unable to push %zu bytes on file line buffer", avail);
+                return false;
+            }
+            file->offset += avail;
+            spanned = true;
+        }
 
-    buffer_clear(buf);
+        if(!file_refill_buffer(file)) {
+            if(!file->eof) {
+                log_message("failure to refill file buffer, unable to read more");
+                return false;
+            }
+            // the last line of the file need not end with the delimiter
+            if(!spanned) return false;
+            break;
+        }
+    }
 
-    while(!delimFound) {
+    buffer_view_from_buffer(line, &file->line);
+    return true;
+}
 
-        if(!file_reader_read_byte(file, &c)) {
-            if(file->eof) {
-                if(buffer_is_empty(buf)) return false;
-                return true;
+// read the next line of [file] straight out of the mapped window
+static bool file_reader_read_line_mapped(FileReader *file, BufferView *line,
+                                         unsigned char delim) {
+    size_t scanned = file->offset;
+    for(;;) {
+        const unsigned char *p = NULL;
+        if(scanned < file->mapLen)
+            p = memchr(file->map + scanned, delim, file->mapLen - scanned);
+        if(NULL != p) {
+            const size_t end = (size_t) (p - file->map) + 1;
+            buffer_view_set(line, file->map + file->offset, end - file->offset);
+            file->offset = end;
+            return true;
+        }
+
+        // the last line of the file need not end with the delimiter
+        if(file->mapStart + file->mapLen >= file->fileSize) {
+            if(file->offset >= file->mapLen) {
+                file->eof = true;
+                return false;
             }
+            buffer_view_set(line, file->map + file->offset,
+                            file->mapLen - file->offset);
+            file->offset = file->mapLen;
+            return true;
         }
 
-        if(delim == c) delimFound = true;
-        if(!buffer_push_byte(buf, c)) {
-            log_message("unable to push a byte on output line buffer");
+        // the line runs past the window, map again from where it starts
+        // keeping what has been searched, twice over when it is that long
+        const size_t start = file->mapStart + file->offset;
+        const size_t searched = file->mapStart + file->mapLen;
+        if(!file_reader_map(file, start, 2 * (searched - start))) return false;
+        scanned = searched - file->mapStart;
+    }
+}
+
+bool file_reader_read_line_view(FileReader *file, BufferView *line,
+                                unsigned char delim) {
+    assert(NULL != file);
+    assert(NULL != line);
+
+    if(!file->open) return false;
+    if(FILE_READER_MODE_MMAP == file->mode)
+        return file_reader_read_line_mapped(file, line, delim);
+    return file_reader_read_line_buffered(file, line, delim);
+}
+
+// find the last [delim] in the [len] bytes at [data], NULL if there is none
+static const unsigned char *file_reader_find_last(const unsigned char *data,
+                                                  size_t len,
+                                                  unsigned char delim) {
+    while(len > 0) {
+        if(delim == data[--len]) return data + len;
+    }
+    return NULL;
+}
+
+bool file_reader_read_block(FileReader *file, BufferView *block,
+                            unsigned char delim) {
+    assert(NULL != file);
+    assert(NULL != block);
+
+    if(!file->open) return false;
+
+    for(;;) {
+        const bool mapped = FILE_READER_MODE_MMAP == file->mode;
+        const size_t avail = mapped ? file->mapLen - file->offset :
+                             file->dataLen - file->offset;
+
+        if(avail > 0) {
+            const unsigned char *start = mapped ? file->map + file->offset :
+                                         file->data + file->offset;
+            const unsigned char *last = file_reader_find_last(start, avail, delim);
+            if(NULL == last) {
+                // no whole line left, the next runs on past what is held
+                return file_reader_read_line_view(file, block, delim);
+            }
+            const size_t len = (size_t) (last - start) + 1;
+            buffer_view_set(block, start, len);
+            file->offset += len;
+            return true;
+        }
+
+        if(mapped) {
+            if(!file_reader_next_window(file)) return false;
+        } else if(!file_refill_buffer(file)) {
+            if(!file->eof)
+                log_message("failure to refill file buffer, unable to read more");
             return false;
         }
     }
+}
+
+bool file_reader_next_line(BufferView *block, BufferView *line,
+                           unsigned char delim) {
+    assert(NULL != block);
+    assert(NULL != line);
+
+    if(0 == block->len) return false;
 
+    const unsigned char *p = memchr(block->data, delim, block->len);
+    const size_t len = NULL == p ? block->len :
+                       (size_t) (p - block->data) + 1;
+    buffer_view_set(line, block->data, len);
+    buffer_view_set(block, block->data + len, block->len - len);
     return true;
 }
 
+/* move [pos] of [fd] forward to just after the next [delim] at or after
+ * pos - 1, to [size] when there is none
+ */
+static bool file_reader_align(int fd, unsigned char delim, size_t size,
+                              size_t *pos) {
+    unsigned char buf[64 * 1024];
+    bool stream = false;
+    size_t at = *pos - 1;
+    while(at < size) {
+        const ssize_t ret = read_ahead_read_at(fd, buf, sizeof(buf), at, &stream);
+        if(ret <= 0) return 0 == ret;
+        const unsigned char *p = memchr(buf, delim, (size_t) ret);
+        if(NULL != p) {
+            *pos = at + (size_t) (p - buf) + 1;
+            return true;
+        }
+        at += (size_t) ret;
+    }
+    *pos = size;
+    return true;
+}
+
+bool file_reader_split(const char *fileName, unsigned char delim, size_t count,
+                       FileRange *ranges, size_t *found) {
+    assert(NULL != fileName);
+    assert(NULL != ranges);
+    assert(NULL != found);
+
+    *found = 0;
+    if(0 == count) return true;
+
+    const int fd = open(fileName, O_RDONLY);
+    if(-1 == fd) {
+        log_message("Unable to open file [%s] to split, error [%s]", fileName,
+                    strerror(errno));
+        return false;
+    }
+    struct stat fi;
+    if(0 != fstat(fd, &fi)) {
+        log_message("Unable to stat file [%s], error [%s]", fileName,
+                    strerror(errno));
+        close(fd);
+        return false;
+    }
+    const size_t size = (size_t) fi.st_size;
+
+    // each cut is moved on past a delimiter, ranges it empties are left out
+    size_t start = 0;
+    for(size_t i = 1; i <= count && start < size; ++i) {
+        size_t cut = i == count ? size : size / count * i + size % count * i / count;
+        if(cut <= start) continue;
+        if(cut < size && !file_reader_align(fd, delim, size, &cut)) {
+            log_message("Unable to read file [%s] to split, error [%s]",
+                        fileName, strerror(errno));
+            close(fd);
+            return false;
+        }
+        ranges[*found].start = start;
+        ranges[*found].end = cut;
+        ++*found;
+        start = cut;
+    }
+
+    close(fd);
+    return true;
+}
+
+void file_reader_get_stats(const FileReader *file, FileReaderStats *stats) {
+    assert(NULL != file);
+    assert(NULL != stats);
+    stats->reads = FILE_READER_MODE_ASYNC == file->mode && file->open ?
+                   read_ahead_get_reads(&file->ahead) : file->reads;
+    stats->bytesRead = file->bytesRead;
+}
+
 bool file_reader_eof(FileReader *file) {
     assert(NULL != file);
     return file->eof;
@@ -200,4 +693,5 @@ void file_reader_assign_recycler(FileReader *file, Recycler *rc) {
     file->recycler = rc;
     file->fileName.recycler = rc;
     file->buf.recycler = rc;
+    file->line.recycler = rc;
 }
\ No newline at end of file
@@ -8,6 +8,103 @@
 #include <stdbool.h>
 #include "buffer.h"
 #include "recycler.h"
+#include "readahead.h"
+
+/* how a FileReader gets at the file, READ copies it through read() into the
+ * reader's buffer, MMAP maps it so lines are handed out straight from the
+ * page cache, ASYNC reads blocks ahead of the caller on a background thread
+ * so reading the disk and working on the lines overlap
+ */
+typedef enum eFileReaderMode {
+    FILE_READER_MODE_READ,
+    FILE_READER_MODE_MMAP,
+    FILE_READER_MODE_ASYNC
+} FileReaderMode;
+
+// bytes of a file mapped at once in MMAP mode
+#define FILE_READER_MAP_WINDOW ((size_t) 1 << 30)
+
+// bytes read into the buffer at a time in READ mode, by default and at most
+#define FILE_READER_BLOCK ((size_t) 1 << 20)
+#define FILE_READER_BLOCK_MAX ((size_t) 16 << 20)
+
+// blocks held by an ASYNC reader by default
+#define FILE_READER_DEPTH 4
+
+/* hints about how a file is read, or'd together in FileReaderOptions
+ * SEQUENTIAL - posix_fadvise the whole file SEQUENTIAL, so the kernel reads
+ *              further ahead and frees pages behind sooner
+ * WILLNEED - keep [prefetch] bytes ahead of the reader asked for, with
+ *            readahead() where there is one, in MMAP mode the first prefetch
+ *            bytes of each window are madvised WILLNEED
+ * DROP_BEHIND - drop pages from the page cache once the reader has gone
+ *               past them, so scanning a huge file does not evict everything
+ *               else.  In MMAP mode a window at a time, on moving to the next
+ * DIRECT - open the file O_DIRECT so READ and ASYNC modes bypass the page
+ *          cache altogether, into blocks aligned to and a multiple of
+ *          FILE_READER_DIRECT_ALIGN.  Where the file system refuses O_DIRECT
+ *          the file is read through the page cache instead
+ */
+typedef enum eFileReaderAdvice {
+    FILE_READER_ADVISE_NONE = 0,
+    FILE_READER_ADVISE_SEQUENTIAL = 1,
+    FILE_READER_ADVISE_WILLNEED = 2,
+    FILE_READER_ADVISE_DROP_BEHIND = 4,
+    FILE_READER_ADVISE_DIRECT = 8
+} FileReaderAdvice;
+
+// bytes asked for ahead of the reader with FILE_READER_ADVISE_WILLNEED
+#define FILE_READER_PREFETCH ((size_t) 16 << 20)
+
+// bytes each range dropped with FILE_READER_ADVISE_DROP_BEHIND goes back over
+#define FILE_READER_DROP_OVERLAP ((size_t) 4 << 20)
+
+// alignment of buffers, offsets and lengths for FILE_READER_ADVISE_DIRECT
+#define FILE_READER_DIRECT_ALIGN 4096
+
+/* FileReaderOptions
+ * choices made when a file is opened, start from file_reader_options_init
+ * [mode] - how the file is read
+ * [mapWindow] - MMAP mode maps at most this many bytes at a time, moving the
+ *               window along the file, so inputs larger than the address
+ *               space budget can be read.  A line longer than the window
+ *               gets a larger window of its own.  Rounded up to whole pages
+ * [blockSize] - READ and ASYNC modes read this many bytes at a time into
+ *               blocks allocated once when the file is opened, up to
+ *               FILE_READER_BLOCK_MAX
+ * [depth] - blocks an ASYNC reader holds, one with the caller and the rest
+ *           being read ahead
+ * [advice] - FileReaderAdvice flags
+ * [prefetch] - bytes kept asked for ahead with FILE_READER_ADVISE_WILLNEED
+ */
+typedef struct stFileReaderOptions {
+    FileReaderMode mode;
+    size_t mapWindow;
+    size_t blockSize;
+    size_t depth;
+    unsigned int advice;
+    size_t prefetch;
+} FileReaderOptions;
+
+// the end of a range running to the end of the file
+#define FILE_READER_TO_END READ_AHEAD_TO_END
+
+/* FileRange
+ * bytes [start] up to [end] of a file
+ */
+typedef struct stFileRange {
+    size_t start;
+    size_t end;
+} FileRange;
+
+/* FileReaderStats
+ * [reads] - read calls made on the file since it was opened
+ * [bytesRead] - bytes they returned
+ */
+typedef struct stFileReaderStats {
+    size_t reads;
+    size_t bytesRead;
+} FileReaderStats;
 
 typedef struct stFileReader {
     Buffer fileName;
@@ -18,14 +115,100 @@ typedef struct stFileReader {
     bool eof;
     Recycler *recycler;
 
+    FileReaderMode mode;
+    const unsigned char *map;
+    size_t mapStart;
+    size_t mapLen;
+    size_t mapWindow;
+    size_t fileSize;
+    Buffer line;
+    size_t blockSize;
+    size_t reads;
+    size_t bytesRead;
+    const unsigned char *data;
+    size_t dataLen;
+    ReadAhead ahead;
+    unsigned int advice;
+    size_t prefetch;
+    size_t prefetched;
+    size_t dropped;
+    size_t position;
+    size_t skip;
+    size_t rangeEnd;
+    bool stream;
 } FileReader;
 
 
 void file_reader_init(FileReader * file);
 void file_reader_close(FileReader *file);
 bool file_reader_open(FileReader *file, const char *fileName);
+
+// set [opts] to the defaults file_reader_open uses
+void file_reader_options_init(FileReaderOptions *opts);
+
+/* open [fileName] for reading by [file] as set out by [opts]
+ * returns false if the file cannot be opened or mapped
+ */
+bool file_reader_open_options(FileReader *file, const char *fileName,
+                              const FileReaderOptions *opts);
+
+/* open bytes [start] up to [end] of [fileName] for reading by [file] as if
+ * they were the whole file, read with pread so any number of readers can
+ * work through one file at once
+ * [end] - offset after the last byte, or FILE_READER_TO_END
+ * returns false if the file cannot be opened or mapped
+ */
+bool file_reader_open_range(FileReader *file, const char *fileName,
+                            const FileReaderOptions *opts, size_t start,
+                            size_t end);
+
+/* split [fileName] into up to [count] ranges of about the same size for
+ * readers to work on in parallel, each ending just after a [delim] (or at
+ * the end of the file) so every line is in exactly one range.  Between them
+ * the ranges cover the file, in order, fewer than count when lines are too
+ * long to cut it that many times
+ * [ranges] - set to the ranges, room for count of them
+ * [found] - set to the number of ranges
+ * returns false if the file cannot be read
+ */
+bool file_reader_split(const char *fileName, unsigned char delim, size_t count,
+                       FileRange *ranges, size_t *found);
+
 bool file_reader_read_byte(FileReader *file, unsigned char *byte);
 bool file_reader_read_line(FileReader *file, Buffer *buf, unsigned char delim);
+
+/* read the next line of [file], ending with [delim] unless it is the last
+ * line of the file, without copying it out
+ * [line] - view set to the line, pointing into the mapped file in MMAP mode
+ *          or the read buffer otherwise, it is only copied when it runs on
+ *          past the end of the buffer.  It is valid until the next read from
+ *          file
+ * returns false at the end of the file or on error
+ */
+bool file_reader_read_line_view(FileReader *file, BufferView *line,
+                                unsigned char delim);
+
+/* read every whole line left in the block [file] holds, for splitting with
+ * file_reader_next_line in a tight loop.  A line running on past the block is
+ * returned as a block of its own, as is the last line of the file which need
+ * not end with [delim]
+ * [block] - view set to the lines, valid until the next read from file
+ * returns false at the end of the file or on error
+ */
+bool file_reader_read_block(FileReader *file, BufferView *block,
+                            unsigned char delim);
+
+/* split the first line, up to and including [delim], off the front of
+ * [block], or all of it if it holds no delim
+ * [line] - view set to the line
+ * returns false once block is empty
+ */
+bool file_reader_next_line(BufferView *block, BufferView *line,
+                           unsigned char delim);
+
+// get the count of reads made on [file] into [stats]
+void file_reader_get_stats(const FileReader *file, FileReaderStats *stats);
+
 bool file_reader_eof(FileReader *file);
 void file_reader_assign_recycler(FileReader *file, Recycler *rc);
 
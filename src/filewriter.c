@@ -0,0 +1,399 @@
+//
+// Created by Joseph Hurdle on 10/19/26.
+//
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "filewriter.h"
+#include "log.h"
+
+void file_writer_init(FileWriter *w) {
+    assert(NULL != w);
+    buffer_init(&w->fileName);
+    buffer_init(&w->buf);
+    buffer_init(&w->spare);
+    w->fd = -1;
+    w->open = false;
+    w->failed = false;
+    w->bufferSize = FILE_WRITER_BUFFER;
+    w->sync = FILE_WRITER_SYNC_NONE;
+    w->syncBytes = 0;
+    w->unsynced = 0;
+    w->writes = 0;
+    w->bytesWritten = 0;
+    w->syncs = 0;
+    w->recycler = NULL;
+    w->background = false;
+    w->pending = false;
+    w->stop = false;
+    w->error = 0;
+}
+
+void file_writer_options_init(FileWriterOptions *opts) {
+    assert(NULL != opts);
+    opts->bufferSize = FILE_WRITER_BUFFER;
+    opts->background = false;
+    opts->sync = FILE_WRITER_SYNC_NONE;
+    opts->syncBytes = (size_t) 64 << 20;
+    opts->append = false;
+}
+
+void file_writer_assign_recycler(FileWriter *w, Recycler *rc) {
+    assert(NULL != w);
+    assert(NULL != rc);
+    w->recycler = rc;
+    w->fileName.recycler = rc;
+    w->buf.recycler = rc;
+    w->spare.recycler = rc;
+}
+
+// fdatasync the file of [w], counting it
+static bool file_writer_datasync(FileWriter *w) {
+    w->syncs++;
+    w->unsynced = 0;
+    if(0 == fdatasync(w->fd)) return true;
+    const int error = errno;
+    log_message("Unable to sync file [%s], error [%s]",
+                buffer_get_string(&w->fileName), strerror(error));
+    errno = error;
+    return false;
+}
+
+/* write all of the [count] pieces at [iov] to the file of [w], however many
+ * writev calls it takes, then sync as the policy says.  Only ever run by one
+ * thread at a time, the background thread while a write is pending and the
+ * caller otherwise
+ */
+static bool file_writer_writev(FileWriter *w, struct iovec *iov, int count) {
+    size_t total = 0;
+    for(int i = 0; i < count; ++i) total += iov[i].iov_len;
+
+    while(count > 0) {
+        const ssize_t ret = writev(w->fd, iov, count);
+        w->writes++;
+        if(ret < 0) {
+            if(EINTR == errno) continue;
+            const int error = errno;
+            log_message("Unable to write file [%s], error [%s]",
+                        buffer_get_string(&w->fileName), strerror(error));
+            errno = error;
+            return false;
+        }
+
+        // step over what went out, a short write leaves a piece part done
+        size_t done = (size_t) ret;
+        while(count > 0 && done >= iov->iov_len) {
+            done -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if(count > 0) {
+            iov->iov_base = (unsigned char *) iov->iov_base + done;
+            iov->iov_len -= done;
+        }
+    }
+
+    w->bytesWritten += total;
+    w->unsynced += total;
+    if(FILE_WRITER_SYNC_FLUSH == w->sync ||
+       (FILE_WRITER_SYNC_BYTES == w->sync && w->unsynced >= w->syncBytes))
+        return file_writer_datasync(w);
+    return true;
+}
+
+static void * file_writer_flusher(void *arg) {
+    FileWriter *w = (FileWriter *) arg;
+
+    pthread_mutex_lock(&w->lock);
+    for(;;) {
+        while(!w->pending && !w->stop) pthread_cond_wait(&w->wake, &w->lock);
+        if(!w->pending) break;
+        pthread_mutex_unlock(&w->lock);
+
+        struct iovec iov = {w->spare.data, w->spare.len};
+        const bool ok = file_writer_writev(w, &iov, 1);
+        const int error = errno;
+
+        pthread_mutex_lock(&w->lock);
+        if(!ok) w->error = 0 == error ? EIO : error;
+        w->spare.len = 0;
+        w->pending = false;
+        pthread_cond_broadcast(&w->wake);
+    }
+    pthread_mutex_unlock(&w->lock);
+    return NULL;
+}
+
+// wait for a background write of [w] to finish, false if one has failed
+static bool file_writer_wait(FileWriter *w) {
+    if(w->background) {
+        pthread_mutex_lock(&w->lock);
+        while(w->pending) pthread_cond_wait(&w->wake, &w->lock);
+        if(0 != w->error) w->failed = true;
+        pthread_mutex_unlock(&w->lock);
+    }
+    return !w->failed;
+}
+
+// write out the buffer of [w], handing it to the background thread if any
+static bool file_writer_flush_buffer(FileWriter *w) {
+    if(0 == w->buf.len) return !w->failed;
+    if(!w->background) {
+        struct iovec iov = {w->buf.data, w->buf.len};
+        w->buf.len = 0;
+        if(!file_writer_writev(w, &iov, 1)) w->failed = true;
+        return !w->failed;
+    }
+
+    // the next buffer fills while this one is written
+    if(!file_writer_wait(w)) return false;
+    pthread_mutex_lock(&w->lock);
+    buffer_swap(&w->buf, &w->spare);
+    w->pending = true;
+    pthread_cond_broadcast(&w->wake);
+    pthread_mutex_unlock(&w->lock);
+    w->buf.len = 0;
+    return true;
+}
+
+/* write the gathered [count] pieces at [iov] and the bytes of the buffer of
+ * [w] from [segment] on, everything gathered so far, in one go
+ */
+static bool file_writer_write_gathered(FileWriter *w, struct iovec *iov,
+                                       int count, size_t segment) {
+    if(segment < w->buf.len) {
+        iov[count].iov_base = w->buf.data + segment;
+        iov[count].iov_len = w->buf.len - segment;
+        ++count;
+    }
+    w->buf.len = 0;
+    if(!file_writer_wait(w)) return false;
+    if(!file_writer_writev(w, iov, count)) w->failed = true;
+    return !w->failed;
+}
+
+bool file_writer_write_views(FileWriter *w, const BufferView *views,
+                             size_t count) {
+    assert(NULL != w);
+    assert(NULL != views || 0 == count);
+
+    if(!w->open || w->failed) return false;
+
+    /* long views are gathered into iov from where they are, in between the
+     * stretches of the buffer holding the short views copied before them,
+     * which start at [segment].  Anything gathered is written before
+     * returning, the views are only good for the call
+     */
+    struct iovec iov[FILE_WRITER_IOV];
+    int gathered = 0;
+    size_t segment = 0;
+    const size_t copyMax = w->bufferSize < FILE_WRITER_COPY_MAX ?
+                           w->bufferSize : FILE_WRITER_COPY_MAX;
+
+    for(size_t i = 0; i < count; ++i) {
+        const BufferView *v = &views[i];
+        if(0 == v->len) continue;
+
+        if(v->len <= copyMax) {
+            if(v->len > w->bufferSize - w->buf.len) {
+                const bool ok = 0 == gathered ? file_writer_flush_buffer(w) :
+                                file_writer_write_gathered(w, iov, gathered,
+                                                           segment);
+                if(!ok) return false;
+                gathered = 0;
+                segment = 0;
+            }
+            memcpy(w->buf.data + w->buf.len, v->data, v->len);
+            w->buf.len += v->len;
+            continue;
+        }
+
+        // room for a stretch of the buffer before and after the view
+        if(gathered + 3 > FILE_WRITER_IOV) {
+            if(!file_writer_write_gathered(w, iov, gathered, segment))
+                return false;
+            gathered = 0;
+            segment = 0;
+        }
+        if(segment < w->buf.len) {
+            iov[gathered].iov_base = w->buf.data + segment;
+            iov[gathered].iov_len = w->buf.len - segment;
+            ++gathered;
+            segment = w->buf.len;
+        }
+        iov[gathered].iov_base = (void *) v->data;
+        iov[gathered].iov_len = v->len;
+        ++gathered;
+    }
+
+    if(0 == gathered) return true;
+    return file_writer_write_gathered(w, iov, gathered, segment);
+}
+
+bool file_writer_write_bytes(FileWriter *w, const unsigned char *data,
+                             size_t len) {
+    assert(NULL != w);
+    assert(NULL != data || 0 == len);
+
+    if(0 == len) return w->open && !w->failed;
+
+    // short writes with room to spare are only copied
+    if(len <= FILE_WRITER_COPY_MAX && len <= w->bufferSize - w->buf.len &&
+       w->open && !w->failed) {
+        memcpy(w->buf.data + w->buf.len, data, len);
+        w->buf.len += len;
+        return true;
+    }
+
+    BufferView view;
+    buffer_view_set(&view, data, len);
+    return file_writer_write_views(w, &view, 1);
+}
+
+bool file_writer_write_byte(FileWriter *w, unsigned char c) {
+    assert(NULL != w);
+    if(w->buf.len < w->bufferSize && w->open && !w->failed) {
+        w->buf.data[w->buf.len++] = c;
+        return true;
+    }
+    return file_writer_write_bytes(w, &c, 1);
+}
+
+bool file_writer_write(FileWriter *w, const Buffer *buf) {
+    assert(NULL != buf);
+    return file_writer_write_bytes(w, buf->data, buf->len);
+}
+
+bool file_writer_write_view(FileWriter *w, const BufferView *view) {
+    assert(NULL != view);
+    return file_writer_write_bytes(w, view->data, view->len);
+}
+
+bool file_writer_flush(FileWriter *w) {
+    assert(NULL != w);
+    if(!w->open) return false;
+    return file_writer_flush_buffer(w) && file_writer_wait(w);
+}
+
+bool file_writer_sync(FileWriter *w) {
+    assert(NULL != w);
+    if(!file_writer_flush(w)) return false;
+    if(!file_writer_datasync(w)) w->failed = true;
+    return !w->failed;
+}
+
+void file_writer_get_stats(FileWriter *w, FileWriterStats *stats) {
+    assert(NULL != w);
+    assert(NULL != stats);
+    if(w->open) file_writer_wait(w);
+    stats->writes = w->writes;
+    stats->bytesWritten = w->bytesWritten;
+    stats->syncs = w->syncs;
+}
+
+bool file_writer_open(FileWriter *w, const char *fileName) {
+    FileWriterOptions opts;
+    file_writer_options_init(&opts);
+    return file_writer_open_options(w, fileName, &opts);
+}
+
+bool file_writer_open_options(FileWriter *w, const char *fileName,
+                              const FileWriterOptions *opts) {
+    assert(NULL != w);
+    assert(NULL != fileName);
+    assert(NULL != opts);
+
+    if(w->open) file_writer_close(w);
+
+    const int flags = O_WRONLY | O_CREAT | (opts->append ? O_APPEND : O_TRUNC);
+    w->fd = open(fileName, flags, 0644);
+    if(-1 == w->fd) {
+        log_message("Unable to open file [%s] for writing, error [%s]",
+                    fileName, strerror(errno));
+        return false;
+    }
+    buffer_strcpy(&w->fileName, fileName);
+
+    w->failed = false;
+    w->bufferSize = 0 == opts->bufferSize ? FILE_WRITER_BUFFER :
+                    opts->bufferSize;
+    if(w->bufferSize > FILE_WRITER_BUFFER_MAX)
+        w->bufferSize = FILE_WRITER_BUFFER_MAX;
+    w->sync = opts->sync;
+    w->syncBytes = opts->syncBytes;
+    w->unsynced = 0;
+    w->writes = 0;
+    w->bytesWritten = 0;
+    w->syncs = 0;
+    w->background = opts->background;
+    w->pending = false;
+    w->stop = false;
+    w->error = 0;
+    buffer_clear(&w->buf);
+    buffer_clear(&w->spare);
+
+    bool ok = buffer_reserve(&w->buf, (unsigned int) w->bufferSize) &&
+              (!w->background ||
+               buffer_reserve(&w->spare, (unsigned int) w->bufferSize));
+    if(!ok) {
+        log_message("Unable to reserve a buffer with %zu bytes for file [%s]",
+                    w->bufferSize, fileName);
+    } else if(w->background) {
+        pthread_mutex_init(&w->lock, NULL);
+        pthread_cond_init(&w->wake, NULL);
+        ok = 0 == pthread_create(&w->thread, NULL, file_writer_flusher, w);
+        if(!ok) {
+            log_message("Unable to start flush thread for file [%s]", fileName);
+            pthread_mutex_destroy(&w->lock);
+            pthread_cond_destroy(&w->wake);
+        }
+    }
+    if(!ok) {
+        close(w->fd);
+        w->fd = -1;
+        buffer_free(&w->fileName);
+        return false;
+    }
+
+    w->open = true;
+    return true;
+}
+
+bool file_writer_close(FileWriter *w) {
+    assert(NULL != w);
+
+    if(!w->open) return false;
+
+    bool ok = file_writer_flush(w);
+    if(w->background) {
+        pthread_mutex_lock(&w->lock);
+        w->stop = true;
+        pthread_cond_broadcast(&w->wake);
+        pthread_mutex_unlock(&w->lock);
+        pthread_join(w->thread, NULL);
+        pthread_mutex_destroy(&w->lock);
+        pthread_cond_destroy(&w->wake);
+    }
+
+    if(ok && w->unsynced > 0 && (FILE_WRITER_SYNC_CLOSE == w->sync ||
+                                 FILE_WRITER_SYNC_BYTES == w->sync))
+        ok = file_writer_datasync(w);
+
+    if(0 != close(w->fd)) {
+        log_message("Unable to close file [%s], error [%s]",
+                    buffer_get_string(&w->fileName), strerror(errno));
+        ok = false;
+    }
+
+    buffer_free(&w->buf);
+    buffer_free(&w->spare);
+    buffer_free(&w->fileName);
+    w->fd = -1;
+    w->open = false;
+    w->background = false;
+    return ok;
+}
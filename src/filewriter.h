@@ -0,0 +1,153 @@
+//
+// Created by Joseph Hurdle on 10/19/26.
+//
+
+#ifndef SEARCHFILEC_FILEWRITER_H
+#define SEARCHFILEC_FILEWRITER_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include "buffer.h"
+#include "recycler.h"
+
+// bytes gathered before they are written, by default and at most
+#define FILE_WRITER_BUFFER ((size_t) 1 << 20)
+#define FILE_WRITER_BUFFER_MAX ((size_t) 256 << 20)
+
+// longer writes are not copied, they go out from where they are in one
+// writev with whatever was gathered before them
+#define FILE_WRITER_COPY_MAX 4096
+
+// most pieces gathered into one writev
+#define FILE_WRITER_IOV 64
+
+/* when a FileWriter makes sure what it wrote is on disk with fdatasync
+ * NONE - never, it is left to the kernel
+ * CLOSE - once, when the file is closed
+ * FLUSH - after every write to the file
+ * BYTES - whenever [syncBytes] more have been written, and at close
+ */
+typedef enum eFileWriterSync {
+    FILE_WRITER_SYNC_NONE,
+    FILE_WRITER_SYNC_CLOSE,
+    FILE_WRITER_SYNC_FLUSH,
+    FILE_WRITER_SYNC_BYTES
+} FileWriterSync;
+
+/* FileWriterOptions
+ * choices made when a file is opened, start from file_writer_options_init
+ * [bufferSize] - bytes gathered before they are written, up to
+ *                FILE_WRITER_BUFFER_MAX
+ * [background] - write full buffers on a thread of the writer's own while
+ *                the next one fills, at the cost of a second buffer
+ * [sync] - when written bytes are made durable
+ * [syncBytes] - bytes between syncs with FILE_WRITER_SYNC_BYTES
+ * [append] - add to the end of an existing file instead of replacing it
+ */
+typedef struct stFileWriterOptions {
+    size_t bufferSize;
+    bool background;
+    FileWriterSync sync;
+    size_t syncBytes;
+    bool append;
+} FileWriterOptions;
+
+/* FileWriterStats
+ * [writes] - write and writev calls made on the file
+ * [bytesWritten] - bytes they wrote
+ * [syncs] - fdatasync calls made
+ */
+typedef struct stFileWriterStats {
+    size_t writes;
+    size_t bytesWritten;
+    size_t syncs;
+} FileWriterStats;
+
+/* FileWriter
+ * the output side of FileReader, gathers small writes into a large buffer
+ * and writes it out in one go.  Once the writer has failed every later call
+ * fails too, so checking the result of file_writer_close is enough
+ */
+typedef struct stFileWriter {
+    Buffer fileName;
+    int fd;
+    bool open;
+    bool failed;
+    Buffer buf;
+    size_t bufferSize;
+    FileWriterSync sync;
+    size_t syncBytes;
+    size_t unsynced;
+    size_t writes;
+    size_t bytesWritten;
+    size_t syncs;
+    Recycler *recycler;
+
+    bool background;
+    Buffer spare;
+    bool pending;
+    bool stop;
+    int error;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+} FileWriter;
+
+// initialize [w] so it writes nothing
+void file_writer_init(FileWriter *w);
+
+// set [opts] to the defaults file_writer_open uses
+void file_writer_options_init(FileWriterOptions *opts);
+
+// assign recycler [rc] to writer [w], call before opening
+void file_writer_assign_recycler(FileWriter *w, Recycler *rc);
+
+// create or truncate [fileName] for writing by [w] with default options
+bool file_writer_open(FileWriter *w, const char *fileName);
+
+/* create or truncate [fileName], or append to it, for writing by [w] as set
+ * out by [opts]
+ * returns false if the file cannot be opened or the thread started
+ */
+bool file_writer_open_options(FileWriter *w, const char *fileName,
+                              const FileWriterOptions *opts);
+
+/* write the [len] bytes at [data]
+ * returns false on a write error, now or from an earlier background write
+ */
+bool file_writer_write_bytes(FileWriter *w, const unsigned char *data,
+                             size_t len);
+
+// write one byte [c]
+bool file_writer_write_byte(FileWriter *w, unsigned char c);
+
+// write the data held by buffer [buf]
+bool file_writer_write(FileWriter *w, const Buffer *buf);
+
+// write the bytes seen through view [view]
+bool file_writer_write_view(FileWriter *w, const BufferView *view);
+
+/* write the [count] views at [views] one after another, small ones copied
+ * and long ones gathered into as few writev calls as possible
+ */
+bool file_writer_write_views(FileWriter *w, const BufferView *views,
+                             size_t count);
+
+/* write out everything gathered so far, waiting for a background write
+ * returns false on a write error
+ */
+bool file_writer_flush(FileWriter *w);
+
+// flush [w] and fdatasync the file whatever the policy
+bool file_writer_sync(FileWriter *w);
+
+// get the writes and syncs made on [w] into [stats], after waiting for a
+// background write in progress
+void file_writer_get_stats(FileWriter *w, FileWriterStats *stats);
+
+/* flush, sync as the policy says and close the file, freeing memory held
+ * returns true if every byte written reached the file
+ */
+bool file_writer_close(FileWriter *w);
+
+#endif //SEARCHFILEC_FILEWRITER_H
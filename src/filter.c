@@ -0,0 +1,422 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#include <assert.h>
+#include <string.h>
+#include "filter.h"
+#include "hash.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// seed used for every filter so a key hashes the same way in all of them
+#define FILTER_SEED 0x9e3779b97f4a7c15ULL
+
+// odd multipliers which pick one bit in each word of a bloom filter block
+static const uint32_t bloom_filter_salt[BLOOM_FILTER_BLOCK_WORDS] = {
+        0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+        0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+};
+
+// allocate [bytes] zeroed bytes from [rc] or the heap
+static void * filter_alloc(Recycler *rc, size_t bytes) {
+    void *mem = NULL != rc ? recycler_get_exact(rc, bytes) : malloc(bytes);
+    if(NULL != mem) memset(mem, 0, bytes);
+    return mem;
+}
+
+// release [bytes] bytes at [mem] obtained from filter_alloc
+static void filter_release(Recycler *rc, size_t bytes, void *mem) {
+    if(NULL == mem) return;
+    if(NULL != rc) recycler_return(rc, bytes, mem);
+    else free(mem);
+}
+
+// returns roughly -log2([rate]) rounded up, rate is clamped to (0, 1)
+static unsigned filter_rate_bits(double rate) {
+    unsigned bits = 0;
+    if(rate <= 0.0) rate = 1e-9;
+    while(rate < 1.0 && bits < 64) {
+        rate *= 2.0;
+        ++bits;
+    }
+    return bits ? bits : 1;
+}
+
+// build the bit of each block word selected by hash [h]
+static void bloom_filter_mask(uint32_t h, uint32_t mask[BLOOM_FILTER_BLOCK_WORDS]) {
+    for(size_t i = 0; i < BLOOM_FILTER_BLOCK_WORDS; ++i)
+        mask[i] = 1U << ((h * bloom_filter_salt[i]) >> 27);
+}
+
+// pick the block addressed by the upper half of hash [h]
+static uint32_t * bloom_filter_block(const BloomFilter *bf, uint64_t h) {
+    size_t idx = (size_t)(((h >> 32) * (uint64_t)bf->blockCount) >> 32);
+    return bf->blocks + idx * BLOOM_FILTER_BLOCK_WORDS;
+}
+
+void bloom_filter_init(BloomFilter *bf) {
+    assert(NULL != bf);
+    bf->blocks = NULL;
+    bf->blockCount = 0;
+    bf->recycler = NULL;
+}
+
+void bloom_filter_assign_recycler(BloomFilter *bf, Recycler *rc) {
+    assert(NULL != bf);
+    bf->recycler = rc;
+}
+
+bool bloom_filter_create(BloomFilter *bf, size_t expected,
+                         double falsePositiveRate) {
+    assert(NULL != bf);
+    bloom_filter_free(bf);
+
+    // eight bits set per key costs a split block filter roughly half a bit
+    // per key more than an ideal bloom filter
+    size_t bitsPerKey = filter_rate_bits(falsePositiveRate) * 3 / 2 + 1;
+    size_t blocks = ((expected ? expected : 1) * bitsPerKey + 255) / 256;
+    if(blocks > UINT32_MAX) blocks = UINT32_MAX;
+
+    bf->blocks = filter_alloc(bf->recycler,
+                              blocks * BLOOM_FILTER_BLOCK_WORDS * sizeof(uint32_t));
+    if(NULL == bf->blocks) return false;
+    bf->blockCount = blocks;
+    return true;
+}
+
+void bloom_filter_free(BloomFilter *bf) {
+    assert(NULL != bf);
+    filter_release(bf->recycler,
+                   bf->blockCount * BLOOM_FILTER_BLOCK_WORDS * sizeof(uint32_t),
+                   bf->blocks);
+    bf->blocks = NULL;
+    bf->blockCount = 0;
+}
+
+static void bloom_filter_add_hash(BloomFilter *bf, uint64_t h) {
+    uint32_t *block = bloom_filter_block(bf, h);
+#if defined(__AVX2__)
+    __m256i salt = _mm256_loadu_si256((const __m256i *)bloom_filter_salt);
+    __m256i bit = _mm256_srli_epi32(
+            _mm256_mullo_epi32(_mm256_set1_epi32((int)(uint32_t)h), salt), 27);
+    __m256i mask = _mm256_sllv_epi32(_mm256_set1_epi32(1), bit);
+    __m256i cur = _mm256_loadu_si256((const __m256i *)block);
+    _mm256_storeu_si256((__m256i *)block, _mm256_or_si256(cur, mask));
+#else
+    uint32_t mask[BLOOM_FILTER_BLOCK_WORDS];
+    bloom_filter_mask((uint32_t)h, mask);
+    for(size_t i = 0; i < BLOOM_FILTER_BLOCK_WORDS; ++i)
+        block[i] |= mask[i];
+#endif
+}
+
+static bool bloom_filter_test_hash(const BloomFilter *bf, uint64_t h) {
+    const uint32_t *block = bloom_filter_block(bf, h);
+#if defined(__AVX2__)
+    __m256i salt = _mm256_loadu_si256((const __m256i *)bloom_filter_salt);
+    __m256i bit = _mm256_srli_epi32(
+            _mm256_mullo_epi32(_mm256_set1_epi32((int)(uint32_t)h), salt), 27);
+    __m256i mask = _mm256_sllv_epi32(_mm256_set1_epi32(1), bit);
+    __m256i cur = _mm256_loadu_si256((const __m256i *)block);
+    // testc is set when every bit of mask is also set in cur
+    return _mm256_testc_si256(cur, mask) != 0;
+#else
+    uint32_t mask[BLOOM_FILTER_BLOCK_WORDS];
+    uint32_t missing = 0;
+    bloom_filter_mask((uint32_t)h, mask);
+    // no early exit so the compiler can turn this into vector compares
+    for(size_t i = 0; i < BLOOM_FILTER_BLOCK_WORDS; ++i)
+        missing |= mask[i] & ~block[i];
+    return 0 == missing;
+#endif
+}
+
+void bloom_filter_add_bytes(BloomFilter *bf, const unsigned char *data,
+                            size_t len) {
+    assert(NULL != bf);
+    assert(NULL != bf->blocks);
+    bloom_filter_add_hash(bf, hash_bytes(data, len, FILTER_SEED));
+}
+
+void bloom_filter_add(BloomFilter *bf, const Buffer *key) {
+    assert(NULL != key);
+    bloom_filter_add_bytes(bf, key->data, key->len);
+}
+
+bool bloom_filter_may_contain_bytes(const BloomFilter *bf,
+                                    const unsigned char *data, size_t len) {
+    assert(NULL != bf);
+    if(NULL == bf->blocks) return false;
+    return bloom_filter_test_hash(bf, hash_bytes(data, len, FILTER_SEED));
+}
+
+bool bloom_filter_may_contain(const BloomFilter *bf, const Buffer *key) {
+    assert(NULL != key);
+    return bloom_filter_may_contain_bytes(bf, key->data, key->len);
+}
+
+// the two candidate buckets of a key depend only on its first bucket and its
+// fingerprint, so a fingerprint can be moved without knowing the key
+static size_t cuckoo_filter_alt(const CuckooFilter *cf, size_t bucket,
+                                uint16_t fp) {
+    return (bucket ^ (size_t)hash_mix64(fp)) & (cf->bucketCount - 1);
+}
+
+static void cuckoo_filter_locate(const CuckooFilter *cf,
+                                 const unsigned char *data, size_t len,
+                                 uint16_t *fp, size_t *i1, size_t *i2) {
+    uint64_t h = hash_bytes(data, len, FILTER_SEED);
+    *fp = (uint16_t)(h >> 48) & cf->fingerprintMask;
+    // zero marks an empty slot
+    if(0 == *fp) *fp = 1;
+    *i1 = (size_t)h & (cf->bucketCount - 1);
+    *i2 = cuckoo_filter_alt(cf, *i1, *fp);
+}
+
+static bool cuckoo_filter_bucket_insert(CuckooFilter *cf, size_t bucket,
+                                        uint16_t fp) {
+    uint16_t *slots = cf->buckets + bucket * CUCKOO_FILTER_BUCKET_SIZE;
+    for(size_t i = 0; i < CUCKOO_FILTER_BUCKET_SIZE; ++i) {
+        if(0 == slots[i]) {
+            slots[i] = fp;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool cuckoo_filter_bucket_has(const CuckooFilter *cf, size_t bucket,
+                                     uint16_t fp) {
+    const uint16_t *slots = cf->buckets + bucket * CUCKOO_FILTER_BUCKET_SIZE;
+    return slots[0] == fp || slots[1] == fp || slots[2] == fp || slots[3] == fp;
+}
+
+static bool cuckoo_filter_bucket_delete(CuckooFilter *cf, size_t bucket,
+                                        uint16_t fp) {
+    uint16_t *slots = cf->buckets + bucket * CUCKOO_FILTER_BUCKET_SIZE;
+    for(size_t i = 0; i < CUCKOO_FILTER_BUCKET_SIZE; ++i) {
+        if(fp == slots[i]) {
+            slots[i] = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+void cuckoo_filter_init(CuckooFilter *cf) {
+    assert(NULL != cf);
+    cf->buckets = NULL;
+    cf->bucketCount = 0;
+    cf->count = 0;
+    cf->fingerprintMask = 0xffff;
+    cf->victim = 0;
+    cf->victimBucket = 0;
+    cf->hasVictim = false;
+    cf->rng = FILTER_SEED;
+    cf->recycler = NULL;
+}
+
+void cuckoo_filter_assign_recycler(CuckooFilter *cf, Recycler *rc) {
+    assert(NULL != cf);
+    cf->recycler = rc;
+}
+
+bool cuckoo_filter_create(CuckooFilter *cf, size_t expected,
+                          double falsePositiveRate) {
+    assert(NULL != cf);
+    cuckoo_filter_free(cf);
+
+    // a lookup compares against 2 * 4 fingerprints, each matching with
+    // probability 2^-bits
+    unsigned bits = filter_rate_bits(falsePositiveRate) + 3;
+    if(bits < 4) bits = 4;
+    if(bits > 16) bits = 16;
+    cf->fingerprintMask = (uint16_t)((1U << bits) - 1);
+
+    // keep the table at most 95% full
+    size_t want = (expected ? expected : 1) * 100 / 95 / CUCKOO_FILTER_BUCKET_SIZE + 1;
+    size_t buckets = 1;
+    while(buckets < want) buckets <<= 1;
+
+    cf->buckets = filter_alloc(cf->recycler,
+                               buckets * CUCKOO_FILTER_BUCKET_SIZE * sizeof(uint16_t));
+    if(NULL == cf->buckets) return false;
+    cf->bucketCount = buckets;
+    cf->count = 0;
+    cf->hasVictim = false;
+    return true;
+}
+
+void cuckoo_filter_free(CuckooFilter *cf) {
+    assert(NULL != cf);
+    filter_release(cf->recycler,
+                   cf->bucketCount * CUCKOO_FILTER_BUCKET_SIZE * sizeof(uint16_t),
+                   cf->buckets);
+    cf->buckets = NULL;
+    cf->bucketCount = 0;
+    cf->count = 0;
+    cf->hasVictim = false;
+}
+
+bool cuckoo_filter_add_bytes(CuckooFilter *cf, const unsigned char *data,
+                             size_t len) {
+    assert(NULL != cf);
+    assert(NULL != cf->buckets);
+    // the slot the last failed insert was parked in must drain first
+    if(cf->hasVictim) return false;
+
+    uint16_t fp;
+    size_t i1, i2;
+    cuckoo_filter_locate(cf, data, len, &fp, &i1, &i2);
+    if(cuckoo_filter_bucket_insert(cf, i1, fp) ||
+       cuckoo_filter_bucket_insert(cf, i2, fp)) {
+        ++cf->count;
+        return true;
+    }
+
+    size_t bucket = (cf->rng & 1) ? i1 : i2;
+    for(size_t kick = 0; kick < CUCKOO_FILTER_MAX_KICKS; ++kick) {
+        cf->rng ^= cf->rng << 13;
+        cf->rng ^= cf->rng >> 7;
+        cf->rng ^= cf->rng << 17;
+        size_t slot = cf->rng % CUCKOO_FILTER_BUCKET_SIZE;
+        uint16_t *slots = cf->buckets + bucket * CUCKOO_FILTER_BUCKET_SIZE;
+        uint16_t evicted = slots[slot];
+        slots[slot] = fp;
+        fp = evicted;
+        bucket = cuckoo_filter_alt(cf, bucket, fp);
+        if(cuckoo_filter_bucket_insert(cf, bucket, fp)) {
+            ++cf->count;
+            return true;
+        }
+    }
+
+    // the new key is in the table, the last fingerprint evicted is not, keep
+    // it on the side so lookups still find it
+    cf->victim = fp;
+    cf->victimBucket = bucket;
+    cf->hasVictim = true;
+    ++cf->count;
+    return true;
+}
+
+bool cuckoo_filter_add(CuckooFilter *cf, const Buffer *key) {
+    assert(NULL != key);
+    return cuckoo_filter_add_bytes(cf, key->data, key->len);
+}
+
+bool cuckoo_filter_may_contain_bytes(const CuckooFilter *cf,
+                                     const unsigned char *data, size_t len) {
+    assert(NULL != cf);
+    if(NULL == cf->buckets) return false;
+    uint16_t fp;
+    size_t i1, i2;
+    cuckoo_filter_locate(cf, data, len, &fp, &i1, &i2);
+    if(cuckoo_filter_bucket_has(cf, i1, fp) ||
+       cuckoo_filter_bucket_has(cf, i2, fp))
+        return true;
+    return cf->hasVictim && cf->victim == fp &&
+           (cf->victimBucket == i1 || cf->victimBucket == i2);
+}
+
+bool cuckoo_filter_may_contain(const CuckooFilter *cf, const Buffer *key) {
+    assert(NULL != key);
+    return cuckoo_filter_may_contain_bytes(cf, key->data, key->len);
+}
+
+bool cuckoo_filter_remove_bytes(CuckooFilter *cf, const unsigned char *data,
+                                size_t len) {
+    assert(NULL != cf);
+    if(NULL == cf->buckets) return false;
+    uint16_t fp;
+    size_t i1, i2;
+    cuckoo_filter_locate(cf, data, len, &fp, &i1, &i2);
+
+    if(cf->hasVictim && cf->victim == fp &&
+       (cf->victimBucket == i1 || cf->victimBucket == i2)) {
+        cf->hasVictim = false;
+        --cf->count;
+        return true;
+    }
+    if(!cuckoo_filter_bucket_delete(cf, i1, fp) &&
+       !cuckoo_filter_bucket_delete(cf, i2, fp))
+        return false;
+    --cf->count;
+
+    // a slot just opened up, try to move the parked fingerprint back in
+    if(cf->hasVictim) {
+        size_t alt = cuckoo_filter_alt(cf, cf->victimBucket, cf->victim);
+        if(cuckoo_filter_bucket_insert(cf, cf->victimBucket, cf->victim) ||
+           cuckoo_filter_bucket_insert(cf, alt, cf->victim))
+            cf->hasVictim = false;
+    }
+    return true;
+}
+
+bool cuckoo_filter_remove(CuckooFilter *cf, const Buffer *key) {
+    assert(NULL != key);
+    return cuckoo_filter_remove_bytes(cf, key->data, key->len);
+}
+
+void membership_filter_init(MembershipFilter *mf, MembershipFilterKind kind) {
+    assert(NULL != mf);
+    mf->kind = kind;
+    mf->saturated = false;
+    bloom_filter_init(&mf->bloom);
+    cuckoo_filter_init(&mf->cuckoo);
+}
+
+void membership_filter_assign_recycler(MembershipFilter *mf, Recycler *rc) {
+    assert(NULL != mf);
+    bloom_filter_assign_recycler(&mf->bloom, rc);
+    cuckoo_filter_assign_recycler(&mf->cuckoo, rc);
+}
+
+bool membership_filter_create(MembershipFilter *mf, size_t expected,
+                              double falsePositiveRate) {
+    assert(NULL != mf);
+    mf->saturated = false;
+    if(MEMBERSHIP_FILTER_BLOOM == mf->kind)
+        return bloom_filter_create(&mf->bloom, expected, falsePositiveRate);
+    return cuckoo_filter_create(&mf->cuckoo, expected, falsePositiveRate);
+}
+
+void membership_filter_free(MembershipFilter *mf) {
+    assert(NULL != mf);
+    bloom_filter_free(&mf->bloom);
+    cuckoo_filter_free(&mf->cuckoo);
+    mf->saturated = false;
+}
+
+void membership_filter_add_bytes(MembershipFilter *mf,
+                                 const unsigned char *data, size_t len) {
+    assert(NULL != mf);
+    if(mf->saturated) return;
+    if(MEMBERSHIP_FILTER_BLOOM == mf->kind) {
+        bloom_filter_add_bytes(&mf->bloom, data, len);
+        return;
+    }
+    if(!cuckoo_filter_add_bytes(&mf->cuckoo, data, len))
+        mf->saturated = true;
+}
+
+void membership_filter_remove_bytes(MembershipFilter *mf,
+                                    const unsigned char *data, size_t len) {
+    assert(NULL != mf);
+    // once saturated some keys never made it into the filter, removing
+    // another key's matching fingerprint could then cause a false negative
+    if(mf->saturated || MEMBERSHIP_FILTER_CUCKOO != mf->kind) return;
+    cuckoo_filter_remove_bytes(&mf->cuckoo, data, len);
+}
+
+bool membership_filter_may_contain_bytes(const MembershipFilter *mf,
+                                         const unsigned char *data, size_t len) {
+    assert(NULL != mf);
+    if(mf->saturated) return true;
+    if(MEMBERSHIP_FILTER_BLOOM == mf->kind)
+        return bloom_filter_may_contain_bytes(&mf->bloom, data, len);
+    return cuckoo_filter_may_contain_bytes(&mf->cuckoo, data, len);
+}
@@ -0,0 +1,169 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#ifndef SEARCHFILEC_FILTER_H
+#define SEARCHFILEC_FILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "buffer.h"
+#include "recycler.h"
+
+/*
+ * Approximate membership filters answer "is this key possibly present" in a
+ * few cache lines, with no false negatives and a configurable rate of false
+ * positives.  Put in front of a HashTable they turn most misses into a single
+ * memory access instead of a bucket chain walk.
+ *
+ * BloomFilter - a split block Bloom filter, every key sets one bit in each of
+ * the eight 32 bit words of a single 256 bit block, so a test touches one
+ * cache line and is a handful of vector instructions.  Keys cannot be removed.
+ *
+ * CuckooFilter - four fingerprints per bucket, two candidate buckets per key.
+ * Slightly larger for the same false positive rate but supports removal.
+ *
+ * MembershipFilter - either of the above behind one interface, this is what
+ * a HashTable accepts.
+*/
+
+// number of 32 bit words in a bloom filter block
+#define BLOOM_FILTER_BLOCK_WORDS 8
+
+// fingerprints held by each cuckoo filter bucket
+#define CUCKOO_FILTER_BUCKET_SIZE 4
+
+// relocations tried before a cuckoo filter insert gives up
+#define CUCKOO_FILTER_MAX_KICKS 500
+
+typedef struct stBloomFilter {
+    uint32_t *blocks;
+    size_t blockCount;
+    Recycler *recycler;
+} BloomFilter;
+
+typedef struct stCuckooFilter {
+    uint16_t *buckets;
+    size_t bucketCount;
+    size_t count;
+    uint16_t fingerprintMask;
+    uint16_t victim;
+    size_t victimBucket;
+    bool hasVictim;
+    uint64_t rng;
+    Recycler *recycler;
+} CuckooFilter;
+
+typedef enum eMembershipFilterKind {
+    MEMBERSHIP_FILTER_BLOOM,
+    MEMBERSHIP_FILTER_CUCKOO
+} MembershipFilterKind;
+
+typedef struct stMembershipFilter {
+    MembershipFilterKind kind;
+    BloomFilter bloom;
+    CuckooFilter cuckoo;
+    bool saturated;
+} MembershipFilter;
+
+// initialize a bloom filter [bf] so it holds no memory
+void bloom_filter_init(BloomFilter *bf);
+
+// assign recycler [rc] to bloom filter [bf], must be called before create
+void bloom_filter_assign_recycler(BloomFilter *bf, Recycler *rc);
+
+// size bloom filter [bf] for [expected] keys at a false positive rate of
+// [falsePositiveRate] (0 < rate < 1) and clear it
+// returns true on success, false on memory exhaustion
+bool bloom_filter_create(BloomFilter *bf, size_t expected,
+                         double falsePositiveRate);
+
+// free any memory held by bloom filter [bf]
+void bloom_filter_free(BloomFilter *bf);
+
+// add the [len] bytes at [data] to bloom filter [bf]
+void bloom_filter_add_bytes(BloomFilter *bf, const unsigned char *data,
+                            size_t len);
+
+// add the data held by buffer [key] to bloom filter [bf]
+void bloom_filter_add(BloomFilter *bf, const Buffer *key);
+
+// returns false if the [len] bytes at [data] were definitely never added to
+// bloom filter [bf], true if they possibly were
+bool bloom_filter_may_contain_bytes(const BloomFilter *bf,
+                                    const unsigned char *data, size_t len);
+
+// returns false if buffer [key] was definitely never added to [bf]
+bool bloom_filter_may_contain(const BloomFilter *bf, const Buffer *key);
+
+// initialize a cuckoo filter [cf] so it holds no memory
+void cuckoo_filter_init(CuckooFilter *cf);
+
+// assign recycler [rc] to cuckoo filter [cf], must be called before create
+void cuckoo_filter_assign_recycler(CuckooFilter *cf, Recycler *rc);
+
+// size cuckoo filter [cf] for [expected] keys at a false positive rate of
+// about [falsePositiveRate] (fingerprints are at most 16 bits, so rates
+// below about 0.0001 are rounded up) and clear it
+// returns true on success, false on memory exhaustion
+bool cuckoo_filter_create(CuckooFilter *cf, size_t expected,
+                          double falsePositiveRate);
+
+// free any memory held by cuckoo filter [cf]
+void cuckoo_filter_free(CuckooFilter *cf);
+
+// add the [len] bytes at [data] to cuckoo filter [cf]
+// returns false if the filter is too full to take the key
+bool cuckoo_filter_add_bytes(CuckooFilter *cf, const unsigned char *data,
+                             size_t len);
+
+// add the data held by buffer [key] to cuckoo filter [cf]
+bool cuckoo_filter_add(CuckooFilter *cf, const Buffer *key);
+
+// remove one copy of the [len] bytes at [data] from cuckoo filter [cf], only
+// remove keys which were added
+// returns true if a matching fingerprint was removed
+bool cuckoo_filter_remove_bytes(CuckooFilter *cf, const unsigned char *data,
+                                size_t len);
+
+// remove one copy of buffer [key] from cuckoo filter [cf]
+bool cuckoo_filter_remove(CuckooFilter *cf, const Buffer *key);
+
+// returns false if the [len] bytes at [data] are definitely not in [cf]
+bool cuckoo_filter_may_contain_bytes(const CuckooFilter *cf,
+                                     const unsigned char *data, size_t len);
+
+// returns false if buffer [key] is definitely not in cuckoo filter [cf]
+bool cuckoo_filter_may_contain(const CuckooFilter *cf, const Buffer *key);
+
+// initialize membership filter [mf] as an empty filter of kind [kind]
+void membership_filter_init(MembershipFilter *mf, MembershipFilterKind kind);
+
+// assign recycler [rc] to membership filter [mf], call before create
+void membership_filter_assign_recycler(MembershipFilter *mf, Recycler *rc);
+
+// size membership filter [mf] for [expected] keys at [falsePositiveRate]
+// returns true on success
+bool membership_filter_create(MembershipFilter *mf, size_t expected,
+                              double falsePositiveRate);
+
+// free any memory held by membership filter [mf]
+void membership_filter_free(MembershipFilter *mf);
+
+// add the [len] bytes at [data] to membership filter [mf].  should the
+// filter fill up it becomes saturated and answers "possibly" for every key
+// from then on, so it never produces a false negative
+void membership_filter_add_bytes(MembershipFilter *mf,
+                                 const unsigned char *data, size_t len);
+
+// remove the [len] bytes at [data] from membership filter [mf], a no-op for
+// bloom filters which cannot forget keys
+void membership_filter_remove_bytes(MembershipFilter *mf,
+                                    const unsigned char *data, size_t len);
+
+// returns false if the [len] bytes at [data] are definitely not in [mf]
+bool membership_filter_may_contain_bytes(const MembershipFilter *mf,
+                                         const unsigned char *data, size_t len);
+
+#endif //SEARCHFILEC_FILTER_H
@@ -0,0 +1,405 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#include <assert.h>
+#include <limits.h>
+#include <stddef.h>
+#include <string.h>
+#include "frozenhashtable.h"
+#include "hash.h"
+#include "log.h"
+
+// number of seeds tried before giving up on finding a perfect hash
+#define FROZEN_HASH_MAX_ATTEMPTS 16
+
+#define FROZEN_HASH_MAX_PILOT 65536
+
+// round [n] up to a multiple of 8
+static size_t frozen_align8(size_t n) {
+    return (n + 7) & ~(size_t) 7;
+}
+
+// bucket owning a key with hash [h] in a table of [buckets] buckets
+static uint64_t frozen_bucket(uint64_t h, uint64_t buckets) {
+    return ((h >> 32) * buckets) >> 32;
+}
+
+// slot a key with hash [h] lands in when its bucket has pilot value [pm]
+static uint64_t frozen_slot(uint64_t h, uint64_t pm, uint64_t slots) {
+    return (h ^ pm) % slots;
+}
+
+// the hashed form of a pilot, mixed with the key hash to pick a slot
+static uint64_t frozen_pilot_mix(uint64_t seed, uint64_t pilot) {
+    return hash_mix64(seed + pilot);
+}
+
+static uint64_t frozen_header_checksum(const FrozenHashHeader *header) {
+    return hash_bytes(header, offsetof(FrozenHashHeader, headerChecksum),
+                      HASH_DEFAULT_SEED);
+}
+
+// point the section pointers of [fht] at the image starting at [data]
+static void frozen_hashtable_attach(FrozenHashTable *fht,
+                                    const unsigned char *data) {
+    fht->data = data;
+    fht->header = (const FrozenHashHeader *) data;
+    fht->pilots = (const uint16_t *) (data + fht->header->pilotOffset);
+    fht->slots = (const uint32_t *) (data + fht->header->slotOffset);
+}
+
+// search for a pilot for every bucket so that all [n] keys with hashes
+// [hashes] land in distinct slots.  buckets are placed largest first as
+// those are the hardest to fit
+// [hashes] - key hashes
+// [n] - number of keys
+// [buckets] - number of buckets
+// [slots] - number of slots
+// [seed] - seed the hashes were computed with
+// [pilots] - output, pilot of every bucket
+// [slotOf] - output, slot of every key
+// returns true if every bucket found a pilot
+static bool frozen_find_pilots(const uint64_t *hashes, size_t n,
+                               uint64_t buckets, uint64_t slots, uint64_t seed,
+                               uint16_t *pilots, uint64_t *slotOf) {
+
+    size_t *start = calloc(buckets + 1, sizeof(size_t));
+    size_t *members = malloc(sizeof(size_t) * (n ? n : 1));
+    uint64_t *order = malloc(sizeof(uint64_t) * buckets);
+    uint64_t *taken = calloc((slots + 63) / 64, sizeof(uint64_t));
+    bool ok = NULL != start && NULL != members && NULL != order && NULL != taken;
+
+    if(!ok) log_message("Unable to allocate memory to build a perfect hash");
+
+    size_t maxSize = 0;
+    for(size_t i = 0; ok && i < n; ++i) {
+        start[frozen_bucket(hashes[i], buckets) + 1]++;
+    }
+    for(uint64_t b = 0; ok && b < buckets; ++b) {
+        if(start[b + 1] > maxSize) maxSize = start[b + 1];
+        start[b + 1] += start[b];
+    }
+
+    size_t *bySize = ok ? calloc(maxSize + 2, sizeof(size_t)) : NULL;
+    ok = ok && NULL != bySize;
+
+    if(ok) {
+        size_t *next = malloc(sizeof(size_t) * buckets);
+        ok = NULL != next;
+        if(ok) {
+            memcpy(next, start, sizeof(size_t) * buckets);
+            for(size_t i = 0; i < n; ++i) {
+                members[next[frozen_bucket(hashes[i], buckets)]++] = i;
+            }
+            free(next);
+        }
+    }
+
+    // counting sort of the buckets, largest first
+    if(ok) {
+        for(uint64_t b = 0; b < buckets; ++b) {
+            bySize[maxSize - (start[b + 1] - start[b]) + 1]++;
+        }
+        for(size_t s = 0; s <= maxSize; ++s) bySize[s + 1] += bySize[s];
+        for(uint64_t b = 0; b < buckets; ++b) {
+            order[bySize[maxSize - (start[b + 1] - start[b])]++] = b;
+        }
+    }
+
+    for(uint64_t o = 0; ok && o < buckets; ++o) {
+        const uint64_t b = order[o];
+        const size_t first = start[b];
+        const size_t count = start[b + 1] - first;
+
+        pilots[b] = 0;
+        if(0 == count) continue;
+
+        bool placed = false;
+        for(uint32_t pilot = 0; !placed && pilot < FROZEN_HASH_MAX_PILOT; ++pilot) {
+            const uint64_t pm = frozen_pilot_mix(seed, pilot);
+            size_t j;
+            for(j = 0; j < count; ++j) {
+                const size_t key = members[first + j];
+                const uint64_t s = frozen_slot(hashes[key], pm, slots);
+                if(taken[s / 64] & (1ULL << (s % 64))) break;
+                taken[s / 64] |= 1ULL << (s % 64);
+                slotOf[key] = s;
+            }
+            if(j == count) {
+                pilots[b] = (uint16_t) pilot;
+                placed = true;
+            } else {
+                // release the slots this pilot claimed before colliding
+                for(size_t k = 0; k < j; ++k) {
+                    const uint64_t s = slotOf[members[first + k]];
+                    taken[s / 64] &= ~(1ULL << (s % 64));
+                }
+            }
+        }
+        ok = placed;
+    }
+
+    free(start);
+    free(members);
+    free(order);
+    free(taken);
+    free(bySize);
+    return ok;
+}
+
+void frozen_hashtable_init(FrozenHashTable *fht) {
+    assert(NULL != fht);
+    buffer_init(&fht->image);
+    mapped_file_init(&fht->file);
+    fht->data = NULL;
+    fht->header = NULL;
+    fht->pilots = NULL;
+    fht->slots = NULL;
+}
+
+bool hashtable_freeze(HashTable *ht, FrozenHashTable *fht) {
+    assert(NULL != ht);
+    assert(NULL != fht);
+
+    frozen_hashtable_init(fht);
+    buffer_assign_recycler(&fht->image, ht->recycler);
+
+    HashTableIterator it;
+    HashValue *hv;
+    size_t n = 0;
+    size_t dataBytes = 0;
+
+    hashtable_iterator_init(&it, ht);
+    while(NULL != (hv = hashtable_iterator_next(&it))) {
+        dataBytes += frozen_align8(2 * sizeof(uint32_t) + hv->key.len + hv->data.len);
+        ++n;
+    }
+
+    const uint64_t buckets = n / FROZEN_HASH_BUCKET_LOAD + 1;
+    const uint64_t slots = (uint64_t) (n / FROZEN_HASH_SLOT_LOAD) + 1;
+
+    FrozenHashHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, FROZEN_HASH_MAGIC, sizeof(FROZEN_HASH_MAGIC));
+    header.version = FROZEN_HASH_VERSION;
+    header.headerSize = sizeof(FrozenHashHeader);
+    header.entryCount = n;
+    header.bucketCount = buckets;
+    header.slotCount = slots;
+    header.pilotOffset = sizeof(FrozenHashHeader);
+    header.slotOffset = frozen_align8(header.pilotOffset + sizeof(uint16_t) * buckets);
+    header.dataOffset = frozen_align8(header.slotOffset + sizeof(uint32_t) * slots);
+    header.fileSize = header.dataOffset + dataBytes;
+
+    if(header.fileSize > UINT_MAX || dataBytes / 8 >= UINT32_MAX) {
+        log_message("Unable to freeze %zu entries, the table would need %llu bytes",
+                    n, (unsigned long long) header.fileSize);
+        return false;
+    }
+
+    HashValue **values = malloc(sizeof(HashValue *) * (n ? n : 1));
+    uint64_t *hashes = malloc(sizeof(uint64_t) * (n ? n : 1));
+    uint64_t *slotOf = malloc(sizeof(uint64_t) * (n ? n : 1));
+    bool ok = NULL != values && NULL != hashes && NULL != slotOf &&
+              buffer_reserve(&fht->image, (unsigned int) header.fileSize);
+
+    if(!ok) log_message("Unable to allocate memory to freeze %zu entries", n);
+
+    size_t i = 0;
+    hashtable_iterator_init(&it, ht);
+    while(ok && NULL != (hv = hashtable_iterator_next(&it))) values[i++] = hv;
+
+    unsigned char *image = fht->image.data;
+    bool found = false;
+    uint64_t seed = HASH_DEFAULT_SEED;
+
+    for(size_t attempt = 0; ok && !found && attempt < FROZEN_HASH_MAX_ATTEMPTS;
+        ++attempt) {
+        seed = hash_mix64(seed + attempt);
+        for(i = 0; i < n; ++i) {
+            hashes[i] = hash_bytes(values[i]->key.data, values[i]->key.len, seed);
+        }
+        found = frozen_find_pilots(hashes, n, buckets, slots, seed,
+                                   (uint16_t *) (image + header.pilotOffset),
+                                   slotOf);
+    }
+
+    if(ok && !found) {
+        log_message("Unable to find a perfect hash for %zu entries", n);
+        ok = false;
+    }
+
+    if(ok) {
+        header.seed = seed;
+        memset(image + header.slotOffset, 0, header.dataOffset - header.slotOffset);
+        memset(image + header.pilotOffset + sizeof(uint16_t) * buckets, 0,
+               header.slotOffset - header.pilotOffset - sizeof(uint16_t) * buckets);
+
+        uint32_t *slotArray = (uint32_t *) (image + header.slotOffset);
+        size_t off = 0;
+        for(i = 0; i < n; ++i) {
+            unsigned char *e = image + header.dataOffset + off;
+            const uint32_t keyLen = (uint32_t) values[i]->key.len;
+            const uint32_t valueLen = (uint32_t) values[i]->data.len;
+            const size_t size = frozen_align8(2 * sizeof(uint32_t) + keyLen + valueLen);
+
+            memset(e, 0, size);
+            memcpy(e, &keyLen, sizeof(uint32_t));
+            memcpy(e + sizeof(uint32_t), &valueLen, sizeof(uint32_t));
+            if(keyLen) memcpy(e + 2 * sizeof(uint32_t), values[i]->key.data, keyLen);
+            if(valueLen) memcpy(e + 2 * sizeof(uint32_t) + keyLen,
+                                values[i]->data.data, valueLen);
+
+            slotArray[slotOf[i]] = (uint32_t) (off / 8 + 1);
+            off += size;
+        }
+
+        header.payloadChecksum = hash_bytes(image + header.pilotOffset,
+                                            header.fileSize - header.pilotOffset,
+                                            HASH_DEFAULT_SEED);
+        header.headerChecksum = frozen_header_checksum(&header);
+        memcpy(image, &header, sizeof(header));
+        fht->image.len = header.fileSize;
+        frozen_hashtable_attach(fht, image);
+    }
+
+    free(values);
+    free(hashes);
+    free(slotOf);
+
+    if(!ok) frozen_hashtable_free(fht);
+    return ok;
+}
+
+void frozen_hashtable_free(FrozenHashTable *fht) {
+    assert(NULL != fht);
+    Recycler *r = fht->image.recycler;
+    buffer_free(&fht->image);
+    mapped_file_close(&fht->file);
+    frozen_hashtable_init(fht);
+    buffer_assign_recycler(&fht->image, r);
+}
+
+bool frozen_hashtable_get_view(const FrozenHashTable *fht,
+                               const BufferView *key, BufferView *value) {
+    assert(NULL != fht);
+    assert(NULL != key);
+
+    const FrozenHashHeader *h = fht->header;
+    if(NULL == h || 0 == h->entryCount || NULL == key->data) return false;
+
+    const uint64_t hash = hash_bytes(key->data, key->len, h->seed);
+    const uint64_t pilot = fht->pilots[frozen_bucket(hash, h->bucketCount)];
+    const uint32_t slot = fht->slots[frozen_slot(hash,
+                                                 frozen_pilot_mix(h->seed, pilot),
+                                                 h->slotCount)];
+    if(0 == slot) return false;
+
+    const unsigned char *e = fht->data + h->dataOffset + (size_t) (slot - 1) * 8;
+    uint32_t keyLen, valueLen;
+    memcpy(&keyLen, e, sizeof(uint32_t));
+    memcpy(&valueLen, e + sizeof(uint32_t), sizeof(uint32_t));
+
+    if(keyLen != key->len) return false;
+    if(0 != memcmp(e + 2 * sizeof(uint32_t), key->data, keyLen)) return false;
+
+    if(NULL != value) {
+        buffer_view_set(value, e + 2 * sizeof(uint32_t) + keyLen, valueLen);
+    }
+    return true;
+}
+
+bool frozen_hashtable_get(const FrozenHashTable *fht, const HashKey *key,
+                          BufferView *value) {
+    assert(NULL != key);
+
+    BufferView view;
+    buffer_view_from_buffer(&view, key);
+    return frozen_hashtable_get_view(fht, &view, value);
+}
+
+bool frozen_hashtable_has(const FrozenHashTable *fht, const HashKey *key) {
+    return frozen_hashtable_get(fht, key, NULL);
+}
+
+size_t frozen_hashtable_get_entry_count(const FrozenHashTable *fht) {
+    assert(NULL != fht);
+    if(NULL == fht->header) return 0;
+    return fht->header->entryCount;
+}
+
+size_t frozen_hashtable_get_memory(const FrozenHashTable *fht) {
+    assert(NULL != fht);
+    if(NULL == fht->header) return 0;
+    return fht->header->fileSize;
+}
+
+bool frozen_hashtable_save(const FrozenHashTable *fht, const char *fileName) {
+    assert(NULL != fht);
+    assert(NULL != fileName);
+
+    if(NULL == fht->header) {
+        log_message("Unable to save an empty frozen hash table");
+        return false;
+    }
+
+    Buffer tmpName;
+    buffer_init(&tmpName);
+    const int fd = mapped_file_create(fileName, &tmpName);
+    if(-1 == fd) return false;
+
+    const bool ok = mapped_file_write(fd, fht->data, fht->header->fileSize);
+    return mapped_file_commit(fd, &tmpName, fileName, ok);
+}
+
+bool frozen_hashtable_open_mapped(FrozenHashTable *fht, const char *fileName) {
+    assert(NULL != fht);
+    assert(NULL != fileName);
+
+    frozen_hashtable_init(fht);
+    if(!mapped_file_open(&fht->file, fileName)) return false;
+
+    const FrozenHashHeader *h = (const FrozenHashHeader *) fht->file.data;
+    const size_t len = fht->file.len;
+    bool ok = len >= sizeof(FrozenHashHeader) &&
+              0 == memcmp(h->magic, FROZEN_HASH_MAGIC, sizeof(FROZEN_HASH_MAGIC));
+
+    if(!ok) {
+        log_message("[%s] is not a frozen hash table", fileName);
+    } else if(FROZEN_HASH_VERSION != h->version ||
+              sizeof(FrozenHashHeader) != h->headerSize) {
+        log_message("[%s] is frozen hash table version %u, expected %u",
+                    fileName, h->version, FROZEN_HASH_VERSION);
+        ok = false;
+    } else if(frozen_header_checksum(h) != h->headerChecksum) {
+        log_message("[%s] frozen hash table header is corrupt", fileName);
+        ok = false;
+    } else if(h->fileSize != len || 0 == h->bucketCount || 0 == h->slotCount ||
+              h->pilotOffset != sizeof(FrozenHashHeader) ||
+              h->slotOffset < h->pilotOffset + sizeof(uint16_t) * h->bucketCount ||
+              h->dataOffset < h->slotOffset + sizeof(uint32_t) * h->slotCount ||
+              h->dataOffset > len) {
+        log_message("[%s] frozen hash table is truncated or inconsistent",
+                    fileName);
+        ok = false;
+    }
+
+    if(!ok) {
+        mapped_file_close(&fht->file);
+        return false;
+    }
+
+    frozen_hashtable_attach(fht, fht->file.data);
+    return true;
+}
+
+bool frozen_hashtable_verify(const FrozenHashTable *fht) {
+    assert(NULL != fht);
+    const FrozenHashHeader *h = fht->header;
+    if(NULL == h) return false;
+
+    return h->payloadChecksum == hash_bytes(fht->data + h->pilotOffset,
+                                            h->fileSize - h->pilotOffset,
+                                            HASH_DEFAULT_SEED);
+}
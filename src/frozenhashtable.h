@@ -0,0 +1,127 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#ifndef SEARCHFILEC_FROZENHASHTABLE_H
+#define SEARCHFILEC_FROZENHASHTABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "buffer.h"
+#include "hashtable.h"
+#include "mappedfile.h"
+
+#define FROZEN_HASH_MAGIC "SSCFRZN"
+#define FROZEN_HASH_VERSION 1
+
+// average number of keys sharing one pilot, 16 bit pilots over 5 keys cost
+// 3.2 bits per key
+#define FROZEN_HASH_BUCKET_LOAD 5
+
+// slots per key is 1 / 0.99, the few spare slots keep pilot searches short
+#define FROZEN_HASH_SLOT_LOAD 0.99
+
+/*
+ * FrozenHashTable
+ * an immutable table built once from a populated HashTable using a PTHash
+ * style (near) minimal perfect hash.  Every key hashes to a bucket which owns
+ * a 16 bit pilot, and the key's hash mixed with its bucket's pilot names the
+ * one slot the key can be in.  A lookup is therefore always one probe plus
+ * one key comparison.
+ *
+ * The table is a single contiguous, position independent image
+ *
+ * [header][pilots][slots][entries]
+ *
+ * so it is saved by writing it out and may be used straight from a read only
+ * mapping.  A slot holds (entry offset / 8) + 1 relative to the entries, or 0
+ * when empty.  An entry is a uint32 key length, a uint32 value length, the key,
+ * the value and padding up to 8 bytes.
+*/
+
+typedef struct stFrozenHashHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t entryCount;
+    uint64_t bucketCount;
+    uint64_t slotCount;
+    uint64_t seed;
+    uint64_t pilotOffset;
+    uint64_t slotOffset;
+    uint64_t dataOffset;
+    uint64_t fileSize;
+    uint64_t payloadChecksum;
+    uint64_t headerChecksum;
+} FrozenHashHeader;
+
+typedef struct stFrozenHashTable {
+    Buffer image;
+    MappedFile file;
+    const unsigned char *data;
+    const FrozenHashHeader *header;
+    const uint16_t *pilots;
+    const uint32_t *slots;
+} FrozenHashTable;
+
+/* initialize a frozen hash table [fht] so that it holds nothing
+ * [fht] - frozen hash table to initialize
+ */
+void frozen_hashtable_init(FrozenHashTable *fht);
+
+/* build an immutable copy of every pair in hashtable [ht] into [fht], the
+ * image is allocated using ht's recycler
+ * [ht] - hash table to freeze, left unchanged
+ * [fht] - frozen hash table to populate
+ * returns true on success, false on memory exhaustion or if no perfect hash
+ * could be found (in practice only for keys whose 64 bit hashes collide)
+ */
+bool hashtable_freeze(HashTable *ht, FrozenHashTable *fht);
+
+/* free any memory held by or unmap frozen hash table [fht] */
+void frozen_hashtable_free(FrozenHashTable *fht);
+
+/* look up key [key] in frozen hash table [fht]
+ * [fht] - frozen hash table to search
+ * [key] - key of data to retrieve
+ * [value] - view pointed at the stored value when found, valid until the
+ * table is freed
+ * returns true if the key was found
+ */
+bool frozen_hashtable_get(const FrozenHashTable *fht, const HashKey *key,
+                          BufferView *value);
+
+/* the same as frozen_hashtable_get with the key held in view [key] */
+bool frozen_hashtable_get_view(const FrozenHashTable *fht,
+                               const BufferView *key, BufferView *value);
+
+/* check frozen hash table [fht] for key [key]
+ * returns true if the key exists in the table
+ */
+bool frozen_hashtable_has(const FrozenHashTable *fht, const HashKey *key);
+
+/* get the number of pairs stored in frozen hash table [fht] */
+size_t frozen_hashtable_get_entry_count(const FrozenHashTable *fht);
+
+/* get the total number of bytes used by frozen hash table [fht], header,
+ * pilots, slots, keys and values included
+ */
+size_t frozen_hashtable_get_memory(const FrozenHashTable *fht);
+
+/* write frozen hash table [fht] to file [fileName]
+ * returns true on success
+ */
+bool frozen_hashtable_save(const FrozenHashTable *fht, const char *fileName);
+
+/* map a frozen hash table saved to [fileName] read only into [fht], only the
+ * header is validated so this is O(1)
+ * returns true on success
+ */
+bool frozen_hashtable_open_mapped(FrozenHashTable *fht, const char *fileName);
+
+/* check every byte of frozen hash table [fht] against its checksum
+ * returns true if the table is intact
+ */
+bool frozen_hashtable_verify(const FrozenHashTable *fht);
+
+#endif //SEARCHFILEC_FROZENHASHTABLE_H
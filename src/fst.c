@@ -0,0 +1,703 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#include <assert.h>
+#include <limits.h>
+#include <stddef.h>
+#include <string.h>
+#include "fst.h"
+#include "hash.h"
+#include "log.h"
+
+// largest serialized state: flags, a two byte count, a ten byte final
+// output, widths and 256 arcs of a label and two eight byte fields
+#define FST_MAX_STATE_BYTES (1 + 2 + 10 + 1 + 256 * 17)
+
+#define FST_FINAL 1
+#define FST_FINAL_OUTPUT 2
+
+typedef struct stFstArc {
+    uint64_t output;
+    uint64_t target;
+    unsigned char label;
+} FstArc;
+
+// a state of the word most recently added, still open to change
+typedef struct stFstNode {
+    FstArc *arcs;
+    size_t count;
+    size_t cap;
+    bool final;
+    uint64_t finalOutput;
+} FstNode;
+
+// a compiled state in the registry used to share identical states
+typedef struct stFstRegistrySlot {
+    uint64_t hash;
+    uint64_t offset;
+    uint64_t len;
+} FstRegistrySlot;
+
+typedef struct stFstBuilder {
+    Buffer *image;
+    FstNode *frontier;
+    size_t frontierCap;
+    FstRegistrySlot *slots;
+    size_t slotCap;
+    size_t slotCount;
+    uint64_t arcCount;
+    unsigned char scratch[FST_MAX_STATE_BYTES];
+} FstBuilder;
+
+// a state read back out of an image
+typedef struct stFstState {
+    bool final;
+    uint64_t finalOutput;
+    size_t count;
+    unsigned outBytes;
+    unsigned targetBytes;
+    const unsigned char *arcs;
+} FstState;
+
+// one level of an iterator's walk, the state reached, the output summed on
+// the way there and the next of its arcs to follow
+typedef struct stFstFrame {
+    uint64_t state;
+    uint64_t output;
+    uint32_t arc;
+    uint32_t visited;
+} FstFrame;
+
+static uint64_t fst_header_checksum(const FstHeader *header) {
+    return hash_bytes(header, offsetof(FstHeader, headerChecksum),
+                      HASH_DEFAULT_SEED);
+}
+
+// number of bytes needed to hold [v], 0 for 0
+static unsigned fst_byte_width(uint64_t v) {
+    unsigned n = 0;
+    while(v) {
+        ++n;
+        v >>= 8;
+    }
+    return n;
+}
+
+static size_t fst_put_varint(unsigned char *p, uint64_t v) {
+    size_t n = 0;
+    while(v >= 0x80) {
+        p[n++] = (unsigned char) (v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (unsigned char) v;
+    return n;
+}
+
+static const unsigned char *fst_get_varint(const unsigned char *p,
+                                           uint64_t *v) {
+    uint64_t r = 0;
+    unsigned shift = 0;
+    while(*p & 0x80) {
+        r |= (uint64_t) (*p++ & 0x7f) << shift;
+        shift += 7;
+    }
+    *v = r | ((uint64_t) *p++ << shift);
+    return p;
+}
+
+static void fst_put_fixed(unsigned char *p, uint64_t v, unsigned bytes) {
+    for(unsigned i=0; i<bytes; ++i) p[i] = (unsigned char) (v >> (8 * i));
+}
+
+static uint64_t fst_get_fixed(const unsigned char *p, unsigned bytes) {
+    uint64_t v = 0;
+    for(unsigned i=0; i<bytes; ++i) v |= (uint64_t) p[i] << (8 * i);
+    return v;
+}
+
+// point the section pointers of [fst] at the image starting at [data]
+static void fst_attach(Fst *fst, const unsigned char *data) {
+    fst->data = data;
+    fst->header = (const FstHeader *) data;
+    fst->states = data + fst->header->stateOffset;
+}
+
+static void fst_read_state(const Fst *fst, uint64_t offset, FstState *s) {
+    const unsigned char *p = fst->states + offset;
+    const unsigned char flags = *p++;
+    uint64_t count;
+    p = fst_get_varint(p, &count);
+    s->final = 0 != (flags & FST_FINAL);
+    s->finalOutput = 0;
+    if(flags & FST_FINAL_OUTPUT) p = fst_get_varint(p, &s->finalOutput);
+    s->count = (size_t) count;
+    s->outBytes = s->targetBytes = 0;
+    if(count) {
+        s->outBytes = *p & 0x0f;
+        s->targetBytes = *p >> 4;
+        ++p;
+    }
+    s->arcs = p;
+}
+
+static void fst_read_arc(const FstState *s, size_t i, unsigned char *label,
+                         uint64_t *output, uint64_t *target) {
+    const unsigned char *a = s->arcs + i * (1 + s->outBytes + s->targetBytes);
+    *label = a[0];
+    *output = fst_get_fixed(a + 1, s->outBytes);
+    *target = fst_get_fixed(a + 1 + s->outBytes, s->targetBytes);
+}
+
+// index of the first arc of state [s] whose label is not below [label]
+static size_t fst_lower_arc(const FstState *s, unsigned char label) {
+    const size_t stride = 1 + s->outBytes + s->targetBytes;
+    size_t lo = 0, hi = s->count;
+    while(lo < hi) {
+        const size_t mid = (lo + hi) / 2;
+        if(s->arcs[mid * stride] < label) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+// add [s] to every output leaving frontier state [node]
+static void fst_node_prepend(FstNode *node, uint64_t s) {
+    for(size_t i=0; i<node->count; ++i) node->arcs[i].output += s;
+    if(node->final) node->finalOutput += s;
+}
+
+static bool fst_node_add_arc(FstNode *node, unsigned char label) {
+    if(node->count == node->cap) {
+        const size_t cap = node->cap ? node->cap * 2 : 4;
+        FstArc *arcs = realloc(node->arcs, cap * sizeof(FstArc));
+        if(NULL == arcs) {
+            log_message("Unable to grow a state to %zu arcs", cap);
+            return false;
+        }
+        node->arcs = arcs;
+        node->cap = cap;
+    }
+    FstArc *arc = &node->arcs[node->count++];
+    arc->label = label;
+    arc->output = 0;
+    arc->target = 0;
+    return true;
+}
+
+static void fst_node_reset(FstNode *node) {
+    node->count = 0;
+    node->final = false;
+    node->finalOutput = 0;
+}
+
+static bool fst_builder_frontier(FstBuilder *b, size_t len) {
+    if(len < b->frontierCap) return true;
+    size_t cap = b->frontierCap * 2;
+    if(cap <= len) cap = len + 1;
+    FstNode *frontier = realloc(b->frontier, cap * sizeof(FstNode));
+    if(NULL == frontier) {
+        log_message("Unable to allocate %zu frontier states", cap);
+        return false;
+    }
+    memset(frontier + b->frontierCap, 0, (cap - b->frontierCap) * sizeof(FstNode));
+    b->frontier = frontier;
+    b->frontierCap = cap;
+    return true;
+}
+
+static bool fst_builder_grow_registry(FstBuilder *b) {
+    const size_t cap = b->slotCap ? b->slotCap * 2 : 1024;
+    FstRegistrySlot *slots = calloc(cap, sizeof(FstRegistrySlot));
+    if(NULL == slots) {
+        log_message("Unable to allocate %zu registry slots", cap);
+        return false;
+    }
+    for(size_t i=0; i<b->slotCap; ++i) {
+        if(0 == b->slots[i].len) continue;
+        size_t j = b->slots[i].hash & (cap - 1);
+        while(0 != slots[j].len) j = (j + 1) & (cap - 1);
+        slots[j] = b->slots[i];
+    }
+    free(b->slots);
+    b->slots = slots;
+    b->slotCap = cap;
+    return true;
+}
+
+// write frontier state [node] to the image, or find an identical state
+// already written, and return its offset in [offset].  children are always
+// written before their parent so equal states serialize to equal bytes
+static bool fst_builder_compile(FstBuilder *b, const FstNode *node,
+                                uint64_t *offset) {
+    unsigned char *p = b->scratch;
+    uint64_t maxOutput = 0, maxTarget = 0;
+    for(size_t i=0; i<node->count; ++i) {
+        if(node->arcs[i].output > maxOutput) maxOutput = node->arcs[i].output;
+        if(node->arcs[i].target > maxTarget) maxTarget = node->arcs[i].target;
+    }
+
+    *p = node->final ? FST_FINAL : 0;
+    if(node->final && node->finalOutput) *p |= FST_FINAL_OUTPUT;
+    ++p;
+    p += fst_put_varint(p, node->count);
+    if(node->final && node->finalOutput) p += fst_put_varint(p, node->finalOutput);
+    if(node->count) {
+        const unsigned ob = fst_byte_width(maxOutput);
+        const unsigned tb = fst_byte_width(maxTarget);
+        *p++ = (unsigned char) (ob | tb << 4);
+        for(size_t i=0; i<node->count; ++i) {
+            *p++ = node->arcs[i].label;
+            fst_put_fixed(p, node->arcs[i].output, ob);
+            p += ob;
+            fst_put_fixed(p, node->arcs[i].target, tb);
+            p += tb;
+        }
+    }
+    const size_t len = (size_t) (p - b->scratch);
+
+    if(2 * (b->slotCount + 1) > b->slotCap && !fst_builder_grow_registry(b))
+        return false;
+
+    const unsigned char *states = b->image->data + sizeof(FstHeader);
+    const uint64_t hash = hash_bytes(b->scratch, len, HASH_DEFAULT_SEED);
+    size_t j = hash & (b->slotCap - 1);
+    while(0 != b->slots[j].len) {
+        const FstRegistrySlot *s = &b->slots[j];
+        if(s->hash == hash && s->len == len &&
+           0 == memcmp(states + s->offset, b->scratch, len)) {
+            *offset = s->offset;
+            return true;
+        }
+        j = (j + 1) & (b->slotCap - 1);
+    }
+
+    Buffer *image = b->image;
+    const size_t need = image->len + len;
+    if(need > image->cap) {
+        size_t cap = image->cap * 2;
+        if(cap < need) cap = need;
+        if(cap > UINT_MAX) cap = UINT_MAX;
+        if(need > cap || !buffer_reserve(image, (unsigned int) cap)) {
+            log_message("Unable to grow dictionary image past %zu bytes",
+                        image->len);
+            return false;
+        }
+    }
+
+    *offset = image->len - sizeof(FstHeader);
+    memcpy(image->data + image->len, b->scratch, len);
+    image->len += len;
+
+    b->slots[j].hash = hash;
+    b->slots[j].offset = *offset;
+    b->slots[j].len = len;
+    b->slotCount++;
+    b->arcCount += node->count;
+    return true;
+}
+
+// write the frontier states below depth [depth] of the previous word, from
+// [last] up, pointing each parent's last arc at its compiled child
+static bool fst_builder_freeze(FstBuilder *b, size_t last, size_t depth) {
+    for(size_t idx=last; idx>depth; --idx) {
+        FstNode *parent = &b->frontier[idx - 1];
+        if(!fst_builder_compile(b, &b->frontier[idx],
+                                &parent->arcs[parent->count - 1].target))
+            return false;
+        fst_node_reset(&b->frontier[idx]);
+    }
+    return true;
+}
+
+static void fst_builder_free(FstBuilder *b) {
+    for(size_t i=0; i<b->frontierCap; ++i) free(b->frontier[i].arcs);
+    free(b->frontier);
+    free(b->slots);
+}
+
+void fst_init(Fst *fst) {
+    assert(NULL != fst);
+    buffer_init(&fst->image);
+    mapped_file_init(&fst->file);
+    fst->data = NULL;
+    fst->header = NULL;
+    fst->states = NULL;
+}
+
+bool fst_build(Fst *fst, BufferArray *words, const uint64_t *payloads) {
+    assert(NULL != fst);
+    assert(NULL != words);
+
+    fst_init(fst);
+    buffer_assign_recycler(&fst->image, words->recycler);
+
+    const size_t n = buffer_array_get_buffer_count(words);
+
+    FstBuilder *b = calloc(1, sizeof(FstBuilder));
+    bool ok = NULL != b;
+    if(ok) {
+        b->image = &fst->image;
+        ok = fst_builder_frontier(b, 0) &&
+             buffer_reserve(&fst->image, sizeof(FstHeader) + 4096);
+    }
+    if(!ok) {
+        log_message("Unable to allocate a dictionary builder");
+        if(NULL != b) fst_builder_free(b);
+        free(b);
+        fst_free(fst);
+        return false;
+    }
+    memset(fst->image.data, 0, sizeof(FstHeader));
+    fst->image.len = sizeof(FstHeader);
+
+    const unsigned char *prev = NULL;
+    size_t prevLen = 0;
+    size_t maxLen = 0;
+
+    for(size_t i=0; ok && i<n; ++i) {
+        const Buffer *w = buffer_array_get_buffer(words, i);
+        const unsigned char *word = w->data;
+        const size_t len = NULL == word ? 0 : w->len;
+        uint64_t output = NULL == payloads ? i : payloads[i];
+
+        size_t p = 0;
+        const size_t shorter = len < prevLen ? len : prevLen;
+        while(p < shorter && prev[p] == word[p]) ++p;
+
+        if(i > 0 && (p == len || (p < shorter && prev[p] > word[p]))) {
+            log_message("Dictionary word %zu is out of order or repeated", i);
+            ok = false;
+            break;
+        }
+
+        if(!fst_builder_freeze(b, prevLen, p) ||
+           !fst_builder_frontier(b, len)) {
+            ok = false;
+            break;
+        }
+
+        for(size_t idx=p+1; idx<=len && ok; ++idx) {
+            fst_node_reset(&b->frontier[idx]);
+            ok = fst_node_add_arc(&b->frontier[idx - 1], word[idx - 1]);
+        }
+        if(!ok) break;
+        b->frontier[len].final = true;
+
+        // move the part of each shared arc's output this word disagrees
+        // with further down, past the point where the words part ways
+        for(size_t idx=1; idx<=p; ++idx) {
+            FstArc *arc = &b->frontier[idx - 1].arcs[b->frontier[idx - 1].count - 1];
+            if(0 == arc->output) continue;
+            const uint64_t common = arc->output < output ? arc->output : output;
+            const uint64_t suffix = arc->output - common;
+            arc->output = common;
+            if(suffix) fst_node_prepend(&b->frontier[idx], suffix);
+            output -= common;
+        }
+
+        if(len > p) b->frontier[p].arcs[b->frontier[p].count - 1].output = output;
+        else b->frontier[len].finalOutput = output;
+
+        if(len > maxLen) maxLen = len;
+        prev = word;
+        prevLen = len;
+    }
+
+    uint64_t root = 0;
+    ok = ok && fst_builder_freeze(b, prevLen, 0) &&
+         fst_builder_compile(b, &b->frontier[0], &root);
+
+    if(ok) {
+        FstHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, FST_MAGIC, sizeof(FST_MAGIC));
+        header.version = FST_VERSION;
+        header.headerSize = sizeof(FstHeader);
+        header.entryCount = n;
+        header.stateCount = b->slotCount;
+        header.arcCount = b->arcCount;
+        header.maxWordLen = maxLen;
+        header.rootOffset = root;
+        header.stateOffset = sizeof(FstHeader);
+        header.fileSize = fst->image.len;
+        header.payloadChecksum = hash_bytes(fst->image.data + header.stateOffset,
+                                            header.fileSize - header.stateOffset,
+                                            HASH_DEFAULT_SEED);
+        header.headerChecksum = fst_header_checksum(&header);
+        memcpy(fst->image.data, &header, sizeof(header));
+        fst_attach(fst, fst->image.data);
+    }
+
+    fst_builder_free(b);
+    free(b);
+
+    if(!ok) fst_free(fst);
+    return ok;
+}
+
+void fst_free(Fst *fst) {
+    assert(NULL != fst);
+    Recycler *r = fst->image.recycler;
+    buffer_free(&fst->image);
+    mapped_file_close(&fst->file);
+    fst_init(fst);
+    buffer_assign_recycler(&fst->image, r);
+}
+
+bool fst_get_view(const Fst *fst, const BufferView *word, uint64_t *payload) {
+    assert(NULL != fst);
+    assert(NULL != word);
+
+    if(NULL == fst->header) return false;
+
+    FstState s;
+    uint64_t state = fst->header->rootOffset;
+    uint64_t output = 0;
+
+    for(size_t i=0; i<word->len; ++i) {
+        fst_read_state(fst, state, &s);
+        const size_t a = fst_lower_arc(&s, word->data[i]);
+        if(a == s.count) return false;
+
+        unsigned char label;
+        uint64_t out;
+        fst_read_arc(&s, a, &label, &out, &state);
+        if(label != word->data[i]) return false;
+        output += out;
+    }
+
+    fst_read_state(fst, state, &s);
+    if(!s.final) return false;
+    if(NULL != payload) *payload = output + s.finalOutput;
+    return true;
+}
+
+bool fst_get(const Fst *fst, const Buffer *word, uint64_t *payload) {
+    assert(NULL != word);
+
+    BufferView view;
+    buffer_view_from_buffer(&view, word);
+    return fst_get_view(fst, &view, payload);
+}
+
+size_t fst_get_entry_count(const Fst *fst) {
+    assert(NULL != fst);
+    if(NULL == fst->header) return 0;
+    return fst->header->entryCount;
+}
+
+size_t fst_get_memory(const Fst *fst) {
+    assert(NULL != fst);
+    if(NULL == fst->header) return 0;
+    return fst->header->fileSize;
+}
+
+size_t fst_get_state_count(const Fst *fst) {
+    assert(NULL != fst);
+    if(NULL == fst->header) return 0;
+    return fst->header->stateCount;
+}
+
+bool fst_save(const Fst *fst, const char *fileName) {
+    assert(NULL != fst);
+    assert(NULL != fileName);
+
+    if(NULL == fst->header) {
+        log_message("Unable to save an empty dictionary");
+        return false;
+    }
+
+    Buffer tmpName;
+    buffer_init(&tmpName);
+    const int fd = mapped_file_create(fileName, &tmpName);
+    if(-1 == fd) return false;
+
+    const bool ok = mapped_file_write(fd, fst->data, fst->header->fileSize);
+    return mapped_file_commit(fd, &tmpName, fileName, ok);
+}
+
+bool fst_open_mapped(Fst *fst, const char *fileName) {
+    assert(NULL != fst);
+    assert(NULL != fileName);
+
+    fst_init(fst);
+    if(!mapped_file_open(&fst->file, fileName)) return false;
+
+    const FstHeader *h = (const FstHeader *) fst->file.data;
+    const size_t len = fst->file.len;
+    bool ok = len >= sizeof(FstHeader) &&
+              0 == memcmp(h->magic, FST_MAGIC, sizeof(FST_MAGIC));
+
+    if(!ok) {
+        log_message("[%s] is not a dictionary", fileName);
+    } else if(FST_VERSION != h->version || sizeof(FstHeader) != h->headerSize) {
+        log_message("[%s] is dictionary version %u, expected %u", fileName,
+                    h->version, FST_VERSION);
+        ok = false;
+    } else if(fst_header_checksum(h) != h->headerChecksum) {
+        log_message("[%s] dictionary header is corrupt", fileName);
+        ok = false;
+    } else if(h->fileSize != len || h->stateOffset != sizeof(FstHeader) ||
+              h->rootOffset >= len - h->stateOffset) {
+        log_message("[%s] dictionary is truncated or inconsistent", fileName);
+        ok = false;
+    }
+
+    if(!ok) {
+        mapped_file_close(&fst->file);
+        return false;
+    }
+
+    fst_attach(fst, fst->file.data);
+    return true;
+}
+
+bool fst_verify(const Fst *fst) {
+    assert(NULL != fst);
+    const FstHeader *h = fst->header;
+    if(NULL == h) return false;
+
+    return h->payloadChecksum == hash_bytes(fst->data + h->stateOffset,
+                                            h->fileSize - h->stateOffset,
+                                            HASH_DEFAULT_SEED);
+}
+
+// make room for the deepest walk [it] can take and reset it to no frames
+static bool fst_iterator_reset(FstIterator *it) {
+    const size_t depth = NULL == it->fst->header ? 0 :
+                         (size_t) it->fst->header->maxWordLen;
+    it->depth = 0;
+    buffer_clear(&it->word);
+    buffer_clear(&it->stack);
+    if(!buffer_reserve(&it->word, (unsigned int) (depth + 1)) ||
+       !buffer_reserve(&it->stack, (unsigned int) ((depth + 1) * sizeof(FstFrame)))) {
+        log_message("Unable to allocate an iterator %zu deep", depth);
+        return false;
+    }
+    return true;
+}
+
+static FstFrame *fst_iterator_push(FstIterator *it, uint64_t state,
+                                   uint64_t output) {
+    FstFrame *f = (FstFrame *) it->stack.data + it->depth++;
+    f->state = state;
+    f->output = output;
+    f->arc = 0;
+    f->visited = 0;
+    return f;
+}
+
+void fst_iterator_init(FstIterator *it, const Fst *fst) {
+    assert(NULL != it);
+    assert(NULL != fst);
+
+    it->fst = fst;
+    it->depth = 0;
+    buffer_init(&it->word);
+    buffer_init(&it->stack);
+
+    BufferView all;
+    buffer_view_init(&all);
+    fst_iterator_seek_prefix(it, &all);
+}
+
+bool fst_iterator_seek_prefix(FstIterator *it, const BufferView *prefix) {
+    assert(NULL != it);
+    assert(NULL != prefix);
+
+    if(!fst_iterator_reset(it) || NULL == it->fst->header ||
+       0 == it->fst->header->entryCount) return false;
+
+    FstState s;
+    uint64_t state = it->fst->header->rootOffset;
+    uint64_t output = 0;
+
+    for(size_t i=0; i<prefix->len; ++i) {
+        fst_read_state(it->fst, state, &s);
+        const size_t a = fst_lower_arc(&s, prefix->data[i]);
+        unsigned char label = 0;
+        uint64_t out = 0;
+        if(a < s.count) fst_read_arc(&s, a, &label, &out, &state);
+        if(a == s.count || label != prefix->data[i]) return false;
+        output += out;
+    }
+
+    // the walk never climbs above the state the prefix leads to
+    if(prefix->len && !buffer_push_bytes(&it->word, prefix->data, prefix->len))
+        return false;
+    fst_iterator_push(it, state, output);
+    return true;
+}
+
+bool fst_iterator_seek(FstIterator *it, const BufferView *word) {
+    assert(NULL != it);
+    assert(NULL != word);
+
+    if(!fst_iterator_reset(it) || NULL == it->fst->header) return false;
+
+    FstState s;
+    FstFrame *f = fst_iterator_push(it, it->fst->header->rootOffset, 0);
+
+    for(size_t i=0; i<word->len; ++i) {
+        fst_read_state(it->fst, f->state, &s);
+        const size_t a = fst_lower_arc(&s, word->data[i]);
+
+        // the words ending here or before come ahead of [word]
+        f->visited = 1;
+        f->arc = (uint32_t) a;
+        if(a == s.count) return true;
+
+        unsigned char label;
+        uint64_t out, target;
+        fst_read_arc(&s, a, &label, &out, &target);
+
+        // every word down a larger label follows [word], next takes it
+        if(label != word->data[i]) return true;
+
+        f->arc++;
+        buffer_push_byte(&it->word, label);
+        f = fst_iterator_push(it, target, f->output + out);
+    }
+    return true;
+}
+
+bool fst_iterator_next(FstIterator *it, BufferView *word, uint64_t *payload) {
+    assert(NULL != it);
+    assert(NULL != word);
+
+    FstState s;
+    while(it->depth > 0) {
+        FstFrame *f = (FstFrame *) it->stack.data + it->depth - 1;
+        fst_read_state(it->fst, f->state, &s);
+
+        if(!f->visited) {
+            f->visited = 1;
+            if(s.final) {
+                buffer_view_set(word, it->word.data, it->word.len);
+                if(NULL != payload) *payload = f->output + s.finalOutput;
+                return true;
+            }
+        }
+
+        if(f->arc < s.count) {
+            unsigned char label;
+            uint64_t out, target;
+            fst_read_arc(&s, f->arc++, &label, &out, &target);
+            it->word.data[it->word.len++] = label;
+            fst_iterator_push(it, target, f->output + out);
+            continue;
+        }
+
+        // the state the walk started from keeps the seeked prefix
+        if(--it->depth > 0) it->word.len--;
+    }
+    return false;
+}
+
+void fst_iterator_free(FstIterator *it) {
+    assert(NULL != it);
+    buffer_free(&it->word);
+    buffer_free(&it->stack);
+    it->depth = 0;
+}
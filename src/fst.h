@@ -0,0 +1,170 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#ifndef SEARCHFILEC_FST_H
+#define SEARCHFILEC_FST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "buffer.h"
+#include "bufferarray.h"
+#include "mappedfile.h"
+
+#define FST_MAGIC "SSCFST1"
+#define FST_VERSION 1
+
+/*
+ * Fst
+ * an immutable dictionary mapping byte string words to 64 bit payloads,
+ * stored as a minimal acyclic finite state transducer.  Words sharing a
+ * prefix share the states spelling it and words sharing a suffix share the
+ * states which finish them, so a large dictionary costs far less than its
+ * word bytes.  Each payload is split over the arcs of its word's path and
+ * found again by summing the outputs met on the way.
+ *
+ * Being a trie at heart the dictionary also answers which words start with
+ * a prefix and which word follows another, walking words in byte order.
+ *
+ * The dictionary is a single contiguous, position independent image
+ *
+ * [header][states]
+ *
+ * so it is saved by writing it out and may be used straight from a read only
+ * mapping.  A state is
+ *
+ *   flags byte         bit 0 final, bit 1 final output follows
+ *   arc count          varint
+ *   final output       varint, when flagged
+ *   widths byte        when there are arcs, output bytes in the low nibble
+ *                      and target bytes in the high nibble
+ *   arcs               sorted by label, each the label byte, its output and
+ *                      the offset of its target state in that many bytes
+ *
+ * Fixed width arcs let a lookup binary search a state's arcs in place.
+*/
+
+typedef struct stFstHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t entryCount;
+    uint64_t stateCount;
+    uint64_t arcCount;
+    uint64_t maxWordLen;
+    uint64_t rootOffset;
+    uint64_t stateOffset;
+    uint64_t fileSize;
+    uint64_t payloadChecksum;
+    uint64_t headerChecksum;
+} FstHeader;
+
+typedef struct stFst {
+    Buffer image;
+    MappedFile file;
+    const unsigned char *data;
+    const FstHeader *header;
+    const unsigned char *states;
+} Fst;
+
+/* FstIterator
+ * walks the words of a dictionary in byte order, either all of them, those
+ * starting with a prefix or those from a word onwards
+ */
+
+typedef struct stFstIterator {
+    const Fst *fst;
+    Buffer word;
+    Buffer stack;
+    size_t depth;
+} FstIterator;
+
+/* initialize a dictionary [fst] so that it holds nothing
+ * [fst] - dictionary to initialize
+ */
+void fst_init(Fst *fst);
+
+/* build a dictionary [fst] of the words held in [words], which must be
+ * sorted in byte order (see buffer_cmp_bytes) with no word given twice.
+ * The image is allocated using the recycler of [words]
+ * [fst] - dictionary to populate
+ * [words] - sorted words
+ * [payloads] - payload of each word, or NULL to give each word its index
+ * returns true on success, false when the words are out of order or memory
+ * is exhausted
+ */
+bool fst_build(Fst *fst, BufferArray *words, const uint64_t *payloads);
+
+/* free any memory held by or unmap dictionary [fst] */
+void fst_free(Fst *fst);
+
+/* look up word [word] in dictionary [fst]
+ * [fst] - dictionary to search
+ * [word] - word to look for
+ * [payload] - receives the word's payload when found, may be NULL
+ * returns true if the word was found
+ */
+bool fst_get(const Fst *fst, const Buffer *word, uint64_t *payload);
+
+/* the same as fst_get with the word held in view [word] */
+bool fst_get_view(const Fst *fst, const BufferView *word, uint64_t *payload);
+
+/* get the number of words held in dictionary [fst] */
+size_t fst_get_entry_count(const Fst *fst);
+
+/* get the total number of bytes used by dictionary [fst] */
+size_t fst_get_memory(const Fst *fst);
+
+/* get the number of states in dictionary [fst] */
+size_t fst_get_state_count(const Fst *fst);
+
+/* write dictionary [fst] to file [fileName]
+ * returns true on success
+ */
+bool fst_save(const Fst *fst, const char *fileName);
+
+/* map a dictionary saved to [fileName] read only into [fst], only the
+ * header is validated so this is O(1)
+ * returns true on success
+ */
+bool fst_open_mapped(Fst *fst, const char *fileName);
+
+/* check every byte of dictionary [fst] against its checksum
+ * returns true if the dictionary is intact
+ */
+bool fst_verify(const Fst *fst);
+
+/* prepare iterator [it] to walk every word of dictionary [fst] in order
+ * [it] - iterator to initialize
+ * [fst] - dictionary to walk
+ */
+void fst_iterator_init(FstIterator *it, const Fst *fst);
+
+/* restrict iterator [it] to the words starting with [prefix], in order
+ * [it] - iterator to position
+ * [prefix] - bytes every word must start with, may be empty
+ * returns false when no word starts with prefix or memory is exhausted
+ */
+bool fst_iterator_seek_prefix(FstIterator *it, const BufferView *prefix);
+
+/* position iterator [it] on the first word which is not less than [word],
+ * iteration then carries on to the end of the dictionary
+ * [it] - iterator to position
+ * [word] - word to start from
+ * returns false on memory exhaustion
+ */
+bool fst_iterator_seek(FstIterator *it, const BufferView *word);
+
+/* advance iterator [it] to the next word
+ * [it] - iterator to advance
+ * [word] - view set to the word, valid until the iterator next moves
+ * [payload] - receives the word's payload, may be NULL
+ * returns false once every word has been visited
+ */
+bool fst_iterator_next(FstIterator *it, BufferView *word, uint64_t *payload);
+
+/* free memory held by iterator [it] */
+void fst_iterator_free(FstIterator *it);
+
+#endif //SEARCHFILEC_FST_H
@@ -0,0 +1,94 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#include <assert.h>
+#include <string.h>
+#include "hash.h"
+
+#define HASH_C1 0x87c37b91114253d5ULL
+#define HASH_C2 0x4cf5ad432745937fULL
+
+static uint64_t hash_rotl(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+uint64_t hash_mix64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+// fold one 8 byte word [k] into hash value [h]
+static uint64_t hash_round(uint64_t h, uint64_t k) {
+    k *= HASH_C1;
+    k = hash_rotl(k, 31);
+    k *= HASH_C2;
+    h ^= k;
+    h = hash_rotl(h, 27);
+    return h * 5 + 0x52dce729;
+}
+
+void hash_state_init(HashState *hs, uint64_t seed) {
+    assert(NULL != hs);
+    hs->h = seed;
+    hs->total = 0;
+    hs->tail = 0;
+    hs->tailLen = 0;
+}
+
+void hash_state_update(HashState *hs, const void *data, size_t len) {
+    assert(NULL != hs);
+    assert(NULL != data || 0 == len);
+
+    const unsigned char *p = (const unsigned char *) data;
+    hs->total += len;
+
+    // finish a word left partially filled by the previous update
+    while(hs->tailLen > 0 && len > 0) {
+        hs->tail |= (uint64_t) *p++ << (8 * hs->tailLen++);
+        --len;
+        if(8 == hs->tailLen) {
+            hs->h = hash_round(hs->h, hs->tail);
+            hs->tail = 0;
+            hs->tailLen = 0;
+        }
+    }
+
+    uint64_t k;
+    while(len >= 8) {
+        memcpy(&k, p, 8);
+        hs->h = hash_round(hs->h, k);
+        p += 8;
+        len -= 8;
+    }
+
+    while(len > 0) {
+        hs->tail |= (uint64_t) *p++ << (8 * hs->tailLen++);
+        --len;
+    }
+}
+
+uint64_t hash_state_final(HashState *hs) {
+    assert(NULL != hs);
+
+    uint64_t h = hs->h;
+    if(hs->tailLen > 0) {
+        uint64_t k = hs->tail * HASH_C1;
+        k = hash_rotl(k, 31);
+        k *= HASH_C2;
+        h ^= k;
+    }
+    h ^= hs->total;
+    return hash_mix64(h);
+}
+
+uint64_t hash_bytes(const void *data, size_t len, uint64_t seed) {
+    HashState hs;
+    hash_state_init(&hs, seed);
+    hash_state_update(&hs, data, len);
+    return hash_state_final(&hs);
+}
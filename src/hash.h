@@ -0,0 +1,57 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#ifndef SEARCHFILEC_HASH_H
+#define SEARCHFILEC_HASH_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define HASH_DEFAULT_SEED 0x2545f4914f6cdd1dULL
+
+/*
+ * a general purpose, well mixed 64 bit hash for places where the quality of
+ * every bit matters (on disk images, filters, perfect hashing) plus a
+ * streaming form of the same hash so large files can be checksummed as they
+ * are written
+*/
+
+typedef struct stHashState {
+    uint64_t h;
+    uint64_t total;
+    uint64_t tail;
+    size_t tailLen;
+} HashState;
+
+// hash [len] bytes at [data] using [seed]
+// [data] - bytes to hash
+// [len] - number of bytes
+// [seed] - seed, different seeds give independent hash functions
+// returns 64 bit hash
+uint64_t hash_bytes(const void *data, size_t len, uint64_t seed);
+
+// initialize a streaming hash [hs] with [seed]
+// [hs] - state to initialize
+// [seed] - seed, hashing the same bytes with the same seed in any number of
+// updates gives the same value as hash_bytes
+void hash_state_init(HashState *hs, uint64_t seed);
+
+// feed [len] bytes at [data] into streaming hash [hs]
+// [hs] - state to update
+// [data] - bytes to hash
+// [len] - number of bytes
+void hash_state_update(HashState *hs, const void *data, size_t len);
+
+// finish streaming hash [hs] and return its value, the state may not be
+// updated afterwards
+// [hs] - state to finish
+// returns 64 bit hash
+uint64_t hash_state_final(HashState *hs);
+
+// mix a single 64 bit value [x] into a well distributed 64 bit value
+// [x] - value to mix
+// returns mixed value
+uint64_t hash_mix64(uint64_t x);
+
+#endif //SEARCHFILEC_HASH_H
@@ -0,0 +1,362 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#include <assert.h>
+#include <limits.h>
+#include <string.h>
+#include "hashset.h"
+#include "hash.h"
+#include "log.h"
+
+// smallest slot array allocated
+#define HASH_SET_MIN_CAP 16
+
+// hash of a key as stored in a slot, zero marks an empty slot
+static uint64_t hashset_hash(const unsigned char *data, size_t len) {
+    uint64_t h = hash_bytes(data, len, HASH_DEFAULT_SEED);
+    return 0 == h ? 1 : h;
+}
+
+static const unsigned char * hashset_key(const HashSet *hs,
+                                         const HashSetSlot *slot) {
+    return hs->pool.data + slot->offset;
+}
+
+// index of the slot holding the key, or of the empty slot where it belongs
+static size_t hashset_find(const HashSet *hs, uint64_t h,
+                           const unsigned char *data, size_t len) {
+    const size_t mask = hs->cap - 1;
+    size_t i = (size_t) h & mask;
+    while(0 != hs->slots[i].hash) {
+        const HashSetSlot *s = &hs->slots[i];
+        if(s->hash == h && s->len == len &&
+           (0 == len || 0 == memcmp(hashset_key(hs, s), data, len)))
+            break;
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static bool hashset_contains_hashed(const HashSet *hs, uint64_t h,
+                                    const unsigned char *data, size_t len) {
+    if(0 == hs->count) return false;
+    return 0 != hs->slots[hashset_find(hs, h, data, len)].hash;
+}
+
+static HashSetSlot * hashset_alloc_slots(Recycler *rc, size_t cap) {
+    const size_t bytes = cap * sizeof(HashSetSlot);
+    HashSetSlot *slots = NULL != rc ? recycler_get_exact(rc, bytes)
+                                    : malloc(bytes);
+    if(NULL == slots) {
+        log_message("Unable to allocate %zu hash set slots", cap);
+        return NULL;
+    }
+    memset(slots, 0, bytes);
+    return slots;
+}
+
+static void hashset_release_slots(Recycler *rc, HashSetSlot *slots,
+                                  size_t cap) {
+    if(NULL == slots) return;
+    if(NULL != rc) recycler_return(rc, cap * sizeof(HashSetSlot), slots);
+    else free(slots);
+}
+
+// make room for [extra] more bytes in the key pool, growing it geometrically
+static bool hashset_pool_reserve(HashSet *hs, size_t extra) {
+    if(hs->pool.len + extra <= hs->pool.cap) return true;
+
+    // when removed keys fill half the pool drop them rather than grow, so
+    // churn at a steady count keeps the pool the size of the live keys
+    if(hs->deadBytes > 0 && hs->deadBytes >= hs->pool.len / 2 &&
+       !hashset_compact(hs))
+        return false;
+
+    const size_t need = hs->pool.len + extra;
+    if(need <= hs->pool.cap) return true;
+
+    size_t cap = hs->pool.cap * 2;
+    if(cap < need) cap = need;
+    if(cap < 256) cap = 256;
+    if(cap > UINT_MAX) cap = UINT_MAX;
+    if(need > cap) {
+        log_message("hash set key pool cannot hold %zu bytes", need);
+        return false;
+    }
+    return buffer_reserve(&hs->pool, (unsigned int) cap);
+}
+
+// move every key into a slot array of [cap] slots
+static bool hashset_rehash(HashSet *hs, size_t cap) {
+    HashSetSlot *slots = hashset_alloc_slots(hs->recycler, cap);
+    if(NULL == slots) return false;
+
+    const size_t mask = cap - 1;
+    for(size_t i=0; i<hs->cap; ++i) {
+        if(0 == hs->slots[i].hash) continue;
+        size_t j = (size_t) hs->slots[i].hash & mask;
+        while(0 != slots[j].hash) j = (j + 1) & mask;
+        slots[j] = hs->slots[i];
+    }
+
+    hashset_release_slots(hs->recycler, hs->slots, hs->cap);
+    hs->slots = slots;
+    hs->cap = cap;
+    return true;
+}
+
+// make sure [count] more keys fit without passing the maximum load
+static bool hashset_grow(HashSet *hs, size_t count) {
+    const size_t want = hs->count + count;
+    if(want * 8 < hs->cap * HASH_SET_MAX_LOAD) return true;
+
+    size_t cap = hs->cap ? hs->cap : HASH_SET_MIN_CAP;
+    while(want * 8 >= cap * HASH_SET_MAX_LOAD) cap <<= 1;
+
+    // a good moment to drop removed keys, every key is being touched anyway
+    if(hs->deadBytes > 0 && !hashset_compact(hs)) return false;
+    return hashset_rehash(hs, cap);
+}
+
+static bool hashset_insert_hashed(HashSet *hs, uint64_t h,
+                                  const unsigned char *data, size_t len,
+                                  bool *added) {
+    if(NULL != added) *added = false;
+    if(hs->count > 0 && 0 != hs->slots[hashset_find(hs, h, data, len)].hash)
+        return true;
+
+    if(!hashset_grow(hs, 1)) return false;
+    if(!hashset_pool_reserve(hs, len)) return false;
+
+    HashSetSlot *slot = &hs->slots[hashset_find(hs, h, data, len)];
+    slot->hash = h;
+    slot->offset = hs->pool.len;
+    slot->len = len;
+    if(len > 0) memcpy(hs->pool.data + hs->pool.len, data, len);
+    hs->pool.len += len;
+    hs->count++;
+    if(NULL != added) *added = true;
+    return true;
+}
+
+// empty slot [i] of hash set [hs], shifting back any key probing past it
+static void hashset_remove_at(HashSet *hs, size_t i) {
+    const size_t mask = hs->cap - 1;
+    hs->deadBytes += hs->slots[i].len;
+
+    size_t j = i;
+    for(;;) {
+        j = (j + 1) & mask;
+        if(0 == hs->slots[j].hash) break;
+        const size_t home = (size_t) hs->slots[j].hash & mask;
+        // key j may fill hole i only if its home is not in (i, j]
+        if(i <= j ? (i < home && home <= j) : (i < home || home <= j))
+            continue;
+        hs->slots[i] = hs->slots[j];
+        i = j;
+    }
+    hs->slots[i].hash = 0;
+    hs->count--;
+}
+
+void hashset_init(HashSet *hs) {
+    assert(NULL != hs);
+    hs->slots = NULL;
+    hs->cap = 0;
+    hs->count = 0;
+    hs->deadBytes = 0;
+    hs->recycler = NULL;
+    buffer_init(&hs->pool);
+}
+
+void hashset_assign_recycler(HashSet *hs, Recycler *rc) {
+    assert(NULL != hs);
+    hs->recycler = rc;
+    buffer_assign_recycler(&hs->pool, rc);
+}
+
+void hashset_free(HashSet *hs) {
+    assert(NULL != hs);
+    Recycler *rc = hs->recycler;
+    hashset_release_slots(rc, hs->slots, hs->cap);
+    buffer_free(&hs->pool);
+    hashset_init(hs);
+    hashset_assign_recycler(hs, rc);
+}
+
+void hashset_clear(HashSet *hs) {
+    assert(NULL != hs);
+    if(NULL != hs->slots) memset(hs->slots, 0, hs->cap * sizeof(HashSetSlot));
+    hs->count = 0;
+    hs->deadBytes = 0;
+    hs->pool.len = 0;
+}
+
+size_t hashset_get_count(const HashSet *hs) {
+    assert(NULL != hs);
+    return hs->count;
+}
+
+bool hashset_reserve(HashSet *hs, size_t count, size_t bytes) {
+    assert(NULL != hs);
+    return hashset_grow(hs, count) && hashset_pool_reserve(hs, bytes);
+}
+
+bool hashset_insert_bytes(HashSet *hs, const unsigned char *data, size_t len,
+                          bool *added) {
+    assert(NULL != hs);
+    assert(NULL != data || 0 == len);
+    return hashset_insert_hashed(hs, hashset_hash(data, len), data, len, added);
+}
+
+bool hashset_insert(HashSet *hs, const Buffer *key, bool *added) {
+    assert(NULL != key);
+    return hashset_insert_bytes(hs, key->data, key->len, added);
+}
+
+bool hashset_contains_bytes(const HashSet *hs, const unsigned char *data,
+                            size_t len) {
+    assert(NULL != hs);
+    assert(NULL != data || 0 == len);
+    return hashset_contains_hashed(hs, hashset_hash(data, len), data, len);
+}
+
+bool hashset_contains(const HashSet *hs, const Buffer *key) {
+    assert(NULL != key);
+    return hashset_contains_bytes(hs, key->data, key->len);
+}
+
+bool hashset_remove_bytes(HashSet *hs, const unsigned char *data, size_t len) {
+    assert(NULL != hs);
+    assert(NULL != data || 0 == len);
+    if(0 == hs->count) return false;
+
+    const size_t i = hashset_find(hs, hashset_hash(data, len), data, len);
+    if(0 == hs->slots[i].hash) return false;
+    hashset_remove_at(hs, i);
+    return true;
+}
+
+bool hashset_remove(HashSet *hs, const Buffer *key) {
+    assert(NULL != key);
+    return hashset_remove_bytes(hs, key->data, key->len);
+}
+
+bool hashset_build(HashSet *hs, BufferArray *keys) {
+    assert(NULL != hs);
+    assert(NULL != keys);
+
+    const size_t count = buffer_array_get_buffer_count(keys);
+    size_t bytes = 0;
+    for(size_t i=0; i<count; ++i) bytes += buffer_array_get_buffer(keys, i)->len;
+
+    // duplicates make this an over estimate, never an under estimate
+    if(!hashset_reserve(hs, count, bytes)) return false;
+
+    for(size_t i=0; i<count; ++i) {
+        if(!hashset_insert(hs, buffer_array_get_buffer(keys, i), NULL))
+            return false;
+    }
+    return true;
+}
+
+bool hashset_union(HashSet *dest, const HashSet *src) {
+    assert(NULL != dest);
+    assert(NULL != src);
+    if(dest == src) return true;
+
+    if(!hashset_grow(dest, src->count)) return false;
+
+    for(size_t i=0; i<src->cap; ++i) {
+        const HashSetSlot *s = &src->slots[i];
+        if(0 == s->hash) continue;
+        // both sets hash the same way so the stored hash is reused
+        if(!hashset_insert_hashed(dest, s->hash, hashset_key(src, s), s->len,
+                                  NULL))
+            return false;
+    }
+    return true;
+}
+
+void hashset_intersection(HashSet *dest, const HashSet *src) {
+    assert(NULL != dest);
+    assert(NULL != src);
+    if(dest == src) return;
+
+    // a removal shifts a later key into slot i, so look at i again.  keys
+    // only ever shift backwards, so none is skipped
+    size_t i = 0;
+    while(i < dest->cap) {
+        const HashSetSlot *s = &dest->slots[i];
+        if(0 != s->hash &&
+           !hashset_contains_hashed(src, s->hash, hashset_key(dest, s), s->len)) {
+            hashset_remove_at(dest, i);
+            continue;
+        }
+        ++i;
+    }
+}
+
+void hashset_difference(HashSet *dest, const HashSet *src) {
+    assert(NULL != dest);
+    assert(NULL != src);
+    if(dest == src) {
+        hashset_clear(dest);
+        return;
+    }
+
+    size_t i = 0;
+    while(i < dest->cap) {
+        const HashSetSlot *s = &dest->slots[i];
+        if(0 != s->hash &&
+           hashset_contains_hashed(src, s->hash, hashset_key(dest, s), s->len)) {
+            hashset_remove_at(dest, i);
+            continue;
+        }
+        ++i;
+    }
+}
+
+bool hashset_compact(HashSet *hs) {
+    assert(NULL != hs);
+    if(0 == hs->deadBytes) return true;
+
+    Buffer pool;
+    buffer_init(&pool);
+    buffer_assign_recycler(&pool, hs->recycler);
+
+    const size_t live = hs->pool.len - hs->deadBytes;
+    if(live > 0 && !buffer_reserve(&pool, (unsigned int) live)) return false;
+
+    for(size_t i=0; i<hs->cap; ++i) {
+        HashSetSlot *s = &hs->slots[i];
+        if(0 == s->hash) continue;
+        if(s->len > 0) memcpy(pool.data + pool.len, hashset_key(hs, s), s->len);
+        s->offset = pool.len;
+        pool.len += s->len;
+    }
+
+    buffer_free(&hs->pool);
+    hs->pool = pool;
+    hs->deadBytes = 0;
+    return true;
+}
+
+bool hashset_iterate(const HashSet *hs, size_t *pos, BufferView *key) {
+    assert(NULL != hs);
+    assert(NULL != pos);
+
+    while(*pos < hs->cap) {
+        const HashSetSlot *s = &hs->slots[(*pos)++];
+        if(0 == s->hash) continue;
+        if(NULL != key) buffer_view_set(key, hashset_key(hs, s), s->len);
+        return true;
+    }
+    return false;
+}
+
+size_t hashset_get_memory(const HashSet *hs) {
+    assert(NULL != hs);
+    return hs->cap * sizeof(HashSetSlot) + hs->pool.cap;
+}
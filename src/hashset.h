@@ -0,0 +1,119 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#ifndef SEARCHFILEC_HASHSET_H
+#define SEARCHFILEC_HASHSET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "buffer.h"
+#include "bufferarray.h"
+#include "recycler.h"
+
+/* HashSet
+ * a set of byte string keys with no value attached.  Key bytes are packed
+ * one after another into a single pool and the open addressed slot array
+ * only holds each key's hash, offset and length, so the set costs the key
+ * bytes plus a small fixed amount per key rather than a HashValue, two
+ * Buffers and their allocations.
+ *
+ * Removed keys leave their bytes in the pool until the next time the slot
+ * array grows, the pool would grow with half of it dead, or hashset_compact
+ * is called.  Any view handed out by the set
+ * points into the pool and is invalidated by the next insert.
+ */
+
+// the slot array grows once it is this many eighths full
+#define HASH_SET_MAX_LOAD 6
+
+typedef struct stHashSetSlot {
+    uint64_t hash;
+    size_t offset;
+    size_t len;
+} HashSetSlot;
+
+typedef struct stHashSet {
+    HashSetSlot *slots;
+    size_t cap;
+    size_t count;
+    Buffer pool;
+    size_t deadBytes;
+    Recycler *recycler;
+} HashSet;
+
+// initialize hash set [hs] so that it is empty and holds no memory
+void hashset_init(HashSet *hs);
+
+// assign recycler [rc] to hash set [hs], call before anything is inserted
+void hashset_assign_recycler(HashSet *hs, Recycler *rc);
+
+// free all memory held by hash set [hs] leaving it empty
+void hashset_free(HashSet *hs);
+
+// remove every key from hash set [hs] keeping its memory for reuse
+void hashset_clear(HashSet *hs);
+
+// returns the number of keys in hash set [hs]
+size_t hashset_get_count(const HashSet *hs);
+
+// make room in hash set [hs] for [count] keys holding [bytes] key bytes in
+// total so they can be inserted without growing
+// returns false on memory exhaustion
+bool hashset_reserve(HashSet *hs, size_t count, size_t bytes);
+
+/* insert the [len] bytes at [data] into hash set [hs]
+ * [added] - if not NULL, set to true when the key was not already present
+ * returns false only on memory exhaustion
+ */
+bool hashset_insert_bytes(HashSet *hs, const unsigned char *data, size_t len,
+                          bool *added);
+
+// insert the data held by [key] into hash set [hs], see hashset_insert_bytes
+bool hashset_insert(HashSet *hs, const Buffer *key, bool *added);
+
+// returns true if hash set [hs] holds the [len] bytes at [data]
+bool hashset_contains_bytes(const HashSet *hs, const unsigned char *data,
+                            size_t len);
+
+// returns true if hash set [hs] holds the data of [key]
+bool hashset_contains(const HashSet *hs, const Buffer *key);
+
+// remove the [len] bytes at [data] from hash set [hs]
+// returns true if the key was present
+bool hashset_remove_bytes(HashSet *hs, const unsigned char *data, size_t len);
+
+// remove the data of [key] from hash set [hs]
+// returns true if the key was present
+bool hashset_remove(HashSet *hs, const Buffer *key);
+
+// insert every buffer of [keys] into hash set [hs], sizing the set once up
+// front.  returns false on memory exhaustion
+bool hashset_build(HashSet *hs, BufferArray *keys);
+
+// add every key of [src] to [dest]
+// returns false on memory exhaustion
+bool hashset_union(HashSet *dest, const HashSet *src);
+
+// remove every key from [dest] which is not also in [src]
+void hashset_intersection(HashSet *dest, const HashSet *src);
+
+// remove every key from [dest] which is in [src]
+void hashset_difference(HashSet *dest, const HashSet *src);
+
+// drop the bytes of removed keys from the pool of hash set [hs]
+// returns false on memory exhaustion, leaving the set unchanged
+bool hashset_compact(HashSet *hs);
+
+/* step through the keys of hash set [hs] in no particular order
+ * [pos] - cursor, set to 0 before the first call
+ * [key] - set to a view of the next key
+ * returns false once every key has been visited
+ */
+bool hashset_iterate(const HashSet *hs, size_t *pos, BufferView *key);
+
+// returns the number of bytes hash set [hs] has allocated
+size_t hashset_get_memory(const HashSet *hs);
+
+#endif //SEARCHFILEC_HASHSET_H
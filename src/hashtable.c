@@ -8,12 +8,14 @@
 #include <string.h>
 #include <stdio.h>
 #include "filereader.h"
+#include "mappedfile.h"
 //#include <math.h>
 #include "log.h"
 
 void hashvalue_init(HashValue *hv) {
     assert(NULL != hv);
     hv->recycler = NULL;
+    hv->hash = 0;
     buffer_init(&hv->data);
     buffer_init(&hv->key);
 }
@@ -25,7 +27,7 @@ HashKey * hashvalue_getkey(HashValue *hv) {
 
 Buffer * hashvalue_getdata(HashValue *hv) {
     assert(NULL != hv);
-    return &hv->key;
+    return &hv->data;
 }
 void hashvalue_free(HashValue *hv) {
     assert(NULL !=hv);
@@ -58,17 +60,16 @@ size_t maxdigits() {
     return count;
 }
 
-// compute the hash of any data stored in a hashkey [hk] will return 0 if
-// no data is stored within the hashkey
-// [hk] - the hash key to compute the hash for
-size_t hashkey_compute_hash(const HashKey *hk) {
-    assert(NULL != hk);
+// compute the hash of [len] bytes starting at [data], will return 0 if
+// there are no bytes to hash
+// [data] - bytes to hash
+// [len] - number of bytes to hash
+size_t hashkey_compute_hash_bytes(const unsigned char *data, size_t len) {
 
     size_t ret = 0;
 
-    if(buffer_is_empty(hk)) return ret;
+    if(NULL == data || 0 == len) return ret;
 
-    const size_t len = buffer_get_size(hk);
     size_t maxDigits = maxdigits() - 2;
     while(maxDigits % 3 != 0) {
         --maxDigits;
@@ -79,15 +80,26 @@ size_t hashkey_compute_hash(const HashKey *hk) {
     ///   ASCII E 22 -> 22000 + 53 = 022053
     for(size_t i=0; i<len; ++i) {
         if(i< maxDigits)
-            ret += hk->data[i] * tenpow(i);
+            ret += data[i] * tenpow(i);
         else {
-            size_t tmp = hk->data[i] * tenpow(i);
+            size_t tmp = data[i] * tenpow(i);
             ret ^= tmp;
         }
     }
     return ret;
 }
 
+// compute the hash of any data stored in a hashkey [hk] will return 0 if
+// no data is stored within the hashkey
+// [hk] - the hash key to compute the hash for
+size_t hashkey_compute_hash(const HashKey *hk) {
+    assert(NULL != hk);
+
+    if(buffer_is_empty(hk)) return 0;
+
+    return hashkey_compute_hash_bytes(hk->data, buffer_get_size(hk));
+}
+
 
 // compute the hash of any the key stored in a hashvalue [hv] will return 0 if
 // the hashvalue's hashkey has no data
@@ -123,6 +135,7 @@ bool hashvalue_cpy(HashValue *dest, const HashValue * src) {
         return false;
     }
 
+    dest->hash = src->hash;
     buffer_free(&tmpData);
     return true;
 }
@@ -154,49 +167,34 @@ bool hashtuple_add(HashTuple *ht, const HashValue *hv) {
     assert(NULL != ht);
     assert(NULL != hv);
 
-
-    HashValue * newHV = NULL;
-    const size_t size = sizeof(HashValue);
-
-    if(ht->recycler) {
-        newHV = recycler_get_exact(ht->recycler, size);
-    }
-    else {
-        newHV = malloc(size);
-    }
-
-    if(NULL == newHV) {
-        log_message("unable to allocate memory to hold a hashvalue");
+    // the value is copied straight into the buffer the chain will hold
+    Buffer tmp;
+    buffer_init(&tmp);
+    buffer_assign_recycler(&tmp, ht->recycler);
+    if(!buffer_reserve(&tmp, sizeof(HashValue))) {
+        log_message("Unable to reserve a hashvalue in buffer.");
         return false;
     }
 
+    HashValue *newHV = (HashValue *) tmp.data;
     hashvalue_init(newHV);
     hashvalue_assign_recylcer(newHV, ht->recycler);
 
     if(!hashvalue_cpy(newHV, hv)) {
         log_message("unable to copy hashvalue into hashvalue in buffer");
+        hashvalue_free(newHV);
+        buffer_free(&tmp);
         return false;
     }
+    tmp.len = sizeof(HashValue);
 
-    Buffer tmp;
-    buffer_init(&tmp);
-    buffer_assign_recycler(&tmp, ht->recycler);
-    if(!buffer_push_bytes(&tmp, (unsigned char *) newHV, sizeof(HashValue))) {
-        log_message("Unable to push hashvalue into buffer.");
-        return false;
-    }
-
-
-
-    buffer_assign_recycler(&tmp, ht->recycler);
-    if(!buffer_array_push(&ht->buffer, &tmp)) {
+    if(!buffer_array_push_move(&ht->buffer, &tmp)) {
         log_message("Failure adding hash value to internal hash tuple array");
+        hashvalue_free(newHV);
         buffer_free(&tmp);
         return false;
     }
 
-    buffer_free(&tmp);
-
     return true;
 }
 
@@ -213,23 +211,28 @@ HashValue * hashtuple_get_hash_value_at_idx(HashTuple * ht, size_t idx) {
 }
 
 
-bool hashtuple_find_key_index(HashTuple * ht, const HashKey *key,
-        size_t *indexOut) {
+// search a hash tuple [ht] for a key made up of [len] bytes at [data] and
+// populate its index to [indexOut]
+// [ht] - hash tuple to search
+// [data] - key bytes to search for
+// [len] - number of key bytes
+// [indexOut] - where the index is written when found
+// returns true if key is found
+static bool hashtuple_find_bytes_index(HashTuple *ht, const unsigned char *data,
+                                       size_t len, size_t *indexOut) {
     assert(NULL != ht);
-    assert(NULL != key);
 
-    if(NULL == key->data) return false;
+    if(NULL == data) return false;
 
     HashValue *hv = NULL;
-    Buffer buf;
 
-    const size_t len = buffer_array_get_buffer_count(&ht->buffer);
-    for(size_t i=0; i<len; ++i)  {
+    const size_t count = buffer_array_get_buffer_count(&ht->buffer);
+    for(size_t i=0; i<count; ++i)  {
         hv = hashtuple_get_hash_value_at_idx(ht, i);
         if(NULL == hv) continue;
         if(NULL == hv->key.data) continue;
-        if(hv->key.len != key->len) continue;
-        if(memcmp(hv->key.data, key->data, key->len) != 0) continue;
+        if(hv->key.len != len) continue;
+        if(memcmp(hv->key.data, data, len) != 0) continue;
 
         *indexOut = i;
         return true;
@@ -238,6 +241,14 @@ bool hashtuple_find_key_index(HashTuple * ht, const HashKey *key,
     return false;
 }
 
+bool hashtuple_find_key_index(HashTuple * ht, const HashKey *key,
+        size_t *indexOut) {
+    assert(NULL != ht);
+    assert(NULL != key);
+
+    return hashtuple_find_bytes_index(ht, key->data, key->len, indexOut);
+}
+
 size_t hashtuple_get_count(HashTuple *ht) {
     assert(NULL != ht);
     return buffer_array_get_buffer_count(&ht->buffer);
@@ -269,12 +280,18 @@ void hashtuple_remove(HashTuple *ht, const HashKey *key) {
     size_t idx = 0;
 
     if(hashtuple_find_key_index(ht, key, &idx)) {
+        hashvalue_free(hashtuple_get_hash_value_at_idx(ht, idx));
         buffer_array_remove_buffer(&ht->buffer, idx);
     }
 }
 
 void hashtuple_free(HashTuple *ht) {
     assert(NULL != ht);
+    const size_t count = buffer_array_get_buffer_count(&ht->buffer);
+    for(size_t i=0; i<count; ++i) {
+        HashValue *hv = hashtuple_get_hash_value_at_idx(ht, i);
+        if(NULL != hv) hashvalue_free(hv);
+    }
     buffer_array_free(&ht->buffer);
     buffer_array_assign_recycler(&ht->buffer, ht->recycler);
 }
@@ -293,6 +310,105 @@ void hashtuple_assign_recylcer(HashTuple *ht, Recycler *r) {
 }
 
 
+// returns the full hash of the key of hash value [hv], computing it for
+// values which were stored without one
+static size_t hashvalue_get_hash(HashValue *hv) {
+    if(0 == hv->hash) hv->hash = hashkey_compute_hash(&hv->key);
+    return hv->hash;
+}
+
+// make room for [extra] more values in the chain of hash tuple [t]
+static bool hashtuple_reserve(HashTuple *t, size_t extra) {
+    const size_t need = (t->buffer.count + extra) * sizeof(Buffer);
+    if(need <= t->buffer.array.cap) return true;
+    size_t cap = t->buffer.array.cap * 2;
+    if(cap < need) cap = need;
+    return buffer_reserve(&t->buffer.array, (unsigned int) cap);
+}
+
+// find the first value in hash tuple [t] whose key is the [len] bytes at
+// [data] with full hash [hash], comparing stored hashes before any key bytes
+static bool hashtuple_find_hashed(HashTuple *t, size_t hash,
+                                  const unsigned char *data, size_t len,
+                                  size_t *indexOut) {
+    const size_t count = t->buffer.count;
+    for(size_t i=0; i<count; ++i) {
+        HashValue *hv = hashtuple_get_hash_value_at_idx(t, i);
+        if(NULL == hv || NULL == hv->key.data) continue;
+        if(0 != hv->hash && hv->hash != hash) continue;
+        if(hv->key.len != len) continue;
+        if(memcmp(hv->key.data, data, len) != 0) continue;
+        *indexOut = i;
+        return true;
+    }
+    return false;
+}
+
+// free hash value buffer [vb] and everything the value holds
+static void hashtuple_release_value(Buffer *vb) {
+    HashValue *hv = (HashValue *) vb->data;
+    if(NULL != hv) hashvalue_free(hv);
+    buffer_free(vb);
+}
+
+// free the chains and buckets of hashtable [ht] but not the values in them,
+// which have been moved elsewhere
+static void hashtable_release_buckets(HashTable *ht) {
+    const size_t count = buffer_array_get_buffer_count(&ht->table);
+    for(size_t i=0; i<count; ++i) {
+        HashTuple *t = (HashTuple *) buffer_array_get_buffer(&ht->table, i)->data;
+        if(NULL != t) buffer_free(&t->buffer.array);
+    }
+    buffer_array_free(&ht->table);
+    buffer_array_assign_recycler(&ht->table, ht->recycler);
+    ht->valueCount = 0;
+}
+
+// move every value of [src] into the buckets of the freshly sized [dest],
+// placing each by its stored hash.  every chain is sized before anything
+// moves so a failure leaves src untouched
+static bool hashtable_move_values(HashTable *dest, HashTable *src) {
+    const size_t buckets = buffer_array_get_buffer_count(&src->table);
+    size_t *counts = calloc(dest->size, sizeof(size_t));
+    if(NULL == counts) {
+        log_message("Unable to allocate %zu bucket counts", dest->size);
+        return false;
+    }
+
+    for(size_t i=0; i<buckets; ++i) {
+        HashTuple *t = (HashTuple *) buffer_array_get_buffer(&src->table, i)->data;
+        if(NULL == t) continue;
+        for(size_t j=0; j<t->buffer.count; ++j) {
+            HashValue *hv = hashtuple_get_hash_value_at_idx(t, j);
+            if(NULL != hv) counts[hashvalue_get_hash(hv) % dest->size]++;
+        }
+    }
+
+    for(size_t i=0; i<dest->size; ++i) {
+        if(0 == counts[i]) continue;
+        HashTuple *t = hashtable_get_hastuple_at_idx(dest, i);
+        if(NULL == t || !hashtuple_reserve(t, counts[i])) {
+            free(counts);
+            return false;
+        }
+    }
+    free(counts);
+
+    for(size_t i=0; i<buckets; ++i) {
+        HashTuple *t = (HashTuple *) buffer_array_get_buffer(&src->table, i)->data;
+        if(NULL == t) continue;
+        for(size_t j=0; j<t->buffer.count; ++j) {
+            Buffer *vb = buffer_array_get_buffer(&t->buffer, j);
+            HashValue *hv = (HashValue *) vb->data;
+            if(NULL == hv) continue;
+            HashTuple *d = (HashTuple *)
+                    buffer_array_get_buffer(&dest->table, hv->hash % dest->size)->data;
+            buffer_array_push_move(&d->buffer, vb);
+        }
+    }
+    return true;
+}
+
 void hashtable_init(HashTable *ht) {
     assert(NULL != ht);
 
@@ -300,6 +416,7 @@ void hashtable_init(HashTable *ht) {
     buffer_array_init(&ht->table);
     ht->size = HASH_TABLE_DEFAULT_SIZE;
     ht->valueCount = 0;
+    ht->filter = NULL;
 }
 
 HashTuple *hashtable_get_hastuple_at_idx(HashTable *ht, size_t idx) {
@@ -360,29 +477,90 @@ bool hashtable_add(HashTable *ht, const HashKey *key, const Buffer *value) {
     hashvalue_init(&hv);
     buffer_clone(&hv.data, value);
     buffer_clone(&hv.key, key);
+    hv.hash = hashkey_compute_hash(key);
 
-    bool newKey = false;
-    HashTuple * hashTuple = hashtable_get_hashtuple(ht, key);
-    if(hashtuple_get(hashTuple, key) == NULL) newKey = true;
+    HashTuple * hashTuple = hashtable_get_hastuple_at_idx(ht, hv.hash % ht->size);
 
     if(NULL == hashTuple) {
         log_message("Error, hashtable_add returned null tuple?");
         return false;
     }
 
+    const bool newKey = (NULL == hashtuple_get(hashTuple, key));
+
     if(!hashtuple_add(hashTuple, &hv)) {
         log_message("Error, unable to add hashvalue to hashuple");
         return false;
     }
-    if(newKey) ht->valueCount++;
+    if(newKey) {
+        ht->valueCount++;
+        if(NULL != ht->filter)
+            membership_filter_add_bytes(ht->filter, key->data, key->len);
+    }
     return true;
 
 }
 
+bool hashtable_add_move(HashTable *ht, HashKey *key, Buffer *value) {
+    assert(NULL != ht);
+    assert(NULL != value);
+    assert(NULL != key);
+
+    if(ht->table.count < ht->size) {
+        if(!hashtable_set_size(ht, ht->size)) {
+            log_message("unable to add an item as hash table cannot be expanded");
+            return false;
+        }
+    }
+
+    const size_t hash = hashkey_compute_hash(key);
+    HashTuple *hashTuple = hashtable_get_hastuple_at_idx(ht, hash % ht->size);
+
+    if(NULL == hashTuple) {
+        log_message("Error, hashtable_add_move returned null tuple?");
+        return false;
+    }
+
+    size_t idx = 0;
+    const bool newKey = !hashtuple_find_hashed(hashTuple, hash, key->data,
+                                               key->len, &idx);
+
+    // every allocation is made before anything is taken from the caller
+    Buffer vb;
+    buffer_init(&vb);
+    buffer_assign_recycler(&vb, hashTuple->recycler);
+    if(!buffer_reserve(&vb, sizeof(HashValue)) ||
+       !hashtuple_reserve(hashTuple, 1)) {
+        log_message("Error, unable to add hashvalue to hashuple");
+        buffer_free(&vb);
+        return false;
+    }
+
+    HashValue *hv = (HashValue *) vb.data;
+    hashvalue_init(hv);
+    hv->recycler = hashTuple->recycler;
+    buffer_move(&hv->key, key);
+    buffer_move(&hv->data, value);
+    hv->hash = hash;
+    vb.len = sizeof(HashValue);
+    buffer_array_push_move(&hashTuple->buffer, &vb);
+
+    if(newKey) {
+        ht->valueCount++;
+        if(NULL != ht->filter)
+            membership_filter_add_bytes(ht->filter, hv->key.data, hv->key.len);
+    }
+    return true;
+}
+
 Buffer *hashtable_get(HashTable *ht, const HashKey *hk) {
     assert(NULL != ht);
     assert(NULL != hk);
 
+    if(NULL != ht->filter &&
+       !membership_filter_may_contain_bytes(ht->filter, hk->data, hk->len))
+        return NULL;
+
     HashTuple * tuple = hashtable_get_hashtuple(ht, hk);
 
     if(NULL == tuple) {
@@ -392,6 +570,199 @@ Buffer *hashtable_get(HashTable *ht, const HashKey *hk) {
     return hashtuple_get(tuple, hk);
 }
 
+#if defined(__GNUC__)
+#define HASH_TABLE_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define HASH_TABLE_PREFETCH(p)
+#endif
+
+// resolve [count] (at most HASH_TABLE_BATCH_SIZE) lookups of the keys viewed
+// by [keys] against hashtable [ht], writing the found data (or NULL) to
+// [results].  every key is hashed and every level of its bucket prefetched
+// before any chain is walked so the cache misses of the independent lookups
+// overlap instead of being paid one after another
+// returns the number of keys found
+static size_t hashtable_get_batch(HashTable *ht, const BufferView *keys,
+                                  size_t count, Buffer **results) {
+
+    Buffer *buckets[HASH_TABLE_BATCH_SIZE];
+    HashTuple *tuples[HASH_TABLE_BATCH_SIZE];
+    Buffer *slots = (Buffer *) ht->table.array.data;
+    size_t found = 0;
+
+    assert(count <= HASH_TABLE_BATCH_SIZE);
+
+    for(size_t i=0; i<count; ++i) {
+        // keys the filter rules out never touch the table
+        if(NULL != ht->filter &&
+           !membership_filter_may_contain_bytes(ht->filter, keys[i].data,
+                                                keys[i].len)) {
+            buckets[i] = NULL;
+            continue;
+        }
+        const size_t idx = hashkey_compute_hash_bytes(keys[i].data,
+                                                      keys[i].len) % ht->size;
+        buckets[i] = &slots[idx];
+        HASH_TABLE_PREFETCH(buckets[i]);
+    }
+
+    for(size_t i=0; i<count; ++i) {
+        tuples[i] = NULL == buckets[i] ? NULL : (HashTuple *) buckets[i]->data;
+        if(NULL != tuples[i]) HASH_TABLE_PREFETCH(tuples[i]);
+    }
+
+    for(size_t i=0; i<count; ++i) {
+        if(NULL == tuples[i]) continue;
+        HASH_TABLE_PREFETCH(tuples[i]->buffer.array.data);
+    }
+
+    // the first value of a chain is where a well sized table usually hits
+    for(size_t i=0; i<count; ++i) {
+        if(NULL == tuples[i] || 0 == tuples[i]->buffer.count) continue;
+        HASH_TABLE_PREFETCH(((Buffer *) tuples[i]->buffer.array.data)->data);
+    }
+
+    for(size_t i=0; i<count; ++i) {
+        HashValue *hv = NULL;
+        if(NULL != tuples[i] && 0 != tuples[i]->buffer.count) {
+            hv = hashtuple_get_hash_value_at_idx(tuples[i], 0);
+        }
+        if(NULL != hv) HASH_TABLE_PREFETCH(hv->key.data);
+    }
+
+    for(size_t i=0; i<count; ++i) {
+        size_t idx = 0;
+        results[i] = NULL;
+        if(NULL == tuples[i]) continue;
+        if(!hashtuple_find_bytes_index(tuples[i], keys[i].data, keys[i].len,
+                                       &idx)) continue;
+        HashValue *hv = hashtuple_get_hash_value_at_idx(tuples[i], idx);
+        if(NULL == hv) continue;
+        results[i] = hashvalue_getdata(hv);
+        ++found;
+    }
+
+    return found;
+}
+
+size_t hashtable_get_many_views(HashTable *ht, const BufferView *keys,
+                                size_t count, Buffer **results) {
+    assert(NULL != ht);
+    assert(NULL != keys || 0 == count);
+    assert(NULL != results || 0 == count);
+
+    // nothing has been added yet, so there is nothing to find
+    if(0 == ht->size || ht->table.count < ht->size) {
+        for(size_t i=0; i<count; ++i) results[i] = NULL;
+        return 0;
+    }
+
+    size_t found = 0;
+
+    for(size_t off=0; off<count; off += HASH_TABLE_BATCH_SIZE) {
+        size_t n = count - off;
+        if(n > HASH_TABLE_BATCH_SIZE) n = HASH_TABLE_BATCH_SIZE;
+        found += hashtable_get_batch(ht, &keys[off], n, &results[off]);
+    }
+
+    return found;
+}
+
+size_t hashtable_get_many(HashTable *ht, BufferArray *keys, Buffer **results) {
+    assert(NULL != ht);
+    assert(NULL != keys);
+
+    BufferView views[HASH_TABLE_BATCH_SIZE];
+    const size_t count = buffer_array_get_buffer_count(keys);
+    size_t found = 0;
+
+    for(size_t off=0; off<count; off += HASH_TABLE_BATCH_SIZE) {
+        size_t n = count - off;
+        if(n > HASH_TABLE_BATCH_SIZE) n = HASH_TABLE_BATCH_SIZE;
+
+        for(size_t i=0; i<n; ++i) {
+            buffer_view_from_buffer(&views[i],
+                                    buffer_array_get_buffer(keys, off + i));
+        }
+        found += hashtable_get_many_views(ht, views, n, &results[off]);
+    }
+
+    return found;
+}
+
+bool hashtable_add_many(HashTable *ht, BufferArray *keys, BufferArray *values) {
+    assert(NULL != ht);
+    assert(NULL != keys);
+    assert(NULL != values);
+
+    const size_t count = buffer_array_get_buffer_count(keys);
+
+    if(count != buffer_array_get_buffer_count(values)) {
+        log_message("key count %zu does not match value count %zu", count,
+                    buffer_array_get_buffer_count(values));
+        return false;
+    }
+
+    if(ht->table.count < ht->size) {
+        if(!hashtable_set_size(ht, ht->size)) {
+            log_message("unable to add items as hash table cannot be expanded");
+            return false;
+        }
+    }
+
+    HashTuple *tuples[HASH_TABLE_BATCH_SIZE];
+    Buffer *slots = (Buffer *) ht->table.array.data;
+
+    for(size_t off=0; off<count; off += HASH_TABLE_BATCH_SIZE) {
+        size_t n = count - off;
+        if(n > HASH_TABLE_BATCH_SIZE) n = HASH_TABLE_BATCH_SIZE;
+
+        size_t idx[HASH_TABLE_BATCH_SIZE];
+
+        size_t hash[HASH_TABLE_BATCH_SIZE];
+
+        for(size_t i=0; i<n; ++i) {
+            hash[i] = hashkey_compute_hash(buffer_array_get_buffer(keys, off + i));
+            idx[i] = hash[i] % ht->size;
+            HASH_TABLE_PREFETCH(&slots[idx[i]]);
+        }
+
+        for(size_t i=0; i<n; ++i) {
+            tuples[i] = hashtable_get_hastuple_at_idx(ht, idx[i]);
+            if(NULL == tuples[i]) {
+                log_message("Error: unable to retrieve hashtuple");
+                return false;
+            }
+            HASH_TABLE_PREFETCH(tuples[i]->buffer.array.data);
+        }
+
+        for(size_t i=0; i<n; ++i) {
+            const Buffer *key = buffer_array_get_buffer(keys, off + i);
+            const Buffer *value = buffer_array_get_buffer(values, off + i);
+
+            HashValue hv;
+            hashvalue_init(&hv);
+            buffer_clone(&hv.data, value);
+            buffer_clone(&hv.key, key);
+            hv.hash = hash[i];
+
+            const bool newKey = (NULL == hashtuple_get(tuples[i], key));
+
+            if(!hashtuple_add(tuples[i], &hv)) {
+                log_message("Error, unable to add hashvalue to hashuple");
+                return false;
+            }
+            if(newKey) {
+                ht->valueCount++;
+                if(NULL != ht->filter)
+                    membership_filter_add_bytes(ht->filter, key->data, key->len);
+            }
+        }
+    }
+
+    return true;
+}
+
 void hashtable_remove(HashTable *ht, const HashKey *hk) {
 
     assert(NULL != ht);
@@ -403,7 +774,540 @@ void hashtable_remove(HashTable *ht, const HashKey *hk) {
         return;
     }
 
+    if(NULL == hashtuple_get(tuple, hk)) return;
+
     hashtuple_remove(tuple, hk);
+
+    // the key is only gone once no earlier copy was uncovered by the removal
+    if(NULL != hashtuple_get(tuple, hk)) return;
+
+    ht->valueCount--;
+    if(NULL != ht->filter)
+        membership_filter_remove_bytes(ht->filter, hk->data, hk->len);
+}
+
+bool hashtable_has(const HashTable *ht, const HashKey *key) {
+    assert(NULL != ht);
+    assert(NULL != key);
+
+    if(NULL != ht->filter &&
+       !membership_filter_may_contain_bytes(ht->filter, key->data, key->len))
+        return false;
+
+    // nothing has been added yet
+    if(ht->table.count < ht->size) return false;
+
+    // the lookup only reads the table once its buckets exist
+    return NULL != hashtable_get((HashTable *) ht, key);
+}
+
+// merge the values held in buckets [begin, end) of [src] into [dest].  with
+// tables of equal size a src bucket maps onto the same dest bucket, which is
+// what lets disjoint bucket ranges be merged at the same time
+// [added] - incremented for every key new to dest
+static bool hashtable_merge_buckets(HashTable *dest, HashTable *src,
+                                    size_t begin, size_t end,
+                                    HashMergeFn combine, void *ctx,
+                                    size_t *added) {
+    const bool sameSize = dest->size == src->size;
+
+    for(size_t b=begin; b<end; ++b) {
+        HashTuple *s = (HashTuple *) buffer_array_get_buffer(&src->table, b)->data;
+        if(NULL == s || 0 == s->buffer.count) continue;
+
+        const size_t count = s->buffer.count;
+        size_t j = 0;
+        bool ok = true;
+
+        // a later copy of a key is shadowed by the first, drop those before
+        // anything moves so the first copy is always there to be found
+        for(j=1; j<count; ++j) {
+            Buffer *vb = buffer_array_get_buffer(&s->buffer, j);
+            HashValue *hv = (HashValue *) vb->data;
+            size_t first = j;
+            if(NULL != hv &&
+               hashtuple_find_hashed(s, hashvalue_get_hash(hv), hv->key.data,
+                                     hv->key.len, &first) &&
+               first != j)
+                hashtuple_release_value(vb);
+        }
+
+        for(j=0; j<count; ++j) {
+            Buffer *vb = buffer_array_get_buffer(&s->buffer, j);
+            HashValue *hv = (HashValue *) vb->data;
+            if(NULL == hv) continue;
+
+            const size_t hash = hashvalue_get_hash(hv);
+            HashTuple *d = hashtable_get_hastuple_at_idx(dest,
+                                                         sameSize ? b : hash % dest->size);
+            if(NULL == d) {
+                ok = false;
+                break;
+            }
+
+            size_t idx = 0;
+            if(hashtuple_find_hashed(d, hash, hv->key.data, hv->key.len, &idx)) {
+                HashValue *dv = hashtuple_get_hash_value_at_idx(d, idx);
+                if(NULL != combine && !combine(&dv->data, &hv->data, ctx)) {
+                    ok = false;
+                    break;
+                }
+                hashtuple_release_value(vb);
+                continue;
+            }
+
+            if(!hashtuple_reserve(d, 1)) {
+                ok = false;
+                break;
+            }
+            buffer_array_push_move(&d->buffer, vb);
+            (*added)++;
+            if(NULL != dest->filter)
+                membership_filter_add_bytes(dest->filter, hv->key.data,
+                                            hv->key.len);
+        }
+
+        // whatever was not merged stays behind at the front of the chain
+        const size_t left = count - j;
+        if(left > 0) {
+            memmove(s->buffer.array.data,
+                    s->buffer.array.data + j * sizeof(Buffer),
+                    left * sizeof(Buffer));
+        }
+        s->buffer.count = left;
+        s->buffer.array.len = left * sizeof(Buffer);
+
+        if(!ok) return false;
+    }
+    return true;
+}
+
+typedef struct stHashMergeJob {
+    HashTable *dest;
+    HashTable *src;
+    HashMergeFn combine;
+    void *ctx;
+    size_t tasks;
+    size_t *added;
+    bool *ok;
+} HashMergeJob;
+
+static void hashtable_merge_task(void *arg, size_t task) {
+    HashMergeJob *job = (HashMergeJob *) arg;
+    const size_t buckets = job->src->size;
+    const size_t begin = buckets * task / job->tasks;
+    const size_t end = buckets * (task + 1) / job->tasks;
+    job->ok[task] = hashtable_merge_buckets(job->dest, job->src, begin, end,
+                                            job->combine, job->ctx,
+                                            &job->added[task]);
+}
+
+// count the live keys of [ht] again after a merge stopped part way
+static void hashtable_recount(HashTable *ht) {
+    HashTableIterator it;
+    size_t count = 0;
+    hashtable_iterator_init(&it, ht);
+    while(NULL != hashtable_iterator_next(&it)) ++count;
+    ht->valueCount = count;
+}
+
+bool hashtable_merge(HashTable *dest, HashTable *src, HashMergeFn combine,
+                     void *ctx, ThreadPool *tp) {
+    assert(NULL != dest);
+    assert(NULL != src);
+
+    if(dest == src) return true;
+    if(src->table.count < src->size || 0 == src->valueCount) return true;
+
+    if(dest->table.count < dest->size) {
+        if(!hashtable_set_size(dest, dest->size)) return false;
+    }
+
+    const bool parallel = NULL != tp && dest->size == src->size &&
+                          NULL == dest->recycler && NULL == src->recycler &&
+                          NULL == dest->filter;
+
+    size_t tasks = parallel ? threadpool_get_thread_count(tp) * 4 : 1;
+    if(tasks > src->size) tasks = src->size;
+
+    size_t *added = calloc(tasks, sizeof(size_t));
+    bool *ok = calloc(tasks, sizeof(bool));
+    if(NULL == added || NULL == ok) {
+        log_message("Unable to allocate %zu merge tasks", tasks);
+        free(added);
+        free(ok);
+        return false;
+    }
+
+    HashMergeJob job = { dest, src, combine, ctx, tasks, added, ok };
+    bool success = threadpool_run(parallel ? tp : NULL, tasks,
+                                  hashtable_merge_task, &job);
+
+    for(size_t i=0; i<tasks; ++i) {
+        dest->valueCount += added[i];
+        success = success && ok[i];
+    }
+    free(added);
+    free(ok);
+
+    if(success) src->valueCount = 0;
+    else hashtable_recount(src);
+    return success;
+}
+
+typedef struct stHashMergeRound {
+    HashTable **tables;
+    size_t count;
+    size_t stride;
+    HashMergeFn combine;
+    void *ctx;
+    bool *ok;
+} HashMergeRound;
+
+static void hashtable_merge_pair_task(void *arg, size_t pair) {
+    HashMergeRound *round = (HashMergeRound *) arg;
+    const size_t i = pair * round->stride * 2;
+    round->ok[pair] = hashtable_merge(round->tables[i],
+                                      round->tables[i + round->stride],
+                                      round->combine, round->ctx, NULL);
+}
+
+bool hashtable_merge_all(HashTable **tables, size_t count, HashMergeFn combine,
+                         void *ctx, ThreadPool *tp) {
+    assert(NULL != tables || 0 == count);
+
+    // pairs of tables may only be merged side by side when none of them
+    // shares a recycler or filter with another
+    bool independent = NULL != tp;
+    for(size_t i=0; i<count && independent; ++i)
+        independent = NULL == tables[i]->recycler && NULL == tables[i]->filter;
+
+    bool *ok = calloc(count ? count : 1, sizeof(bool));
+    if(NULL == ok) {
+        log_message("Unable to allocate %zu merge results", count);
+        return false;
+    }
+
+    bool success = true;
+    for(size_t stride=1; stride<count && success; stride *= 2) {
+        // the pair starting at i * stride * 2 exists when its right table does
+        const size_t pairs = (count - stride + 2 * stride - 1) / (2 * stride);
+
+        if(independent && pairs >= threadpool_get_thread_count(tp)) {
+            HashMergeRound round = { tables, count, stride, combine, ctx, ok };
+            success = threadpool_run(tp, pairs, hashtable_merge_pair_task, &round);
+            for(size_t p=0; p<pairs; ++p) success = success && ok[p];
+            continue;
+        }
+
+        // too few pairs to keep every thread busy, split each merge instead
+        for(size_t p=0; p<pairs && success; ++p) {
+            const size_t i = p * stride * 2;
+            success = hashtable_merge(tables[i], tables[i + stride], combine,
+                                      ctx, tp);
+        }
+    }
+
+    free(ok);
+    return success;
+}
+
+typedef struct stHashBuildJob {
+    HashTable *ht;
+    const BufferView *keys;
+    const BufferView *values;
+    const BufferView *value;
+    size_t count;
+    size_t chunks;
+    size_t parts;
+    size_t *hashes;
+    size_t *offsets;
+    size_t *order;
+    size_t *added;
+    bool *ok;
+} HashBuildJob;
+
+// the partition owning bucket [bucket], partitions are contiguous bucket
+// ranges so no two of them ever touch the same chain
+static size_t hashtable_build_part(const HashBuildJob *job, size_t bucket) {
+    return bucket * job->parts / job->ht->size;
+}
+
+// hash the keys of chunk [chunk] and count how many land in each partition
+static void hashtable_build_hash_task(void *arg, size_t chunk) {
+    HashBuildJob *job = (HashBuildJob *) arg;
+    const size_t begin = job->count * chunk / job->chunks;
+    const size_t end = job->count * (chunk + 1) / job->chunks;
+    size_t *counts = job->offsets + chunk * job->parts;
+
+    for(size_t i=begin; i<end; ++i) {
+        const size_t hash = hashkey_compute_hash_bytes(job->keys[i].data,
+                                                       job->keys[i].len);
+        job->hashes[i] = hash;
+        counts[hashtable_build_part(job, hash % job->ht->size)]++;
+    }
+}
+
+// write the indexes of chunk [chunk] to the slots of their partitions,
+// chunks are laid out in input order so every partition keeps it
+static void hashtable_build_scatter_task(void *arg, size_t chunk) {
+    HashBuildJob *job = (HashBuildJob *) arg;
+    const size_t begin = job->count * chunk / job->chunks;
+    const size_t end = job->count * (chunk + 1) / job->chunks;
+    size_t *next = job->offsets + chunk * job->parts;
+
+    for(size_t i=begin; i<end; ++i) {
+        const size_t p = hashtable_build_part(job, job->hashes[i] % job->ht->size);
+        job->order[next[p]++] = i;
+    }
+}
+
+// append a copy of [key] and [value] with full hash [hash] to the chain of
+// hash tuple [t], room must have been reserved
+static bool hashtuple_push_view(HashTuple *t, size_t hash, const BufferView *key,
+                                const BufferView *value) {
+    Buffer vb;
+    buffer_init(&vb);
+    buffer_assign_recycler(&vb, t->recycler);
+    if(!buffer_reserve(&vb, sizeof(HashValue))) return false;
+
+    HashValue *hv = (HashValue *) vb.data;
+    hashvalue_init(hv);
+    hashvalue_assign_recylcer(hv, t->recycler);
+    if(!buffer_cpy_view(&hv->key, key) || !buffer_cpy_view(&hv->data, value)) {
+        hashvalue_free(hv);
+        buffer_free(&vb);
+        return false;
+    }
+    hv->hash = hash;
+    vb.len = sizeof(HashValue);
+
+    buffer_array_push_move(&t->buffer, &vb);
+    return true;
+}
+
+// build partition [part] from the keys routed to it, sizing each of its
+// chains once before any value is added
+static void hashtable_build_part_task(void *arg, size_t part) {
+    HashBuildJob *job = (HashBuildJob *) arg;
+    HashTable *ht = job->ht;
+    const size_t first = part * job->chunks;
+    const size_t begin = 0 == part ? 0 : job->offsets[first - 1];
+    const size_t end = job->offsets[first + job->chunks - 1];
+    const size_t lo = (ht->size * part + job->parts - 1) / job->parts;
+    const size_t hi = (ht->size * (part + 1) + job->parts - 1) / job->parts;
+
+    job->ok[part] = true;
+    if(begin == end) return;
+
+    size_t *counts = calloc(hi - lo, sizeof(size_t));
+    if(NULL == counts) {
+        log_message("Unable to allocate %zu bucket counts", hi - lo);
+        job->ok[part] = false;
+        return;
+    }
+    for(size_t i=begin; i<end; ++i)
+        counts[job->hashes[job->order[i]] % ht->size - lo]++;
+
+    for(size_t b=lo; b<hi; ++b) {
+        if(0 == counts[b - lo]) continue;
+        HashTuple *t = hashtable_get_hastuple_at_idx(ht, b);
+        if(NULL == t || !hashtuple_reserve(t, counts[b - lo])) {
+            job->ok[part] = false;
+            free(counts);
+            return;
+        }
+    }
+    free(counts);
+
+    Buffer *slots = (Buffer *) ht->table.array.data;
+    for(size_t i=begin; i<end; ++i) {
+        const size_t k = job->order[i];
+        const size_t hash = job->hashes[k];
+        const BufferView *key = &job->keys[k];
+        const BufferView *value = NULL != job->values ? &job->values[k] :
+                                  job->value;
+        HashTuple *t = (HashTuple *) slots[hash % ht->size].data;
+
+        size_t idx = 0;
+        const bool newKey = !hashtuple_find_hashed(t, hash, key->data,
+                                                   key->len, &idx);
+        if(!hashtuple_push_view(t, hash, key, value)) {
+            log_message("Unable to add key %zu while building hash table", k);
+            job->ok[part] = false;
+            return;
+        }
+        if(!newKey) continue;
+        job->added[part]++;
+        if(NULL != ht->filter)
+            membership_filter_add_bytes(ht->filter, key->data, key->len);
+    }
+}
+
+// add the [count] keys viewed by [keys] to [ht], each with the value at the
+// same index of [values] or, when values is NULL, a copy of [value]
+static bool hashtable_build(HashTable *ht, const BufferView *keys,
+                            const BufferView *values, const BufferView *value,
+                            size_t count, ThreadPool *tp) {
+    if(0 == count) return true;
+
+    if(ht->table.count < ht->size) {
+        if(!hashtable_set_size(ht, ht->size)) {
+            log_message("unable to build as hash table cannot be expanded");
+            return false;
+        }
+    }
+
+    const bool parallel = NULL != tp && NULL == ht->recycler &&
+                          NULL == ht->filter;
+    const size_t threads = parallel ? threadpool_get_thread_count(tp) : 1;
+
+    size_t chunks = threads * 4;
+    if(chunks > count) chunks = count;
+    size_t parts = threads * 4;
+    if(parts > ht->size) parts = ht->size;
+
+    HashBuildJob job = { ht, keys, values, value, count, chunks, parts,
+                         malloc(count * sizeof(size_t)),
+                         calloc(chunks * parts, sizeof(size_t)),
+                         malloc(count * sizeof(size_t)),
+                         calloc(parts, sizeof(size_t)),
+                         calloc(parts, sizeof(bool)) };
+
+    bool success = NULL != job.hashes && NULL != job.offsets &&
+                   NULL != job.order && NULL != job.added && NULL != job.ok;
+    if(!success) log_message("Unable to allocate a build of %zu keys", count);
+
+    success = success && threadpool_run(parallel ? tp : NULL, chunks,
+                                        hashtable_build_hash_task, &job);
+
+    if(success) {
+        // lay the slots out partition by partition, each partition holding
+        // its chunks in order.  the counts become the slot each chunk
+        // writes its next index to, and the last of each partition its end
+        size_t *sums = malloc(chunks * parts * sizeof(size_t));
+        success = NULL != sums;
+        if(success) {
+            size_t next = 0;
+            for(size_t p=0; p<parts; ++p) {
+                for(size_t c=0; c<chunks; ++c) {
+                    sums[p * chunks + c] = next + job.offsets[c * parts + p];
+                    job.offsets[c * parts + p] = next;
+                    next = sums[p * chunks + c];
+                }
+            }
+            success = threadpool_run(parallel ? tp : NULL, chunks,
+                                     hashtable_build_scatter_task, &job);
+            memcpy(job.offsets, sums, chunks * parts * sizeof(size_t));
+            free(sums);
+        }
+    }
+
+    success = success && threadpool_run(parallel ? tp : NULL, parts,
+                                        hashtable_build_part_task, &job);
+
+    if(NULL != job.added && NULL != job.ok) {
+        for(size_t p=0; p<parts; ++p) {
+            ht->valueCount += job.added[p];
+            success = success && job.ok[p];
+        }
+    }
+
+    free(job.hashes);
+    free(job.offsets);
+    free(job.order);
+    free(job.added);
+    free(job.ok);
+    return success;
+}
+
+bool hashtable_build_parallel(HashTable *ht, BufferArray *keys,
+                              BufferArray *values, ThreadPool *tp) {
+    assert(NULL != ht);
+    assert(NULL != keys);
+    assert(NULL != values);
+
+    const size_t count = buffer_array_get_buffer_count(keys);
+
+    if(count != buffer_array_get_buffer_count(values)) {
+        log_message("key count %zu does not match value count %zu", count,
+                    buffer_array_get_buffer_count(values));
+        return false;
+    }
+    if(0 == count) return true;
+
+    BufferView *views = malloc(count * 2 * sizeof(BufferView));
+    if(NULL == views) {
+        log_message("Unable to allocate views of %zu pairs", count);
+        return false;
+    }
+    for(size_t i=0; i<count; ++i) {
+        buffer_view_from_buffer(&views[i], buffer_array_get_buffer(keys, i));
+        buffer_view_from_buffer(&views[count + i],
+                                buffer_array_get_buffer(values, i));
+    }
+
+    const bool ret = hashtable_build(ht, views, views + count, NULL, count, tp);
+    free(views);
+    return ret;
+}
+
+bool hashtable_build_parallel_file(HashTable *ht, const char *fileName,
+                                   unsigned char delim, const Buffer *value,
+                                   ThreadPool *tp) {
+    assert(NULL != ht);
+    assert(NULL != fileName);
+    assert(NULL != value);
+
+    MappedFile mf;
+    if(!mapped_file_open(&mf, fileName)) return false;
+
+    size_t count = 0;
+    const unsigned char *p = mf.data;
+    const unsigned char *end = mf.data + mf.len;
+    while(p < end) {
+        const unsigned char *next = memchr(p, delim, (size_t) (end - p));
+        if(NULL == next) next = end;
+        if(next > p) ++count;
+        p = next + 1;
+    }
+
+    BufferView *keys = malloc((count ? count : 1) * sizeof(BufferView));
+    if(NULL == keys) {
+        log_message("Unable to allocate views of %zu keys", count);
+        mapped_file_close(&mf);
+        return false;
+    }
+
+    size_t i = 0;
+    p = mf.data;
+    while(p < end) {
+        const unsigned char *next = memchr(p, delim, (size_t) (end - p));
+        if(NULL == next) next = end;
+        if(next > p) buffer_view_set(&keys[i++], p, (size_t) (next - p));
+        p = next + 1;
+    }
+
+    BufferView shared;
+    buffer_view_from_buffer(&shared, value);
+
+    const bool ret = hashtable_build(ht, keys, NULL, &shared, count, tp);
+    free(keys);
+    mapped_file_close(&mf);
+    return ret;
+}
+
+void hashtable_attach_filter(HashTable *ht, MembershipFilter *mf) {
+    assert(NULL != ht);
+
+    ht->filter = mf;
+    if(NULL == mf || ht->table.count < ht->size) return;
+
+    HashTableIterator it;
+    HashValue *hv;
+    hashtable_iterator_init(&it, ht);
+    while(NULL != (hv = hashtable_iterator_next(&it)))
+        membership_filter_add_bytes(mf, hv->key.data, hv->key.len);
 }
 
 void hashtable_assign_recycler(HashTable *ht, Recycler *r) {
@@ -427,9 +1331,15 @@ void hashtable_free(HashTable *ht) {
     const size_t count = buffer_array_get_buffer_count(&ht->table);
 
     for(size_t i=0; i<count; ++i) {
-        HashTuple * tuple = hashtable_get_hastuple_at_idx(ht, i);
+        Buffer *bucket = buffer_array_get_buffer(&ht->table, i);
+        HashTuple * tuple = (HashTuple *) bucket->data;
         if(NULL != tuple) hashtuple_free(tuple);
     }
+
+    // frees every bucket's tuple header along with the bucket array
+    buffer_array_free(&ht->table);
+    buffer_array_assign_recycler(&ht->table, ht->recycler);
+    ht->valueCount = 0;
 }
 size_t hashtable_get_size(const HashTable *ht) {
     assert(NULL != ht);
@@ -449,6 +1359,7 @@ void hashtable_clone(HashTable *dest, HashTable *src) {
     dest->size = src->size;
     dest->recycler = src->recycler;
     dest->valueCount = src->valueCount;
+    dest->filter = src->filter;
     buffer_array_clone(&dest->table, &src->table);
 }
 
@@ -470,8 +1381,6 @@ bool hashtable_set_size(HashTable *ht, size_t size) {
     htNew.size = size;
     htNew.recycler = ht->recycler;
 
-    const size_t oldHTSize = ht->size;
-
     Buffer bufferTmp;
     buffer_init(&bufferTmp);
     buffer_assign_recycler(&bufferTmp, ht->recycler);
@@ -486,7 +1395,15 @@ bool hashtable_set_size(HashTable *ht, size_t size) {
         return false;
     }
 
-    for(size_t i=0; i < ht->size; ++i) {
+    // reserve every bucket header up front, pushing them one at a time would
+    // otherwise reallocate the bucket array over and over
+    if(!buffer_reserve(&htNew.table.array, size * sizeof(Buffer))) {
+        log_message("Unable to reserve %zu hash table buckets", size);
+        buffer_free(&bufferTmp);
+        return false;
+    }
+
+    for(size_t i=0; i < size; ++i) {
         if(!buffer_array_push(&htNew.table, &bufferTmp)) {
             log_message("Unable to push buffer onto hash table");
             buffer_free(&bufferTmp);
@@ -497,37 +1414,162 @@ bool hashtable_set_size(HashTable *ht, size_t size) {
 
     buffer_free(&bufferTmp);
 
-    for (size_t i = 0; i < oldHTSize ; ++i) {
+    if(!hashtable_move_values(&htNew, ht)) {
+        log_message("Unable to move hashvalues to new hash table");
+        hashtable_free(&htNew);
+        return false;
+    }
+
+    // the keys have not changed so neither do the count or the filter
+    htNew.valueCount = ht->valueCount;
+    htNew.filter = ht->filter;
+    hashtable_release_buckets(ht);
+    hashtable_clone(ht, &htNew);
+    return true;
+}
+
+
+void hashtable_iterator_init(HashTableIterator *it, HashTable *ht) {
+    assert(NULL != it);
+    assert(NULL != ht);
+    it->ht = ht;
+    it->bucket = 0;
+    it->idx = 0;
+}
+
+HashValue *hashtable_iterator_next(HashTableIterator *it) {
+    assert(NULL != it);
 
-        HashTuple * hashTuple = hashtable_get_hastuple_at_idx(ht, i);
+    HashTable *ht = it->ht;
+    const size_t buckets = buffer_array_get_buffer_count(&ht->table);
 
-        if(NULL == hashTuple) {
-           continue;
+    while(it->bucket < buckets) {
+        Buffer *b = buffer_array_get_buffer(&ht->table, it->bucket);
+        HashTuple *tuple = (NULL == b) ? NULL : (HashTuple *) b->data;
+        const size_t count = (NULL == tuple) ? 0 : hashtuple_get_count(tuple);
+
+        while(it->idx < count) {
+            const size_t cur = it->idx++;
+            HashValue *hv = hashtuple_get_hash_value_at_idx(tuple, cur);
+            if(NULL == hv || NULL == hv->key.data) continue;
+
+            // skip entries shadowed by an earlier entry with the same key
+            size_t first = cur;
+            if(hashtuple_find_key_index(tuple, &hv->key, &first) &&
+               first != cur) continue;
+
+            return hv;
         }
 
-        const size_t hashTupleCount = hashtuple_get_count(hashTuple);
+        it->bucket++;
+        it->idx = 0;
+    }
+
+    return NULL;
+}
 
-        for(size_t j=0; j < hashTupleCount; ++j) {
+// account for buffer [b] holding [used] bytes of type [part] in [stats]
+static void hashtable_stats_add_buffer(HashTableStats *stats, const Buffer *b,
+                                       size_t used, size_t *part) {
+    if(NULL == b->data) return;
+    if(used > b->cap) used = b->cap;
+    *part += used;
+    stats->slackBytes += b->cap - used;
+    stats->allocations++;
+}
 
-            HashValue * hv = hashtuple_get_hash_value_at_idx(hashTuple, j);
+void hashtable_get_stats(const HashTable *ht, HashTableStats *stats) {
+    assert(NULL != ht);
+    assert(NULL != stats);
 
-            if(NULL == hv) continue;
+    memset(stats, 0, sizeof(HashTableStats));
+    stats->bucketCount = ht->size;
+    stats->entryCount = ht->valueCount;
 
-            if(!hashtable_add(&htNew, &hv->key, &hv->data)) {
+    hashtable_stats_add_buffer(stats, &ht->table.array, ht->table.array.len,
+                               &stats->slotBytes);
 
-                log_message("Unable to add hashvalue to new hash table");
-                hashtable_free(&htNew);
+    const size_t buckets = ht->table.count;
+    const Buffer *slots = (const Buffer *) ht->table.array.data;
 
-                return false;
-            }
+    for(size_t i=0; i<buckets; ++i) {
+        const Buffer *b = &slots[i];
+        HashTuple *tuple = (HashTuple *) b->data;
+        size_t chain = 0;
+
+        if(NULL != tuple) {
+            hashtable_stats_add_buffer(stats, b, sizeof(HashTuple),
+                                       &stats->slotBytes);
+            hashtable_stats_add_buffer(stats, &tuple->buffer.array,
+                                       tuple->buffer.array.len,
+                                       &stats->slotBytes);
+            chain = tuple->buffer.count;
+        }
+
+        for(size_t j=0; j<chain; ++j) {
+            const Buffer *vb = buffer_array_get_buffer(&tuple->buffer, j);
+            const HashValue *hv = (const HashValue *) vb->data;
+            if(NULL == hv) continue;
+
+            hashtable_stats_add_buffer(stats, vb, sizeof(HashValue),
+                                       &stats->slotBytes);
+            hashtable_stats_add_buffer(stats, &hv->key, hv->key.len,
+                                       &stats->keyBytes);
+            hashtable_stats_add_buffer(stats, &hv->data, hv->data.len,
+                                       &stats->valueBytes);
+
+            size_t first = j;
+            if(hashtuple_find_bytes_index(tuple, hv->key.data, hv->key.len,
+                                          &first) && first != j)
+                stats->tombstoneCount++;
         }
+
+        if(chain > 0) stats->usedBuckets++;
+        if(chain > stats->longestChain) stats->longestChain = chain;
+        stats->storedValues += chain;
+        stats->chainHistogram[chain < HASH_TABLE_STATS_HISTOGRAM ?
+                              chain : HASH_TABLE_STATS_HISTOGRAM - 1]++;
     }
 
-    hashtable_free(ht);
-    hashtable_clone(ht, &htNew);
-    return true;
+    // buckets beyond those allocated are empty until the first add
+    if(ht->size > buckets) stats->chainHistogram[0] += ht->size - buckets;
+
+    stats->totalBytes = stats->slotBytes + stats->keyBytes +
+                        stats->valueBytes + stats->slackBytes;
+    if(ht->size > 0)
+        stats->loadFactor = (double) stats->entryCount / (double) ht->size;
+    if(stats->usedBuckets > 0)
+        stats->averageChain = (double) stats->storedValues /
+                              (double) stats->usedBuckets;
+    if(stats->entryCount > 0)
+        stats->bytesPerEntry = (double) stats->totalBytes /
+                               (double) stats->entryCount;
 }
 
+void hashtable_stats_dump(const HashTableStats *stats) {
+    assert(NULL != stats);
+
+    fprintf(stderr, "\tHash Table Stats\n");
+    fprintf(stderr, "\t\tBuckets: %zu (%zu used)\n", stats->bucketCount,
+            stats->usedBuckets);
+    fprintf(stderr, "\t\tEntries: %zu (%zu stored, %zu tombstones)\n",
+            stats->entryCount, stats->storedValues, stats->tombstoneCount);
+    fprintf(stderr, "\t\tLoad Factor: %.3f\n", stats->loadFactor);
+    fprintf(stderr, "\t\tChain: average %.3f longest %zu\n",
+            stats->averageChain, stats->longestChain);
+    fprintf(stderr, "\t\tChain Lengths:");
+    for(size_t i=0; i<HASH_TABLE_STATS_HISTOGRAM; ++i) {
+        if(0 == stats->chainHistogram[i]) continue;
+        fprintf(stderr, " %zu%s:%zu", i,
+                i == HASH_TABLE_STATS_HISTOGRAM - 1 ? "+" : "",
+                stats->chainHistogram[i]);
+    }
+    fprintf(stderr, "\n");
+    fprintf(stderr, "\t\tBytes: %zu slots, %zu keys, %zu values, %zu slack "
+                    "in %zu allocations\n", stats->slotBytes, stats->keyBytes,
+            stats->valueBytes, stats->slackBytes, stats->allocations);
+    fprintf(stderr, "\t\tBytes Per Entry: %.1f\n", stats->bytesPerEntry);
+}
 
 void hashvalue_dump(HashValue *src) {
     assert(NULL != src);
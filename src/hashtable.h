@@ -9,9 +9,14 @@
 #include <stdbool.h>
 #include "recycler.h"
 #include "bufferarray.h"
+#include "filter.h"
+#include "threadpool.h"
 
 #define HASH_TABLE_DEFAULT_SIZE 10
 
+// number of independent lookups the batched operations keep in flight
+#define HASH_TABLE_BATCH_SIZE 16
+
 typedef Buffer HashKey;
 
 
@@ -24,6 +29,7 @@ typedef struct stHashedValue {
     HashKey key;
     Buffer data;
     Recycler *recycler;
+    size_t hash;
 } HashValue;
 
 /* HashTuple
@@ -48,8 +54,69 @@ typedef struct stHashTable {
     size_t valueCount;
     size_t size;
     Recycler *recycler;
+    MembershipFilter *filter;
 } HashTable;
 
+/* HashMergeFn
+ * combines the value [src] of a key being merged into the value [dest] the
+ * destination table already holds for it, [ctx] is passed through from the
+ * merge call.  src is discarded afterwards so its storage may be taken, for
+ * instance with buffer_swap.  returns false to abort the merge
+ */
+
+typedef bool (*HashMergeFn)(Buffer *dest, Buffer *src, void *ctx);
+
+/* HashTableIterator
+ * walks every live key/value pair of a hash table in bucket order.  A pair
+ * whose key was added again later is only visited once, for the value
+ * hashtable_get would return.
+ */
+
+typedef struct stHashTableIterator {
+    HashTable *ht;
+    size_t bucket;
+    size_t idx;
+} HashTableIterator;
+
+// chain lengths from 0 up to HASH_TABLE_STATS_HISTOGRAM - 2 get their own
+// histogram slot, the last slot counts every longer chain
+#define HASH_TABLE_STATS_HISTOGRAM 16
+
+/* HashTableStats
+ * a summary of how well a hash table spreads its keys and where its memory
+ * goes.  A chain is the run of values sharing a bucket, a lookup compares
+ * against each of them in turn so the chain length is the probe length.
+ * Values shadowed by a later add of the same key stay in their chain until
+ * removed, those are counted as tombstones.
+ *
+ * The bytes are split into
+ *   slotBytes  - bucket array, tuple and value headers
+ *   keyBytes   - key bytes in use
+ *   valueBytes - value bytes in use
+ *   slackBytes - allocated but unused capacity of all of the above
+ * allocations is the number of separate blocks holding those bytes, each
+ * also costs the allocator its own header which is not counted in the bytes
+ */
+
+typedef struct stHashTableStats {
+    size_t bucketCount;
+    size_t usedBuckets;
+    size_t entryCount;
+    size_t storedValues;
+    size_t tombstoneCount;
+    size_t longestChain;
+    double loadFactor;
+    double averageChain;
+    size_t chainHistogram[HASH_TABLE_STATS_HISTOGRAM];
+    size_t slotBytes;
+    size_t keyBytes;
+    size_t valueBytes;
+    size_t slackBytes;
+    size_t totalBytes;
+    size_t allocations;
+    double bytesPerEntry;
+} HashTableStats;
+
 /* initialize a hash value [hv] so that it is ready to be populated
    [hv] - hash value to be initialized
 */
@@ -98,6 +165,17 @@ void hashtable_init(HashTable *ht);
 */
 bool hashtable_add(HashTable *ht, const HashKey *key, const Buffer *value);
 
+/* the same as hashtable_add but [key] and [value] are moved into the table
+ * rather than copied, both are left empty.  Their memory is freed to the
+ * recycler it came from, which need not be the table's
+ * [ht] - hash table to add value to
+ * [key] - key used to retrieve value, emptied on success
+ * [value] - value to be retrieved, emptied on success
+ returns true on success, fails only on memory allocation failure in which
+ case key and value are untouched
+*/
+bool hashtable_add_move(HashTable *ht, HashKey *key, Buffer *value);
+
 /* Remove a key [hk] and any data stored using that key to hash table [ht]
  * [ht] - hash table to remove key from
  * [hk] - key to remove
@@ -113,6 +191,39 @@ void hashtable_remove(HashTable *ht, const HashKey *hk);
  */
 Buffer *hashtable_get(HashTable *ht, const HashKey *key);
 
+/* Retrieve the data stored in hashtable [ht] for every key in [keys],
+ * writing a pointer to each internal data buffer (or NULL when the key is not
+ * present) to the matching slot of [results].  Keys are hashed and their
+ * buckets prefetched HASH_TABLE_BATCH_SIZE at a time before any chain is
+ * walked, hiding memory latency across the independent lookups
+ * [ht] - hash table from which to retrieve keys
+ * [keys] - keys of the data to retrieve
+ * [results] - caller supplied array with room for one pointer per key
+ * returns the number of keys found
+ */
+size_t hashtable_get_many(HashTable *ht, BufferArray *keys, Buffer **results);
+
+/* the same as hashtable_get_many but for [count] keys held in views [keys]
+ * [ht] - hash table from which to retrieve keys
+ * [keys] - array of [count] views of the keys to retrieve
+ * [count] - number of keys
+ * [results] - caller supplied array with room for [count] pointers
+ * returns the number of keys found
+ */
+size_t hashtable_get_many_views(HashTable *ht, const BufferView *keys,
+                                size_t count, Buffer **results);
+
+/* Add every key in [keys] to hashtable [ht] with the value at the same index
+ * in [values].  Behaves like calling hashtable_add for each pair in order but
+ * hashes and prefetches HASH_TABLE_BATCH_SIZE buckets ahead
+ * [ht] - hash table to add values to
+ * [keys] - keys used to retrieve values
+ * [values] - values to be retrieved, must hold as many buffers as [keys]
+ * returns true on success, fails on a count mismatch or memory allocation
+ * failure (pairs before the failure remain added)
+ */
+bool hashtable_add_many(HashTable *ht, BufferArray *keys, BufferArray *values);
+
 /* Check hashtable [ht] to see if it has any data stored using key [key]
  * [ht] - hash table to check
  * [key] - key to check hash table for
@@ -121,6 +232,90 @@ Buffer *hashtable_get(HashTable *ht, const HashKey *key);
 
 bool hashtable_has(const HashTable *ht, const HashKey *key);
 
+/* move every key/value pair of hashtable [src] into hashtable [dest],
+ * leaving src empty.  Pairs are moved, not copied, and land in their bucket
+ * using the hash stored when they were added.  When dest already holds a key
+ * [combine] is called to fold the src value into the dest value, with
+ * [combine] NULL the dest value is kept.
+ *
+ * With thread pool [tp] and two tables of the same size the buckets are
+ * split into ranges merged at the same time.  Tables of different sizes, or
+ * with a recycler or filter assigned, are merged on the calling thread since
+ * neither recyclers nor filters may be shared between threads.  Moved
+ * buffers keep the recycler they were allocated from.
+ *
+ * [dest] - hash table receiving the pairs
+ * [src] - hash table the pairs are taken from
+ * [combine] - folds a src value into an existing dest value, may be NULL
+ * [ctx] - passed to every call of combine
+ * [tp] - thread pool to merge on, NULL to merge on the calling thread
+ * returns false on memory exhaustion or when combine fails, every pair is
+ * then still held by one of the two tables
+ */
+bool hashtable_merge(HashTable *dest, HashTable *src, HashMergeFn combine,
+                     void *ctx, ThreadPool *tp);
+
+/* merge [count] hash tables [tables] into tables[0] by a tree reduction,
+ * pairs of tables are merged side by side on thread pool [tp] in rounds
+ * until one is left.  every other table is left empty
+ * [tables] - array of [count] pointers to the tables to merge
+ * [count] - number of tables
+ * [combine] - as for hashtable_merge
+ * [ctx] - passed to every call of combine
+ * [tp] - thread pool to merge on, NULL to merge on the calling thread
+ * returns false on memory exhaustion or when combine fails
+ */
+bool hashtable_merge_all(HashTable **tables, size_t count, HashMergeFn combine,
+                         void *ctx, ThreadPool *tp);
+
+/* add every key in [keys] to hashtable [ht] with the value at the same index
+ * in [values], hashing on all threads of thread pool [tp].  The result is
+ * the same as hashtable_add_many: pairs are copied and a key given twice
+ * keeps its first value.
+ *
+ * Keys are hashed in chunks, then radix partitioned by bucket index so each
+ * partition owns a contiguous range of buckets.  Partitions are then built
+ * side by side without locks, every chain being sized once up front.  Size
+ * [ht] for the expected key count with hashtable_set_size first, the table
+ * does not grow and the number of partitions is bounded by its size.  A
+ * table with a recycler or filter assigned is built on the calling thread.
+ *
+ * [ht] - hash table to add values to
+ * [keys] - keys used to retrieve values
+ * [values] - values to be retrieved, must hold as many buffers as [keys]
+ * [tp] - thread pool to build on, NULL to build on the calling thread
+ * returns true on success, fails on a count mismatch or memory allocation
+ * failure (some pairs may then have been added)
+ */
+bool hashtable_build_parallel(HashTable *ht, BufferArray *keys,
+                              BufferArray *values, ThreadPool *tp);
+
+/* the same as hashtable_build_parallel with one key for each [delim]
+ * terminated record of file [fileName], every key getting a copy of
+ * [value].  The file is mapped rather than read, empty records are skipped
+ * [ht] - hash table to add values to
+ * [fileName] - name of the file holding the keys
+ * [delim] - byte ending each key, usually a newline
+ * [value] - value stored for every key
+ * [tp] - thread pool to build on, NULL to build on the calling thread
+ * returns true on success, false when the file cannot be mapped or memory
+ * is exhausted
+ */
+bool hashtable_build_parallel_file(HashTable *ht, const char *fileName,
+                                   unsigned char delim, const Buffer *value,
+                                   ThreadPool *tp);
+
+/* attach membership filter [mf] to hashtable [ht] so lookups of keys the
+ * filter rules out return without touching the table.  every key already in
+ * [ht] is added to [mf], afterwards adds and removes keep the two in step.
+ * the filter is not owned by the table and must outlive it or be detached
+ * by attaching NULL.  a bloom filter cannot forget removed keys, those only
+ * cost the chain walk the filter would otherwise have saved
+ * [ht] - hash table to front with the filter
+ * [mf] - created filter sized for the expected key count, or NULL to detach
+ */
+void hashtable_attach_filter(HashTable *ht, MembershipFilter *mf);
+
 /* assign recylcer [r] to hashtable [ht] so that memory may be recyled intead
  * of being returned using free
  * [ht] - hashtable to assign recycler to
@@ -164,6 +359,30 @@ size_t hashtable_get_entry_count(const HashTable *ht);
 
 void hashtable_clone(HashTable *dest, HashTable *src);
 
+/* prepare iterator [it] to walk every pair held in hashtable [ht], the
+ * iterator is invalidated by anything which adds to or removes from ht
+ * [it] - iterator to initialize
+ * [ht] - hash table to walk
+ */
+void hashtable_iterator_init(HashTableIterator *it, HashTable *ht);
+
+/* advance iterator [it] to the next pair
+ * [it] - iterator to advance
+ * returns the next hash value or NULL once every pair has been visited
+ */
+HashValue *hashtable_iterator_next(HashTableIterator *it);
+
+/* gather statistics about hashtable [ht] into [stats] without printing or
+ * changing anything, cheap enough to sample a large table periodically as it
+ * reads each bucket and value header once
+ * [ht] - hash table to examine
+ * [stats] - filled in with the results
+ */
+void hashtable_get_stats(const HashTable *ht, HashTableStats *stats);
+
+// print the summary held in [stats] to stderr
+void hashtable_stats_dump(const HashTableStats *stats);
+
 void hashvalue_dump(HashValue *src);
 void hashtuple_dump(HashTuple *src);
 void hashtable_dump(HashTable *src);
@@ -0,0 +1,356 @@
+//
+// Created by Joseph Hurdle on 10/19/26.
+//
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
+#include <unistd.h>
+#include "mappedbufferarray.h"
+#include "log.h"
+
+// compute the checksum of image header [header], skipping the checksum field
+static uint64_t buffer_array_image_header_checksum(
+        const BufferArrayImageHeader *header) {
+    return hash_bytes(header, offsetof(BufferArrayImageHeader, headerChecksum),
+                      HASH_DEFAULT_SEED);
+}
+
+// the offset of the index following [dataSize] element bytes
+static uint64_t buffer_array_image_index_offset(uint64_t dataSize) {
+    return (sizeof(BufferArrayImageHeader) + dataSize + 7) & ~(uint64_t) 7;
+}
+
+// write and checksum the [len] bytes at [p] as the next part of the image
+static bool buffer_array_writer_out(BufferArrayWriter *w, const void *p,
+                                    size_t len) {
+    if(!mapped_file_write(w->fd, p, len)) {
+        w->failed = true;
+        return false;
+    }
+    hash_state_update(&w->checksum, p, len);
+    return true;
+}
+
+// write out the gathered element bytes
+static bool buffer_array_writer_flush_data(BufferArrayWriter *w) {
+    if(0 == w->data.len) return true;
+    const bool ok = buffer_array_writer_out(w, w->data.data, w->data.len);
+    w->data.len = 0;
+    return ok;
+}
+
+// move the gathered element ends to the index file, creating it on first use
+static bool buffer_array_writer_spill(BufferArrayWriter *w) {
+    if(-1 == w->indexFd) {
+        Buffer base;
+        buffer_init(&base);
+        const char *fileName = buffer_get_string(&w->fileName);
+        const bool named = buffer_push_bytes(&base, (const unsigned char *) fileName,
+                                             strlen(fileName)) &&
+                           buffer_push_bytes(&base, (const unsigned char *) ".index",
+                                             sizeof(".index"));
+        if(named) w->indexFd = mapped_file_create(buffer_get_string(&base),
+                                                  &w->indexName);
+        buffer_free(&base);
+        if(-1 == w->indexFd) {
+            w->failed = true;
+            return false;
+        }
+    }
+    if(!mapped_file_write(w->indexFd, w->ends.data, w->ends.len)) {
+        w->failed = true;
+        return false;
+    }
+    w->indexSpilled += w->ends.len;
+    w->ends.len = 0;
+    return true;
+}
+
+// close and remove any temporary files and empty writer [w]
+static void buffer_array_writer_reset(BufferArrayWriter *w) {
+    const char *fileName = NULL == w->fileName.data ? "" :
+                           buffer_get_string(&w->fileName);
+    if(-1 != w->indexFd) mapped_file_commit(w->indexFd, &w->indexName,
+                                            fileName, false);
+    if(-1 != w->fd) mapped_file_commit(w->fd, &w->tmpName, fileName, false);
+
+    Recycler *r = w->recycler;
+    buffer_free(&w->fileName);
+    buffer_free(&w->tmpName);
+    buffer_free(&w->indexName);
+    buffer_free(&w->data);
+    buffer_free(&w->ends);
+    buffer_array_writer_init(w);
+    buffer_array_writer_assign_recycler(w, r);
+}
+
+void buffer_array_writer_init(BufferArrayWriter *w) {
+    assert(NULL != w);
+    w->fd = -1;
+    w->indexFd = -1;
+    buffer_init(&w->fileName);
+    buffer_init(&w->tmpName);
+    buffer_init(&w->indexName);
+    buffer_init(&w->data);
+    buffer_init(&w->ends);
+    w->dataSize = 0;
+    w->count = 0;
+    w->indexSpilled = 0;
+    hash_state_init(&w->checksum, HASH_DEFAULT_SEED);
+    w->failed = false;
+    w->recycler = NULL;
+}
+
+void buffer_array_writer_assign_recycler(BufferArrayWriter *w, Recycler *rc) {
+    assert(NULL != w);
+    w->recycler = rc;
+    buffer_assign_recycler(&w->data, rc);
+    buffer_assign_recycler(&w->ends, rc);
+}
+
+bool buffer_array_writer_open(BufferArrayWriter *w, const char *fileName) {
+    assert(NULL != w);
+    assert(NULL != fileName);
+
+    buffer_array_writer_reset(w);
+
+    // the header is written last, once the checksum is known
+    BufferArrayImageHeader header;
+    memset(&header, 0, sizeof(header));
+
+    bool ok = buffer_strcpy(&w->fileName, fileName) &&
+              buffer_reserve(&w->data, BUFFER_ARRAY_WRITER_BLOCK) &&
+              buffer_reserve(&w->ends, BUFFER_ARRAY_WRITER_BLOCK);
+    if(ok) w->fd = mapped_file_create(fileName, &w->tmpName);
+    ok = ok && -1 != w->fd && mapped_file_write(w->fd, &header, sizeof(header));
+
+    if(!ok) {
+        log_message("Unable to start buffer array image [%s]", fileName);
+        buffer_array_writer_reset(w);
+    }
+    return ok;
+}
+
+bool buffer_array_writer_push_bytes(BufferArrayWriter *w,
+                                    const unsigned char *data, size_t len) {
+    assert(NULL != w);
+    assert(NULL != data || 0 == len);
+
+    if(w->failed || -1 == w->fd) return false;
+
+    if(w->data.len + len > BUFFER_ARRAY_WRITER_BLOCK &&
+       !buffer_array_writer_flush_data(w))
+        return false;
+
+    // a block's worth or more goes straight out
+    if(len >= BUFFER_ARRAY_WRITER_BLOCK) {
+        if(!buffer_array_writer_out(w, data, len)) return false;
+    } else if(len > 0) {
+        memcpy(w->data.data + w->data.len, data, len);
+        w->data.len += len;
+    }
+    w->dataSize += len;
+
+    if(w->ends.len + sizeof(uint64_t) > BUFFER_ARRAY_WRITER_BLOCK &&
+       !buffer_array_writer_spill(w))
+        return false;
+    memcpy(w->ends.data + w->ends.len, &w->dataSize, sizeof(uint64_t));
+    w->ends.len += sizeof(uint64_t);
+    ++w->count;
+    return true;
+}
+
+bool buffer_array_writer_push(BufferArrayWriter *w, const Buffer *buf) {
+    assert(NULL != buf);
+    return buffer_array_writer_push_bytes(w, buf->data,
+                                          NULL == buf->data ? 0 : buf->len);
+}
+
+bool buffer_array_writer_push_view(BufferArrayWriter *w, const BufferView *view) {
+    assert(NULL != view);
+    return buffer_array_writer_push_bytes(w, view->data,
+                                          NULL == view->data ? 0 : view->len);
+}
+
+size_t buffer_array_writer_get_count(const BufferArrayWriter *w) {
+    assert(NULL != w);
+    return w->count;
+}
+
+bool buffer_array_writer_finish(BufferArrayWriter *w) {
+    assert(NULL != w);
+
+    if(-1 == w->fd) return false;
+
+    static const unsigned char zeros[8] = { 0 };
+    BufferArrayImageHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, BUFFER_ARRAY_IMAGE_MAGIC, sizeof(BUFFER_ARRAY_IMAGE_MAGIC));
+    header.version = BUFFER_ARRAY_IMAGE_VERSION;
+    header.headerSize = sizeof(BufferArrayImageHeader);
+    header.count = w->count;
+    header.dataOffset = sizeof(BufferArrayImageHeader);
+    header.dataSize = w->dataSize;
+    header.indexOffset = buffer_array_image_index_offset(w->dataSize);
+    header.fileSize = header.indexOffset + w->count * sizeof(uint64_t);
+
+    bool ok = !w->failed && buffer_array_writer_flush_data(w) &&
+              buffer_array_writer_out(w, zeros, header.indexOffset -
+                                                header.dataOffset - w->dataSize);
+
+    // ends which went to the index file are copied back through the data
+    // block, followed by those still gathered
+    if(ok && w->indexSpilled > 0) {
+        const int fd = buffer_array_writer_spill(w) ?
+                       open(buffer_get_string(&w->indexName), O_RDONLY) : -1;
+        ok = -1 != fd;
+        for(uint64_t off = 0; ok && off < w->indexSpilled; ) {
+            const ssize_t ret = pread(fd, w->data.data, BUFFER_ARRAY_WRITER_BLOCK,
+                                      (off_t) off);
+            if(ret < 0 && EINTR == errno) continue;
+            if(ret <= 0) {
+                log_message("Unable to read back buffer array index, error [%s]",
+                            0 == ret ? "end of file" : strerror(errno));
+                ok = false;
+                break;
+            }
+            ok = buffer_array_writer_out(w, w->data.data, (size_t) ret);
+            off += (uint64_t) ret;
+        }
+        if(-1 != fd) close(fd);
+    }
+    ok = ok && buffer_array_writer_out(w, w->ends.data, w->ends.len);
+
+    if(ok) {
+        header.payloadChecksum = hash_state_final(&w->checksum);
+        header.headerChecksum = buffer_array_image_header_checksum(&header);
+        ok = mapped_file_write_at(w->fd, &header, sizeof(header), 0);
+    }
+
+    ok = mapped_file_commit(w->fd, &w->tmpName, buffer_get_string(&w->fileName),
+                            ok);
+    w->fd = -1;
+    if(!ok) log_message("Unable to save buffer array image [%s]",
+                        buffer_get_string(&w->fileName));
+    buffer_array_writer_reset(w);
+    return ok;
+}
+
+void buffer_array_writer_free(BufferArrayWriter *w) {
+    assert(NULL != w);
+    buffer_array_writer_reset(w);
+}
+
+bool buffer_array_save(const BufferArray *ba, const char *fileName) {
+    assert(NULL != ba);
+    assert(NULL != fileName);
+
+    BufferArrayWriter w;
+    buffer_array_writer_init(&w);
+    buffer_array_writer_assign_recycler(&w, ba->recycler);
+
+    bool ok = buffer_array_writer_open(&w, fileName);
+    const Buffer *bufs = (const Buffer *) ba->array.data;
+    for(size_t i = 0; ok && i < ba->count; ++i)
+        ok = buffer_array_writer_push(&w, &bufs[i]);
+    ok = ok && buffer_array_writer_finish(&w);
+
+    buffer_array_writer_free(&w);
+    return ok;
+}
+
+void mapped_buffer_array_init(MappedBufferArray *mba) {
+    assert(NULL != mba);
+    mapped_file_init(&mba->file);
+    mba->header = NULL;
+    mba->data = NULL;
+    mba->ends = NULL;
+}
+
+bool buffer_array_open_mapped(MappedBufferArray *mba, const char *fileName) {
+    assert(NULL != mba);
+    assert(NULL != fileName);
+
+    mapped_buffer_array_init(mba);
+
+    if(!mapped_file_open(&mba->file, fileName)) return false;
+
+    const BufferArrayImageHeader *h =
+            (const BufferArrayImageHeader *) mba->file.data;
+    const size_t len = mba->file.len;
+
+    bool ok = len >= sizeof(BufferArrayImageHeader) &&
+              0 == memcmp(h->magic, BUFFER_ARRAY_IMAGE_MAGIC,
+                          sizeof(BUFFER_ARRAY_IMAGE_MAGIC));
+    if(!ok) {
+        log_message("[%s] is not a buffer array image", fileName);
+    } else if(BUFFER_ARRAY_IMAGE_VERSION != h->version ||
+              sizeof(BufferArrayImageHeader) != h->headerSize) {
+        log_message("[%s] is buffer array image version %u, expected %u",
+                    fileName, h->version, BUFFER_ARRAY_IMAGE_VERSION);
+        ok = false;
+    } else if(buffer_array_image_header_checksum(h) != h->headerChecksum) {
+        log_message("[%s] buffer array image header is corrupt", fileName);
+        ok = false;
+    } else if(h->fileSize != len ||
+              h->dataOffset != sizeof(BufferArrayImageHeader) ||
+              h->dataSize > len ||
+              h->indexOffset != buffer_array_image_index_offset(h->dataSize) ||
+              h->indexOffset > len ||
+              h->count > (len - h->indexOffset) / sizeof(uint64_t) ||
+              h->indexOffset + h->count * sizeof(uint64_t) != len) {
+        log_message("[%s] buffer array image is truncated or inconsistent",
+                    fileName);
+        ok = false;
+    }
+
+    if(!ok) {
+        mapped_file_close(&mba->file);
+        return false;
+    }
+
+    mba->header = h;
+    mba->data = mba->file.data + h->dataOffset;
+    mba->ends = (const uint64_t *) (mba->file.data + h->indexOffset);
+    return true;
+}
+
+void mapped_buffer_array_close(MappedBufferArray *mba) {
+    assert(NULL != mba);
+    mapped_file_close(&mba->file);
+    mapped_buffer_array_init(mba);
+}
+
+size_t mapped_buffer_array_get_count(const MappedBufferArray *mba) {
+    assert(NULL != mba);
+    if(NULL == mba->header) return 0;
+    return mba->header->count;
+}
+
+bool mapped_buffer_array_get_view(const MappedBufferArray *mba, size_t index,
+                                  BufferView *view) {
+    assert(NULL != mba);
+    assert(NULL != view);
+
+    if(NULL == mba->header || index >= mba->header->count) return false;
+
+    const uint64_t start = 0 == index ? 0 : mba->ends[index - 1];
+    const uint64_t end = mba->ends[index];
+    if(start > end || end > mba->header->dataSize) return false;
+
+    buffer_view_set(view, mba->data + start, (size_t) (end - start));
+    return true;
+}
+
+bool mapped_buffer_array_verify(const MappedBufferArray *mba) {
+    assert(NULL != mba);
+    if(NULL == mba->header) return false;
+
+    const size_t start = mba->header->dataOffset;
+    const uint64_t sum = hash_bytes(mba->file.data + start,
+                                    mba->file.len - start, HASH_DEFAULT_SEED);
+    return sum == mba->header->payloadChecksum;
+}
@@ -0,0 +1,165 @@
+//
+// Created by Joseph Hurdle on 10/19/26.
+//
+
+#ifndef SEARCHFILEC_MAPPEDBUFFERARRAY_H
+#define SEARCHFILEC_MAPPEDBUFFERARRAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "buffer.h"
+#include "bufferarray.h"
+#include "hash.h"
+#include "mappedfile.h"
+
+#define BUFFER_ARRAY_IMAGE_MAGIC "SSCBARR"
+#define BUFFER_ARRAY_IMAGE_VERSION 1
+
+// bytes a BufferArrayWriter gathers before each write
+#define BUFFER_ARRAY_WRITER_BLOCK (1 << 20)
+
+/*
+ * A buffer array image is a file holding the bytes of every buffer of an
+ * array back to back followed by an index of where each one ends, read
+ * straight out of a read only mapping with no parsing and no allocation.
+ * Every offset is relative to the start of the file.
+ *
+ * [header][element bytes][pad to 8][element ends]
+ *
+ * Element i runs from ends[i - 1] (0 for the first) up to ends[i] within the
+ * element bytes.  The index comes last so an image can be written in one
+ * pass by a BufferArrayWriter, which never holds more than a block of it.
+*/
+
+typedef struct stBufferArrayImageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t count;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+    uint64_t indexOffset;
+    uint64_t fileSize;
+    uint64_t payloadChecksum;
+    uint64_t headerChecksum;
+} BufferArrayImageHeader;
+
+typedef struct stMappedBufferArray {
+    MappedFile file;
+    const BufferArrayImageHeader *header;
+    const unsigned char *data;
+    const uint64_t *ends;
+} MappedBufferArray;
+
+/* BufferArrayWriter
+ * writes a buffer array image one element at a time, so arrays far larger
+ * than memory can be saved.  Element bytes are gathered into a block before
+ * being written, element ends likewise, spilling to a temporary index file
+ * which is copied behind the elements when the image is finished
+ */
+
+typedef struct stBufferArrayWriter {
+    int fd;
+    int indexFd;
+    Buffer fileName;
+    Buffer tmpName;
+    Buffer indexName;
+    Buffer data;
+    Buffer ends;
+    uint64_t dataSize;
+    uint64_t count;
+    uint64_t indexSpilled;
+    HashState checksum;
+    bool failed;
+    Recycler *recycler;
+} BufferArrayWriter;
+
+/* write every buffer held in buffer array [ba] to an image file [fileName].
+ * The image is written to a temporary file and renamed into place, so
+ * processes which have the previous image mapped keep a consistent view of it
+ * [ba] - buffer array to save
+ * [fileName] - name of the image file
+ * returns true on success
+ */
+bool buffer_array_save(const BufferArray *ba, const char *fileName);
+
+/* initialize a mapped buffer array [mba] so it maps nothing
+ * [mba] - mapped buffer array to initialize
+ */
+void mapped_buffer_array_init(MappedBufferArray *mba);
+
+/* map the image [fileName] written by buffer_array_save or a
+ * BufferArrayWriter read only into [mba].  Only the header is validated so
+ * opening is O(1) whatever the size, use mapped_buffer_array_verify to check
+ * every byte against the stored checksum
+ * [mba] - mapped buffer array to populate
+ * [fileName] - name of the image file
+ * returns true on success, false if the file is missing, truncated or is not
+ * an image of a supported version
+ */
+bool buffer_array_open_mapped(MappedBufferArray *mba, const char *fileName);
+
+/* unmap a mapped buffer array [mba]
+ * [mba] - mapped buffer array to close
+ */
+void mapped_buffer_array_close(MappedBufferArray *mba);
+
+/* get the number of buffers held in mapped buffer array [mba] */
+size_t mapped_buffer_array_get_count(const MappedBufferArray *mba);
+
+/* point [view] at buffer [index] of mapped buffer array [mba], it stays valid
+ * until the array is closed
+ * returns false if there is no such buffer or its index entry is corrupt
+ */
+bool mapped_buffer_array_get_view(const MappedBufferArray *mba, size_t index,
+                                  BufferView *view);
+
+/* check every byte of the image mapped by [mba] against its checksum
+ * [mba] - mapped buffer array to check
+ * returns true if the image is intact
+ */
+bool mapped_buffer_array_verify(const MappedBufferArray *mba);
+
+/* initialize a buffer array writer [w] so it writes nothing
+ * [w] - writer to initialize
+ */
+void buffer_array_writer_init(BufferArrayWriter *w);
+
+/* assign recycler [rc] to writer [w], call before buffer_array_writer_open */
+void buffer_array_writer_assign_recycler(BufferArrayWriter *w, Recycler *rc);
+
+/* start writing an image which will be named [fileName] once finished
+ * [w] - writer to start
+ * [fileName] - name of the image file
+ * returns true on success
+ */
+bool buffer_array_writer_open(BufferArrayWriter *w, const char *fileName);
+
+/* append the [len] bytes at [data] to the image as its next element
+ * returns false on a write or memory failure, after which the image can only
+ * be abandoned
+ */
+bool buffer_array_writer_push_bytes(BufferArrayWriter *w,
+                                    const unsigned char *data, size_t len);
+
+/* append the data of buffer [buf] as the next element */
+bool buffer_array_writer_push(BufferArrayWriter *w, const Buffer *buf);
+
+/* append the bytes of view [view] as the next element */
+bool buffer_array_writer_push_view(BufferArrayWriter *w, const BufferView *view);
+
+/* get the number of elements written to [w] so far */
+size_t buffer_array_writer_get_count(const BufferArrayWriter *w);
+
+/* write the index and header and move the image into place under its name,
+ * the writer is left empty
+ * returns true if the image is complete
+ */
+bool buffer_array_writer_finish(BufferArrayWriter *w);
+
+/* abandon any unfinished image, removing its temporary files, and free
+ * memory held by writer [w]
+ */
+void buffer_array_writer_free(BufferArrayWriter *w);
+
+#endif //SEARCHFILEC_MAPPEDBUFFERARRAY_H
@@ -0,0 +1,204 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include "mappedfile.h"
+#include "log.h"
+
+void mapped_file_init(MappedFile *mf) {
+    assert(NULL != mf);
+    mf->data = NULL;
+    mf->len = 0;
+}
+
+bool mapped_file_open(MappedFile *mf, const char *fileName) {
+    assert(NULL != mf);
+    assert(NULL != fileName);
+
+    mapped_file_init(mf);
+
+    const int fd = open(fileName, O_RDONLY);
+    if(-1 == fd) {
+        log_message("Unable to open file [%s] for mapping, error [%s]",
+                    fileName, strerror(errno));
+        return false;
+    }
+
+    struct stat fi;
+    if(0 != fstat(fd, &fi)) {
+        log_message("Unable to stat file [%s], error [%s]", fileName,
+                    strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    if(0 == fi.st_size) {
+        log_message("Unable to map empty file [%s]", fileName);
+        close(fd);
+        return false;
+    }
+
+    void *p = mmap(NULL, (size_t) fi.st_size, PROT_READ, MAP_SHARED, fd, 0);
+
+    // the mapping holds its own reference to the file
+    close(fd);
+
+    if(MAP_FAILED == p) {
+        log_message("Unable to map file [%s], error [%s]", fileName,
+                    strerror(errno));
+        return false;
+    }
+
+    mf->data = (const unsigned char *) p;
+    mf->len = (size_t) fi.st_size;
+    return true;
+}
+
+void mapped_file_close(MappedFile *mf) {
+    assert(NULL != mf);
+    if(NULL != mf->data) munmap((void *) mf->data, mf->len);
+    mapped_file_init(mf);
+}
+
+int mapped_file_create(const char *fileName, Buffer *tmpName) {
+    assert(NULL != fileName);
+    assert(NULL != tmpName);
+
+    const size_t cap = strlen(fileName) + 32;
+    if(!buffer_reserve(tmpName, cap)) {
+        log_message("Unable to build temporary name for [%s]", fileName);
+        return -1;
+    }
+
+    // a name of its own for every image being written, even by threads of
+    // one process saving the same file
+    snprintf((char *) tmpName->data, cap, "%s.XXXXXX", fileName);
+    const int fd = mkstemp((char *) tmpName->data);
+    tmpName->len = strlen((char *) tmpName->data) + 1;
+    tmpName->nullTerminated = true;
+
+    if(-1 == fd) {
+        log_message("Unable to create file [%s], error [%s]",
+                    buffer_get_string(tmpName), strerror(errno));
+        return -1;
+    }
+
+    // mkstemp leaves the file readable by its owner alone
+    if(0 != fchmod(fd, 0644)) {
+        log_message("Unable to set mode of file [%s], error [%s]",
+                    buffer_get_string(tmpName), strerror(errno));
+    }
+    return fd;
+}
+
+bool mapped_file_write(int fd, const void *data, size_t len) {
+    const unsigned char *p = (const unsigned char *) data;
+
+    while(len > 0) {
+        const ssize_t ret = write(fd, p, len);
+        if(ret < 0) {
+            if(EINTR == errno) continue;
+            log_message("Unable to write %zu bytes, error [%s]", len,
+                        strerror(errno));
+            return false;
+        }
+        p += ret;
+        len -= (size_t) ret;
+    }
+    return true;
+}
+
+bool mapped_file_write_at(int fd, const void *data, size_t len, size_t off) {
+    const unsigned char *p = (const unsigned char *) data;
+
+    while(len > 0) {
+        const ssize_t ret = pwrite(fd, p, len, (off_t) off);
+        if(ret < 0) {
+            if(EINTR == errno) continue;
+            log_message("Unable to write %zu bytes at %zu, error [%s]", len,
+                        off, strerror(errno));
+            return false;
+        }
+        p += ret;
+        off += (size_t) ret;
+        len -= (size_t) ret;
+    }
+    return true;
+}
+
+bool mapped_file_pad(int fd, size_t *written, size_t align) {
+    assert(NULL != written);
+    assert(align > 0 && align <= 64);
+
+    static const unsigned char zeros[64] = { 0 };
+    const size_t pad = (align - *written % align) % align;
+
+    if(0 == pad) return true;
+    if(!mapped_file_write(fd, zeros, pad)) return false;
+    *written += pad;
+    return true;
+}
+
+// fsync the directory holding [fileName] so a rename into it is durable
+static bool mapped_file_sync_dir(const char *fileName) {
+    const char *slash = strrchr(fileName, '/');
+    Buffer dir;
+    buffer_init(&dir);
+    if(NULL == slash) buffer_strcpy(&dir, ".");
+    else if(buffer_strcpy(&dir, fileName)) {
+        // keep the root of "/cake.img"
+        const size_t end = slash == fileName ? 1 : (size_t) (slash - fileName);
+        dir.data[end] = 0;
+        dir.len = end + 1;
+    }
+
+    const int fd = open(buffer_get_string(&dir), O_RDONLY | O_DIRECTORY);
+    bool ok = -1 != fd && 0 == fsync(fd);
+    if(!ok) {
+        log_message("Unable to sync directory [%s], error [%s]",
+                    buffer_get_string(&dir), strerror(errno));
+    }
+    if(-1 != fd) close(fd);
+    buffer_free(&dir);
+    return ok;
+}
+
+bool mapped_file_commit(int fd, Buffer *tmpName, const char *fileName,
+                        bool success) {
+    assert(NULL != tmpName);
+    assert(NULL != fileName);
+
+    // the image must be on disk before its final name can point at it
+    if(success && 0 != fsync(fd)) {
+        log_message("Unable to sync [%s], error [%s]",
+                    buffer_get_string(tmpName), strerror(errno));
+        success = false;
+    }
+
+    if(0 != close(fd)) {
+        log_message("Unable to close [%s], error [%s]",
+                    buffer_get_string(tmpName), strerror(errno));
+        success = false;
+    }
+
+    if(success && 0 != rename(buffer_get_string(tmpName), fileName)) {
+        log_message("Unable to rename [%s] to [%s], error [%s]",
+                    buffer_get_string(tmpName), fileName, strerror(errno));
+        success = false;
+    }
+
+    if(!success) unlink(buffer_get_string(tmpName));
+    else mapped_file_sync_dir(fileName);
+
+    buffer_free(tmpName);
+    return success;
+}
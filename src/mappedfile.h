@@ -0,0 +1,81 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#ifndef SEARCHFILEC_MAPPEDFILE_H
+#define SEARCHFILEC_MAPPEDFILE_H
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include "buffer.h"
+
+/*
+ * MappedFile
+ * a whole file mapped read only into memory.  Every process which maps the
+ * same file shares the same page cache copy of it.  Also holds the helpers
+ * used to write the on disk images which are later mapped
+*/
+
+typedef struct stMappedFile {
+    const unsigned char *data;
+    size_t len;
+} MappedFile;
+
+// initialize a mapped file [mf] so it maps nothing
+// [mf] - mapped file to be initialized
+void mapped_file_init(MappedFile *mf);
+
+// map the whole of file [fileName] read only into [mf]
+// [mf] - mapped file to populate
+// [fileName] - name of file to map
+// returns true on success
+bool mapped_file_open(MappedFile *mf, const char *fileName);
+
+// unmap a mapped file [mf]
+// [mf] - mapped file to unmap
+void mapped_file_close(MappedFile *mf);
+
+// create a temporary file with a unique name next to [fileName] to write an
+// image into, the temporary file replaces fileName on mapped_file_commit so
+// readers which already mapped the old file are never disturbed
+// [fileName] - name the image will finally have
+// [tmpName] - buffer to receive the temporary file's name
+// returns a file descriptor open for writing or -1 on failure
+int mapped_file_create(const char *fileName, Buffer *tmpName);
+
+// write [len] bytes at [data] to file descriptor [fd], retrying short writes
+// [fd] - file descriptor to write to
+// [data] - bytes to write
+// [len] - number of bytes to write
+// returns true when every byte was written
+bool mapped_file_write(int fd, const void *data, size_t len);
+
+// write [len] bytes at [data] to file descriptor [fd] at offset [off]
+// [fd] - file descriptor to write to
+// [data] - bytes to write
+// [len] - number of bytes to write
+// [off] - file offset to write at
+// returns true when every byte was written
+bool mapped_file_write_at(int fd, const void *data, size_t len, size_t off);
+
+// write zero bytes to file descriptor [fd] until [written] is a multiple of
+// [align], updating written
+// [fd] - file descriptor to write to
+// [written] - bytes written so far
+// [align] - alignment required, must be at most 64
+// returns true on success
+bool mapped_file_pad(int fd, size_t *written, size_t align);
+
+// fsync and close file descriptor [fd] and move temporary file [tmpName]
+// over [fileName], then fsync the directory so that after a crash the name
+// holds either the old image or the whole new one.  The temporary file is
+// removed instead when [success] is false
+// [fd] - file descriptor returned by mapped_file_create
+// [tmpName] - temporary name populated by mapped_file_create, freed here
+// [fileName] - final name of the image
+// [success] - whether the image was written completely
+// returns true if the image is now in place
+bool mapped_file_commit(int fd, Buffer *tmpName, const char *fileName,
+                        bool success);
+
+#endif //SEARCHFILEC_MAPPEDFILE_H
@@ -0,0 +1,270 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+#include "mappedhashtable.h"
+#include "hash.h"
+#include "log.h"
+
+// seed used for the bucket hash of every image, changing it changes the
+// format and needs a version bump
+#define HASH_IMAGE_SEED 0x5353434854424cULL
+
+// compute the checksum of image header [header], skipping the checksum field
+static uint64_t hash_image_header_checksum(const HashImageHeader *header) {
+    return hash_bytes(header, offsetof(HashImageHeader, headerChecksum),
+                      HASH_DEFAULT_SEED);
+}
+
+// the smallest power of two which is >= [n] and at least 1
+static uint64_t hash_image_bucket_count(uint64_t n) {
+    uint64_t ret = 1;
+    while(ret < n) ret <<= 1;
+    return ret;
+}
+
+bool hashtable_save(HashTable *ht, const char *fileName) {
+    assert(NULL != ht);
+    assert(NULL != fileName);
+
+    HashTableIterator it;
+    HashValue *hv;
+    size_t n = 0;
+
+    hashtable_iterator_init(&it, ht);
+    while(NULL != hashtable_iterator_next(&it)) ++n;
+
+    const uint64_t bucketCount = hash_image_bucket_count(n);
+
+    HashValue **values = malloc(sizeof(HashValue *) * (n ? n : 1));
+    uint64_t *hashes = malloc(sizeof(uint64_t) * (n ? n : 1));
+    uint64_t *buckets = calloc(bucketCount + 1, sizeof(uint64_t));
+    HashImageEntry *entries = malloc(sizeof(HashImageEntry) * (n ? n : 1));
+
+    bool ok = NULL != values && NULL != hashes && NULL != buckets &&
+              NULL != entries;
+    if(!ok) {
+        log_message("Unable to allocate memory to save %zu entries", n);
+    }
+
+    size_t i = 0;
+    hashtable_iterator_init(&it, ht);
+    while(ok && NULL != (hv = hashtable_iterator_next(&it))) {
+        values[i] = hv;
+        hashes[i] = hash_bytes(hv->key.data, hv->key.len, HASH_IMAGE_SEED);
+        buckets[(hashes[i] & (bucketCount - 1)) + 1]++;
+        ++i;
+    }
+
+    HashImageHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, HASH_IMAGE_MAGIC, sizeof(HASH_IMAGE_MAGIC));
+    header.version = HASH_IMAGE_VERSION;
+    header.headerSize = sizeof(HashImageHeader);
+    header.bucketCount = bucketCount;
+    header.entryCount = n;
+    header.bucketOffset = sizeof(HashImageHeader);
+    header.entryOffset = header.bucketOffset + sizeof(uint64_t) * (bucketCount + 1);
+    header.dataOffset = header.entryOffset + sizeof(HashImageEntry) * n;
+
+    if(ok) {
+        // turn the per bucket counts into bucket start positions and
+        // scatter the entries into bucket order
+        for(uint64_t b = 0; b < bucketCount; ++b) buckets[b + 1] += buckets[b];
+
+        uint64_t *next = malloc(sizeof(uint64_t) * bucketCount);
+        ok = NULL != next;
+        if(ok) {
+            memcpy(next, buckets, sizeof(uint64_t) * bucketCount);
+            for(i = 0; i < n; ++i) {
+                HashImageEntry *e = &entries[next[hashes[i] & (bucketCount - 1)]++];
+                e->hash = hashes[i];
+                e->keyLen = (uint32_t) values[i]->key.len;
+                e->valueLen = (uint32_t) values[i]->data.len;
+                // stash the source index, replaced by the real offset below
+                e->dataOffset = i;
+            }
+            free(next);
+        }
+    }
+
+    uint64_t dataOffset = header.dataOffset;
+    for(i = 0; ok && i < n; ++i) {
+        const size_t src = entries[i].dataOffset;
+        entries[i].dataOffset = dataOffset;
+        dataOffset += entries[i].keyLen + entries[i].valueLen;
+        hashes[i] = src; // reuse as the write order
+    }
+    header.fileSize = dataOffset;
+
+    Buffer tmpName;
+    buffer_init(&tmpName);
+    const int fd = ok ? mapped_file_create(fileName, &tmpName) : -1;
+    ok = ok && -1 != fd;
+
+    HashState checksum;
+    hash_state_init(&checksum, HASH_DEFAULT_SEED);
+
+    ok = ok && mapped_file_write(fd, &header, sizeof(header));
+    ok = ok && mapped_file_write(fd, buckets, sizeof(uint64_t) * (bucketCount + 1));
+    if(ok) hash_state_update(&checksum, buckets, sizeof(uint64_t) * (bucketCount + 1));
+    ok = ok && mapped_file_write(fd, entries, sizeof(HashImageEntry) * n);
+    if(ok) hash_state_update(&checksum, entries, sizeof(HashImageEntry) * n);
+
+    for(i = 0; ok && i < n; ++i) {
+        const HashValue *src = values[hashes[i]];
+        ok = mapped_file_write(fd, src->key.data, src->key.len) &&
+             mapped_file_write(fd, src->data.data, src->data.len);
+        if(ok) {
+            hash_state_update(&checksum, src->key.data, src->key.len);
+            hash_state_update(&checksum, src->data.data, src->data.len);
+        }
+    }
+
+    if(ok) {
+        header.payloadChecksum = hash_state_final(&checksum);
+        header.headerChecksum = hash_image_header_checksum(&header);
+        ok = mapped_file_write_at(fd, &header, sizeof(header), 0);
+    }
+
+    if(-1 != fd) ok = mapped_file_commit(fd, &tmpName, fileName, ok);
+    buffer_free(&tmpName);
+
+    free(values);
+    free(hashes);
+    free(buckets);
+    free(entries);
+
+    if(!ok) log_message("Unable to save hash table image [%s]", fileName);
+    return ok;
+}
+
+void mapped_hashtable_init(MappedHashTable *mht) {
+    assert(NULL != mht);
+    mapped_file_init(&mht->file);
+    mht->header = NULL;
+    mht->buckets = NULL;
+    mht->entries = NULL;
+}
+
+bool hashtable_open_mapped(MappedHashTable *mht, const char *fileName) {
+    assert(NULL != mht);
+    assert(NULL != fileName);
+
+    mapped_hashtable_init(mht);
+
+    if(!mapped_file_open(&mht->file, fileName)) return false;
+
+    const HashImageHeader *h = (const HashImageHeader *) mht->file.data;
+    const size_t len = mht->file.len;
+
+    bool ok = len >= sizeof(HashImageHeader) &&
+              0 == memcmp(h->magic, HASH_IMAGE_MAGIC, sizeof(HASH_IMAGE_MAGIC));
+    if(!ok) {
+        log_message("[%s] is not a hash table image", fileName);
+    } else if(HASH_IMAGE_VERSION != h->version ||
+              sizeof(HashImageHeader) != h->headerSize) {
+        log_message("[%s] is hash table image version %u, expected %u",
+                    fileName, h->version, HASH_IMAGE_VERSION);
+        ok = false;
+    } else if(hash_image_header_checksum(h) != h->headerChecksum) {
+        log_message("[%s] hash table image header is corrupt", fileName);
+        ok = false;
+    } else if(h->fileSize != len || 0 == h->bucketCount ||
+              h->bucketCount >= len / sizeof(uint64_t) ||
+              h->entryCount > len / sizeof(HashImageEntry) ||
+              h->bucketOffset != sizeof(HashImageHeader) ||
+              0 != (h->bucketCount & (h->bucketCount - 1)) ||
+              h->entryOffset != h->bucketOffset +
+                                sizeof(uint64_t) * (h->bucketCount + 1) ||
+              h->dataOffset != h->entryOffset +
+                               sizeof(HashImageEntry) * h->entryCount ||
+              h->dataOffset > len) {
+        log_message("[%s] hash table image is truncated or inconsistent",
+                    fileName);
+        ok = false;
+    }
+
+    if(!ok) {
+        mapped_file_close(&mht->file);
+        return false;
+    }
+
+    mht->header = h;
+    mht->buckets = (const uint64_t *) (mht->file.data + h->bucketOffset);
+    mht->entries = (const HashImageEntry *) (mht->file.data + h->entryOffset);
+    return true;
+}
+
+void mapped_hashtable_close(MappedHashTable *mht) {
+    assert(NULL != mht);
+    mapped_file_close(&mht->file);
+    mapped_hashtable_init(mht);
+}
+
+bool mapped_hashtable_get_view(const MappedHashTable *mht,
+                               const BufferView *key, BufferView *value) {
+    assert(NULL != mht);
+    assert(NULL != key);
+
+    if(NULL == mht->header || NULL == key->data) return false;
+
+    const uint64_t hash = hash_bytes(key->data, key->len, HASH_IMAGE_SEED);
+    const uint64_t b = hash & (mht->header->bucketCount - 1);
+
+    // only the header is checked at open, a corrupt payload must make a
+    // miss rather than a read outside the file
+    const uint64_t first = mht->buckets[b];
+    const uint64_t last = mht->buckets[b + 1];
+    if(first > last || last > mht->header->entryCount) return false;
+
+    const uint64_t fileSize = mht->header->fileSize;
+    for(uint64_t i = first; i < last; ++i) {
+        const HashImageEntry *e = &mht->entries[i];
+        if(e->hash != hash || e->keyLen != key->len) continue;
+        if(e->dataOffset < mht->header->dataOffset ||
+           e->dataOffset > fileSize ||
+           (uint64_t) e->keyLen + e->valueLen > fileSize - e->dataOffset)
+            return false;
+
+        const unsigned char *data = mht->file.data + e->dataOffset;
+        if(0 != memcmp(data, key->data, key->len)) continue;
+
+        if(NULL != value) buffer_view_set(value, data + e->keyLen, e->valueLen);
+        return true;
+    }
+
+    return false;
+}
+
+bool mapped_hashtable_get(const MappedHashTable *mht, const HashKey *key,
+                          BufferView *value) {
+    assert(NULL != key);
+
+    BufferView view;
+    buffer_view_from_buffer(&view, key);
+    return mapped_hashtable_get_view(mht, &view, value);
+}
+
+bool mapped_hashtable_has(const MappedHashTable *mht, const HashKey *key) {
+    return mapped_hashtable_get(mht, key, NULL);
+}
+
+size_t mapped_hashtable_get_entry_count(const MappedHashTable *mht) {
+    assert(NULL != mht);
+    if(NULL == mht->header) return 0;
+    return mht->header->entryCount;
+}
+
+bool mapped_hashtable_verify(const MappedHashTable *mht) {
+    assert(NULL != mht);
+    if(NULL == mht->header) return false;
+
+    const size_t start = mht->header->bucketOffset;
+    const uint64_t sum = hash_bytes(mht->file.data + start,
+                                    mht->file.len - start, HASH_DEFAULT_SEED);
+    return sum == mht->header->payloadChecksum;
+}
@@ -0,0 +1,114 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#ifndef SEARCHFILEC_MAPPEDHASHTABLE_H
+#define SEARCHFILEC_MAPPEDHASHTABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "buffer.h"
+#include "hashtable.h"
+#include "mappedfile.h"
+
+#define HASH_IMAGE_MAGIC "SSCHTBL"
+#define HASH_IMAGE_VERSION 1
+
+/*
+ * A hash table image is a position independent copy of a HashTable which is
+ * queried straight out of a read only mapping of the file, with no parsing
+ * and no allocation.  Every offset is relative to the start of the file.
+ *
+ * [header][bucket starts][entries][key and value bytes]
+ *
+ * Entries are grouped by bucket, bucket i owns entries
+ * buckets[i] .. buckets[i + 1] - 1.  The key of an entry is stored at its
+ * dataOffset and its value immediately after the key.
+*/
+
+typedef struct stHashImageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t bucketCount;
+    uint64_t entryCount;
+    uint64_t bucketOffset;
+    uint64_t entryOffset;
+    uint64_t dataOffset;
+    uint64_t fileSize;
+    uint64_t payloadChecksum;
+    uint64_t headerChecksum;
+} HashImageHeader;
+
+typedef struct stHashImageEntry {
+    uint64_t hash;
+    uint64_t dataOffset;
+    uint32_t keyLen;
+    uint32_t valueLen;
+} HashImageEntry;
+
+typedef struct stMappedHashTable {
+    MappedFile file;
+    const HashImageHeader *header;
+    const uint64_t *buckets;
+    const HashImageEntry *entries;
+} MappedHashTable;
+
+/* write every pair held in hashtable [ht] to an image file [fileName].  The
+ * image is written to a temporary file and renamed into place, so processes
+ * which have the previous image mapped keep a consistent view of it
+ * [ht] - hash table to save
+ * [fileName] - name of the image file
+ * returns true on success
+ */
+bool hashtable_save(HashTable *ht, const char *fileName);
+
+/* initialize a mapped hashtable [mht] so it maps nothing
+ * [mht] - mapped hash table to initialize
+ */
+void mapped_hashtable_init(MappedHashTable *mht);
+
+/* map the image [fileName] written by hashtable_save read only into [mht].
+ * Only the header is validated so opening is O(1), use
+ * mapped_hashtable_verify to check every byte against the stored checksum
+ * [mht] - mapped hash table to populate
+ * [fileName] - name of the image file
+ * returns true on success, false if the file is missing, truncated or is not
+ * an image of a supported version
+ */
+bool hashtable_open_mapped(MappedHashTable *mht, const char *fileName);
+
+/* unmap a mapped hashtable [mht]
+ * [mht] - mapped hash table to close
+ */
+void mapped_hashtable_close(MappedHashTable *mht);
+
+/* look up key [key] in mapped hashtable [mht]
+ * [mht] - mapped hash table to search
+ * [key] - key of data to retrieve
+ * [value] - view which is pointed at the stored value when found, it stays
+ * valid until the table is closed
+ * returns true if the key was found
+ */
+bool mapped_hashtable_get(const MappedHashTable *mht, const HashKey *key,
+                          BufferView *value);
+
+/* the same as mapped_hashtable_get with the key held in view [key] */
+bool mapped_hashtable_get_view(const MappedHashTable *mht,
+                               const BufferView *key, BufferView *value);
+
+/* check mapped hashtable [mht] for key [key]
+ * returns true if the key exists in the table
+ */
+bool mapped_hashtable_has(const MappedHashTable *mht, const HashKey *key);
+
+/* get the number of pairs stored in mapped hashtable [mht] */
+size_t mapped_hashtable_get_entry_count(const MappedHashTable *mht);
+
+/* check every byte of the image mapped by [mht] against its checksum
+ * [mht] - mapped hash table to check
+ * returns true if the image is intact
+ */
+bool mapped_hashtable_verify(const MappedHashTable *mht);
+
+#endif //SEARCHFILEC_MAPPEDHASHTABLE_H
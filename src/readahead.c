@@ -0,0 +1,206 @@
+//
+// Created by Joseph Hurdle on 10/19/26.
+//
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include "readahead.h"
+#include "recycler.h"
+#include "log.h"
+
+/* the two counters and the flags are shared by the threads without the
+ * lock, sequentially consistent so a side setting its waiting flag and then
+ * looking at the counters cannot miss the other side moving them
+ */
+#define READ_AHEAD_LOAD(p) __atomic_load_n(p, __ATOMIC_SEQ_CST)
+#define READ_AHEAD_STORE(p, v) __atomic_store_n(p, v, __ATOMIC_SEQ_CST)
+
+static bool read_ahead_has_room(const ReadAhead *ra) {
+    return READ_AHEAD_LOAD(&ra->stop) ||
+           ra->filled - READ_AHEAD_LOAD(&ra->taken) < ra->depth;
+}
+
+static bool read_ahead_has_block(const ReadAhead *ra) {
+    return READ_AHEAD_LOAD(&ra->filled) != ra->taken;
+}
+
+// sleep until [ready] holds, flagging in [waiting] that this side is asleep
+static void read_ahead_wait(ReadAhead *ra, bool *waiting,
+                            bool (*ready)(const ReadAhead *)) {
+    pthread_mutex_lock(&ra->lock);
+    READ_AHEAD_STORE(waiting, true);
+    while(!ready(ra)) pthread_cond_wait(&ra->wake, &ra->lock);
+    READ_AHEAD_STORE(waiting, false);
+    pthread_mutex_unlock(&ra->lock);
+}
+
+// wake the other side if [waiting] says it is asleep
+static void read_ahead_wake(ReadAhead *ra, bool *waiting) {
+    if(!READ_AHEAD_LOAD(waiting)) return;
+    pthread_mutex_lock(&ra->lock);
+    pthread_cond_broadcast(&ra->wake);
+    pthread_mutex_unlock(&ra->lock);
+}
+
+ssize_t read_ahead_read_at(int fd, void *buf, size_t len, size_t pos,
+                           bool *stream) {
+    assert(NULL != stream);
+    for(;;) {
+        const ssize_t ret = *stream ? read(fd, buf, len) :
+                            pread(fd, buf, len, (off_t) pos);
+        if(ret >= 0) return ret;
+        if(EINTR == errno) continue;
+        if(ESPIPE != errno || *stream || 0 != pos) return ret;
+        *stream = true;
+    }
+}
+
+static void * read_ahead_reader(void *arg) {
+    ReadAhead *ra = (ReadAhead *) arg;
+    size_t pos = ra->start;
+    bool end = pos >= ra->end;
+    int error = 0;
+
+    for(;;) {
+        if(!read_ahead_has_room(ra))
+            read_ahead_wait(ra, &ra->readerWaiting, read_ahead_has_room);
+        if(READ_AHEAD_LOAD(&ra->stop)) break;
+
+        // fill the block, a read of a pipe or a socket can come up short
+        ReadAheadBlock *block = &ra->blocks[ra->filled % ra->depth];
+        block->len = 0;
+        block->error = 0;
+        while(0 == error && !end && block->len < ra->blockSize) {
+            const size_t at = pos + block->len;
+            const size_t room = ra->blockSize - block->len;
+            size_t want = room;
+            if(ra->end - at < want) {
+                want = ra->end - at + READ_AHEAD_ALIGN - 1;
+                want -= want % READ_AHEAD_ALIGN;
+                if(want > room) want = room;
+            }
+            const ssize_t ret = read_ahead_read_at(ra->fd,
+                                                   block->data + block->len,
+                                                   want, at, &ra->stream);
+            READ_AHEAD_STORE(&ra->reads, ra->reads + 1);
+            if(ret > 0) block->len += (size_t) ret;
+            else if(0 == ret) end = true;
+            else error = errno;
+            if(pos + block->len >= ra->end) {
+                block->len = ra->end - pos;
+                end = true;
+            }
+        }
+        pos += block->len;
+
+        // bytes read before the end or an error go over first, then an
+        // empty block marks where the file stopped
+        const bool last = 0 == block->len;
+        if(last) block->error = error;
+
+        READ_AHEAD_STORE(&ra->filled, ra->filled + 1);
+        read_ahead_wake(ra, &ra->takerWaiting);
+        if(last) break;
+    }
+    return NULL;
+}
+
+bool read_ahead_start(ReadAhead *ra, int fd, size_t start, size_t end,
+                      size_t depth, size_t blockSize) {
+    assert(NULL != ra);
+    assert(blockSize > 0);
+
+    if(depth < 2) depth = 2;
+
+    memset(ra, 0, sizeof(ReadAhead));
+    ra->fd = fd;
+    ra->start = start;
+    ra->end = end;
+    ra->depth = depth;
+    ra->blockSize = blockSize;
+    ra->blocks = calloc(depth, sizeof(ReadAheadBlock));
+    if(NULL == ra->blocks) {
+        log_message("Unable to allocate %zu read ahead blocks", depth);
+        return false;
+    }
+    for(size_t i=0; i<depth; ++i) {
+        MemoryChunk mc;
+        if(recycler_get_aligned(NULL, &mc, blockSize, READ_AHEAD_ALIGN))
+            ra->blocks[i].data = mc.p;
+        if(NULL == ra->blocks[i].data) {
+            log_message("Unable to allocate a read ahead block of %zu bytes",
+                        blockSize);
+            read_ahead_stop(ra);
+            return false;
+        }
+    }
+
+    pthread_mutex_init(&ra->lock, NULL);
+    pthread_cond_init(&ra->wake, NULL);
+    if(0 != pthread_create(&ra->thread, NULL, read_ahead_reader, ra)) {
+        log_message("Unable to start read ahead thread");
+        pthread_mutex_destroy(&ra->lock);
+        pthread_cond_destroy(&ra->wake);
+        read_ahead_stop(ra);
+        return false;
+    }
+    ra->running = true;
+    return true;
+}
+
+bool read_ahead_next(ReadAhead *ra, const unsigned char **data, size_t *len) {
+    assert(NULL != ra);
+    assert(NULL != data);
+    assert(NULL != len);
+
+    if(ra->ended) return false;
+
+    if(ra->holding) {
+        ra->holding = false;
+        READ_AHEAD_STORE(&ra->taken, ra->taken + 1);
+        read_ahead_wake(ra, &ra->readerWaiting);
+    }
+
+    if(!read_ahead_has_block(ra))
+        read_ahead_wait(ra, &ra->takerWaiting, read_ahead_has_block);
+
+    const ReadAheadBlock *block = &ra->blocks[ra->taken % ra->depth];
+    if(0 == block->len) {
+        ra->ended = true;
+        ra->error = block->error;
+        return false;
+    }
+
+    ra->holding = true;
+    *data = block->data;
+    *len = block->len;
+    return true;
+}
+
+size_t read_ahead_get_reads(const ReadAhead *ra) {
+    assert(NULL != ra);
+    return READ_AHEAD_LOAD(&ra->reads);
+}
+
+void read_ahead_stop(ReadAhead *ra) {
+    assert(NULL != ra);
+
+    if(ra->running) {
+        READ_AHEAD_STORE(&ra->stop, true);
+        pthread_mutex_lock(&ra->lock);
+        pthread_cond_broadcast(&ra->wake);
+        pthread_mutex_unlock(&ra->lock);
+        pthread_join(ra->thread, NULL);
+        pthread_mutex_destroy(&ra->lock);
+        pthread_cond_destroy(&ra->wake);
+        ra->running = false;
+    }
+
+    if(NULL != ra->blocks) {
+        for(size_t i=0; i<ra->depth; ++i) free(ra->blocks[i].data);
+        free(ra->blocks);
+        ra->blocks = NULL;
+    }
+}
@@ -0,0 +1,96 @@
+//
+// Created by Joseph Hurdle on 10/19/26.
+//
+
+#ifndef SEARCHFILEC_READAHEAD_H
+#define SEARCHFILEC_READAHEAD_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/types.h>
+
+/* ReadAhead
+ * a background thread reading a range of a file descriptor into a ring of
+ * [depth] blocks, so the disk is kept busy while the caller works
+ * on the block it was last handed.  Filled blocks are passed over through a
+ * single producer single consumer queue of two counters, the thread only
+ * sleeps on the lock when the ring is full and the caller only when it is
+ * empty.
+ *
+ * The caller holds one block at a time, read_ahead_next gives the one it
+ * holds back to the thread before handing over the next, so depth - 1
+ * blocks are in flight while it works.
+ */
+
+// every block starts on this boundary so the file can be opened O_DIRECT
+#define READ_AHEAD_ALIGN 4096
+
+// the end of a range running to the end of the file
+#define READ_AHEAD_TO_END ((size_t) -1)
+
+typedef struct stReadAheadBlock {
+    unsigned char *data;
+    size_t len;
+    int error;
+} ReadAheadBlock;
+
+typedef struct stReadAhead {
+    int fd;
+    size_t start;
+    size_t end;
+    bool stream;
+    ReadAheadBlock *blocks;
+    size_t depth;
+    size_t blockSize;
+    size_t filled;
+    size_t taken;
+    size_t reads;
+    bool holding;
+    bool ended;
+    int error;
+    bool stop;
+    bool running;
+    bool readerWaiting;
+    bool takerWaiting;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+} ReadAhead;
+
+/* read up to [len] bytes of [fd] at offset [pos] into [buf] with pread,
+ * retrying when interrupted.  A pipe cannot be read at an offset, from the
+ * start it is read in order with read instead, from then on as [stream]
+ * records
+ * returns the bytes read, 0 at the end of the file, -1 on error with errno
+ */
+ssize_t read_ahead_read_at(int fd, void *buf, size_t len, size_t pos,
+                           bool *stream);
+
+/* start reading bytes [start] up to [end] of [fd] into [depth] blocks of
+ * [blockSize] bytes on a background thread.  Reads are rounded up to a
+ * multiple of READ_AHEAD_ALIGN, and blocks cut back to the range after
+ * [start] - offset of the first byte to read, aligned for O_DIRECT
+ * [end] - offset after the last byte to read, or READ_AHEAD_TO_END
+ * [depth] - blocks in the ring, at least 2
+ * returns false if the blocks cannot be allocated or the thread started
+ */
+bool read_ahead_start(ReadAhead *ra, int fd, size_t start, size_t end,
+                      size_t depth, size_t blockSize);
+
+/* give back the block last handed over and wait for the next one
+ * [data] - set to the bytes of the block, valid until the next call
+ * [len] - set to the number of bytes in the block, short only at the end of
+ *         the file
+ * returns false at the end of the file, or on a read error which is then
+ * left in ra->error
+ */
+bool read_ahead_next(ReadAhead *ra, const unsigned char **data, size_t *len);
+
+// returns the number of read calls the thread has made so far
+size_t read_ahead_get_reads(const ReadAhead *ra);
+
+// stop the thread, without closing the file descriptor, and free the blocks
+void read_ahead_stop(ReadAhead *ra);
+
+#endif //SEARCHFILEC_READAHEAD_H
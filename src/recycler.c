@@ -3,6 +3,7 @@
 //
 
 #include <assert.h>
+#include <stdint.h>
 #include "recycler.h"
 #include "string.h"
 #include "log.h"
@@ -65,14 +66,12 @@ void recycler_return(Recycler *rc, size_t size, void *mem) {
         if(ptr->cap == 0 || NULL == ptr->p) {
             ptr->p = mem;
             ptr->cap = size;
-            mem_chunk_init(mem);
             return;
         }
     }
 
     if(!recycler_expand(rc)) {
         free(mem);
-        mem_chunk_init(mem);
     }
     else return recycler_return(rc, size, mem);
 }
@@ -122,6 +121,34 @@ bool recycler_get(Recycler *rc, MemoryChunk *out, size_t bytes) {
     return true;
 }
 
+bool recycler_get_aligned(Recycler *rc, MemoryChunk *out, size_t bytes,
+                          size_t alignment) {
+
+    assert(NULL != out);
+
+    for(size_t i=0; NULL != rc && i<rc->cap; ++i) {
+
+        MemoryChunk *ptr = &rc->memory[i];
+        if(ptr->cap >= bytes && NULL != ptr->p &&
+           0 == (uintptr_t) ptr->p % alignment) {
+            *out = *ptr;
+            mem_chunk_init(ptr);
+            return true;
+        }
+    }
+
+    const int ret = posix_memalign(&out->p, alignment, bytes);
+    if(0 != ret) {
+        out->p = NULL;
+        log_message("failure allocating %zu bytes aligned to %zu", bytes,
+                    alignment);
+        return false;
+    }
+    out->cap = bytes;
+
+    return true;
+}
+
 void * recycler_get_exact(Recycler *rc, size_t bytes) {
     assert(NULL != rc);
     void * ret = NULL;
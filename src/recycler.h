@@ -44,6 +44,16 @@ void recycler_free(Recycler *rc);
 // returns true on success
 bool recycler_get(Recycler *rc, MemoryChunk *out, size_t bytes);
 
+// get a memory chunk whose address is a multiple of [alignment] out of the
+// recycler, or allocate one with posix_memalign, as needed for O_DIRECT
+// [rc] - recycler to retrieve memory from, NULL to always allocate
+// [out] - memory chunk to populate, its memory can be freed with free
+// [bytes] - number of bytes to allocate
+// [alignment] - power of two at least the size of a pointer
+// returns true on success
+bool recycler_get_aligned(Recycler *rc, MemoryChunk *out, size_t bytes,
+                          size_t alignment);
+
 // get memory out of the recylcer [rc] of exactly [size_t] bytes or, allocate
 // memory using malloc
 // [rc] - recycler to retrieve memory from
@@ -0,0 +1,588 @@
+//
+// Created by Joseph Hurdle on 10/19/26.
+//
+
+#include <assert.h>
+#include <limits.h>
+#include <stddef.h>
+#include <string.h>
+#include "sorteddict.h"
+#include "hash.h"
+#include "log.h"
+
+#if defined(__GNUC__)
+#define SORTED_DICT_PREFETCH(p) __builtin_prefetch(p)
+#else
+#define SORTED_DICT_PREFETCH(p) ((void) 0)
+#endif
+
+// sections start on a cache line so prefetched prefixes share lines
+#define SORTED_DICT_ALIGN 64
+
+/* what a search looks for.  Keys sorting before the target are passed over
+ * and the search stops at the first key which does not, for a prefix search
+ * keys starting with the target are passed over as well.  [prefix] holds
+ * the target's first 8 bytes in the form block prefixes are kept and [mask]
+ * the part of a block prefix which is compared against it
+ */
+typedef struct stSortedDictTarget {
+    const unsigned char *data;
+    size_t len;
+    uint64_t prefix;
+    uint64_t mask;
+    bool prefixSearch;
+} SortedDictTarget;
+
+static uint64_t sorted_dict_header_checksum(const SortedDictHeader *header) {
+    return hash_bytes(header, offsetof(SortedDictHeader, headerChecksum),
+                      HASH_DEFAULT_SEED);
+}
+
+static size_t sorted_dict_align(size_t n) {
+    return (n + SORTED_DICT_ALIGN - 1) & ~(size_t) (SORTED_DICT_ALIGN - 1);
+}
+
+static size_t sorted_dict_varint_len(uint64_t v) {
+    size_t n = 1;
+    while(v >= 0x80) {
+        ++n;
+        v >>= 7;
+    }
+    return n;
+}
+
+static size_t sorted_dict_put_varint(unsigned char *p, uint64_t v) {
+    size_t n = 0;
+    while(v >= 0x80) {
+        p[n++] = (unsigned char) (v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (unsigned char) v;
+    return n;
+}
+
+static const unsigned char *sorted_dict_get_varint(const unsigned char *p,
+                                                   uint64_t *v) {
+    uint64_t r = 0;
+    unsigned shift = 0;
+    while(*p & 0x80) {
+        r |= (uint64_t) (*p++ & 0x7f) << shift;
+        shift += 7;
+    }
+    *v = r | ((uint64_t) *p++ << shift);
+    return p;
+}
+
+// the first 8 bytes at [p] big endian, zero filled past [len]
+static uint64_t sorted_dict_prefix(const unsigned char *p, size_t len) {
+    uint64_t v = 0;
+    for(size_t i=0; i<8; ++i) v = v << 8 | (i < len ? p[i] : 0);
+    return v;
+}
+
+// the first key of block [block], which is stored whole
+static const unsigned char *sorted_dict_first_key(const SortedDict *dict,
+                                                  size_t block, size_t *len) {
+    uint64_t shared, n;
+    const unsigned char *p = dict->keys + dict->offsets[block];
+    p = sorted_dict_get_varint(p, &shared);
+    p = sorted_dict_get_varint(p, &n);
+    *len = (size_t) n;
+    return p;
+}
+
+// point the section pointers of [dict] at the image starting at [data]
+static void sorted_dict_attach(SortedDict *dict, const unsigned char *data) {
+    const SortedDictHeader *h = (const SortedDictHeader *) data;
+    dict->data = data;
+    dict->header = h;
+    dict->prefixes = (const uint64_t *) (data + h->prefixOffset);
+    dict->ids = (const uint32_t *) (data + h->idOffset);
+    dict->offsets = (const uint64_t *) (data + h->blockOffset);
+    dict->keys = data + h->keyOffset;
+}
+
+static void sorted_dict_target(SortedDictTarget *t, const BufferView *key,
+                               bool prefixSearch) {
+    t->data = key->data;
+    t->len = key->len;
+    t->prefix = sorted_dict_prefix(key->data, key->len);
+    t->prefixSearch = prefixSearch;
+    // a prefix search ignores the bytes of a key past the end of the target
+    t->mask = ~(uint64_t) 0;
+    if(prefixSearch && key->len < 8)
+        t->mask = 0 == key->len ? 0 : t->mask << (8 * (8 - key->len));
+}
+
+// true when the [len] byte [key] is passed over by a search for [t]
+static bool sorted_dict_before(const SortedDictTarget *t,
+                               const unsigned char *key, size_t len) {
+    const size_t n = len < t->len ? len : t->len;
+    const int c = 0 == n ? 0 : memcmp(key, t->data, n);
+    if(0 != c) return c < 0;
+    if(len < t->len) return true;
+    return t->prefixSearch;
+}
+
+// true when the first key of the block at Eytzinger entry [k] is passed over
+static bool sorted_dict_entry_before(const SortedDict *dict,
+                                     const SortedDictTarget *t, size_t k) {
+    const uint64_t prefix = dict->prefixes[k] & t->mask;
+    if(prefix != t->prefix) return prefix < t->prefix;
+
+    size_t len;
+    const unsigned char *key = sorted_dict_first_key(dict, dict->ids[k], &len);
+    return sorted_dict_before(t, key, len);
+}
+
+// returns the rank of block [block]'s first key, where a search for [t]
+// stopped, setting [equal] when that key is the target itself
+static size_t sorted_dict_stop(const SortedDict *dict, const SortedDictTarget *t,
+                               size_t block, bool *equal) {
+    const SortedDictHeader *h = dict->header;
+    if(!t->prefixSearch && block < h->blockCount) {
+        size_t len;
+        const unsigned char *key = sorted_dict_first_key(dict, block, &len);
+        *equal = len == t->len && (0 == len || 0 == memcmp(key, t->data, len));
+    }
+    const size_t rank = block * (size_t) h->blockKeys;
+    return rank < h->entryCount ? rank : (size_t) h->entryCount;
+}
+
+/* returns the rank of the first key which search [t] does not pass over,
+ * setting [equal] when that key is the target itself
+ */
+static size_t sorted_dict_search(const SortedDict *dict,
+                                 const SortedDictTarget *t, bool *equal) {
+    *equal = false;
+    const SortedDictHeader *h = dict->header;
+    if(NULL == h || 0 == h->entryCount) return 0;
+
+    // descend the Eytzinger tree, left when a block's first key is not
+    // passed over.  The index reached records every turn taken
+    const size_t blocks = (size_t) h->blockCount;
+    size_t k = 1;
+    while(k <= blocks) {
+        SORTED_DICT_PREFETCH(dict->prefixes + 8 * k);
+        k = 2 * k + sorted_dict_entry_before(dict, t, k);
+    }
+
+    // dropping the right turns after the last left turn, and that turn,
+    // leaves the entry where it was taken, the first block not passed over
+#if defined(__GNUC__)
+    k >>= __builtin_ctzll(~(unsigned long long) k) + 1;
+#else
+    while(k & 1) k >>= 1;
+    k >>= 1;
+#endif
+    const size_t first = 0 == k ? blocks : (size_t) dict->ids[k];
+    if(0 == first) return sorted_dict_stop(dict, t, 0, equal);
+
+    // walk the block before it.  [match] is how many bytes the last key
+    // passed over shares with the target, a key sharing more with that key
+    // sorts the same way and one sharing less has a larger byte where the
+    // target's begins to differ
+    const size_t block = first - 1;
+    const size_t base = block * (size_t) h->blockKeys;
+    size_t count = (size_t) h->entryCount - base;
+    if(count > h->blockKeys) count = (size_t) h->blockKeys;
+
+    const unsigned char *p = dict->keys + dict->offsets[block];
+    size_t match = 0;
+    for(size_t i=0; i<count; ++i) {
+        uint64_t shared, len;
+        p = sorted_dict_get_varint(p, &shared);
+        p = sorted_dict_get_varint(p, &len);
+        const unsigned char *suffix = p;
+        p += len;
+
+        if(shared > match) continue;
+        if(shared < match) return base + i;
+
+        const size_t rest = t->len - match;
+        const size_t n = len < rest ? (size_t) len : rest;
+        size_t j = 0;
+        while(j < n && suffix[j] == t->data[match + j]) ++j;
+        if(j < n) {
+            if(suffix[j] > t->data[match + j]) return base + i;
+        } else if(j == rest && !t->prefixSearch) {
+            *equal = j == len;
+            return base + i;
+        }
+        match += j;
+    }
+    return sorted_dict_stop(dict, t, first, equal);
+}
+
+void sorted_dict_init(SortedDict *dict) {
+    assert(NULL != dict);
+    buffer_init(&dict->image);
+    mapped_file_init(&dict->file);
+    dict->data = NULL;
+    dict->header = NULL;
+    dict->prefixes = NULL;
+    dict->ids = NULL;
+    dict->offsets = NULL;
+    dict->keys = NULL;
+}
+
+// lay the block prefixes out in Eytzinger order by an in order walk of the
+// implicit tree, returning the next block to place
+static size_t sorted_dict_fill(const SortedDict *dict, uint64_t *prefixes,
+                               uint32_t *ids, size_t k, size_t block,
+                               size_t blocks) {
+    if(k > blocks) return block;
+    block = sorted_dict_fill(dict, prefixes, ids, 2 * k, block, blocks);
+    size_t len;
+    const unsigned char *key = sorted_dict_first_key(dict, block, &len);
+    prefixes[k] = sorted_dict_prefix(key, len);
+    ids[k] = (uint32_t) block;
+    return sorted_dict_fill(dict, prefixes, ids, 2 * k + 1, block + 1, blocks);
+}
+
+bool sorted_dict_build(SortedDict *dict, BufferArray *keys) {
+    assert(NULL != dict);
+    assert(NULL != keys);
+
+    sorted_dict_init(dict);
+    buffer_assign_recycler(&dict->image, keys->recycler);
+
+    const size_t n = buffer_array_get_buffer_count(keys);
+    const size_t blockKeys = SORTED_DICT_BLOCK_KEYS;
+
+    // size the blocks, checking the order on the way
+    const unsigned char *prev = NULL;
+    size_t prevLen = 0;
+    size_t maxLen = 0;
+    size_t keyBytes = 0;
+    for(size_t i=0; i<n; ++i) {
+        const Buffer *b = buffer_array_get_buffer(keys, i);
+        const unsigned char *key = b->data;
+        const size_t len = NULL == key ? 0 : b->len;
+
+        size_t p = 0;
+        const size_t shorter = len < prevLen ? len : prevLen;
+        while(p < shorter && prev[p] == key[p]) ++p;
+
+        if(i > 0 && (p == len || (p < shorter && prev[p] > key[p]))) {
+            log_message("Dictionary key %zu is out of order or repeated", i);
+            return false;
+        }
+
+        if(0 == i % blockKeys) p = 0;
+        keyBytes += sorted_dict_varint_len(p) + sorted_dict_varint_len(len - p) +
+                    len - p;
+        if(len > maxLen) maxLen = len;
+        prev = key;
+        prevLen = len;
+    }
+
+    const size_t blocks = (n + blockKeys - 1) / blockKeys;
+    const size_t prefixOffset = sorted_dict_align(sizeof(SortedDictHeader));
+    const size_t idOffset = prefixOffset + (blocks + 1) * sizeof(uint64_t);
+    const size_t blockOffset = sorted_dict_align(idOffset +
+                                                 (blocks + 1) * sizeof(uint32_t));
+    const size_t keyOffset = blockOffset + (blocks + 1) * sizeof(uint64_t);
+    const size_t fileSize = keyOffset + keyBytes;
+
+    if(blocks > UINT32_MAX || fileSize > UINT_MAX) {
+        log_message("Dictionary of %zu keys is too large", n);
+        return false;
+    }
+    if(!buffer_reserve(&dict->image, (unsigned int) fileSize)) {
+        log_message("Unable to allocate a %zu byte dictionary", fileSize);
+        return false;
+    }
+    unsigned char *data = dict->image.data;
+    memset(data, 0, keyOffset);
+    dict->image.len = fileSize;
+
+    SortedDictHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SORTED_DICT_MAGIC, sizeof(SORTED_DICT_MAGIC));
+    header.version = SORTED_DICT_VERSION;
+    header.headerSize = sizeof(SortedDictHeader);
+    header.entryCount = n;
+    header.blockCount = blocks;
+    header.blockKeys = blockKeys;
+    header.maxKeyLen = maxLen;
+    header.prefixOffset = prefixOffset;
+    header.idOffset = idOffset;
+    header.blockOffset = blockOffset;
+    header.keyOffset = keyOffset;
+    header.fileSize = fileSize;
+
+    // front code the keys, each block starting with a whole key
+    uint64_t *offsets = (uint64_t *) (data + blockOffset);
+    unsigned char *out = data + keyOffset;
+    prev = NULL;
+    prevLen = 0;
+    for(size_t i=0; i<n; ++i) {
+        const Buffer *b = buffer_array_get_buffer(keys, i);
+        const unsigned char *key = b->data;
+        const size_t len = NULL == key ? 0 : b->len;
+
+        size_t p = 0;
+        if(0 == i % blockKeys) {
+            offsets[i / blockKeys] = (uint64_t) (out - (data + keyOffset));
+        } else {
+            const size_t shorter = len < prevLen ? len : prevLen;
+            while(p < shorter && prev[p] == key[p]) ++p;
+        }
+        out += sorted_dict_put_varint(out, p);
+        out += sorted_dict_put_varint(out, len - p);
+        if(len > p) memcpy(out, key + p, len - p);
+        out += len - p;
+        prev = key;
+        prevLen = len;
+    }
+    offsets[blocks] = keyBytes;
+
+    memcpy(data, &header, sizeof(header));
+    sorted_dict_attach(dict, data);
+    sorted_dict_fill(dict, (uint64_t *) (data + prefixOffset),
+                     (uint32_t *) (data + idOffset), 1, 0, blocks);
+
+    header.payloadChecksum = hash_bytes(data + sizeof(SortedDictHeader),
+                                        fileSize - sizeof(SortedDictHeader),
+                                        HASH_DEFAULT_SEED);
+    header.headerChecksum = sorted_dict_header_checksum(&header);
+    memcpy(data, &header, sizeof(header));
+    return true;
+}
+
+void sorted_dict_free(SortedDict *dict) {
+    assert(NULL != dict);
+    Recycler *r = dict->image.recycler;
+    buffer_free(&dict->image);
+    mapped_file_close(&dict->file);
+    sorted_dict_init(dict);
+    buffer_assign_recycler(&dict->image, r);
+}
+
+bool sorted_dict_get_view(const SortedDict *dict, const BufferView *key,
+                          size_t *rank) {
+    assert(NULL != dict);
+    assert(NULL != key);
+
+    SortedDictTarget t;
+    sorted_dict_target(&t, key, false);
+    bool equal;
+    const size_t r = sorted_dict_search(dict, &t, &equal);
+    if(equal && NULL != rank) *rank = r;
+    return equal;
+}
+
+bool sorted_dict_get(const SortedDict *dict, const Buffer *key, size_t *rank) {
+    assert(NULL != key);
+
+    BufferView view;
+    buffer_view_from_buffer(&view, key);
+    return sorted_dict_get_view(dict, &view, rank);
+}
+
+size_t sorted_dict_lower_bound(const SortedDict *dict, const BufferView *key) {
+    assert(NULL != dict);
+    assert(NULL != key);
+
+    SortedDictTarget t;
+    sorted_dict_target(&t, key, false);
+    bool equal;
+    return sorted_dict_search(dict, &t, &equal);
+}
+
+bool sorted_dict_prefix_range(const SortedDict *dict, const BufferView *prefix,
+                              size_t *begin, size_t *end) {
+    assert(NULL != dict);
+    assert(NULL != prefix);
+    assert(NULL != begin);
+    assert(NULL != end);
+
+    SortedDictTarget t;
+    bool equal;
+    sorted_dict_target(&t, prefix, false);
+    *begin = sorted_dict_search(dict, &t, &equal);
+    sorted_dict_target(&t, prefix, true);
+    *end = sorted_dict_search(dict, &t, &equal);
+    return *end > *begin;
+}
+
+bool sorted_dict_select(const SortedDict *dict, size_t rank, Buffer *key) {
+    assert(NULL != dict);
+    assert(NULL != key);
+
+    const SortedDictHeader *h = dict->header;
+    if(NULL == h || rank >= h->entryCount) return false;
+    if(!buffer_reserve(key, (unsigned int) h->maxKeyLen + 1)) return false;
+
+    const size_t block = rank / (size_t) h->blockKeys;
+    const unsigned char *p = dict->keys + dict->offsets[block];
+    for(size_t i=block * (size_t) h->blockKeys; i<=rank; ++i) {
+        uint64_t shared, len;
+        p = sorted_dict_get_varint(p, &shared);
+        p = sorted_dict_get_varint(p, &len);
+        memcpy(key->data + shared, p, len);
+        key->len = (size_t) (shared + len);
+        p += len;
+    }
+    key->nullTerminated = false;
+    return true;
+}
+
+size_t sorted_dict_get_entry_count(const SortedDict *dict) {
+    assert(NULL != dict);
+    if(NULL == dict->header) return 0;
+    return dict->header->entryCount;
+}
+
+size_t sorted_dict_get_memory(const SortedDict *dict) {
+    assert(NULL != dict);
+    if(NULL == dict->header) return 0;
+    return dict->header->fileSize;
+}
+
+bool sorted_dict_save(const SortedDict *dict, const char *fileName) {
+    assert(NULL != dict);
+    assert(NULL != fileName);
+
+    if(NULL == dict->header) {
+        log_message("Unable to save an empty dictionary");
+        return false;
+    }
+
+    Buffer tmpName;
+    buffer_init(&tmpName);
+    const int fd = mapped_file_create(fileName, &tmpName);
+    if(-1 == fd) return false;
+
+    const bool ok = mapped_file_write(fd, dict->data, dict->header->fileSize);
+    return mapped_file_commit(fd, &tmpName, fileName, ok);
+}
+
+bool sorted_dict_open_mapped(SortedDict *dict, const char *fileName) {
+    assert(NULL != dict);
+    assert(NULL != fileName);
+
+    sorted_dict_init(dict);
+    if(!mapped_file_open(&dict->file, fileName)) return false;
+
+    const SortedDictHeader *h = (const SortedDictHeader *) dict->file.data;
+    const size_t len = dict->file.len;
+    bool ok = len >= sizeof(SortedDictHeader) &&
+              0 == memcmp(h->magic, SORTED_DICT_MAGIC, sizeof(SORTED_DICT_MAGIC));
+
+    if(!ok) {
+        log_message("[%s] is not a sorted dictionary", fileName);
+    } else if(SORTED_DICT_VERSION != h->version ||
+              sizeof(SortedDictHeader) != h->headerSize) {
+        log_message("[%s] is sorted dictionary version %u, expected %u",
+                    fileName, h->version, SORTED_DICT_VERSION);
+        ok = false;
+    } else if(sorted_dict_header_checksum(h) != h->headerChecksum) {
+        log_message("[%s] sorted dictionary header is corrupt", fileName);
+        ok = false;
+    } else if(h->fileSize != len || 0 == h->blockKeys ||
+              h->blockCount != (h->entryCount + h->blockKeys - 1) / h->blockKeys ||
+              h->prefixOffset != sorted_dict_align(sizeof(SortedDictHeader)) ||
+              h->idOffset != h->prefixOffset + (h->blockCount + 1) * sizeof(uint64_t) ||
+              h->blockOffset != sorted_dict_align(h->idOffset +
+                                                  (h->blockCount + 1) * sizeof(uint32_t)) ||
+              h->keyOffset != h->blockOffset + (h->blockCount + 1) * sizeof(uint64_t) ||
+              h->keyOffset > len ||
+              ((const uint64_t *) (dict->file.data + h->blockOffset))[h->blockCount] !=
+              len - h->keyOffset) {
+        log_message("[%s] sorted dictionary is truncated or inconsistent",
+                    fileName);
+        ok = false;
+    }
+
+    if(!ok) {
+        mapped_file_close(&dict->file);
+        return false;
+    }
+
+    sorted_dict_attach(dict, dict->file.data);
+    return true;
+}
+
+bool sorted_dict_verify(const SortedDict *dict) {
+    assert(NULL != dict);
+    const SortedDictHeader *h = dict->header;
+    if(NULL == h) return false;
+
+    return h->payloadChecksum == hash_bytes(dict->data + sizeof(SortedDictHeader),
+                                            h->fileSize - sizeof(SortedDictHeader),
+                                            HASH_DEFAULT_SEED);
+}
+
+void sorted_dict_iterator_init(SortedDictIterator *it, const SortedDict *dict) {
+    assert(NULL != it);
+    assert(NULL != dict);
+
+    it->dict = dict;
+    it->rank = 0;
+    it->end = 0;
+    it->next = NULL;
+    buffer_init(&it->key);
+    sorted_dict_iterator_seek(it, 0, SIZE_MAX);
+}
+
+bool sorted_dict_iterator_seek(SortedDictIterator *it, size_t begin,
+                               size_t end) {
+    assert(NULL != it);
+
+    const SortedDictHeader *h = it->dict->header;
+    const size_t count = NULL == h ? 0 : (size_t) h->entryCount;
+    it->rank = begin < count ? begin : count;
+    it->end = end < count ? end : count;
+    it->next = NULL;
+    buffer_clear(&it->key);
+    if(it->rank >= it->end) return true;
+
+    if(!buffer_reserve(&it->key, (unsigned int) h->maxKeyLen + 1)) {
+        log_message("Unable to allocate an iterator for %zu byte keys",
+                    (size_t) h->maxKeyLen);
+        it->end = it->rank;
+        return false;
+    }
+
+    // rebuild the keys of the block ahead of [begin], which it is coded from
+    const size_t block = it->rank / (size_t) h->blockKeys;
+    const unsigned char *p = it->dict->keys + it->dict->offsets[block];
+    for(size_t i=block * (size_t) h->blockKeys; i<it->rank; ++i) {
+        uint64_t shared, len;
+        p = sorted_dict_get_varint(p, &shared);
+        p = sorted_dict_get_varint(p, &len);
+        memcpy(it->key.data + shared, p, len);
+        it->key.len = (size_t) (shared + len);
+        p += len;
+    }
+    it->next = p;
+    return true;
+}
+
+bool sorted_dict_iterator_next(SortedDictIterator *it, BufferView *key,
+                               size_t *rank) {
+    assert(NULL != it);
+    assert(NULL != key);
+
+    if(it->rank >= it->end) return false;
+
+    // blocks follow one another, so the walk reads straight on
+    uint64_t shared, len;
+    const unsigned char *p = sorted_dict_get_varint(it->next, &shared);
+    p = sorted_dict_get_varint(p, &len);
+    memcpy(it->key.data + shared, p, len);
+    it->key.len = (size_t) (shared + len);
+    it->next = p + len;
+
+    buffer_view_set(key, it->key.data, it->key.len);
+    if(NULL != rank) *rank = it->rank;
+    ++it->rank;
+    return true;
+}
+
+void sorted_dict_iterator_free(SortedDictIterator *it) {
+    assert(NULL != it);
+    buffer_free(&it->key);
+}
@@ -0,0 +1,190 @@
+//
+// Created by Joseph Hurdle on 10/19/26.
+//
+
+#ifndef SEARCHFILEC_SORTEDDICT_H
+#define SEARCHFILEC_SORTEDDICT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "buffer.h"
+#include "bufferarray.h"
+#include "mappedfile.h"
+
+#define SORTED_DICT_MAGIC "SSCSDC1"
+#define SORTED_DICT_VERSION 1
+
+// number of keys front coded together in a block
+#define SORTED_DICT_BLOCK_KEYS 16
+
+/*
+ * SortedDict
+ * an immutable sorted set of byte string keys, numbered 0 up in byte order
+ * (see buffer_cmp_bytes).  A key's number is its rank, so the dictionary maps
+ * keys to dense ids and back, finds the first key not less than any other,
+ * and gives the run of keys starting with a prefix as a range of ranks.
+ *
+ * Keys are front coded in blocks of SORTED_DICT_BLOCK_KEYS, each key after
+ * the first in a block stored as the number of bytes it shares with the key
+ * before it and the bytes which follow, so sorted words cost little more
+ * than their differences.  A lookup finds its block by searching the first
+ * keys of all blocks, then walks at most one block.
+ *
+ * The block search runs over the first 8 bytes of each block's first key in
+ * Eytzinger (breadth first) order: the children of entry k are entries 2k
+ * and 2k + 1, so each step is one comparison choosing the next index rather
+ * than a branch, and the 8 entries three levels down share a cache line
+ * which is prefetched ahead.
+ *
+ * The dictionary is a single contiguous, position independent image
+ *
+ * [header][prefixes][block ids][block offsets][blocks]
+ *
+ *   prefixes       uint64 per block in Eytzinger order, entry 0 unused
+ *   block ids      uint32 block number of each Eytzinger entry
+ *   block offsets  uint64 start of each block, plus the end of the last
+ *   blocks         per key a varint shared byte count, a varint suffix
+ *                  length and the suffix bytes
+ *
+ * so it is saved by writing it out and may be used straight from a read only
+ * mapping.
+*/
+
+typedef struct stSortedDictHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t entryCount;
+    uint64_t blockCount;
+    uint64_t blockKeys;
+    uint64_t maxKeyLen;
+    uint64_t prefixOffset;
+    uint64_t idOffset;
+    uint64_t blockOffset;
+    uint64_t keyOffset;
+    uint64_t fileSize;
+    uint64_t payloadChecksum;
+    uint64_t headerChecksum;
+} SortedDictHeader;
+
+typedef struct stSortedDict {
+    Buffer image;
+    MappedFile file;
+    const unsigned char *data;
+    const SortedDictHeader *header;
+    const uint64_t *prefixes;
+    const uint32_t *ids;
+    const uint64_t *offsets;
+    const unsigned char *keys;
+} SortedDict;
+
+/* SortedDictIterator
+ * walks the keys of a dictionary in order over a range of ranks
+ */
+
+typedef struct stSortedDictIterator {
+    const SortedDict *dict;
+    Buffer key;
+    size_t rank;
+    size_t end;
+    const unsigned char *next;
+} SortedDictIterator;
+
+/* initialize a dictionary [dict] so that it holds nothing
+ * [dict] - dictionary to initialize
+ */
+void sorted_dict_init(SortedDict *dict);
+
+/* build a dictionary [dict] of the keys held in [keys], which must be sorted
+ * in byte order (see buffer_cmp_bytes) with no key given twice.  The image is
+ * allocated using the recycler of [keys]
+ * [dict] - dictionary to populate
+ * [keys] - sorted keys
+ * returns true on success, false when the keys are out of order or memory is
+ * exhausted
+ */
+bool sorted_dict_build(SortedDict *dict, BufferArray *keys);
+
+/* free any memory held by or unmap dictionary [dict] */
+void sorted_dict_free(SortedDict *dict);
+
+/* look up key [key] in dictionary [dict]
+ * [dict] - dictionary to search
+ * [key] - key to look for
+ * [rank] - receives the key's rank when found, may be NULL
+ * returns true if the key was found
+ */
+bool sorted_dict_get(const SortedDict *dict, const Buffer *key, size_t *rank);
+
+/* the same as sorted_dict_get with the key held in view [key] */
+bool sorted_dict_get_view(const SortedDict *dict, const BufferView *key,
+                          size_t *rank);
+
+/* returns the rank of the first key in dictionary [dict] which is not less
+ * than [key], the number of keys when every key is less
+ */
+size_t sorted_dict_lower_bound(const SortedDict *dict, const BufferView *key);
+
+/* find the keys of dictionary [dict] starting with [prefix]
+ * [begin] - receives the rank of the first such key
+ * [end] - receives the rank after the last such key
+ * returns true if any key starts with prefix
+ */
+bool sorted_dict_prefix_range(const SortedDict *dict, const BufferView *prefix,
+                              size_t *begin, size_t *end);
+
+/* copy the key of rank [rank] in dictionary [dict] into [key]
+ * returns false when there is no such rank or memory is exhausted
+ */
+bool sorted_dict_select(const SortedDict *dict, size_t rank, Buffer *key);
+
+/* get the number of keys held in dictionary [dict] */
+size_t sorted_dict_get_entry_count(const SortedDict *dict);
+
+/* get the total number of bytes used by dictionary [dict] */
+size_t sorted_dict_get_memory(const SortedDict *dict);
+
+/* write dictionary [dict] to file [fileName]
+ * returns true on success
+ */
+bool sorted_dict_save(const SortedDict *dict, const char *fileName);
+
+/* map a dictionary saved to [fileName] read only into [dict], only the
+ * header and section bounds are validated so this is O(1)
+ * returns true on success
+ */
+bool sorted_dict_open_mapped(SortedDict *dict, const char *fileName);
+
+/* check every byte of dictionary [dict] against its checksum
+ * returns true if the dictionary is intact
+ */
+bool sorted_dict_verify(const SortedDict *dict);
+
+/* prepare iterator [it] to walk every key of dictionary [dict] in order
+ * [it] - iterator to initialize
+ * [dict] - dictionary to walk
+ */
+void sorted_dict_iterator_init(SortedDictIterator *it, const SortedDict *dict);
+
+/* restrict iterator [it] to the keys with ranks from [begin] up to but not
+ * including [end], as given by sorted_dict_prefix_range.  Ranks past the
+ * last key are ignored
+ * returns false on memory exhaustion
+ */
+bool sorted_dict_iterator_seek(SortedDictIterator *it, size_t begin,
+                               size_t end);
+
+/* advance iterator [it] to the next key
+ * [it] - iterator to advance
+ * [key] - view set to the key, valid until the iterator next moves
+ * [rank] - receives the key's rank, may be NULL
+ * returns false once every key has been visited or memory is exhausted
+ */
+bool sorted_dict_iterator_next(SortedDictIterator *it, BufferView *key,
+                               size_t *rank);
+
+/* free memory held by iterator [it] */
+void sorted_dict_iterator_free(SortedDictIterator *it);
+
+#endif //SEARCHFILEC_SORTEDDICT_H
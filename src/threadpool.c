@@ -0,0 +1,181 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+#include "threadpool.h"
+#include "log.h"
+
+#define THREAD_POOL_MIN_QUEUE 64
+
+static void * threadpool_worker(void *arg) {
+    ThreadPool *tp = (ThreadPool *) arg;
+
+    pthread_mutex_lock(&tp->lock);
+    for(;;) {
+        while(0 == tp->queued && !tp->stop)
+            pthread_cond_wait(&tp->work, &tp->lock);
+        if(0 == tp->queued && tp->stop) break;
+
+        ThreadPoolTask task = tp->queue[tp->head];
+        tp->head = (tp->head + 1) % tp->queueCap;
+        tp->queued--;
+        tp->running++;
+        pthread_mutex_unlock(&tp->lock);
+
+        task.fn(task.arg);
+
+        pthread_mutex_lock(&tp->lock);
+        tp->running--;
+        if(0 == tp->queued && 0 == tp->running)
+            pthread_cond_broadcast(&tp->done);
+    }
+    pthread_mutex_unlock(&tp->lock);
+    return NULL;
+}
+
+size_t threadpool_cpu_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (size_t) n : 1;
+}
+
+bool threadpool_init(ThreadPool *tp, size_t threads) {
+    assert(NULL != tp);
+
+    if(0 == threads) threads = threadpool_cpu_count();
+
+    memset(tp, 0, sizeof(ThreadPool));
+    tp->threads = malloc(sizeof(pthread_t) * threads);
+    tp->queue = malloc(sizeof(ThreadPoolTask) * THREAD_POOL_MIN_QUEUE);
+    if(NULL == tp->threads || NULL == tp->queue) {
+        log_message("Unable to allocate a thread pool of %zu threads", threads);
+        free(tp->threads);
+        free(tp->queue);
+        return false;
+    }
+    tp->queueCap = THREAD_POOL_MIN_QUEUE;
+
+    pthread_mutex_init(&tp->lock, NULL);
+    pthread_cond_init(&tp->work, NULL);
+    pthread_cond_init(&tp->done, NULL);
+
+    for(size_t i=0; i<threads; ++i) {
+        if(0 != pthread_create(&tp->threads[i], NULL, threadpool_worker, tp)) {
+            log_message("Unable to start thread pool worker %zu", i);
+            threadpool_free(tp);
+            return false;
+        }
+        tp->threadCount++;
+    }
+    return true;
+}
+
+size_t threadpool_get_thread_count(const ThreadPool *tp) {
+    assert(NULL != tp);
+    return tp->threadCount;
+}
+
+bool threadpool_submit(ThreadPool *tp, ThreadPoolFn fn, void *arg) {
+    assert(NULL != tp);
+    assert(NULL != fn);
+
+    pthread_mutex_lock(&tp->lock);
+
+    if(tp->queued == tp->queueCap) {
+        const size_t cap = tp->queueCap * 2;
+        ThreadPoolTask *queue = malloc(sizeof(ThreadPoolTask) * cap);
+        if(NULL == queue) {
+            pthread_mutex_unlock(&tp->lock);
+            log_message("Unable to grow thread pool queue to %zu tasks", cap);
+            return false;
+        }
+        for(size_t i=0; i<tp->queued; ++i)
+            queue[i] = tp->queue[(tp->head + i) % tp->queueCap];
+        free(tp->queue);
+        tp->queue = queue;
+        tp->queueCap = cap;
+        tp->head = 0;
+    }
+
+    ThreadPoolTask *task = &tp->queue[(tp->head + tp->queued) % tp->queueCap];
+    task->fn = fn;
+    task->arg = arg;
+    tp->queued++;
+
+    pthread_cond_signal(&tp->work);
+    pthread_mutex_unlock(&tp->lock);
+    return true;
+}
+
+void threadpool_wait(ThreadPool *tp) {
+    assert(NULL != tp);
+    pthread_mutex_lock(&tp->lock);
+    while(0 != tp->queued || 0 != tp->running)
+        pthread_cond_wait(&tp->done, &tp->lock);
+    pthread_mutex_unlock(&tp->lock);
+}
+
+typedef struct stThreadPoolRangeTask {
+    ThreadPoolRangeFn fn;
+    void *ctx;
+    size_t task;
+} ThreadPoolRangeTask;
+
+static void threadpool_range_task(void *arg) {
+    ThreadPoolRangeTask *t = (ThreadPoolRangeTask *) arg;
+    t->fn(t->ctx, t->task);
+}
+
+bool threadpool_run(ThreadPool *tp, size_t tasks, ThreadPoolRangeFn fn,
+                    void *ctx) {
+    assert(NULL != fn);
+
+    if(NULL == tp || tasks <= 1) {
+        for(size_t i=0; i<tasks; ++i) fn(ctx, i);
+        return true;
+    }
+
+    ThreadPoolRangeTask *args = malloc(sizeof(ThreadPoolRangeTask) * tasks);
+    if(NULL == args) {
+        log_message("Unable to allocate %zu thread pool tasks", tasks);
+        return false;
+    }
+
+    size_t submitted = 0;
+    for(; submitted<tasks; ++submitted) {
+        args[submitted].fn = fn;
+        args[submitted].ctx = ctx;
+        args[submitted].task = submitted;
+        if(!threadpool_submit(tp, threadpool_range_task, &args[submitted]))
+            break;
+    }
+
+    // anything which could not be queued runs here
+    for(size_t i=submitted; i<tasks; ++i) fn(ctx, i);
+
+    threadpool_wait(tp);
+    free(args);
+    return true;
+}
+
+void threadpool_free(ThreadPool *tp) {
+    assert(NULL != tp);
+
+    pthread_mutex_lock(&tp->lock);
+    tp->stop = true;
+    pthread_cond_broadcast(&tp->work);
+    pthread_mutex_unlock(&tp->lock);
+
+    for(size_t i=0; i<tp->threadCount; ++i) pthread_join(tp->threads[i], NULL);
+
+    pthread_mutex_destroy(&tp->lock);
+    pthread_cond_destroy(&tp->work);
+    pthread_cond_destroy(&tp->done);
+    free(tp->threads);
+    free(tp->queue);
+    tp->threads = NULL;
+    tp->queue = NULL;
+    tp->threadCount = 0;
+}
@@ -0,0 +1,71 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#ifndef SEARCHFILEC_THREADPOOL_H
+#define SEARCHFILEC_THREADPOOL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+/* ThreadPool
+ * a fixed set of worker threads pulling tasks off one shared queue.  Tasks
+ * are a function and an argument, threadpool_wait blocks until every task
+ * submitted so far has finished.  A task must not wait on the pool it runs
+ * in.
+ */
+
+typedef void (*ThreadPoolFn)(void *arg);
+
+// runs task [task] of a threadpool_run batch, [ctx] is shared by all tasks
+typedef void (*ThreadPoolRangeFn)(void *ctx, size_t task);
+
+typedef struct stThreadPoolTask {
+    ThreadPoolFn fn;
+    void *arg;
+} ThreadPoolTask;
+
+typedef struct stThreadPool {
+    pthread_t *threads;
+    size_t threadCount;
+    ThreadPoolTask *queue;
+    size_t queueCap;
+    size_t head;
+    size_t queued;
+    size_t running;
+    bool stop;
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t done;
+} ThreadPool;
+
+// returns the number of processors online, at least 1
+size_t threadpool_cpu_count(void);
+
+/* start thread pool [tp] with [threads] workers, 0 meaning one per online
+ * processor
+ * returns false if the workers cannot be started
+ */
+bool threadpool_init(ThreadPool *tp, size_t threads);
+
+// returns the number of workers in thread pool [tp]
+size_t threadpool_get_thread_count(const ThreadPool *tp);
+
+// queue [fn]([arg]) to run on thread pool [tp]
+// returns false on memory exhaustion
+bool threadpool_submit(ThreadPool *tp, ThreadPoolFn fn, void *arg);
+
+// block until every task submitted to thread pool [tp] has finished
+void threadpool_wait(ThreadPool *tp);
+
+// run [fn]([ctx], i) for every i below [tasks] on thread pool [tp], or on
+// the calling thread when tp is NULL, and wait for all of them
+// returns false on memory exhaustion, in which case nothing ran
+bool threadpool_run(ThreadPool *tp, size_t tasks, ThreadPoolRangeFn fn,
+                    void *ctx);
+
+// finish the queued tasks, stop the workers and free thread pool [tp]
+void threadpool_free(ThreadPool *tp);
+
+#endif //SEARCHFILEC_THREADPOOL_H
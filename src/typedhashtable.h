@@ -0,0 +1,272 @@
+//
+// Created by Joseph Hurdle on 10/18/26.
+//
+
+#ifndef SEARCHFILEC_TYPEDHASHTABLE_H
+#define SEARCHFILEC_TYPEDHASHTABLE_H
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "buffer.h"
+#include "hash.h"
+#include "log.h"
+#include "recycler.h"
+
+/*
+ * Typed hash tables
+ * HashTable stores every key and value in its own Buffer, which is the right
+ * thing for arbitrary data but costs an allocation and a Buffer header per
+ * value.  When the key and value types are known and of fixed size, a table
+ * generated by TYPED_HASHTABLE_DEFINE stores both inline in a single open
+ * addressed (linear probing) slot array, with the hash and key compare
+ * resolved at compile time.
+ *
+ *     TYPED_HASHTABLE_DEFINE(CountTable, ShortString, size_t,
+ *                            typed_hash_short_string,
+ *                            typed_equal_short_string)
+ *
+ * generates the type CountTable and the static inline functions
+ * CountTable_init, CountTable_free, CountTable_assign_recycler,
+ * CountTable_reserve, CountTable_put, CountTable_get, CountTable_get_or_add,
+ * CountTable_remove, CountTable_get_entry_count and CountTable_iterate.
+ * [hashFn] takes a key and returns a uint64_t, [equalFn] takes two keys and
+ * returns true when they are the same.
+ *
+ * Keys and values are copied by value, pointers returned by NAME_get and
+ * NAME_get_or_add are invalidated by anything which adds to the table.
+*/
+
+// largest string held inline by a ShortString
+#define SHORT_STRING_MAX 23
+
+// numerator / denominator of the load factor at which a typed table grows
+#define TYPED_HASHTABLE_LOAD_NUM 3
+#define TYPED_HASHTABLE_LOAD_DEN 4
+
+#define TYPED_HASHTABLE_MIN_CAPACITY 16
+
+/* ShortString
+ * a string of at most SHORT_STRING_MAX bytes held inline, used as a fixed
+ * size key for typed hash tables
+ */
+typedef struct stShortString {
+    unsigned char len;
+    unsigned char data[SHORT_STRING_MAX];
+} ShortString;
+
+// set short string [ss] to the [len] bytes at [data]
+// returns false, leaving ss empty, if len is greater than SHORT_STRING_MAX
+static inline bool short_string_set(ShortString *ss, const unsigned char *data,
+                                    size_t len) {
+    assert(NULL != ss);
+    memset(ss, 0, sizeof(ShortString));
+    if(len > SHORT_STRING_MAX) return false;
+    if(len > 0) memcpy(ss->data, data, len);
+    ss->len = (unsigned char) len;
+    return true;
+}
+
+// set short string [ss] to the data held by buffer [buf]
+// returns false if buf holds more than SHORT_STRING_MAX bytes
+static inline bool short_string_from_buffer(ShortString *ss, const Buffer *buf) {
+    assert(NULL != buf);
+    return short_string_set(ss, buf->data, buf->len);
+}
+
+static inline uint64_t typed_hash_u64(uint64_t key) {
+    return hash_mix64(key);
+}
+
+static inline bool typed_equal_u64(uint64_t a, uint64_t b) {
+    return a == b;
+}
+
+static inline uint64_t typed_hash_u32(uint32_t key) {
+    return hash_mix64(key);
+}
+
+static inline bool typed_equal_u32(uint32_t a, uint32_t b) {
+    return a == b;
+}
+
+static inline uint64_t typed_hash_short_string(ShortString key) {
+    return hash_bytes(key.data, key.len, HASH_DEFAULT_SEED);
+}
+
+static inline bool typed_equal_short_string(ShortString a, ShortString b) {
+    return a.len == b.len && 0 == memcmp(a.data, b.data, a.len);
+}
+
+#define TYPED_HASHTABLE_DEFINE(NAME, KEY, VALUE, hashFn, equalFn)              \
+                                                                               \
+typedef struct st##NAME##Slot {                                                \
+    KEY key;                                                                   \
+    VALUE value;                                                               \
+} NAME##Slot;                                                                  \
+                                                                               \
+typedef struct st##NAME {                                                      \
+    NAME##Slot *slots;                                                         \
+    unsigned char *used;                                                       \
+    size_t cap;                                                                \
+    size_t count;                                                              \
+    Recycler *recycler;                                                        \
+} NAME;                                                                        \
+                                                                               \
+static inline void NAME##_init(NAME *t) {                                      \
+    assert(NULL != t);                                                         \
+    t->slots = NULL;                                                           \
+    t->used = NULL;                                                            \
+    t->cap = 0;                                                                \
+    t->count = 0;                                                              \
+    t->recycler = NULL;                                                        \
+}                                                                              \
+                                                                               \
+static inline void NAME##_assign_recycler(NAME *t, Recycler *r) {              \
+    assert(NULL != t);                                                         \
+    t->recycler = r;                                                           \
+}                                                                              \
+                                                                               \
+/* slots and used flags live in one allocation, slots first */                 \
+static inline size_t NAME##_alloc_size(size_t cap) {                           \
+    return cap * sizeof(NAME##Slot) + cap;                                     \
+}                                                                              \
+                                                                               \
+static inline void NAME##_release(Recycler *r, NAME##Slot *slots,              \
+                                  size_t cap) {                                \
+    if(NULL == slots) return;                                                  \
+    if(NULL != r) recycler_return(r, NAME##_alloc_size(cap), slots);           \
+    else free(slots);                                                          \
+}                                                                              \
+                                                                               \
+static inline void NAME##_free(NAME *t) {                                      \
+    assert(NULL != t);                                                         \
+    Recycler *r = t->recycler;                                                 \
+    NAME##_release(r, t->slots, t->cap);                                       \
+    NAME##_init(t);                                                            \
+    t->recycler = r;                                                           \
+}                                                                              \
+                                                                               \
+static inline size_t NAME##_get_entry_count(const NAME *t) {                   \
+    assert(NULL != t);                                                         \
+    return t->count;                                                           \
+}                                                                              \
+                                                                               \
+/* index of the slot holding [key], or of the empty slot where it belongs */   \
+static inline size_t NAME##_find(const NAME *t, KEY key) {                     \
+    const size_t mask = t->cap - 1;                                            \
+    size_t i = (size_t) hashFn(key) & mask;                                    \
+    while(t->used[i] && !equalFn(t->slots[i].key, key)) i = (i + 1) & mask;    \
+    return i;                                                                  \
+}                                                                              \
+                                                                               \
+static inline bool NAME##_rehash(NAME *t, size_t cap) {                        \
+    void *p = NULL;                                                            \
+    const size_t bytes = NAME##_alloc_size(cap);                               \
+    if(NULL != t->recycler) p = recycler_get_exact(t->recycler, bytes);        \
+    else p = malloc(bytes);                                                    \
+    if(NULL == p) {                                                            \
+        log_message("Unable to allocate %zu slots for " #NAME, cap);           \
+        return false;                                                          \
+    }                                                                          \
+                                                                               \
+    NAME old = *t;                                                             \
+    t->slots = (NAME##Slot *) p;                                               \
+    t->used = (unsigned char *) p + cap * sizeof(NAME##Slot);                  \
+    t->cap = cap;                                                              \
+    memset(t->used, 0, cap);                                                   \
+                                                                               \
+    for(size_t i = 0; i < old.cap; ++i) {                                      \
+        if(!old.used[i]) continue;                                             \
+        const size_t j = NAME##_find(t, old.slots[i].key);                     \
+        t->slots[j] = old.slots[i];                                            \
+        t->used[j] = 1;                                                        \
+    }                                                                          \
+                                                                               \
+    NAME##_release(t->recycler, old.slots, old.cap);                           \
+    return true;                                                               \
+}                                                                              \
+                                                                               \
+/* make room for [count] entries without growing again */                      \
+static inline bool NAME##_reserve(NAME *t, size_t count) {                     \
+    assert(NULL != t);                                                         \
+    size_t cap = TYPED_HASHTABLE_MIN_CAPACITY;                                 \
+    while(cap * TYPED_HASHTABLE_LOAD_NUM / TYPED_HASHTABLE_LOAD_DEN < count)   \
+        cap <<= 1;                                                             \
+    if(cap <= t->cap) return true;                                             \
+    return NAME##_rehash(t, cap);                                              \
+}                                                                              \
+                                                                               \
+/* pointer to the value stored for [key] or NULL when absent */                \
+static inline VALUE *NAME##_get(NAME *t, KEY key) {                            \
+    assert(NULL != t);                                                         \
+    if(0 == t->count) return NULL;                                             \
+    const size_t i = NAME##_find(t, key);                                      \
+    return t->used[i] ? &t->slots[i].value : NULL;                             \
+}                                                                              \
+                                                                               \
+/* pointer to the value stored for [key], adding [value] first when absent */ \
+static inline VALUE *NAME##_get_or_add(NAME *t, KEY key, VALUE value) {        \
+    assert(NULL != t);                                                         \
+    if(!NAME##_reserve(t, t->count + 1)) return NULL;                          \
+    const size_t i = NAME##_find(t, key);                                      \
+    if(!t->used[i]) {                                                          \
+        t->slots[i].key = key;                                                 \
+        t->slots[i].value = value;                                             \
+        t->used[i] = 1;                                                        \
+        t->count++;                                                            \
+    }                                                                          \
+    return &t->slots[i].value;                                                 \
+}                                                                              \
+                                                                               \
+/* store [value] for [key], replacing any value already stored */              \
+static inline bool NAME##_put(NAME *t, KEY key, VALUE value) {                 \
+    VALUE *v = NAME##_get_or_add(t, key, value);                               \
+    if(NULL == v) return false;                                                \
+    *v = value;                                                                \
+    return true;                                                               \
+}                                                                              \
+                                                                               \
+/* remove [key], shifting later entries of its probe run back so no */         \
+/* tombstone is needed; returns true if the key was present */                 \
+static inline bool NAME##_remove(NAME *t, KEY key) {                           \
+    assert(NULL != t);                                                         \
+    if(0 == t->count) return false;                                            \
+    const size_t mask = t->cap - 1;                                            \
+    size_t i = NAME##_find(t, key);                                            \
+    if(!t->used[i]) return false;                                              \
+                                                                               \
+    size_t j = i;                                                              \
+    for(;;) {                                                                  \
+        j = (j + 1) & mask;                                                    \
+        if(!t->used[j]) break;                                                 \
+        const size_t home = (size_t) hashFn(t->slots[j].key) & mask;           \
+        /* entry j may fill hole i only if its home is not in (i, j] */        \
+        if(i <= j ? (i < home && home <= j) : (i < home || home <= j))         \
+            continue;                                                          \
+        t->slots[i] = t->slots[j];                                             \
+        i = j;                                                                 \
+    }                                                                          \
+    t->used[i] = 0;                                                            \
+    t->count--;                                                                \
+    return true;                                                               \
+}                                                                              \
+                                                                               \
+/* walk every entry, [pos] starts at 0; returns false once done */             \
+static inline bool NAME##_iterate(const NAME *t, size_t *pos, KEY *key,        \
+                                  VALUE *value) {                              \
+    assert(NULL != t);                                                         \
+    assert(NULL != pos);                                                       \
+    while(*pos < t->cap) {                                                     \
+        const size_t i = (*pos)++;                                             \
+        if(!t->used[i]) continue;                                              \
+        if(NULL != key) *key = t->slots[i].key;                                \
+        if(NULL != value) *value = t->slots[i].value;                          \
+        return true;                                                           \
+    }                                                                          \
+    return false;                                                              \
+}
+
+#endif //SEARCHFILEC_TYPEDHASHTABLE_H
@@ -5,6 +5,7 @@
 /* file minunit_example.c */
 
 #include <stdio.h>
+#include <unistd.h>
 #include "simpletest.h"
 #include "../src/buffer.h"
 #include "../src/bufferarray.h"
@@ -13,11 +14,31 @@
 #include <string.h>
 #include <time.h>
 #include <ctype.h>
+#include <limits.h>
+#include <stdint.h>
 #include "../src/hashtable.h"
+#include "../src/mappedhashtable.h"
+#include "../src/mappedbufferarray.h"
+#include "../src/filereader.h"
+#include "../src/filewriter.h"
+#include "../src/frozenhashtable.h"
+#include "../src/typedhashtable.h"
+#include "../src/hashset.h"
+#include "../src/cache.h"
+#include "../src/threadpool.h"
+#include "../src/fst.h"
+#include "../src/art.h"
+#include "../src/sorteddict.h"
 
 int tests_run;
 int tests_passed;
 
+TYPED_HASHTABLE_DEFINE(U64U32Table, uint64_t, uint32_t, typed_hash_u64,
+                       typed_equal_u64)
+
+TYPED_HASHTABLE_DEFINE(WordCountTable, ShortString, size_t,
+                       typed_hash_short_string, typed_equal_short_string)
+
 void buffer_init_test() {
     Buffer b;
     buffer_init(&b);
@@ -63,6 +84,22 @@ void buffer_reserve_test(Recycler * recycler) {
     simple_test_assert("Buffer freespace not 0 after free",
                        buffer_get_freespace(&b) == 0);
 
+    // a buffer cannot grow past UINT_MAX bytes, pushing onto a full one
+    // fails without writing, here a small block posing as a full buffer
+    simple_test_assert("Buffer grew past UINT_MAX bytes",
+                       !buffer_grow(&b, (size_t) UINT_MAX + 1) &&
+                       0 == buffer_get_capacity(&b));
+    simple_test_assert("Failure to reserve buffer", buffer_reserve(&b, 16));
+    unsigned char *data = b.data;
+    const size_t cap = b.cap;
+    b.len = b.cap = UINT_MAX;
+    simple_test_assert("Pushed onto a buffer of UINT_MAX bytes",
+                       !buffer_push_byte(&b, 'c') &&
+                       !buffer_push_bytes(&b, (const unsigned char *) "cake", 4) &&
+                       UINT_MAX == b.len && UINT_MAX == b.cap && data == b.data);
+    b.len = 0;
+    b.cap = cap;
+    buffer_free(&b);
 }
 
 void buffer_set_test(Recycler * recycler) {
@@ -124,8 +161,919 @@ void buffer_array_test(Recycler * recycler) {
 
     simple_test_assert("Buffer array fails to add buffer",
                        buffer_array_push(&ba, &b));
+
+    // a moved buffer hands its memory over and is left empty
+    unsigned char *data = b.data;
+    simple_test_assert("Buffer array fails to move buffer",
+                       buffer_array_push_move(&ba, &b));
+    Buffer *moved = buffer_array_get_buffer(&ba, 1);
+    simple_test_assert("Buffer array move copied the buffer",
+                       2 == buffer_array_get_buffer_count(&ba) &&
+                       NULL != moved && data == moved->data &&
+                       buffer_is_empty(&b) && b.recycler == recycler);
+
+    Buffer c;
+    buffer_init(&c);
+    buffer_strcpy(&c, "Hello From Venus");
+    buffer_move(&c, moved);
+    simple_test_assert("Buffer move copied the buffer",
+                       data == c.data && buffer_is_empty(moved) &&
+                       c.recycler == recycler &&
+                       strcmp("Hello From Mars", (char *) c.data) == 0);
+    buffer_free(&c);
+
+    for(size_t i=0; i<100; ++i) {
+        buffer_strcpy(&b, "Hello From Mars");
+        buffer_array_push_move(&ba, &b);
+    }
+    simple_test_assert("Buffer array loses moved buffers",
+                       102 == buffer_array_get_buffer_count(&ba) &&
+                       strcmp("Hello From Mars", (char *)
+                              buffer_array_get_buffer(&ba, 101)->data) == 0);
+
+    // clearing keeps the array's memory, reserving past it grows it once
+    unsigned char *headers = ba.array.data;
+    const size_t capacity = buffer_array_get_capacity(&ba);
+    buffer_array_clear(&ba);
+    simple_test_assert("Buffer array clear released its memory",
+                       0 == buffer_array_get_buffer_count(&ba) &&
+                       headers == ba.array.data &&
+                       capacity == buffer_array_get_capacity(&ba));
+    simple_test_assert("Failure to reserve buffer array",
+                       buffer_array_reserve(&ba, 1000) &&
+                       1000 <= buffer_array_get_capacity(&ba));
+    simple_test_assert("Buffer array reserved past UINT_MAX bytes",
+                       !buffer_array_reserve(&ba, UINT_MAX / sizeof(Buffer) + 1) &&
+                       !buffer_array_reserve(&ba, SIZE_MAX / 2) &&
+                       1000 <= buffer_array_get_capacity(&ba));
+
+    // nor can its headers grow past UINT_MAX bytes, faked on a small block
+    {
+        Buffer spare;
+        buffer_init(&spare);
+        const Buffer array = ba.array;
+        const size_t count = ba.count;
+        ba.array.len = ba.array.cap = UINT_MAX - UINT_MAX % sizeof(Buffer);
+        ba.count = ba.array.len / sizeof(Buffer);
+        simple_test_assert("Pushed a buffer past UINT_MAX bytes of headers",
+                           !buffer_array_push_move(&ba, &spare) &&
+                           NULL == buffer_array_emplace(&ba) &&
+                           array.data == ba.array.data);
+        ba.array = array;
+        ba.count = count;
+    }
+    headers = ba.array.data;
+
+    // emplaced buffers are filled in place
+    bool ok = true;
+    char tmp[32];
+    for(size_t i=0; i<1000; ++i) {
+        Buffer *slot = buffer_array_emplace(&ba);
+        snprintf(tmp, sizeof(tmp), "%zu", i);
+        ok = ok && NULL != slot && slot->recycler == ba.recycler &&
+             buffer_strcpy(slot, tmp);
+    }
+    simple_test_assert("Buffer array emplace failed or grew the array",
+                       ok && headers == ba.array.data &&
+                       1000 == buffer_array_get_buffer_count(&ba));
+
+    // swap removal moves the last buffer into the hole
+    buffer_array_swap_remove(&ba, 10);
+    buffer_array_swap_remove(&ba, 998);
+    simple_test_assert("Buffer array swap remove is wrong",
+                       998 == buffer_array_get_buffer_count(&ba) &&
+                       strcmp("999", (char *)
+                              buffer_array_get_buffer(&ba, 10)->data) == 0 &&
+                       strcmp("997", (char *)
+                              buffer_array_get_buffer(&ba, 997)->data) == 0);
+
+    BufferArray more;
+    buffer_array_init(&more);
+    buffer_array_assign_recycler(&more, recycler);
+    simple_test_assert("Failure to extend buffer array",
+                       buffer_array_extend(&more,
+                                           buffer_array_get_buffer(&ba, 0),
+                                           buffer_array_get_buffer_count(&ba)) &&
+                       998 == buffer_array_get_buffer_count(&more) &&
+                       strcmp("999", (char *)
+                              buffer_array_get_buffer(&more, 10)->data) == 0 &&
+                       buffer_array_get_buffer(&more, 10)->data !=
+                       buffer_array_get_buffer(&ba, 10)->data);
+    buffer_array_free(&more);
+
+    // pushing a byte at a time grows the buffer geometrically
+    buffer_free(&b);
+    ok = true;
+    size_t grew = 0, cap = 0;
+    for(size_t i=0; i<100000; ++i) {
+        ok = ok && buffer_push_bytes(&b, (unsigned char *) "ab", 2);
+        if(buffer_get_capacity(&b) != cap) ++grew;
+        cap = buffer_get_capacity(&b);
+    }
+    simple_test_assert("Buffer push grows linearly",
+                       ok && 200000 == b.len && grew < 40 &&
+                       0 == memcmp(b.data + 199998, "ab", 2));
+
+    buffer_array_free(&ba);
+    buffer_free(&b);
+}
+
+void packed_buffer_array_test(Recycler * recycler) {
+
+    PackedBufferArray pa;
+    packed_buffer_array_init(&pa);
+    packed_buffer_array_assign_recycler(&pa, recycler);
+
+    BufferView view;
+    simple_test_assert("Packed buffer array retrieves an entry when empty",
+                       !packed_buffer_array_get_view(&pa, 0, &view));
+
+    // entries of every length from 0 up, the empty one included
+    const size_t count = 10000;
+    char tmp[32];
+    bool ok = true;
+    size_t bytes = 0;
+    for(size_t i=0; i<count; ++i) {
+        const int len = snprintf(tmp, sizeof(tmp), "%zu", i * 7919);
+        const size_t use = 0 == i % 10 ? 0 : (size_t) len;
+        ok = ok && packed_buffer_array_push_bytes(&pa, (unsigned char *) tmp,
+                                                  use);
+        bytes += use;
+    }
+    simple_test_assert("Failure to push onto packed buffer array", ok);
+    simple_test_assert("Packed buffer array count or size is wrong",
+                       count == packed_buffer_array_get_count(&pa) &&
+                       bytes == packed_buffer_array_get_size(&pa));
+
+    ok = true;
+    for(size_t i=0; i<count; ++i) {
+        const int len = snprintf(tmp, sizeof(tmp), "%zu", i * 7919);
+        const size_t use = 0 == i % 10 ? 0 : (size_t) len;
+        ok = ok && packed_buffer_array_get_view(&pa, i, &view) &&
+             use == view.len && 0 == memcmp(view.data, tmp, use);
+    }
+    simple_test_assert("Packed buffer array lost an entry", ok);
+    simple_test_assert("Packed buffer array retrieves past the end",
+                       !packed_buffer_array_get_view(&pa, count, &view));
+    // a recycler may hand back any chunk at least as big as asked for
+    simple_test_assert("Packed buffer array costs more than 4 bytes an entry",
+                       NULL != recycler ||
+                       packed_buffer_array_get_memory(&pa) <=
+                       2 * (bytes + count * sizeof(uint32_t)));
+
+    // packing a buffer array copies every buffer once
+    BufferArray ba;
+    buffer_array_init(&ba);
+    buffer_array_assign_recycler(&ba, recycler);
+    Buffer b;
+    buffer_init(&b);
+    buffer_assign_recycler(&b, recycler);
+    buffer_strcpy(&b, "Hello From Mars");
+    buffer_array_push(&ba, &b);
+    buffer_clear(&b);
+    buffer_array_push(&ba, &b);
+    buffer_strcpy(&b, "Hello From Venus");
+    buffer_array_push(&ba, &b);
+
+    packed_buffer_array_clear(&pa);
+    simple_test_assert("Failure to pack buffer array",
+                       packed_buffer_array_pack(&pa, &ba) &&
+                       3 == packed_buffer_array_get_count(&pa));
+    simple_test_assert("Packed buffer array mangled a buffer",
+                       packed_buffer_array_get_view(&pa, 2, &view) &&
+                       view.len == b.len &&
+                       0 == memcmp(view.data, b.data, b.len) &&
+                       packed_buffer_array_get_view(&pa, 1, &view) &&
+                       0 == view.len);
+
+    buffer_view_set(&view, (const unsigned char *) "Hello From Jupiter", 18);
+    packed_buffer_array_push_view(&pa, &view);
+    simple_test_assert("Packed buffer array lost a view",
+                       packed_buffer_array_get_view(&pa, 3, &view) &&
+                       18 == view.len &&
+                       0 == memcmp(view.data, "Hello From Jupiter", 18));
+
+    packed_buffer_array_free(&pa);
+    simple_test_assert("Freed packed buffer array holds memory",
+                       0 == packed_buffer_array_get_memory(&pa) &&
+                       0 == packed_buffer_array_get_count(&pa));
+    buffer_array_free(&ba);
+    buffer_free(&b);
 }
 
+// true when the buffers of [ba] are in the order of [cmp]
+static bool buffer_array_sort_test_ordered(BufferArray *ba,
+                                           int (*cmp)(const void *,
+                                                      const void *)) {
+    for(size_t i=1; i<buffer_array_get_buffer_count(ba); ++i)
+        if(cmp(buffer_array_get_buffer(ba, i - 1),
+               buffer_array_get_buffer(ba, i)) > 0) return false;
+    return true;
+}
+
+void buffer_array_sort_test(Recycler * recycler) {
+
+    ThreadPool tp;
+    simple_test_assert("Failure to start sort thread pool",
+                       threadpool_init(&tp, 4));
+
+    // keys with long shared prefixes, repeats, zero bytes and empty keys,
+    // enough of them to be split across the pool.  The recycler only goes
+    // to the small arrays below, it scans every chunk it holds on return
+    const size_t count = 100000;
+    BufferArray ba;
+    buffer_array_init(&ba);
+    buffer_array_reserve(&ba, count);
+    uint64_t seed = 0x9e3779b97f4a7c15ULL;
+    const char *prefixes[] = { "", "a", "common/prefix/of/many/keys/",
+                               "common/prefix/of/", "zz" };
+    for(size_t i=0; i<count; ++i) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        Buffer *slot = buffer_array_emplace(&ba);
+        const char *prefix = prefixes[seed % 5];
+        buffer_push_bytes(slot, (const unsigned char *) prefix, strlen(prefix));
+        const size_t extra = (seed >> 8) % 12;
+        for(size_t j=0; j<extra; ++j)
+            buffer_push_byte(slot, (unsigned char) ((seed >> (16 + j * 3)) % 5));
+    }
+    BufferArray copy;
+    buffer_array_init(&copy);
+    buffer_array_extend(&copy, buffer_array_get_buffer(&ba, 0), count);
+
+    simple_test_assert("Failure to sort buffer array",
+                       buffer_array_sort(&ba, BUFFER_ARRAY_ORDER_BYTES, NULL));
+    simple_test_assert("Buffer array sort is not in byte order",
+                       count == buffer_array_get_buffer_count(&ba) &&
+                       buffer_array_sort_test_ordered(&ba, buffer_cmp_bytes));
+    simple_test_assert("Failure to sort buffer array on a pool",
+                       buffer_array_sort(&copy, BUFFER_ARRAY_ORDER_BYTES, &tp));
+    bool same = true;
+    for(size_t i=0; i<count; ++i)
+        same = same && 0 == buffer_cmp_bytes(buffer_array_get_buffer(&ba, i),
+                                             buffer_array_get_buffer(&copy, i));
+    simple_test_assert("Buffer array sort differs on a pool", same);
+
+    simple_test_assert("Failure to sort buffer array by length",
+                       buffer_array_sort(&ba, BUFFER_ARRAY_ORDER_LENGTH, &tp) &&
+                       buffer_array_sort_test_ordered(&ba, buffer_cmp));
+    simple_test_assert("Buffer array sort by length differs on one thread",
+                       buffer_array_sort(&copy, BUFFER_ARRAY_ORDER_LENGTH,
+                                         NULL) &&
+                       buffer_array_sort_test_ordered(&copy, buffer_cmp));
+
+    // small arrays and arrays of one repeated key
+    buffer_array_free(&ba);
+    buffer_array_assign_recycler(&ba, recycler);
+    Buffer b;
+    buffer_init(&b);
+    buffer_assign_recycler(&b, recycler);
+    buffer_push_bytes(&b, (const unsigned char *) "same", 4);
+    for(size_t i=0; i<1000; ++i) buffer_array_push(&ba, &b);
+    simple_test_assert("Failure to sort equal buffers",
+                       buffer_array_sort(&ba, BUFFER_ARRAY_ORDER_BYTES, &tp) &&
+                       1000 == buffer_array_get_buffer_count(&ba));
+    buffer_array_clear(&ba);
+    buffer_array_push(&ba, &b);
+    buffer_clear(&b);
+    buffer_push_bytes(&b, (const unsigned char *) "sam", 3);
+    buffer_array_push(&ba, &b);
+    simple_test_assert("Failure to sort two buffers",
+                       buffer_array_sort(&ba, BUFFER_ARRAY_ORDER_BYTES, NULL) &&
+                       3 == buffer_array_get_buffer(&ba, 0)->len);
+
+    buffer_free(&b);
+    buffer_array_free(&ba);
+    buffer_array_free(&copy);
+    threadpool_free(&tp);
+}
+
+
+void mapped_buffer_array_test(Recycler * recycler) {
+
+    const char *fileName = "mapped_buffer_array_test.img";
+    const char *ary[] = { "the", "cake", "", "is", "a", "lie", NULL };
+
+    BufferArray ba;
+    buffer_array_init(&ba);
+    buffer_array_assign_recycler(&ba, recycler);
+    Buffer b;
+    buffer_init(&b);
+    buffer_assign_recycler(&b, recycler);
+    for(size_t i=0; NULL != ary[i]; ++i) {
+        buffer_clear(&b);
+        buffer_push_bytes(&b, (const unsigned char *) ary[i], strlen(ary[i]));
+        buffer_array_push(&ba, &b);
+    }
+
+    // an element larger than the writer's block goes straight to the file
+    buffer_clear(&b);
+    for(size_t i=0; i<BUFFER_ARRAY_WRITER_BLOCK + 1000; ++i)
+        buffer_push_byte(&b, (unsigned char) (i * 7));
+    buffer_array_push(&ba, &b);
+    const size_t count = buffer_array_get_buffer_count(&ba);
+
+    simple_test_assert("Failure to save buffer array image",
+                       buffer_array_save(&ba, fileName));
+
+    MappedBufferArray mba;
+    simple_test_assert("Failure to open buffer array image",
+                       buffer_array_open_mapped(&mba, fileName));
+    simple_test_assert("Buffer array image count is wrong",
+                       count == mapped_buffer_array_get_count(&mba));
+    simple_test_assert("Buffer array image fails its checksum",
+                       mapped_buffer_array_verify(&mba));
+
+    bool same = true;
+    BufferView view;
+    for(size_t i=0; i<count; ++i) {
+        const Buffer *src = buffer_array_get_buffer(&ba, i);
+        same = same && mapped_buffer_array_get_view(&mba, i, &view) &&
+               view.len == src->len &&
+               (0 == view.len || 0 == memcmp(view.data, src->data, view.len));
+    }
+    simple_test_assert("Buffer array image changed a buffer", same);
+    simple_test_assert("Buffer array image has a buffer past its end",
+                       !mapped_buffer_array_get_view(&mba, count, &view));
+    mapped_buffer_array_close(&mba);
+
+    // more elements than the writer gathers ends for spill its index
+    BufferArrayWriter w;
+    buffer_array_writer_init(&w);
+    buffer_array_writer_assign_recycler(&w, recycler);
+    simple_test_assert("Failure to start buffer array image",
+                       buffer_array_writer_open(&w, fileName));
+    const size_t many = BUFFER_ARRAY_WRITER_BLOCK / sizeof(uint64_t) * 2 + 17;
+    char tmp[32];
+    bool pushed = true;
+    for(size_t i=0; i<many; ++i) {
+        const int len = snprintf(tmp, sizeof(tmp), "%zu", i * 31);
+        BufferView v;
+        buffer_view_set(&v, (const unsigned char *) tmp, (size_t) len);
+        pushed = pushed && buffer_array_writer_push_view(&w, &v);
+    }
+    simple_test_assert("Failure to write buffer array image",
+                       pushed && many == buffer_array_writer_get_count(&w) &&
+                       buffer_array_writer_finish(&w));
+
+    simple_test_assert("Failure to open streamed buffer array image",
+                       buffer_array_open_mapped(&mba, fileName) &&
+                       many == mapped_buffer_array_get_count(&mba) &&
+                       mapped_buffer_array_verify(&mba));
+    same = true;
+    for(size_t i=0; i<many; i += 997) {
+        const int len = snprintf(tmp, sizeof(tmp), "%zu", i * 31);
+        same = same && mapped_buffer_array_get_view(&mba, i, &view) &&
+               view.len == (size_t) len && 0 == memcmp(view.data, tmp, view.len);
+    }
+    same = same && mapped_buffer_array_get_view(&mba, many - 1, &view) &&
+           view.len == (size_t) snprintf(tmp, sizeof(tmp), "%zu", (many - 1) * 31) &&
+           0 == memcmp(view.data, tmp, view.len);
+    simple_test_assert("Streamed buffer array image changed a buffer", same);
+    mapped_buffer_array_close(&mba);
+
+    // a damaged byte opens but fails verification, a short file does not open
+    FILE *f = fopen(fileName, "r+b");
+    fseek(f, sizeof(BufferArrayImageHeader) + 3, SEEK_SET);
+    fputc('#', f);
+    fclose(f);
+    simple_test_assert("Damaged buffer array image passes its checksum",
+                       buffer_array_open_mapped(&mba, fileName) &&
+                       !mapped_buffer_array_verify(&mba));
+    mapped_buffer_array_close(&mba);
+    simple_test_assert("Failure to truncate buffer array image",
+                       0 == truncate(fileName, sizeof(BufferArrayImageHeader) + 8));
+    simple_test_assert("Opened a truncated buffer array image",
+                       !buffer_array_open_mapped(&mba, fileName));
+    remove(fileName);
+
+    // an abandoned image leaves nothing behind
+    simple_test_assert("Failure to start buffer array image",
+                       buffer_array_writer_open(&w, fileName) &&
+                       buffer_array_writer_push(&w, &b));
+    buffer_array_writer_free(&w);
+    simple_test_assert("Opened an abandoned buffer array image",
+                       !buffer_array_open_mapped(&mba, fileName));
+
+    BufferArray none;
+    buffer_array_init(&none);
+    simple_test_assert("Failure to save empty buffer array image",
+                       buffer_array_save(&none, fileName) &&
+                       buffer_array_open_mapped(&mba, fileName) &&
+                       0 == mapped_buffer_array_get_count(&mba) &&
+                       mapped_buffer_array_verify(&mba));
+    mapped_buffer_array_close(&mba);
+    remove(fileName);
+
+    buffer_array_free(&ba);
+    buffer_free(&b);
+}
+
+// ways file_reader_test_lines reads a file
+typedef enum eFileReaderTestRead {
+    FILE_READER_TEST_LINE,
+    FILE_READER_TEST_VIEW,
+    FILE_READER_TEST_BLOCK
+} FileReaderTestRead;
+
+// read every line of [fileName] with [opts], copying them out, through views
+// or split from blocks as [how] says, and compare them with [expected]
+static bool file_reader_test_lines(Recycler *recycler, const char *fileName,
+                                   const FileReaderOptions *opts,
+                                   FileReaderTestRead how,
+                                   BufferArray *expected) {
+    FileReader reader;
+    file_reader_init(&reader);
+    if(NULL != recycler) file_reader_assign_recycler(&reader, recycler);
+    if(!file_reader_open_options(&reader, fileName, opts)) return false;
+
+    Buffer line;
+    buffer_init(&line);
+    BufferView view, block;
+    buffer_view_init(&block);
+    size_t seen = 0;
+    bool same = true;
+    for(;;) {
+        if(FILE_READER_TEST_VIEW == how) {
+            if(!file_reader_read_line_view(&reader, &view, '\n')) break;
+        } else if(FILE_READER_TEST_BLOCK == how) {
+            if(!file_reader_next_line(&block, &view, '\n')) {
+                if(!file_reader_read_block(&reader, &block, '\n')) break;
+                same = same && block.len > 0;
+                continue;
+            }
+        } else {
+            if(!file_reader_read_line(&reader, &line, '\n')) break;
+            buffer_view_from_buffer(&view, &line);
+        }
+        const Buffer *e = buffer_array_get_buffer(expected, seen++);
+        same = same && NULL != e && e->len == view.len &&
+               0 == memcmp(e->data, view.data, view.len);
+    }
+    same = same && file_reader_eof(&reader) &&
+           seen == buffer_array_get_buffer_count(expected);
+
+    file_reader_close(&reader);
+    buffer_free(&line);
+    return same;
+}
+
+// check a reader set up by [opts] for range [start, end) of [fileName] finds
+// nothing to read in it
+static bool file_reader_test_no_range(Recycler *recycler, const char *fileName,
+                                      const FileReaderOptions *opts,
+                                      size_t start, size_t end) {
+    FileReader reader;
+    file_reader_init(&reader);
+    if(NULL != recycler) file_reader_assign_recycler(&reader, recycler);
+    if(!file_reader_open_range(&reader, fileName, opts, start, end))
+        return false;
+    BufferView view;
+    unsigned char c;
+    const bool none = !file_reader_read_block(&reader, &view, '\n') &&
+                      !file_reader_read_line_view(&reader, &view, '\n') &&
+                      !file_reader_read_byte(&reader, &c) &&
+                      file_reader_eof(&reader);
+    file_reader_close(&reader);
+    return none;
+}
+
+// split [fileName] into [count] ranges of [size] bytes between them, read
+// each with its own reader set up by [opts] and check that between them they
+// see the lines of [expected] once each, in order
+static bool file_reader_test_ranges(Recycler *recycler, const char *fileName,
+                                    const FileReaderOptions *opts, size_t count,
+                                    size_t size, BufferArray *expected) {
+    FileRange *ranges = malloc(sizeof(FileRange) * count);
+    size_t found;
+    bool same = NULL != ranges &&
+                file_reader_split(fileName, '\n', count, ranges, &found) &&
+                found > 0 && found <= count && 0 == ranges[0].start &&
+                size == ranges[found - 1].end;
+
+    size_t seen = 0;
+    for(size_t r = 0; same && r < found; ++r) {
+        same = ranges[r].start < ranges[r].end &&
+               (0 == r || ranges[r - 1].end == ranges[r].start);
+
+        FileReader reader;
+        file_reader_init(&reader);
+        if(NULL != recycler) file_reader_assign_recycler(&reader, recycler);
+        same = same && file_reader_open_range(&reader, fileName, opts,
+                                              ranges[r].start, ranges[r].end);
+        BufferView block, line;
+        while(same && file_reader_read_block(&reader, &block, '\n')) {
+            while(file_reader_next_line(&block, &line, '\n')) {
+                const Buffer *e = buffer_array_get_buffer(expected, seen++);
+                same = same && NULL != e && e->len == line.len &&
+                       0 == memcmp(e->data, line.data, line.len);
+            }
+        }
+        same = same && file_reader_eof(&reader);
+        file_reader_close(&reader);
+    }
+
+    // empty ranges, inside the file and at or past its end, hold nothing
+    if(same) {
+        const size_t mid = ranges[found / 2].start;
+        same = file_reader_test_no_range(recycler, fileName, opts, mid, mid) &&
+               file_reader_test_no_range(recycler, fileName, opts, size,
+                                         FILE_READER_TO_END) &&
+               file_reader_test_no_range(recycler, fileName, opts, size + 33,
+                                         size + 43);
+    }
+
+    free(ranges);
+    return same && seen == buffer_array_get_buffer_count(expected);
+}
+
+void file_reader_test(Recycler * recycler) {
+
+    const char *fileName = "file_reader_test.txt";
+
+    // lines of many lengths, empty ones, one far longer than a map window
+    // and a last line with no delimiter
+    BufferArray expected;
+    buffer_array_init(&expected);
+    Buffer line;
+    buffer_init(&line);
+    Buffer all;
+    buffer_init(&all);
+    for(size_t i=0; i<2000; ++i) {
+        buffer_clear(&line);
+        const size_t len = 0 == i % 50 ? 0 : (i * 37) % 200;
+        for(size_t j=0; j<(1000 == i ? 20000 : len); ++j)
+            buffer_push_byte(&line, (unsigned char) ('a' + (i + j) % 26));
+        if(1999 != i) buffer_push_byte(&line, '\n');
+        buffer_array_push(&expected, &line);
+        buffer_append(&all, &line);
+    }
+    FILE *f = fopen(fileName, "wb");
+    fwrite(all.data, 1, all.len, f);
+    fclose(f);
+
+    FileReaderOptions opts;
+    file_reader_options_init(&opts);
+    simple_test_assert("File reader read the wrong lines",
+                       file_reader_test_lines(recycler, fileName, &opts,
+                                              FILE_READER_TEST_LINE, &expected));
+    simple_test_assert("File reader viewed the wrong lines",
+                       file_reader_test_lines(recycler, fileName, &opts,
+                                              FILE_READER_TEST_VIEW, &expected));
+    simple_test_assert("File reader blocks held the wrong lines",
+                       file_reader_test_lines(recycler, fileName, &opts,
+                                              FILE_READER_TEST_BLOCK, &expected));
+
+    // blocks smaller than most lines and than the page
+    for(size_t blockSize = 1; blockSize <= 4096; blockSize *= 8) {
+        opts.blockSize = blockSize;
+        simple_test_assert("File reader with small blocks read the wrong lines",
+                           file_reader_test_lines(recycler, fileName, &opts,
+                                                  FILE_READER_TEST_VIEW,
+                                                  &expected) &&
+                           file_reader_test_lines(recycler, fileName, &opts,
+                                                  FILE_READER_TEST_BLOCK,
+                                                  &expected));
+    }
+
+    // one read per block and one more to find the end of the file
+    FileReader reader;
+    file_reader_init(&reader);
+    opts.blockSize = 4096;
+    simple_test_assert("Failure to open file for reading",
+                       file_reader_open_options(&reader, fileName, &opts));
+    BufferView view;
+    while(file_reader_read_line_view(&reader, &view, '\n'));
+    FileReaderStats stats;
+    file_reader_get_stats(&reader, &stats);
+    simple_test_assert("File reader made the wrong number of reads",
+                       stats.bytesRead == all.len &&
+                       stats.reads == (all.len + 4095) / 4096 + 1);
+    file_reader_close(&reader);
+
+    // blocks read ahead on another thread, through a ring of two and more
+    opts.mode = FILE_READER_MODE_ASYNC;
+    for(size_t blockSize = 1; blockSize <= 4096; blockSize *= 8) {
+        opts.blockSize = blockSize;
+        opts.depth = 2 + blockSize % 5;
+        simple_test_assert("Read ahead file reader read the wrong lines",
+                           file_reader_test_lines(recycler, fileName, &opts,
+                                                  FILE_READER_TEST_LINE,
+                                                  &expected) &&
+                           file_reader_test_lines(recycler, fileName, &opts,
+                                                  FILE_READER_TEST_BLOCK,
+                                                  &expected));
+    }
+
+    // closing with the ring full stops the thread
+    simple_test_assert("Failure to open file for reading ahead",
+                       file_reader_open_options(&reader, fileName, &opts) &&
+                       file_reader_read_line_view(&reader, &view, '\n'));
+    for(size_t wait = 0; wait < 5000; ++wait) {
+        file_reader_get_stats(&reader, &stats);
+        if(stats.reads >= opts.depth) break;
+        usleep(1000);
+    }
+    usleep(1000);
+    file_reader_get_stats(&reader, &stats);
+    simple_test_assert("Read ahead file reader did not read ahead",
+                       opts.depth == stats.reads);
+    file_reader_close(&reader);
+    opts.mode = FILE_READER_MODE_READ;
+    opts.blockSize = 0;
+    opts.depth = 0;
+
+    // every hint in every mode, small blocks and windows so pages are
+    // dropped and asked for many times over
+    const unsigned int advice[] = {
+            FILE_READER_ADVISE_SEQUENTIAL | FILE_READER_ADVISE_WILLNEED,
+            FILE_READER_ADVISE_DROP_BEHIND | FILE_READER_ADVISE_WILLNEED,
+            FILE_READER_ADVISE_DIRECT,
+            FILE_READER_ADVISE_DIRECT | FILE_READER_ADVISE_DROP_BEHIND
+    };
+    const FileReaderMode modes[] = {
+            FILE_READER_MODE_READ, FILE_READER_MODE_ASYNC, FILE_READER_MODE_MMAP
+    };
+    for(size_t a = 0; a < sizeof(advice) / sizeof(advice[0]); ++a) {
+        for(size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); ++m) {
+            file_reader_options_init(&opts);
+            opts.mode = modes[m];
+            opts.advice = advice[a];
+            opts.blockSize = 1000;
+            opts.mapWindow = 8192;
+            opts.prefetch = 5000;
+            simple_test_assert("File reader with hints read the wrong lines",
+                               file_reader_test_lines(recycler, fileName, &opts,
+                                                      FILE_READER_TEST_BLOCK,
+                                                      &expected));
+        }
+    }
+
+    // direct reads are of whole aligned blocks
+    file_reader_options_init(&opts);
+    opts.advice = FILE_READER_ADVISE_DIRECT;
+    opts.blockSize = 1;
+    simple_test_assert("Failure to open file for direct reading",
+                       file_reader_open_options(&reader, fileName, &opts));
+    while(file_reader_read_line_view(&reader, &view, '\n'));
+    file_reader_get_stats(&reader, &stats);
+    simple_test_assert("Direct file reader made the wrong number of reads",
+                       stats.bytesRead == all.len &&
+                       stats.reads == (all.len + 4095) / 4096 + 1);
+    file_reader_close(&reader);
+    file_reader_options_init(&opts);
+
+    // a window of a page makes lines cross windows and outgrow them
+    opts.mode = FILE_READER_MODE_MMAP;
+    opts.mapWindow = 4096;
+    simple_test_assert("Mapped file reader viewed the wrong lines",
+                       file_reader_test_lines(recycler, fileName, &opts,
+                                              FILE_READER_TEST_VIEW, &expected));
+    simple_test_assert("Mapped file reader read the wrong lines",
+                       file_reader_test_lines(recycler, fileName, &opts,
+                                              FILE_READER_TEST_LINE, &expected));
+    simple_test_assert("Mapped file reader blocks held the wrong lines",
+                       file_reader_test_lines(recycler, fileName, &opts,
+                                              FILE_READER_TEST_BLOCK, &expected));
+
+    // windows smaller than a page are taken as a page
+    const size_t windows[] = {1, 8, 3431};
+    for(size_t i = 0; i < sizeof(windows) / sizeof(windows[0]); ++i) {
+        opts.mapWindow = windows[i];
+        simple_test_assert("Mapped file reader with a small window read wrong lines",
+                           file_reader_test_lines(recycler, fileName, &opts,
+                                                  FILE_READER_TEST_VIEW,
+                                                  &expected) &&
+                           file_reader_test_lines(recycler, fileName, &opts,
+                                                  FILE_READER_TEST_BLOCK,
+                                                  &expected));
+    }
+
+    opts.mapWindow = 0;
+    simple_test_assert("Mapped file reader with one window read wrong lines",
+                       file_reader_test_lines(recycler, fileName, &opts,
+                                              FILE_READER_TEST_VIEW, &expected));
+
+    unsigned char c;
+    for(size_t i = 0; i < sizeof(windows) / sizeof(windows[0]); ++i) {
+        file_reader_init(&reader);
+        opts.mapWindow = windows[i];
+        simple_test_assert("Failure to map file for reading",
+                           file_reader_open_options(&reader, fileName, &opts));
+        size_t n = 0;
+        bool same = true;
+        // a reader going round in circles is stopped past the end
+        while(n <= all.len && file_reader_read_byte(&reader, &c)) {
+            same = same && n < all.len && all.data[n] == c;
+            ++n;
+        }
+        simple_test_assert("Mapped file reader read the wrong bytes",
+                           same && n == all.len && file_reader_eof(&reader));
+        file_reader_close(&reader);
+    }
+
+    // every line once however many ranges it is split into, including more
+    // ranges than lines, in each mode and with ranges starting off alignment
+    const size_t counts[] = {1, 2, 3, 7, 16, 61, 500, 5000};
+    const FileReaderMode rangeModes[] = {
+            FILE_READER_MODE_READ, FILE_READER_MODE_ASYNC, FILE_READER_MODE_MMAP
+    };
+    for(size_t m = 0; m < sizeof(rangeModes) / sizeof(rangeModes[0]); ++m) {
+        for(size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i) {
+            file_reader_options_init(&opts);
+            opts.mode = rangeModes[m];
+            opts.blockSize = 3000;
+            opts.mapWindow = 8192;
+            simple_test_assert("File reader ranges saw the wrong lines",
+                               file_reader_test_ranges(recycler, fileName,
+                                                       &opts, counts[i],
+                                                       all.len, &expected));
+            opts.advice = FILE_READER_ADVISE_DIRECT;
+            simple_test_assert("Direct file reader ranges saw the wrong lines",
+                               file_reader_test_ranges(recycler, fileName,
+                                                       &opts, counts[i],
+                                                       all.len, &expected));
+        }
+    }
+    file_reader_options_init(&opts);
+    opts.mode = FILE_READER_MODE_MMAP;
+    opts.mapWindow = 4096;
+
+    f = fopen(fileName, "wb");
+    fclose(f);
+    buffer_array_free(&expected);
+    buffer_array_init(&expected);
+    size_t found = 1;
+    FileRange none[4];
+    simple_test_assert("Split an empty file into ranges",
+                       file_reader_split(fileName, '\n', 4, none, &found) &&
+                       0 == found);
+    simple_test_assert("Mapped file reader found a line in an empty file",
+                       file_reader_test_lines(recycler, fileName, &opts,
+                                              FILE_READER_TEST_BLOCK, &expected));
+    opts.mode = FILE_READER_MODE_READ;
+    simple_test_assert("File reader found a line in an empty file",
+                       file_reader_test_lines(recycler, fileName, &opts,
+                                              FILE_READER_TEST_BLOCK, &expected) &&
+                       file_reader_test_lines(recycler, fileName, &opts,
+                                              FILE_READER_TEST_VIEW, &expected));
+    opts.mode = FILE_READER_MODE_MMAP;
+    remove(fileName);
+    simple_test_assert("Mapped a file which does not exist",
+                       !file_reader_open_options(&reader, fileName, &opts));
+
+    buffer_array_free(&expected);
+    buffer_free(&line);
+    buffer_free(&all);
+}
+
+// check [fileName] holds exactly the bytes of [expected]
+static bool file_writer_test_file(const char *fileName, const Buffer *expected) {
+    FILE *f = fopen(fileName, "rb");
+    if(NULL == f) return false;
+    unsigned char *got = malloc(expected->len + 1);
+    const size_t n = NULL == got ? 0 : fread(got, 1, expected->len + 1, f);
+    fclose(f);
+    const bool same = NULL != got && n == expected->len &&
+                      0 == memcmp(got, expected->data, n);
+    free(got);
+    return same;
+}
+
+void file_writer_test(Recycler * recycler) {
+
+    const char *fileName = "file_writer_test.txt";
+
+    // records from empty to far longer than any buffer, mostly short
+    Buffer record;
+    buffer_init(&record);
+    Buffer expected;
+    buffer_init(&expected);
+    BufferArray records;
+    buffer_array_init(&records);
+    for(size_t i = 0; i < 3000; ++i) {
+        buffer_clear(&record);
+        size_t len = (i * 31) % 40;
+        if(0 == i % 97) len = 5000;
+        if(0 == i % 1001) len = 3 * FILE_WRITER_BUFFER;
+        for(size_t j = 0; j < len; ++j)
+            buffer_push_byte(&record, (unsigned char) ('a' + (i + j) % 26));
+        buffer_array_push(&records, &record);
+    }
+    const size_t count = buffer_array_get_buffer_count(&records);
+    for(size_t i = 0; i < count; ++i) {
+        buffer_append(&expected, buffer_array_get_buffer(&records, i));
+        buffer_push_byte(&expected, '\n');
+    }
+
+    BufferView *views = malloc(sizeof(BufferView) * 2 * count);
+    const size_t sizes[] = {1, 64, 4096, 0};
+    for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        for(int background = 0; background < 2; ++background) {
+            for(int how = 0; how < 3; ++how) {
+                FileWriterOptions opts;
+                file_writer_options_init(&opts);
+                opts.bufferSize = sizes[s];
+                opts.background = background;
+                opts.sync = (FileWriterSync) (how + 1);
+                opts.syncBytes = 100000;
+
+                FileWriter w;
+                file_writer_init(&w);
+                if(NULL != recycler) file_writer_assign_recycler(&w, recycler);
+                bool ok = file_writer_open_options(&w, fileName, &opts);
+
+                // a record and its delimiter at a time, as buffers and views,
+                // or all of them in one go
+                for(size_t i = 0; ok && 2 != how && i < count; ++i) {
+                    const Buffer *b = buffer_array_get_buffer(&records, i);
+                    BufferView v;
+                    buffer_view_from_buffer(&v, b);
+                    ok = (0 == how ? file_writer_write(&w, b) :
+                          file_writer_write_view(&w, &v)) &&
+                         file_writer_write_byte(&w, '\n');
+                }
+                if(2 == how) {
+                    for(size_t i = 0; i < count; ++i) {
+                        buffer_view_from_buffer(&views[2 * i],
+                                                buffer_array_get_buffer(&records, i));
+                        buffer_view_set(&views[2 * i + 1],
+                                        (const unsigned char *) "\n", 1);
+                    }
+                    ok = file_writer_write_views(&w, views, 2 * count);
+                }
+
+                FileWriterStats stats;
+                file_writer_get_stats(&w, &stats);
+                ok = ok && file_writer_close(&w);
+                file_writer_get_stats(&w, &stats);
+                simple_test_assert("File writer wrote the wrong bytes",
+                                   ok && stats.bytesWritten == expected.len &&
+                                   file_writer_test_file(fileName, &expected));
+                // a sync follows every write, a few or only the close
+                const bool synced =
+                        FILE_WRITER_SYNC_FLUSH == opts.sync ?
+                        stats.syncs == stats.writes :
+                        FILE_WRITER_SYNC_BYTES == opts.sync ?
+                        stats.syncs > 1 && stats.syncs <= stats.writes + 1 :
+                        1 == stats.syncs;
+                simple_test_assert("File writer synced against its policy",
+                                   synced);
+            }
+        }
+    }
+
+    // with the default buffer short records are gathered into a few writes
+    FileWriter w;
+    file_writer_init(&w);
+    simple_test_assert("Failure to open file for writing",
+                       file_writer_open(&w, fileName));
+    for(size_t i = 0; i < 100000; ++i)
+        file_writer_write_bytes(&w, (const unsigned char *) "cake\n", 5);
+    FileWriterStats stats;
+    file_writer_get_stats(&w, &stats);
+    simple_test_assert("File writer closed with a failure",
+                       file_writer_close(&w));
+    file_writer_get_stats(&w, &stats);
+    simple_test_assert("File writer did not gather writes",
+                       500000 == stats.bytesWritten && 1 == stats.writes);
+
+    // appending
+    FileWriterOptions opts;
+    file_writer_options_init(&opts);
+    opts.append = true;
+    buffer_clear(&expected);
+    for(size_t i = 0; i < 100001; ++i) buffer_push_bytes(&expected,
+                                                       (const unsigned char *) "cake\n", 5);
+    simple_test_assert("File writer could not append",
+                       file_writer_open_options(&w, fileName, &opts) &&
+                       file_writer_write_bytes(&w, (const unsigned char *) "cake\n", 5) &&
+                       file_writer_close(&w) &&
+                       file_writer_test_file(fileName, &expected));
+    remove(fileName);
+
+    // an oversized buffer is cut down rather than reserved short
+    file_writer_options_init(&opts);
+    opts.bufferSize = (size_t) UINT_MAX + 4096;
+    simple_test_assert("File writer buffer was not capped",
+                       file_writer_open_options(&w, fileName, &opts) &&
+                       FILE_WRITER_BUFFER_MAX == w.bufferSize &&
+                       w.buf.cap >= w.bufferSize &&
+                       file_writer_write_bytes(&w, (const unsigned char *) "cake\n", 5) &&
+                       file_writer_close(&w));
+    remove(fileName);
+
+    simple_test_assert("Opened a file in a directory which does not exist",
+                       !file_writer_open(&w, "no/such/dir/file.txt") &&
+                       !file_writer_write_bytes(&w, (const unsigned char *) "x", 1) &&
+                       !file_writer_close(&w));
+
+    free(views);
+    buffer_array_free(&records);
+    buffer_free(&record);
+    buffer_free(&expected);
+}
 
 void buffer_split_test(Recycler * recycler) {
 
@@ -173,6 +1121,17 @@ void buffer_split_test(Recycler * recycler) {
 void recycler_test(Recycler * recycler) {
     simple_test_assert("Recycler Empty despite recycled memory",
                        recycler->cap > 0);
+
+    MemoryChunk mc;
+    simple_test_assert("Unable to get aligned memory from recycler",
+                       recycler_get_aligned(recycler, &mc, 10000, 4096) &&
+                       0 == (uintptr_t) mc.p % 4096 && mc.cap >= 10000);
+    void *p = mc.p;
+    recycler_return(recycler, mc.cap, mc.p);
+    simple_test_assert("Recycler did not reuse aligned memory",
+                       recycler_get_aligned(recycler, &mc, 8192, 4096) &&
+                       p == mc.p);
+    recycler_return(recycler, mc.cap, mc.p);
 }
 
 void validate_hashvalue(HashValue *hv) {
@@ -317,10 +1276,1750 @@ void hash_table_test(Recycler * recycler) {
         simple_test_assert("Failure to retrieve key from hashtable",
                            NULL !=ret);
         if(NULL == ret) continue;
-        int *j = (int *) ret->data;
+        size_t *j = (size_t *) ret->data;
         simple_test_assert("Incorrect value retrieved from hashtable",
-                           *j !=i);
+                           *j == i);
+    }
+
+    // a moved pair is found like any other and shadows nothing
+    Buffer key, value;
+    buffer_init(&key);
+    buffer_init(&value);
+    buffer_assign_recycler(&key, recycler);
+    buffer_assign_recycler(&value, recycler);
+    const size_t big = 1000;
+    buffer_strcpy(&key, "cake");
+    buffer_push_bytes(&value, (unsigned char *) &big, sizeof(big));
+    const size_t before = hashtable_get_entry_count(&ht);
+    simple_test_assert("Failure to move key/value into hashtable",
+                       hashtable_add_move(&ht, &key, &value));
+    simple_test_assert("Moved key/value left behind",
+                       buffer_is_empty(&key) && buffer_is_empty(&value) &&
+                       before + 1 == hashtable_get_entry_count(&ht));
+
+    buffer_strcpy(&key, "cake");
+    Buffer *ret = hashtable_get(&ht, &key);
+    simple_test_assert("Incorrect moved value retrieved from hashtable",
+                       NULL != ret && big == *(size_t *) ret->data);
+
+    buffer_strcpy(&key, "foo");
+    buffer_push_bytes(&value, (unsigned char *) &big, sizeof(big));
+    hashtable_add_move(&ht, &key, &value);
+    buffer_strcpy(&key, "foo");
+    ret = hashtable_get(&ht, &key);
+    simple_test_assert("Moved duplicate shadows first value",
+                       NULL != ret && 0 == *(size_t *) ret->data &&
+                       before + 1 == hashtable_get_entry_count(&ht));
+
+    buffer_free(&key);
+    buffer_free(&value);
+    hashtable_free(&ht);
+}
+
+void hash_table_batch_test(Recycler * recycler) {
+
+    HashTable ht;
+    hashtable_init(&ht);
+    hashtable_assign_recycler(&ht, recycler);
+
+    const char* const ary[] = { "foo", "bar", "taco", "beer", "cake", "lie",
+                                "portal", "companion", "cube", "turret",
+                                "glados", "wheatley", "aperture", "science",
+                                "neurotoxin", "moon", "rock", "lemon", 0 };
+
+    BufferArray keys, values;
+    buffer_array_init(&keys);
+    buffer_array_init(&values);
+    buffer_array_assign_recycler(&keys, recycler);
+    buffer_array_assign_recycler(&values, recycler);
+
+    size_t count = 0;
+    for(size_t i=0; NULL != ary[i]; ++i) {
+        Buffer key, value;
+        buffer_init(&key);
+        buffer_init(&value);
+        buffer_assign_recycler(&key, recycler);
+        buffer_assign_recycler(&value, recycler);
+        buffer_strcpy(&key, ary[i]);
+        buffer_push_bytes(&value, (unsigned char *) &i, sizeof(i));
+        buffer_array_push(&keys, &key);
+        buffer_array_push(&values, &value);
+        buffer_free(&key);
+        buffer_free(&value);
+        ++count;
+    }
+
+    Buffer *results[32];
+
+    simple_test_assert("Batched get on an empty hashtable finds something",
+                       hashtable_get_many(&ht, &keys, results) == 0);
+
+    simple_test_assert("Failure to batch add keys/values to hashtable",
+                       hashtable_add_many(&ht, &keys, &values));
+
+    simple_test_assert("Batched add produced the wrong entry count",
+                       hashtable_get_entry_count(&ht) == count);
+
+    simple_test_assert("Batched get did not find every key",
+                       hashtable_get_many(&ht, &keys, results) == count);
+
+    for(size_t i=0; i<count; ++i) {
+        Buffer *single = hashtable_get(&ht, buffer_array_get_buffer(&keys, i));
+        simple_test_assert("Batched get disagrees with hashtable_get",
+                           single == results[i]);
+        if(NULL == results[i]) continue;
+        simple_test_assert("Incorrect value retrieved by batched get",
+                           *(size_t *) results[i]->data == i);
+    }
+
+    const char *probe[] = { "cake", "pie", "moon", "" };
+    Buffer probeKeys[4];
+    BufferView views[4];
+    for(size_t i=0; i<4; ++i) {
+        buffer_init(&probeKeys[i]);
+        buffer_assign_recycler(&probeKeys[i], recycler);
+        buffer_strcpy(&probeKeys[i], probe[i]);
+        buffer_view_from_buffer(&views[i], &probeKeys[i]);
+    }
+
+    simple_test_assert("Batched view get found the wrong number of keys",
+                       hashtable_get_many_views(&ht, views, 4, results) == 2);
+    simple_test_assert("Batched view get missed a present key",
+                       NULL != results[0] && NULL != results[2]);
+    simple_test_assert("Batched view get found a missing key",
+                       NULL == results[1] && NULL == results[3]);
+
+    for(size_t i=0; i<4; ++i) buffer_free(&probeKeys[i]);
+    buffer_array_free(&keys);
+    buffer_array_free(&values);
+    hashtable_free(&ht);
+}
+
+void hash_table_image_test(Recycler * recycler) {
+
+    const char *fileName = "hash_table_image_test.img";
+    const char* const ary[] = { "foo", "bar", "taco", "beer", "cake", "lie",
+                                "portal", "companion", "cube", 0 };
+
+    HashTable ht;
+    hashtable_init(&ht);
+    hashtable_assign_recycler(&ht, recycler);
+
+    Buffer key, value;
+    buffer_init(&key);
+    buffer_init(&value);
+    buffer_assign_recycler(&key, recycler);
+    buffer_assign_recycler(&value, recycler);
+
+    size_t count = 0;
+    for(size_t i=0; NULL != ary[i]; ++i) {
+        buffer_strcpy(&key, ary[i]);
+        buffer_clear(&value);
+        buffer_push_bytes(&value, (unsigned char *) &i, sizeof(i));
+        hashtable_add(&ht, &key, &value);
+        ++count;
+    }
+
+    // a repeated key must only be saved once
+    buffer_strcpy(&key, "cake");
+    hashtable_add(&ht, &key, &value);
+
+    simple_test_assert("Failure to save hashtable image",
+                       hashtable_save(&ht, fileName));
+
+    MappedHashTable mht;
+    simple_test_assert("Failure to open hashtable image",
+                       hashtable_open_mapped(&mht, fileName));
+
+    simple_test_assert("Hashtable image entry count is wrong",
+                       mapped_hashtable_get_entry_count(&mht) == count);
+
+    simple_test_assert("Hashtable image fails its checksum",
+                       mapped_hashtable_verify(&mht));
+
+    for(size_t i=0; NULL != ary[i]; ++i) {
+        BufferView view;
+        buffer_strcpy(&key, ary[i]);
+        simple_test_assert("Hashtable image is missing a key",
+                           mapped_hashtable_get(&mht, &key, &view));
+        simple_test_assert("Hashtable image returned the wrong value",
+                           view.len == sizeof(size_t) &&
+                           0 == memcmp(view.data, &i, sizeof(i)));
+    }
+
+    buffer_strcpy(&key, "pie");
+    simple_test_assert("Hashtable image found a missing key",
+                       !mapped_hashtable_has(&mht, &key));
+
+    mapped_hashtable_close(&mht);
+
+    // a corrupt payload passes the header checks at open, lookups in it
+    // miss instead of reading outside the file
+    for(int corrupt = 0; corrupt < 4; ++corrupt) {
+        hashtable_save(&ht, fileName);
+        FILE *f = fopen(fileName, "r+b");
+        HashImageHeader header;
+        bool ok = NULL != f && 1 == fread(&header, sizeof(header), 1, f);
+        if(0 == corrupt) {
+            // every bucket claims entries past the last
+            for(uint64_t b = 1; ok && b <= header.bucketCount; ++b) {
+                const uint64_t end = header.entryCount + 5;
+                ok = 0 == fseek(f, (long) (header.bucketOffset + b * 8), SEEK_SET) &&
+                     1 == fwrite(&end, sizeof(end), 1, f);
+            }
+        }
+        for(uint64_t i = 0; ok && 0 != corrupt && i < header.entryCount; ++i) {
+            HashImageEntry e;
+            const long at = (long) (header.entryOffset + i * sizeof(e));
+            ok = 0 == fseek(f, at, SEEK_SET) && 1 == fread(&e, sizeof(e), 1, f);
+            if(1 == corrupt) e.dataOffset = header.fileSize - 1;
+            if(2 == corrupt) e.dataOffset = UINT64_MAX - 2;
+            if(3 == corrupt) e.valueLen = UINT32_MAX;
+            ok = ok && 0 == fseek(f, at, SEEK_SET) &&
+                 1 == fwrite(&e, sizeof(e), 1, f);
+        }
+        if(NULL != f) fclose(f);
+        simple_test_assert("Failure to corrupt hashtable image", ok);
+
+        simple_test_assert("Failure to open corrupt hashtable image",
+                           hashtable_open_mapped(&mht, fileName));
+        ok = !mapped_hashtable_verify(&mht);
+        for(size_t i=0; NULL != ary[i]; ++i) {
+            BufferView view;
+            buffer_strcpy(&key, ary[i]);
+            ok = ok && !mapped_hashtable_get(&mht, &key, &view);
+        }
+        simple_test_assert("Corrupt hashtable image found a key", ok);
+        mapped_hashtable_close(&mht);
+    }
+    remove(fileName);
+
+    simple_test_assert("Opened a hashtable image which does not exist",
+                       !hashtable_open_mapped(&mht, fileName));
+
+    // images of one file being written at once each get a temporary file of
+    // their own, the one committed last wins whole
+    Buffer firstName, secondName;
+    buffer_init(&firstName);
+    buffer_init(&secondName);
+    const int first = mapped_file_create(fileName, &firstName);
+    const int second = mapped_file_create(fileName, &secondName);
+    simple_test_assert("Image writers share a temporary file",
+                       -1 != first && -1 != second &&
+                       0 != strcmp(buffer_get_string(&firstName),
+                                   buffer_get_string(&secondName)));
+    simple_test_assert("Failure to write and commit concurrent images",
+                       mapped_file_write(first, "first", 5) &&
+                       mapped_file_write(second, "second", 6) &&
+                       mapped_file_commit(second, &secondName, fileName, true) &&
+                       mapped_file_commit(first, &firstName, fileName, true));
+    MappedFile mf;
+    simple_test_assert("Committed image is not the last one written",
+                       mapped_file_open(&mf, fileName) && 5 == mf.len &&
+                       0 == memcmp(mf.data, "first", 5));
+    mapped_file_close(&mf);
+    remove(fileName);
+
+    buffer_free(&key);
+    buffer_free(&value);
+    hashtable_free(&ht);
+}
+
+void frozen_hash_table_test(Recycler * recycler) {
+
+    const char *fileName = "frozen_hash_table_test.img";
+    const size_t count = 5000;
+
+    HashTable ht;
+    hashtable_init(&ht);
+    hashtable_assign_recycler(&ht, recycler);
+    hashtable_set_size(&ht, 1021);
+
+    Buffer key, value;
+    buffer_init(&key);
+    buffer_init(&value);
+    buffer_assign_recycler(&key, recycler);
+    buffer_assign_recycler(&value, recycler);
+
+    char tmp[32];
+    for(size_t i=0; i<count; ++i) {
+        snprintf(tmp, sizeof(tmp), "word%zu", i);
+        buffer_strcpy(&key, tmp);
+        buffer_clear(&value);
+        buffer_push_bytes(&value, (unsigned char *) &i, sizeof(i));
+        hashtable_add(&ht, &key, &value);
+    }
+
+    FrozenHashTable fht;
+    simple_test_assert("Failure to freeze hashtable",
+                       hashtable_freeze(&ht, &fht));
+
+    simple_test_assert("Frozen hashtable entry count is wrong",
+                       frozen_hashtable_get_entry_count(&fht) == count);
+
+    bool allFound = true;
+    for(size_t i=0; i<count; ++i) {
+        BufferView view;
+        snprintf(tmp, sizeof(tmp), "word%zu", i);
+        buffer_strcpy(&key, tmp);
+        allFound = allFound && frozen_hashtable_get(&fht, &key, &view) &&
+                   view.len == sizeof(i) && 0 == memcmp(view.data, &i, sizeof(i));
+    }
+    simple_test_assert("Frozen hashtable lost or changed a value", allFound);
+
+    bool noneFound = true;
+    for(size_t i=count; i<2 * count; ++i) {
+        snprintf(tmp, sizeof(tmp), "word%zu", i);
+        buffer_strcpy(&key, tmp);
+        noneFound = noneFound && !frozen_hashtable_has(&fht, &key);
+    }
+    simple_test_assert("Frozen hashtable found a missing key", noneFound);
+
+    simple_test_assert("Failure to save frozen hashtable",
+                       frozen_hashtable_save(&fht, fileName));
+
+    FrozenHashTable mapped;
+    simple_test_assert("Failure to map frozen hashtable",
+                       frozen_hashtable_open_mapped(&mapped, fileName));
+    simple_test_assert("Mapped frozen hashtable fails its checksum",
+                       frozen_hashtable_verify(&mapped));
+
+    buffer_strcpy(&key, "word42");
+    simple_test_assert("Mapped frozen hashtable is missing a key",
+                       frozen_hashtable_has(&mapped, &key));
+
+    frozen_hashtable_free(&mapped);
+    frozen_hashtable_free(&fht);
+    remove(fileName);
+
+    HashTable empty;
+    hashtable_init(&empty);
+    simple_test_assert("Failure to freeze an empty hashtable",
+                       hashtable_freeze(&empty, &fht));
+    simple_test_assert("Empty frozen hashtable found a key",
+                       !frozen_hashtable_has(&fht, &key));
+    frozen_hashtable_free(&fht);
+
+    buffer_free(&key);
+    buffer_free(&value);
+    hashtable_free(&ht);
+}
+
+void typed_hash_table_test(Recycler * recycler) {
+
+    U64U32Table t;
+    U64U32Table_init(&t);
+    U64U32Table_assign_recycler(&t, recycler);
+
+    const uint64_t count = 10000;
+    bool ok = true;
+    for(uint64_t i=0; i<count; ++i) {
+        ok = ok && U64U32Table_put(&t, i * 7919, (uint32_t) i);
+    }
+    simple_test_assert("Failure to put into typed hashtable", ok);
+    simple_test_assert("Typed hashtable entry count is wrong",
+                       U64U32Table_get_entry_count(&t) == count);
+
+    for(uint64_t i=0; i<count; i += 2) {
+        ok = ok && U64U32Table_remove(&t, i * 7919);
+    }
+    simple_test_assert("Failure to remove from typed hashtable", ok);
+    simple_test_assert("Removing a missing key from typed hashtable succeeds",
+                       !U64U32Table_remove(&t, 1));
+
+    for(uint64_t i=0; i<count; ++i) {
+        uint32_t *v = U64U32Table_get(&t, i * 7919);
+        ok = ok && ((i % 2) ? (NULL != v && *v == i) : NULL == v);
+    }
+    simple_test_assert("Typed hashtable returned the wrong value", ok);
+
+    size_t pos = 0, seen = 0;
+    while(U64U32Table_iterate(&t, &pos, NULL, NULL)) ++seen;
+    simple_test_assert("Typed hashtable iteration missed entries",
+                       seen == count / 2);
+    U64U32Table_free(&t);
+
+    WordCountTable words;
+    WordCountTable_init(&words);
+    WordCountTable_assign_recycler(&words, recycler);
+
+    const char *text[] = { "the", "cake", "is", "a", "lie", "the", "cake", 0 };
+    for(size_t i=0; NULL != text[i]; ++i) {
+        ShortString ss;
+        short_string_set(&ss, (const unsigned char *) text[i], strlen(text[i]));
+        size_t *c = WordCountTable_get_or_add(&words, ss, 0);
+        if(NULL != c) ++*c;
+    }
+
+    ShortString cake;
+    short_string_set(&cake, (const unsigned char *) "cake", 4);
+    size_t *c = WordCountTable_get(&words, cake);
+    simple_test_assert("Typed hashtable word count is wrong",
+                       NULL != c && 2 == *c);
+    simple_test_assert("Typed hashtable distinct word count is wrong",
+                       WordCountTable_get_entry_count(&words) == 5);
+
+    ShortString tooLong;
+    simple_test_assert("Short string accepted a string which is too long",
+                       !short_string_set(&tooLong, (const unsigned char *)
+                                         "this string is far too long to fit", 35));
+    WordCountTable_free(&words);
+}
+
+void hash_table_stats_test(Recycler * recycler) {
+
+    const size_t count = 5000;
+    char tmp[32];
+
+    HashTable ht;
+    hashtable_init(&ht);
+    hashtable_assign_recycler(&ht, recycler);
+
+    HashTableStats stats;
+    hashtable_get_stats(&ht, &stats);
+    simple_test_assert("Empty hashtable stats are wrong",
+                       0 == stats.entryCount && 0 == stats.storedValues &&
+                       0 == stats.longestChain &&
+                       stats.chainHistogram[0] == HASH_TABLE_DEFAULT_SIZE);
+
+    hashtable_set_size(&ht, 1021);
+
+    Buffer key, value;
+    buffer_init(&key);
+    buffer_init(&value);
+    buffer_assign_recycler(&key, recycler);
+    buffer_assign_recycler(&value, recycler);
+
+    size_t keyBytes = 0;
+    for(size_t i=0; i<count; ++i) {
+        snprintf(tmp, sizeof(tmp), "key%zu", i);
+        buffer_strcpy(&key, tmp);
+        buffer_clear(&value);
+        buffer_push_bytes(&value, (unsigned char *) &i, sizeof(i));
+        hashtable_add(&ht, &key, &value);
+        keyBytes += key.len;
+    }
+
+    // ten keys added twice leave ten shadowed values behind
+    for(size_t i=0; i<10; ++i) {
+        snprintf(tmp, sizeof(tmp), "key%zu", i);
+        buffer_strcpy(&key, tmp);
+        hashtable_add(&ht, &key, &value);
+        keyBytes += key.len;
+    }
+
+    // removing one copy of a duplicated key leaves the key in the table
+    buffer_strcpy(&key, "key0");
+    hashtable_remove(&ht, &key);
+    keyBytes -= key.len;
+    buffer_strcpy(&key, "key4999");
+    hashtable_remove(&ht, &key);
+    keyBytes -= key.len;
+    buffer_strcpy(&key, "nokey");
+    hashtable_remove(&ht, &key);
+
+    hashtable_get_stats(&ht, &stats);
+
+    simple_test_assert("Hashtable stats entry count is wrong",
+                       stats.entryCount == count - 1 &&
+                       hashtable_get_entry_count(&ht) == count - 1);
+    simple_test_assert("Hashtable stats stored value count is wrong",
+                       stats.storedValues == count + 8);
+    simple_test_assert("Hashtable stats tombstone count is wrong",
+                       stats.tombstoneCount == 9);
+    simple_test_assert("Hashtable stats load factor is wrong",
+                       stats.loadFactor > 4.8 && stats.loadFactor < 4.9);
+
+    size_t buckets = 0, longest = 0;
+    for(size_t i=0; i<HASH_TABLE_STATS_HISTOGRAM; ++i) {
+        buckets += stats.chainHistogram[i];
+        if(stats.chainHistogram[i]) longest = i;
+    }
+    simple_test_assert("Hashtable stats histogram does not cover every bucket",
+                       buckets == 1021 && stats.bucketCount == 1021);
+    simple_test_assert("Hashtable stats longest chain is wrong",
+                       stats.longestChain >= longest &&
+                       (double) stats.longestChain >= stats.averageChain);
+    simple_test_assert("Hashtable stats key bytes are wrong",
+                       stats.keyBytes == keyBytes);
+    simple_test_assert("Hashtable stats value bytes are wrong",
+                       stats.valueBytes == (count + 8) * sizeof(size_t));
+    simple_test_assert("Hashtable stats bytes do not add up",
+                       stats.totalBytes == stats.slotBytes + stats.keyBytes +
+                                           stats.valueBytes + stats.slackBytes &&
+                       stats.slotBytes >= 1021 * sizeof(Buffer));
+
+    buffer_free(&key);
+    buffer_free(&value);
+    hashtable_free(&ht);
+}
+
+void filter_test(Recycler * recycler) {
+
+    const size_t count = 10000;
+    char tmp[32];
+
+    BloomFilter bf;
+    bloom_filter_init(&bf);
+    bloom_filter_assign_recycler(&bf, recycler);
+    simple_test_assert("Failure to create bloom filter",
+                       bloom_filter_create(&bf, count, 0.01));
+
+    CuckooFilter cf;
+    cuckoo_filter_init(&cf);
+    cuckoo_filter_assign_recycler(&cf, recycler);
+    simple_test_assert("Failure to create cuckoo filter",
+                       cuckoo_filter_create(&cf, count, 0.001));
+
+    Buffer key;
+    buffer_init(&key);
+    buffer_assign_recycler(&key, recycler);
+
+    bool ok = true;
+    for(size_t i=0; i<count; ++i) {
+        snprintf(tmp, sizeof(tmp), "key%zu", i);
+        buffer_strcpy(&key, tmp);
+        bloom_filter_add(&bf, &key);
+        ok = ok && cuckoo_filter_add(&cf, &key);
+    }
+    simple_test_assert("Failure to add to cuckoo filter", ok);
+
+    size_t bloomMisses = 0, cuckooMisses = 0;
+    for(size_t i=0; i<count; ++i) {
+        snprintf(tmp, sizeof(tmp), "key%zu", i);
+        buffer_strcpy(&key, tmp);
+        if(!bloom_filter_may_contain(&bf, &key)) ++bloomMisses;
+        if(!cuckoo_filter_may_contain(&cf, &key)) ++cuckooMisses;
+    }
+    simple_test_assert("Bloom filter has a false negative", 0 == bloomMisses);
+    simple_test_assert("Cuckoo filter has a false negative", 0 == cuckooMisses);
+
+    size_t bloomFalse = 0, cuckooFalse = 0;
+    for(size_t i=count; i<2 * count; ++i) {
+        snprintf(tmp, sizeof(tmp), "key%zu", i);
+        buffer_strcpy(&key, tmp);
+        if(bloom_filter_may_contain(&bf, &key)) ++bloomFalse;
+        if(cuckoo_filter_may_contain(&cf, &key)) ++cuckooFalse;
+    }
+    simple_test_assert("Bloom filter false positive rate is too high",
+                       bloomFalse < count * 2 / 100);
+    simple_test_assert("Cuckoo filter false positive rate is too high",
+                       cuckooFalse < count * 2 / 1000);
+
+    ok = true;
+    for(size_t i=0; i<count; i += 2) {
+        snprintf(tmp, sizeof(tmp), "key%zu", i);
+        buffer_strcpy(&key, tmp);
+        ok = ok && cuckoo_filter_remove(&cf, &key);
+    }
+    simple_test_assert("Failure to remove from cuckoo filter", ok);
+
+    size_t stillThere = 0;
+    for(size_t i=0; i<count; ++i) {
+        snprintf(tmp, sizeof(tmp), "key%zu", i);
+        buffer_strcpy(&key, tmp);
+        if(i % 2) ok = ok && cuckoo_filter_may_contain(&cf, &key);
+        else if(cuckoo_filter_may_contain(&cf, &key)) ++stillThere;
+    }
+    simple_test_assert("Cuckoo filter lost a key during removal", ok);
+    simple_test_assert("Cuckoo filter did not forget removed keys",
+                       stillThere < count / 100);
+
+    bloom_filter_free(&bf);
+    cuckoo_filter_free(&cf);
+
+    // a filter sized far too small must saturate rather than lie
+    MembershipFilter small;
+    membership_filter_init(&small, MEMBERSHIP_FILTER_CUCKOO);
+    membership_filter_assign_recycler(&small, recycler);
+    membership_filter_create(&small, 8, 0.01);
+    for(size_t i=0; i<1000; ++i) {
+        snprintf(tmp, sizeof(tmp), "key%zu", i);
+        membership_filter_add_bytes(&small, (unsigned char *) tmp, strlen(tmp));
+    }
+    ok = true;
+    for(size_t i=0; i<1000; ++i) {
+        snprintf(tmp, sizeof(tmp), "key%zu", i);
+        ok = ok && membership_filter_may_contain_bytes(&small, (unsigned char *) tmp,
+                                                       strlen(tmp));
+    }
+    simple_test_assert("Overfull membership filter has a false negative", ok);
+    membership_filter_free(&small);
+
+    const MembershipFilterKind kinds[] = { MEMBERSHIP_FILTER_BLOOM,
+                                           MEMBERSHIP_FILTER_CUCKOO };
+    for(size_t k=0; k<2; ++k) {
+        HashTable ht;
+        hashtable_init(&ht);
+        hashtable_assign_recycler(&ht, recycler);
+        hashtable_set_size(&ht, 1021);
+
+        Buffer value;
+        buffer_init(&value);
+        buffer_assign_recycler(&value, recycler);
+
+        // half the keys go in before the filter is attached
+        for(size_t i=0; i<count / 2; ++i) {
+            snprintf(tmp, sizeof(tmp), "key%zu", i);
+            buffer_strcpy(&key, tmp);
+            buffer_clear(&value);
+            buffer_push_bytes(&value, (unsigned char *) &i, sizeof(i));
+            hashtable_add(&ht, &key, &value);
+        }
+
+        MembershipFilter mf;
+        membership_filter_init(&mf, kinds[k]);
+        membership_filter_assign_recycler(&mf, recycler);
+        membership_filter_create(&mf, count, 0.01);
+        hashtable_attach_filter(&ht, &mf);
+
+        for(size_t i=count / 2; i<count; ++i) {
+            snprintf(tmp, sizeof(tmp), "key%zu", i);
+            buffer_strcpy(&key, tmp);
+            buffer_clear(&value);
+            buffer_push_bytes(&value, (unsigned char *) &i, sizeof(i));
+            hashtable_add(&ht, &key, &value);
+        }
+
+        simple_test_assert("Failure to grow a filtered hashtable",
+                           hashtable_set_size(&ht, 4099));
+        simple_test_assert("Growing a hashtable dropped its filter",
+                           ht.filter == &mf);
+
+        ok = true;
+        for(size_t i=0; i<2 * count; ++i) {
+            snprintf(tmp, sizeof(tmp), "key%zu", i);
+            buffer_strcpy(&key, tmp);
+            Buffer *data = hashtable_get(&ht, &key);
+            if(i < count)
+                ok = ok && NULL != data && 0 == memcmp(data->data, &i, sizeof(i));
+            else
+                ok = ok && NULL == data && !hashtable_has(&ht, &key);
+        }
+        simple_test_assert("Filtered hashtable returned the wrong value", ok);
+
+        Buffer probes[4];
+        BufferView views[4];
+        Buffer *results[4];
+        const char *probe[] = { "key1", "nokey", "key9999", "key10000" };
+        for(size_t i=0; i<4; ++i) {
+            buffer_init(&probes[i]);
+            buffer_assign_recycler(&probes[i], recycler);
+            buffer_strcpy(&probes[i], probe[i]);
+            buffer_view_from_buffer(&views[i], &probes[i]);
+        }
+        simple_test_assert("Filtered batched get found the wrong keys",
+                           2 == hashtable_get_many_views(&ht, views, 4, results) &&
+                           NULL != results[0] && NULL == results[1] &&
+                           NULL != results[2] && NULL == results[3]);
+        for(size_t i=0; i<4; ++i) buffer_free(&probes[i]);
+
+        // a key added twice must stay visible until both copies are gone
+        buffer_strcpy(&key, "key7");
+        hashtable_add(&ht, &key, &value);
+        hashtable_remove(&ht, &key);
+        simple_test_assert("Filtered hashtable forgot a duplicated key",
+                           hashtable_has(&ht, &key));
+        hashtable_remove(&ht, &key);
+        simple_test_assert("Filtered hashtable kept a removed key",
+                           !hashtable_has(&ht, &key));
+
+        // removing keys which were never added must not disturb the filter
+        for(size_t i=count; i<2 * count; ++i) {
+            snprintf(tmp, sizeof(tmp), "key%zu", i);
+            buffer_strcpy(&key, tmp);
+            hashtable_remove(&ht, &key);
+        }
+        ok = true;
+        for(size_t i=0; i<count; ++i) {
+            if(7 == i) continue;
+            snprintf(tmp, sizeof(tmp), "key%zu", i);
+            buffer_strcpy(&key, tmp);
+            ok = ok && hashtable_has(&ht, &key);
+        }
+        simple_test_assert("Filtered hashtable lost a key", ok);
+
+        hashtable_attach_filter(&ht, NULL);
+        hashtable_free(&ht);
+        membership_filter_free(&mf);
+        buffer_free(&value);
+    }
+
+    buffer_free(&key);
+}
+
+void hash_set_test(Recycler * recycler) {
+
+    const size_t count = 10000;
+    char tmp[32];
+
+    HashSet a, b;
+    hashset_init(&a);
+    hashset_init(&b);
+    hashset_assign_recycler(&a, recycler);
+    hashset_assign_recycler(&b, recycler);
+
+    // a holds the multiples of 2, b is built in bulk from the multiples of 3
+    bool ok = true;
+    bool added = false;
+    for(size_t i=0; i<count; i += 2) {
+        snprintf(tmp, sizeof(tmp), "key%zu", i);
+        ok = ok && hashset_insert_bytes(&a, (unsigned char *) tmp, strlen(tmp),
+                                        &added) && added;
+    }
+    simple_test_assert("Failure to insert into hash set", ok);
+
+    hashset_insert_bytes(&a, (unsigned char *) "key0", 4, &added);
+    simple_test_assert("Hash set inserted a duplicate", !added);
+    simple_test_assert("Hash set count is wrong",
+                       hashset_get_count(&a) == count / 2);
+
+    BufferArray keys;
+    buffer_array_init(&keys);
+    buffer_array_assign_recycler(&keys, recycler);
+    Buffer key;
+    buffer_init(&key);
+    buffer_assign_recycler(&key, recycler);
+    for(size_t i=0; i<count; i += 3) {
+        snprintf(tmp, sizeof(tmp), "key%zu", i);
+        buffer_clear(&key);
+        buffer_push_bytes(&key, (unsigned char *) tmp, strlen(tmp));
+        buffer_array_push(&keys, &key);
+    }
+    buffer_array_push(&keys, &key);
+    simple_test_assert("Failure to build hash set",
+                       hashset_build(&b, &keys) &&
+                       hashset_get_count(&b) == (count + 2) / 3);
+
+    ok = true;
+    for(size_t i=0; i<count; ++i) {
+        snprintf(tmp, sizeof(tmp), "key%zu", i);
+        ok = ok && hashset_contains_bytes(&a, (unsigned char *) tmp,
+                                          strlen(tmp)) == (0 == i % 2);
+    }
+    simple_test_assert("Hash set membership is wrong", ok);
+
+    HashSet u, n, d;
+    hashset_init(&u);
+    hashset_init(&n);
+    hashset_init(&d);
+    hashset_assign_recycler(&u, recycler);
+    hashset_assign_recycler(&n, recycler);
+    hashset_assign_recycler(&d, recycler);
+
+    simple_test_assert("Failure to form hash set union",
+                       hashset_union(&u, &a) && hashset_union(&u, &b) &&
+                       hashset_union(&n, &a) && hashset_union(&d, &a));
+    hashset_intersection(&n, &b);
+    hashset_difference(&d, &b);
+
+    ok = true;
+    size_t inU = 0, inN = 0, inD = 0;
+    for(size_t i=0; i<count; ++i) {
+        snprintf(tmp, sizeof(tmp), "key%zu", i);
+        const unsigned char *k = (unsigned char *) tmp;
+        const bool two = 0 == i % 2, three = 0 == i % 3;
+        ok = ok && hashset_contains_bytes(&u, k, strlen(tmp)) == (two || three);
+        ok = ok && hashset_contains_bytes(&n, k, strlen(tmp)) == (two && three);
+        ok = ok && hashset_contains_bytes(&d, k, strlen(tmp)) == (two && !three);
+        inU += two || three;
+        inN += two && three;
+        inD += two && !three;
+    }
+    simple_test_assert("Hash set union, intersection or difference is wrong",
+                       ok && hashset_get_count(&u) == inU &&
+                       hashset_get_count(&n) == inN &&
+                       hashset_get_count(&d) == inD);
+
+    // removing keys then compacting must keep every remaining key intact
+    ok = true;
+    for(size_t i=0; i<count; i += 4) {
+        snprintf(tmp, sizeof(tmp), "key%zu", i);
+        ok = ok && hashset_remove_bytes(&a, (unsigned char *) tmp, strlen(tmp));
+    }
+    simple_test_assert("Failure to remove from hash set", ok);
+    simple_test_assert("Hash set removed a missing key",
+                       !hashset_remove_bytes(&a, (unsigned char *) "key1", 4));
+
+    const size_t before = a.pool.len;
+    simple_test_assert("Failure to compact hash set",
+                       hashset_compact(&a) && a.pool.len < before);
+
+    ok = true;
+    for(size_t i=0; i<count; ++i) {
+        snprintf(tmp, sizeof(tmp), "key%zu", i);
+        ok = ok && hashset_contains_bytes(&a, (unsigned char *) tmp,
+                                          strlen(tmp)) == (2 == i % 4);
+    }
+    simple_test_assert("Hash set lost keys during removal", ok);
+
+    size_t pos = 0, seen = 0;
+    BufferView view;
+    ok = true;
+    while(hashset_iterate(&a, &pos, &view)) {
+        ++seen;
+        ok = ok && hashset_contains_bytes(&a, view.data, view.len);
+    }
+    simple_test_assert("Hash set iteration is wrong",
+                       ok && seen == hashset_get_count(&a));
+
+    // removing and inserting at a steady count reuses the space of removed
+    // keys, the pool does not grow with every key ever inserted
+    hashset_clear(&b);
+    for(size_t i=0; i<1000; ++i) {
+        snprintf(tmp, sizeof(tmp), "churn%zu", i);
+        hashset_insert_bytes(&b, (unsigned char *) tmp, strlen(tmp), NULL);
+    }
+    const size_t steady = hashset_get_memory(&b);
+    ok = true;
+    size_t most = 0;
+    for(size_t i=1000; i<200000; ++i) {
+        snprintf(tmp, sizeof(tmp), "churn%zu", i - 1000);
+        ok = ok && hashset_remove_bytes(&b, (unsigned char *) tmp, strlen(tmp));
+        snprintf(tmp, sizeof(tmp), "churn%zu", i);
+        ok = ok && hashset_insert_bytes(&b, (unsigned char *) tmp, strlen(tmp),
+                                        NULL);
+        if(hashset_get_memory(&b) > most) most = hashset_get_memory(&b);
+    }
+    simple_test_assert("Hash set churn lost keys",
+                       ok && 1000 == hashset_get_count(&b) &&
+                       hashset_contains_bytes(&b, (unsigned char *) "churn199999",
+                                              11));
+    simple_test_assert("Hash set pool grew under churn", most <= 4 * steady);
+
+    hashset_free(&a);
+    hashset_free(&b);
+    hashset_free(&u);
+    hashset_free(&n);
+    hashset_free(&d);
+    buffer_array_free(&keys);
+    buffer_free(&key);
+}
+
+// eviction callback which hands an evicted entry back to a recycler
+static void cache_test_evict(Buffer *key, Buffer *value, void *ctx) {
+    size_t *evicted = (size_t *) ctx;
+    ++*evicted;
+    buffer_free(key);
+    buffer_free(value);
+}
+
+void cache_test(Recycler * recycler) {
+
+    char tmp[32];
+    Buffer key, value;
+    buffer_init(&key);
+    buffer_init(&value);
+    buffer_assign_recycler(&key, recycler);
+    buffer_assign_recycler(&value, recycler);
+
+    Cache c;
+    cache_init(&c);
+    cache_assign_recycler(&c, recycler);
+    simple_test_assert("Cache accepted no limits", !cache_create(&c, 0, 0, 0));
+    simple_test_assert("Failure to create cache", cache_create(&c, 100, 0, 0));
+
+    size_t evicted = 0;
+    cache_set_evict_callback(&c, cache_test_evict, &evicted);
+
+    bool ok = true;
+    for(size_t i=0; i<100; ++i) {
+        snprintf(tmp, sizeof(tmp), "key%zu", i);
+        buffer_strcpy(&key, tmp);
+        buffer_clear(&value);
+        buffer_push_bytes(&value, (unsigned char *) &i, sizeof(i));
+        ok = ok && cache_put(&c, &key, &value);
+    }
+    simple_test_assert("Failure to put into cache", ok);
+    simple_test_assert("Cache evicted before it was full",
+                       0 == evicted && cache_get_count(&c) == 100);
+
+    // keys read since the hand passed survive, so the even keys stay
+    for(size_t i=0; i<100; i += 2) {
+        snprintf(tmp, sizeof(tmp), "key%zu", i);
+        buffer_strcpy(&key, tmp);
+        ok = ok && NULL != cache_get(&c, &key);
+    }
+    for(size_t i=100; i<150; ++i) {
+        snprintf(tmp, sizeof(tmp), "key%zu", i);
+        buffer_strcpy(&key, tmp);
+        buffer_clear(&value);
+        buffer_push_bytes(&value, (unsigned char *) &i, sizeof(i));
+        ok = ok && cache_put(&c, &key, &value);
+    }
+    simple_test_assert("Cache did not stay within its entry limit",
+                       ok && cache_get_count(&c) == 100 && 50 == evicted);
+
+    for(size_t i=0; i<150; ++i) {
+        snprintf(tmp, sizeof(tmp), "key%zu", i);
+        buffer_strcpy(&key, tmp);
+        Buffer *v = cache_get(&c, &key);
+        const bool expect = i >= 100 || 0 == i % 2;
+        ok = ok && (NULL != v) == expect;
+        if(NULL != v) ok = ok && 0 == memcmp(v->data, &i, sizeof(i));
+    }
+    simple_test_assert("Cache evicted the wrong entries", ok);
+
+    CacheStats stats;
+    cache_get_stats(&c, &stats);
+    simple_test_assert("Cache counters are wrong",
+                       stats.hits == 150 && stats.misses == 50 &&
+                       stats.evictions == 50 && stats.count == 100);
+
+    buffer_strcpy(&key, "key0");
+    simple_test_assert("Failure to remove from cache",
+                       cache_remove(&c, &key) && NULL == cache_get(&c, &key) &&
+                       !cache_remove(&c, &key) && 50 == evicted);
+    cache_free(&c);
+
+    // a byte bound cache grows its slots as needed and never passes the bound
+    cache_init(&c);
+    cache_assign_recycler(&c, recycler);
+    simple_test_assert("Failure to create byte bound cache",
+                       cache_create(&c, 0, 4096, 4));
+    buffer_clear(&value);
+    for(size_t i=0; i<64; ++i) buffer_push_byte(&value, 'x');
+    ok = true;
+    for(size_t i=0; i<1000; ++i) {
+        snprintf(tmp, sizeof(tmp), "key%zu", i);
+        buffer_strcpy(&key, tmp);
+        ok = ok && cache_put(&c, &key, &value);
+        cache_get_stats(&c, &stats);
+        ok = ok && stats.bytes <= 4096;
+    }
+    simple_test_assert("Byte bound cache passed its bound",
+                       ok && cache_get_count(&c) > 32 &&
+                       stats.evictions == 1000 - cache_get_count(&c));
+
+    // replacing a value adjusts the byte count
+    buffer_strcpy(&key, "key999");
+    buffer_clear(&value);
+    buffer_push_byte(&value, 'y');
+    cache_get_stats(&c, &stats);
+    const size_t before = stats.bytes;
+    cache_put(&c, &key, &value);
+    cache_get_stats(&c, &stats);
+    simple_test_assert("Cache replace did not update its value",
+                       stats.bytes == before - 63 &&
+                       1 == cache_get(&c, &key)->len);
+
+    for(size_t i=0; i<4100; ++i) buffer_push_byte(&value, 'z');
+    simple_test_assert("Cache accepted an entry larger than its bound",
+                       !cache_put(&c, &key, &value));
+    cache_free(&c);
+
+    buffer_free(&key);
+    buffer_free(&value);
+}
+
+// merge callback adding the size_t count in [src] to the one in [dest]
+static bool hash_merge_test_add(Buffer *dest, Buffer *src, void *ctx) {
+    size_t a, b;
+    memcpy(&a, dest->data, sizeof(a));
+    memcpy(&b, src->data, sizeof(b));
+    a += b;
+    memcpy(dest->data, &a, sizeof(a));
+    (void) ctx;
+    return true;
+}
+
+// fill [ht] with a count of 1 for every multiple of [step] below [limit]
+static void hash_merge_test_fill(HashTable *ht, size_t size, size_t step,
+                                 size_t limit, Recycler *recycler) {
+    hashtable_init(ht);
+    hashtable_assign_recycler(ht, recycler);
+    hashtable_set_size(ht, size);
+
+    Buffer key, value;
+    buffer_init(&key);
+    buffer_init(&value);
+    char tmp[32];
+    const size_t one = 1;
+    buffer_push_bytes(&value, (unsigned char *) &one, sizeof(one));
+    for(size_t i=0; i<limit; i += step) {
+        snprintf(tmp, sizeof(tmp), "word%zu", i);
+        buffer_strcpy(&key, tmp);
+        hashtable_add(ht, &key, &value);
+    }
+    buffer_free(&key);
+    buffer_free(&value);
+}
+
+// returns true if every word below [limit] in [ht] is counted once for each
+// of the [steps] dividing it, and nothing else is
+static bool hash_merge_test_check(HashTable *ht, const size_t *steps,
+                                  size_t stepCount, size_t limit) {
+    Buffer key;
+    buffer_init(&key);
+    char tmp[32];
+    size_t expectKeys = 0;
+    bool ok = true;
+    for(size_t i=0; i<limit; ++i) {
+        size_t expect = 0;
+        for(size_t s=0; s<stepCount; ++s) expect += (0 == i % steps[s]);
+        snprintf(tmp, sizeof(tmp), "word%zu", i);
+        buffer_strcpy(&key, tmp);
+        Buffer *v = hashtable_get(ht, &key);
+        size_t got = 0;
+        if(NULL != v) memcpy(&got, v->data, sizeof(got));
+        ok = ok && got == expect;
+        expectKeys += expect > 0;
+    }
+    buffer_free(&key);
+    return ok && hashtable_get_entry_count(ht) == expectKeys;
+}
+
+void hash_table_merge_test(Recycler * recycler) {
+
+    const size_t limit = 6000;
+    const size_t steps[] = { 2, 3, 5, 7, 1, 11, 13, 4 };
+
+    ThreadPool tp;
+    simple_test_assert("Failure to start thread pool", threadpool_init(&tp, 4));
+
+    // serial merge into a table of another size, a key added twice to src
+    // only contributes its live copy
+    HashTable a, b;
+    hash_merge_test_fill(&a, 1021, 2, limit, recycler);
+    hash_merge_test_fill(&b, 509, 3, limit, recycler);
+    Buffer key, value;
+    buffer_init(&key);
+    buffer_init(&value);
+    const size_t big = 100;
+    buffer_strcpy(&key, "word3");
+    buffer_push_bytes(&value, (unsigned char *) &big, sizeof(big));
+    hashtable_add(&b, &key, &value);
+
+    simple_test_assert("Failure to merge hashtables",
+                       hashtable_merge(&a, &b, hash_merge_test_add, NULL, &tp));
+    simple_test_assert("Merged hashtable counts are wrong",
+                       hash_merge_test_check(&a, steps, 2, limit));
+    simple_test_assert("Merge source was not emptied",
+                       0 == hashtable_get_entry_count(&b) &&
+                       NULL == hashtable_get(&b, &key));
+
+    // the emptied source is still usable
+    hashtable_add(&b, &key, &value);
+    simple_test_assert("Merge source unusable after merge",
+                       NULL != hashtable_get(&b, &key) &&
+                       1 == hashtable_get_entry_count(&b));
+    hashtable_free(&a);
+    hashtable_free(&b);
+
+    // equal sizes merge bucket ranges on the pool
+    hash_merge_test_fill(&a, 1021, 2, limit, recycler);
+    hash_merge_test_fill(&b, 1021, 3, limit, recycler);
+    simple_test_assert("Failure to merge hashtables in parallel",
+                       hashtable_merge(&a, &b, hash_merge_test_add, NULL, &tp));
+    simple_test_assert("Parallel merged hashtable counts are wrong",
+                       hash_merge_test_check(&a, steps, 2, limit));
+    hashtable_free(&a);
+    hashtable_free(&b);
+
+    HashTable tables[8];
+    HashTable *ptrs[8];
+    for(size_t i=0; i<8; ++i) {
+        hash_merge_test_fill(&tables[i], 1021, steps[i], limit, recycler);
+        ptrs[i] = &tables[i];
+    }
+    simple_test_assert("Failure to reduce hashtables",
+                       hashtable_merge_all(ptrs, 8, hash_merge_test_add, NULL, &tp));
+    simple_test_assert("Reduced hashtable counts are wrong",
+                       hash_merge_test_check(&tables[0], steps, 8, limit));
+    bool empty = true;
+    for(size_t i=1; i<8; ++i)
+        empty = empty && 0 == hashtable_get_entry_count(&tables[i]);
+    simple_test_assert("Reduced hashtables were not emptied", empty);
+    for(size_t i=0; i<8; ++i) hashtable_free(&tables[i]);
+
+    buffer_free(&key);
+    buffer_free(&value);
+    threadpool_free(&tp);
+}
+
+void hash_table_build_test(Recycler * recycler) {
+
+    const size_t limit = 6000;
+    const char *fileName = "hash_table_build_test.txt";
+
+    ThreadPool tp;
+    simple_test_assert("Failure to start thread pool", threadpool_init(&tp, 4));
+
+    BufferArray keys, values;
+    buffer_array_init(&keys);
+    buffer_array_init(&values);
+
+    Buffer key, value;
+    buffer_init(&key);
+    buffer_init(&value);
+    buffer_assign_recycler(&key, recycler);
+    buffer_assign_recycler(&value, recycler);
+    char tmp[32];
+
+    FILE *fp = fopen(fileName, "w");
+    simple_test_assert("Failure to create build test file", NULL != fp);
+
+    // every key once, then the even keys again with another value which
+    // must stay shadowed by the first
+    for(size_t i=0; i<limit + limit / 2; ++i) {
+        const size_t n = i < limit ? i : (i - limit) * 2;
+        const size_t v = i < limit ? n : n + 1;
+        snprintf(tmp, sizeof(tmp), "word%zu", n);
+        buffer_clear(&key);
+        buffer_push_bytes(&key, (unsigned char *) tmp, strlen(tmp));
+        buffer_clear(&value);
+        buffer_push_bytes(&value, (unsigned char *) &v, sizeof(v));
+        buffer_array_push(&keys, &key);
+        buffer_array_push(&values, &value);
+        if(NULL != fp) fprintf(fp, "%s\n\n", tmp);
+    }
+    if(NULL != fp) fclose(fp);
+
+    HashTable ht;
+    hashtable_init(&ht);
+    hashtable_assign_recycler(&ht, recycler);
+    hashtable_set_size(&ht, 1021);
+    simple_test_assert("Failure to build hashtable in parallel",
+                       hashtable_build_parallel(&ht, &keys, &values, &tp));
+    simple_test_assert("Parallel built hashtable has wrong entry count",
+                       limit == hashtable_get_entry_count(&ht));
+
+    bool found = true;
+    for(size_t i=0; i<limit; ++i) {
+        snprintf(tmp, sizeof(tmp), "word%zu", i);
+        buffer_clear(&key);
+        buffer_push_bytes(&key, (unsigned char *) tmp, strlen(tmp));
+        Buffer *b = hashtable_get(&ht, &key);
+        found = found && NULL != b && sizeof(size_t) == b->len &&
+                i == *(size_t *) b->data;
+    }
+    simple_test_assert("Parallel built hashtable lookups are wrong", found);
+
+    // a built table is a normal table
+    hashtable_remove(&ht, &key);
+    simple_test_assert("Parallel built hashtable remove failed",
+                       !hashtable_has(&ht, &key) &&
+                       limit - 1 == hashtable_get_entry_count(&ht));
+    hashtable_free(&ht);
+
+    const size_t zero = 0;
+    buffer_clear(&value);
+    buffer_push_bytes(&value, (unsigned char *) &zero, sizeof(zero));
+    hashtable_init(&ht);
+    hashtable_assign_recycler(&ht, recycler);
+    hashtable_set_size(&ht, 509);
+    simple_test_assert("Failure to build hashtable from file",
+                       hashtable_build_parallel_file(&ht, fileName, '\n',
+                                                     &value, &tp));
+    found = limit == hashtable_get_entry_count(&ht);
+    for(size_t i=0; i<limit; ++i) {
+        snprintf(tmp, sizeof(tmp), "word%zu", i);
+        buffer_clear(&key);
+        buffer_push_bytes(&key, (unsigned char *) tmp, strlen(tmp));
+        Buffer *b = hashtable_get(&ht, &key);
+        found = found && NULL != b && 0 == *(size_t *) b->data;
+    }
+    simple_test_assert("Hashtable built from file is wrong", found);
+    hashtable_free(&ht);
+    remove(fileName);
+
+    buffer_array_free(&keys);
+    buffer_array_free(&values);
+    buffer_free(&key);
+    buffer_free(&value);
+    threadpool_free(&tp);
+}
+
+void fst_test(Recycler * recycler) {
+
+    const char *fileName = "fst_test.img";
+    const char *stems[] = { "walk", "talk", "jump", "play", "work", "cook",
+                            "read", "paint", NULL };
+    const char *endings[] = { "", "s", "ed", "er", "ers", "ing", "ings", NULL };
+
+    BufferArray words;
+    buffer_array_init(&words);
+    buffer_array_assign_recycler(&words, recycler);
+
+    // words sharing stems and endings, numbered so payloads vary
+    Buffer word;
+    buffer_init(&word);
+    char tmp[32];
+    for(size_t i=0; i<50; ++i) {
+        for(size_t s=0; NULL != stems[s]; ++s) {
+            for(size_t e=0; NULL != endings[e]; ++e) {
+                const int len = snprintf(tmp, sizeof(tmp), "%s%zu%s", stems[s],
+                                         i, endings[e]);
+                buffer_clear(&word);
+                buffer_push_bytes(&word, (unsigned char *) tmp, (size_t) len);
+                buffer_array_push(&words, &word);
+            }
+        }
+    }
+    const size_t count = buffer_array_get_buffer_count(&words);
+    qsort(words.array.data, count, sizeof(Buffer), buffer_cmp_bytes);
+
+    uint64_t *payloads = malloc(count * sizeof(uint64_t));
+    size_t bytes = 0;
+    for(size_t i=0; i<count; ++i) {
+        payloads[i] = (i * 7919) % 1000 + (i % 3 == 0 ? 1ULL << 40 : 0);
+        bytes += buffer_array_get_buffer(&words, i)->len;
+    }
+
+    Fst fst;
+    simple_test_assert("Failure to build dictionary",
+                       fst_build(&fst, &words, payloads));
+    simple_test_assert("Dictionary entry count is wrong",
+                       count == fst_get_entry_count(&fst));
+    simple_test_assert("Dictionary does not share states",
+                       fst_get_memory(&fst) < bytes);
+
+    bool allFound = true;
+    uint64_t payload = 0;
+    for(size_t i=0; i<count; ++i) {
+        allFound = allFound &&
+                   fst_get(&fst, buffer_array_get_buffer(&words, i), &payload) &&
+                   payloads[i] == payload;
+    }
+    simple_test_assert("Dictionary lost or changed a payload", allFound);
+
+    const char *missing[] = { "", "walk", "walk1e", "walk1ingss", "zebra",
+                              "paint49inga", NULL };
+    bool noneFound = true;
+    for(size_t i=0; NULL != missing[i]; ++i) {
+        BufferView view;
+        buffer_view_set(&view, (const unsigned char *) missing[i],
+                        strlen(missing[i]));
+        noneFound = noneFound && !fst_get_view(&fst, &view, NULL);
+    }
+    simple_test_assert("Dictionary found a missing word", noneFound);
+
+    // every word comes back once, in order, with its payload
+    FstIterator it;
+    BufferView view;
+    fst_iterator_init(&it, &fst);
+    size_t seen = 0;
+    bool ordered = true;
+    while(fst_iterator_next(&it, &view, &payload)) {
+        const Buffer *w = buffer_array_get_buffer(&words, seen);
+        ordered = ordered && NULL != w && w->len == view.len &&
+                  0 == memcmp(w->data, view.data, view.len) &&
+                  payloads[seen] == payload;
+        ++seen;
+    }
+    simple_test_assert("Dictionary iteration is out of order",
+                       ordered && count == seen);
+
+    // words with a prefix are the run of sorted words starting with it
+    buffer_view_set(&view, (const unsigned char *) "talk1", 5);
+    simple_test_assert("Dictionary prefix not found",
+                       fst_iterator_seek_prefix(&it, &view));
+    size_t expected = 0;
+    for(size_t i=0; i<count; ++i) {
+        const Buffer *w = buffer_array_get_buffer(&words, i);
+        if(w->len >= 5 && 0 == memcmp(w->data, "talk1", 5)) ++expected;
+    }
+    seen = 0;
+    bool prefixed = true;
+    while(fst_iterator_next(&it, &view, NULL)) {
+        prefixed = prefixed && view.len >= 5 && 0 == memcmp(view.data, "talk1", 5);
+        ++seen;
+    }
+    simple_test_assert("Dictionary prefix enumeration is wrong",
+                       prefixed && expected == seen && 77 == seen);
+
+    buffer_view_set(&view, (const unsigned char *) "talk1x", 6);
+    simple_test_assert("Dictionary found a missing prefix",
+                       !fst_iterator_seek_prefix(&it, &view));
+
+    // the word after one which is not in the dictionary
+    buffer_view_set(&view, (const unsigned char *) "walk1ingz", 9);
+    fst_iterator_seek(&it, &view);
+    simple_test_assert("Dictionary seek found the wrong word",
+                       fst_iterator_next(&it, &view, NULL) && 6 == view.len &&
+                       0 == memcmp(view.data, "walk1s", 6));
+    buffer_view_set(&view, (const unsigned char *) "walk10", 6);
+    fst_iterator_seek(&it, &view);
+    simple_test_assert("Dictionary seek skipped an existing word",
+                       fst_iterator_next(&it, &view, NULL) && 6 == view.len &&
+                       0 == memcmp(view.data, "walk10", 6) &&
+                       fst_iterator_next(&it, &view, NULL) && 8 == view.len &&
+                       0 == memcmp(view.data, "walk10ed", 8));
+    buffer_view_set(&view, (const unsigned char *) "zzz", 3);
+    fst_iterator_seek(&it, &view);
+    simple_test_assert("Dictionary seek past the end found a word",
+                       !fst_iterator_next(&it, &view, NULL));
+
+    simple_test_assert("Failure to save dictionary", fst_save(&fst, fileName));
+    Fst mapped;
+    simple_test_assert("Failure to map dictionary",
+                       fst_open_mapped(&mapped, fileName));
+    simple_test_assert("Mapped dictionary fails its checksum",
+                       fst_verify(&mapped));
+    simple_test_assert("Mapped dictionary lost a payload",
+                       fst_get(&mapped, buffer_array_get_buffer(&words, 17),
+                               &payload) && payloads[17] == payload);
+    fst_free(&mapped);
+    fst_free(&fst);
+    remove(fileName);
+
+    // out of order words are refused
+    buffer_array_push(&words, buffer_array_get_buffer(&words, 0));
+    simple_test_assert("Dictionary built from unsorted words",
+                       !fst_build(&fst, &words, NULL));
+
+    BufferArray none;
+    buffer_array_init(&none);
+    simple_test_assert("Failure to build empty dictionary",
+                       fst_build(&fst, &none, NULL));
+    fst_iterator_free(&it);
+    fst_iterator_init(&it, &fst);
+    simple_test_assert("Empty dictionary holds a word",
+                       !fst_iterator_next(&it, &view, NULL) &&
+                       !fst_get(&fst, &word, NULL));
+    BufferView prefix;
+    buffer_view_set(&prefix, (const unsigned char *) "", 0);
+    simple_test_assert("Empty dictionary has a word with the empty prefix",
+                       !fst_iterator_seek_prefix(&it, &prefix));
+    fst_free(&fst);
+
+    // the empty word sorts first and gets index 0
+    buffer_clear(&word);
+    buffer_array_push(&none, &word);
+    buffer_strcpy(&word, "a");
+    buffer_array_push(&none, &word);
+    buffer_clear(&word);
+    simple_test_assert("Failure to build dictionary with the empty word",
+                       fst_build(&fst, &none, NULL));
+    simple_test_assert("Dictionary lost the empty word",
+                       fst_get(&fst, &word, &payload) && 0 == payload);
+    fst_iterator_free(&it);
+    fst_iterator_init(&it, &fst);
+    simple_test_assert("Empty prefix does not find the empty word first",
+                       fst_iterator_seek_prefix(&it, &prefix) &&
+                       fst_iterator_next(&it, &view, NULL) && 0 == view.len);
+    fst_free(&fst);
+
+    fst_iterator_free(&it);
+    buffer_array_free(&none);
+    buffer_array_free(&words);
+    buffer_free(&word);
+    free(payloads);
+}
+
+// key [i] of the tree test, long shared prefixes for some and a few keys
+// too big for a size class
+static size_t art_test_key(size_t i, char *tmp, size_t cap) {
+    if(0 == i % 97) {
+        memset(tmp, 'z', cap - 32);
+        return (size_t) snprintf(tmp + cap - 32, 32, "%zu", i) + cap - 32;
+    }
+    if(0 == i % 3)
+        return (size_t) snprintf(tmp, cap, "shared/long/prefix/%zu", i);
+    return (size_t) snprintf(tmp, cap, "key%zu", i);
+}
+
+void art_test(Recycler * recycler) {
+
+    const size_t count = 5000;
+    const size_t cap = 3000;
+    char *tmp = malloc(cap);
+
+    Art art;
+    art_init(&art);
+    art_assign_recycler(&art, recycler);
+
+    BufferArray keys;
+    buffer_array_init(&keys);
+    Buffer key;
+    buffer_init(&key);
+
+    bool ok = true;
+    bool added = false;
+    for(size_t i=0; i<count; ++i) {
+        const size_t len = art_test_key(i, tmp, cap);
+        ok = ok && art_insert_bytes(&art, (unsigned char *) tmp, len, i,
+                                    &added) && added;
+        buffer_clear(&key);
+        buffer_push_bytes(&key, (unsigned char *) tmp, len);
+        buffer_array_push(&keys, &key);
+    }
+    // keys which are prefixes of others, including the empty key
+    const char *prefixes[] = { "", "k", "key", "shared/", "shared/long/prefix/",
+                               NULL };
+    for(size_t i=0; NULL != prefixes[i]; ++i) {
+        ok = ok && art_insert_bytes(&art, (unsigned char *) prefixes[i],
+                                    strlen(prefixes[i]), count + i, &added) &&
+             added;
+        buffer_clear(&key);
+        buffer_push_bytes(&key, (unsigned char *) prefixes[i],
+                          strlen(prefixes[i]));
+        buffer_array_push(&keys, &key);
+    }
+    simple_test_assert("Failure to insert into tree", ok);
+
+    const size_t total = buffer_array_get_buffer_count(&keys);
+    simple_test_assert("Tree count is wrong", total == art_get_count(&art));
+
+    art_insert_bytes(&art, (unsigned char *) "key7", 4, 42, &added);
+    uint64_t value = 0;
+    simple_test_assert("Tree insert did not replace a value",
+                       !added && total == art_get_count(&art) &&
+                       art_get_bytes(&art, (unsigned char *) "key7", 4,
+                                     &value) && 42 == value);
+    art_insert_bytes(&art, (unsigned char *) "key7", 4, 7, NULL);
+
+    ok = true;
+    for(size_t i=0; i<total; ++i) {
+        const Buffer *k = buffer_array_get_buffer(&keys, i);
+        ok = ok && art_get(&art, k, &value) && i == value;
+    }
+    simple_test_assert("Tree lost or changed a value", ok);
+
+    const char *missing[] = { "ke", "key50000", "key5000", "shared/long",
+                              "shared/long/prefix/1", "zzz", NULL };
+    ok = true;
+    for(size_t i=0; NULL != missing[i]; ++i)
+        ok = ok && !art_get_bytes(&art, (unsigned char *) missing[i],
+                                  strlen(missing[i]), NULL);
+    simple_test_assert("Tree found a missing key", ok);
+
+    // walking the tree gives back the sorted keys
+    Buffer *sorted = malloc(total * sizeof(Buffer));
+    memcpy(sorted, keys.array.data, total * sizeof(Buffer));
+    qsort(sorted, total, sizeof(Buffer), buffer_cmp_bytes);
+
+    ArtIterator it;
+    BufferView view;
+    art_iterator_init(&it, &art);
+    size_t seen = 0;
+    ok = true;
+    while(art_iterator_next(&it, &view, &value)) {
+        ok = ok && seen < total && sorted[seen].len == view.len &&
+             (0 == view.len || 0 == memcmp(sorted[seen].data, view.data,
+                                           view.len));
+        ++seen;
+    }
+    simple_test_assert("Tree iteration is out of order", ok && total == seen);
+
+    // the keys starting with key12 are key12, key120-key129, key1200-key1299
+    // less the multiples of 3 and 97 which are stored elsewhere
+    size_t expected = 0;
+    for(size_t i=0; i<total; ++i)
+        if(sorted[i].len >= 5 && 0 == memcmp(sorted[i].data, "key12", 5))
+            ++expected;
+    buffer_view_set(&view, (const unsigned char *) "key12", 5);
+    art_iterator_seek_prefix(&it, &view);
+    seen = 0;
+    ok = true;
+    while(art_iterator_next(&it, &view, NULL)) {
+        ok = ok && view.len >= 5 && 0 == memcmp(view.data, "key12", 5);
+        ++seen;
+    }
+    simple_test_assert("Tree prefix walk is wrong",
+                       ok && expected == seen && expected > 50);
+
+    // a range is the run of sorted keys from low up to high
+    BufferView low, high;
+    buffer_view_set(&low, (const unsigned char *) "key2", 4);
+    buffer_view_set(&high, (const unsigned char *) "key3", 4);
+    size_t first = 0, last = 0;
+    while(buffer_cmp_bytes(&sorted[first], &(Buffer) {
+            .data = (unsigned char *) "key2", .len = 4 }) < 0) ++first;
+    last = first;
+    while(buffer_cmp_bytes(&sorted[last], &(Buffer) {
+            .data = (unsigned char *) "key3", .len = 4 }) < 0) ++last;
+    art_iterator_seek_range(&it, &low, &high);
+    seen = 0;
+    ok = true;
+    while(art_iterator_next(&it, &view, NULL)) {
+        ok = ok && first + seen < last &&
+             sorted[first + seen].len == view.len &&
+             0 == memcmp(sorted[first + seen].data, view.data, view.len);
+        ++seen;
+    }
+    simple_test_assert("Tree range walk is wrong",
+                       ok && last - first == seen && seen > 0);
+
+    // seeking a missing key lands on the next one
+    buffer_view_set(&view, (const unsigned char *) "key4999z", 8);
+    art_iterator_seek(&it, &view);
+    simple_test_assert("Tree seek found the wrong key",
+                       art_iterator_next(&it, &view, &value) && 5 == value);
+    buffer_view_set(&view, (const unsigned char *) "shared/long/prefix/", 19);
+    art_iterator_seek(&it, &view);
+    simple_test_assert("Tree seek skipped an existing key",
+                       art_iterator_next(&it, &view, &value) &&
+                       count + 4 == value);
+    buffer_view_set(&view, (const unsigned char *) "shared/long/prefiy", 18);
+    art_iterator_seek(&it, &view);
+    simple_test_assert("Tree seek inside a prefix found the wrong key",
+                       art_iterator_next(&it, &view, NULL) && 'z' == view.data[0]);
+    buffer_view_set(&view, (const unsigned char *) "{", 1);
+    art_iterator_seek(&it, &view);
+    simple_test_assert("Tree seek past the end found a key",
+                       !art_iterator_next(&it, &view, NULL));
+
+    // removing every other key leaves the rest intact and in order
+    ok = true;
+    for(size_t i=0; i<total; i += 2)
+        ok = ok && art_remove(&art, buffer_array_get_buffer(&keys, i));
+    simple_test_assert("Failure to remove from tree", ok);
+    simple_test_assert("Tree removed a missing key",
+                       !art_remove(&art, buffer_array_get_buffer(&keys, 0)) &&
+                       total / 2 == art_get_count(&art));
+    ok = true;
+    for(size_t i=0; i<total; ++i)
+        ok = ok && art_get(&art, buffer_array_get_buffer(&keys, i), NULL) ==
+                   (1 == i % 2);
+    simple_test_assert("Tree lost keys during removal", ok);
+
+    art_iterator_seek_range(&it, NULL, NULL);
+    seen = 0;
+    Buffer prev;
+    buffer_init(&prev);
+    ok = true;
+    while(art_iterator_next(&it, &view, NULL)) {
+        Buffer cur = { .data = (unsigned char *) view.data, .len = view.len };
+        ok = ok && (0 == seen || buffer_cmp_bytes(&prev, &cur) < 0);
+        prev = cur;
+        ++seen;
+    }
+    simple_test_assert("Tree iteration after removal is wrong",
+                       ok && total / 2 == seen);
+
+    for(size_t i=1; i<total; i += 2)
+        art_remove(&art, buffer_array_get_buffer(&keys, i));
+    simple_test_assert("Tree is not empty after removing every key",
+                       0 == art_get_count(&art) && NULL == art.root);
+    art_iterator_init(&it, &art);
+    simple_test_assert("Empty tree iteration found a key",
+                       !art_iterator_next(&it, &view, NULL));
+
+    // nodes grow and shrink through every type as children come and go
+    ArtStats stats;
+    unsigned char b[2] = { 'x', 0 };
+    for(unsigned i=0; i<256; ++i) {
+        b[1] = (unsigned char) i;
+        art_insert_bytes(&art, b, 2, i, NULL);
+    }
+    art_get_stats(&art, &stats);
+    simple_test_assert("Tree did not grow a Node256",
+                       1 == stats.node256 && 256 == stats.leaves &&
+                       0 == stats.node4 + stats.node16 + stats.node48);
+    const size_t sizes[] = { 37, 12, 5, 3, 1, 0 };
+    const size_t types[] = { 48, 16, 16, 4, 0, 0 };
+    size_t live = 256;
+    ok = true;
+    for(size_t s=0; s<sizeof(sizes) / sizeof(sizes[0]); ++s) {
+        while(live > sizes[s]) {
+            b[1] = (unsigned char) --live;
+            ok = ok && art_remove_bytes(&art, b, 2);
+        }
+        art_get_stats(&art, &stats);
+        ok = ok && live == stats.leaves;
+        if(48 == types[s]) ok = ok && 1 == stats.node48;
+        if(16 == types[s]) ok = ok && 1 == stats.node16;
+        if(4 == types[s]) ok = ok && 1 == stats.node4;
+        if(0 == types[s]) ok = ok && 0 == stats.node4 + stats.node16 +
+                                          stats.node48 + stats.node256;
+    }
+    simple_test_assert("Tree nodes did not shrink", ok && NULL == art.root);
+
+    simple_test_assert("Tree holds no memory", art_get_memory(&art) > 0);
+    art_iterator_free(&it);
+    art_free(&art);
+    simple_test_assert("Freed tree holds memory", 0 == art_get_memory(&art));
+    buffer_array_free(&keys);
+    buffer_free(&key);
+    free(sorted);
+    free(tmp);
+}
+
+// number of [words] sorting before the [len] bytes at [key], and the number
+// of them sorting before every key starting with those bytes
+static void sorted_dict_test_bounds(BufferArray *words, const unsigned char *key,
+                                    size_t len, size_t *lower, size_t *upper) {
+    *lower = 0;
+    *upper = 0;
+    for(size_t i=0; i<buffer_array_get_buffer_count(words); ++i) {
+        const Buffer *w = buffer_array_get_buffer(words, i);
+        const size_t n = w->len < len ? w->len : len;
+        const int c = 0 == n ? 0 : memcmp(w->data, key, n);
+        if(c < 0 || (0 == c && w->len < len)) ++*lower;
+        if(c < 0 || 0 == c) ++*upper;
+    }
+}
+
+void sorted_dict_test(Recycler * recycler) {
+
+    const char *fileName = "sorted_dict_test.img";
+    const char *stems[] = { "walk", "talk", "jump", "play", "work", "cook",
+                            "read", "paint", "interstellar", "international",
+                            NULL };
+    const char *endings[] = { "", "s", "ed", "er", "ers", "ing", "ings", NULL };
+
+    BufferArray words;
+    buffer_array_init(&words);
+    buffer_array_assign_recycler(&words, recycler);
+
+    Buffer word;
+    buffer_init(&word);
+    char tmp[32];
+    for(size_t i=0; i<50; ++i) {
+        for(size_t s=0; NULL != stems[s]; ++s) {
+            for(size_t e=0; NULL != endings[e]; ++e) {
+                const int len = snprintf(tmp, sizeof(tmp), "%s%zu%s", stems[s],
+                                         i, endings[e]);
+                buffer_clear(&word);
+                buffer_push_bytes(&word, (unsigned char *) tmp, (size_t) len);
+                buffer_array_push(&words, &word);
+            }
+        }
+    }
+    const size_t count = buffer_array_get_buffer_count(&words);
+    qsort(words.array.data, count, sizeof(Buffer), buffer_cmp_bytes);
+    size_t bytes = 0;
+    for(size_t i=0; i<count; ++i) bytes += buffer_array_get_buffer(&words, i)->len;
+
+    SortedDict dict;
+    simple_test_assert("Failure to build sorted dictionary",
+                       sorted_dict_build(&dict, &words));
+    simple_test_assert("Sorted dictionary entry count is wrong",
+                       count == sorted_dict_get_entry_count(&dict));
+    simple_test_assert("Sorted dictionary is not front coded",
+                       sorted_dict_get_memory(&dict) < bytes);
+
+    // every key is found at its rank and selected back by it
+    bool allFound = true;
+    bool allSelected = true;
+    for(size_t i=0; i<count; ++i) {
+        const Buffer *w = buffer_array_get_buffer(&words, i);
+        size_t rank = count;
+        allFound = allFound && sorted_dict_get(&dict, w, &rank) && i == rank;
+        allSelected = allSelected && sorted_dict_select(&dict, i, &word) &&
+                      word.len == w->len && 0 == memcmp(word.data, w->data, w->len);
+    }
+    simple_test_assert("Sorted dictionary lost a key", allFound);
+    simple_test_assert("Sorted dictionary selected the wrong key", allSelected);
+    simple_test_assert("Sorted dictionary selected past the end",
+                       !sorted_dict_select(&dict, count, &word));
+
+    // near misses of every key bound where a linear scan says
+    bool bounded = true;
+    bool noneFound = true;
+    for(size_t i=0; i<count; ++i) {
+        const Buffer *w = buffer_array_get_buffer(&words, i);
+        memcpy(tmp, w->data, w->len);
+        for(int probe=0; probe<4; ++probe) {
+            size_t len = w->len;
+            if(0 == probe) len -= 1;
+            else if(1 == probe) tmp[len++] = 'a';
+            else if(2 == probe) tmp[len - 1]++;
+            else tmp[len++] = '\0';
+
+            BufferView view;
+            buffer_view_set(&view, (unsigned char *) tmp, len);
+            size_t lower, upper, begin, end;
+            sorted_dict_test_bounds(&words, view.data, len, &lower, &upper);
+            const bool any = sorted_dict_prefix_range(&dict, &view, &begin, &end);
+            bounded = bounded && lower == sorted_dict_lower_bound(&dict, &view) &&
+                      lower == begin && upper == end && any == (upper > lower);
+            if(1 == probe || 3 == probe)
+                noneFound = noneFound && !sorted_dict_get_view(&dict, &view, NULL);
+            memcpy(tmp, w->data, w->len);
+        }
+    }
+    simple_test_assert("Sorted dictionary bounds disagree with a scan", bounded);
+    simple_test_assert("Sorted dictionary found a missing key", noneFound);
+
+    // every key comes back once, in order
+    SortedDictIterator it;
+    BufferView view;
+    size_t rank;
+    sorted_dict_iterator_init(&it, &dict);
+    size_t seen = 0;
+    bool ordered = true;
+    while(sorted_dict_iterator_next(&it, &view, &rank)) {
+        const Buffer *w = buffer_array_get_buffer(&words, seen);
+        ordered = ordered && seen == rank && w->len == view.len &&
+                  0 == memcmp(w->data, view.data, view.len);
+        ++seen;
+    }
+    simple_test_assert("Sorted dictionary iteration is out of order",
+                       ordered && count == seen);
+
+    // keys with a prefix are a run of ranks
+    size_t begin, end;
+    buffer_view_set(&view, (const unsigned char *) "talk1", 5);
+    simple_test_assert("Sorted dictionary prefix not found",
+                       sorted_dict_prefix_range(&dict, &view, &begin, &end) &&
+                       77 == end - begin);
+    sorted_dict_iterator_seek(&it, begin, end);
+    seen = 0;
+    bool prefixed = true;
+    while(sorted_dict_iterator_next(&it, &view, &rank)) {
+        prefixed = prefixed && begin + seen == rank && view.len >= 5 &&
+                   0 == memcmp(view.data, "talk1", 5);
+        ++seen;
     }
+    simple_test_assert("Sorted dictionary prefix enumeration is wrong",
+                       prefixed && 77 == seen);
+
+    buffer_view_set(&view, (const unsigned char *) "talk1x", 6);
+    simple_test_assert("Sorted dictionary found a missing prefix",
+                       !sorted_dict_prefix_range(&dict, &view, &begin, &end) &&
+                       begin == end);
+    buffer_view_set(&view, (const unsigned char *) "zzz", 3);
+    simple_test_assert("Sorted dictionary bound past the end is wrong",
+                       count == sorted_dict_lower_bound(&dict, &view));
+
+    simple_test_assert("Failure to save sorted dictionary",
+                       sorted_dict_save(&dict, fileName));
+    SortedDict mapped;
+    simple_test_assert("Failure to map sorted dictionary",
+                       sorted_dict_open_mapped(&mapped, fileName));
+    simple_test_assert("Mapped sorted dictionary fails its checksum",
+                       sorted_dict_verify(&mapped));
+    simple_test_assert("Mapped sorted dictionary lost a key",
+                       sorted_dict_get(&mapped, buffer_array_get_buffer(&words, 17),
+                                       &rank) && 17 == rank);
+    sorted_dict_free(&mapped);
+    sorted_dict_free(&dict);
+    remove(fileName);
+
+    // out of order keys are refused
+    buffer_array_push(&words, buffer_array_get_buffer(&words, 0));
+    simple_test_assert("Sorted dictionary built from unsorted keys",
+                       !sorted_dict_build(&dict, &words));
+
+    BufferArray none;
+    buffer_array_init(&none);
+    simple_test_assert("Failure to build empty sorted dictionary",
+                       sorted_dict_build(&dict, &none));
+    sorted_dict_iterator_seek(&it, 0, SIZE_MAX);
+    simple_test_assert("Empty sorted dictionary holds a key",
+                       !sorted_dict_iterator_next(&it, &view, NULL) &&
+                       !sorted_dict_get(&dict, &word, NULL) &&
+                       0 == sorted_dict_lower_bound(&dict, &view));
+    sorted_dict_free(&dict);
+
+    // the empty key sorts first and gets rank 0
+    buffer_clear(&word);
+    buffer_array_push(&none, &word);
+    buffer_strcpy(&word, "a");
+    buffer_array_push(&none, &word);
+    buffer_clear(&word);
+    simple_test_assert("Failure to build sorted dictionary with the empty key",
+                       sorted_dict_build(&dict, &none));
+    simple_test_assert("Sorted dictionary lost the empty key",
+                       sorted_dict_get(&dict, &word, &rank) && 0 == rank);
+    sorted_dict_free(&dict);
+
+    sorted_dict_iterator_free(&it);
+    buffer_array_free(&none);
+    buffer_array_free(&words);
+    buffer_free(&word);
 }
 
 void buffer_cleanse_test(Recycler *recycler) {
@@ -383,8 +3082,26 @@ void all_tests() {
     buffer_set_test(NULL);
     buffer_transform_test(NULL);
     buffer_array_test(NULL);
+    packed_buffer_array_test(NULL);
+    buffer_array_sort_test(NULL);
+    mapped_buffer_array_test(NULL);
+    file_reader_test(NULL);
+    file_writer_test(NULL);
     buffer_split_test(NULL);
     hash_table_test(NULL);
+    hash_table_batch_test(NULL);
+    hash_table_image_test(NULL);
+    frozen_hash_table_test(NULL);
+    typed_hash_table_test(NULL);
+    hash_table_stats_test(NULL);
+    filter_test(NULL);
+    hash_set_test(NULL);
+    cache_test(NULL);
+    hash_table_merge_test(NULL);
+    hash_table_build_test(NULL);
+    fst_test(NULL);
+    art_test(NULL);
+    sorted_dict_test(NULL);
     hash_value_test(NULL);
     buffer_cleanse_test(NULL);
     fprintf(stderr, "Begin Tests with Recycler\n");
@@ -392,9 +3109,27 @@ void all_tests() {
     buffer_set_test(&recycler);
     buffer_transform_test(&recycler);
     buffer_array_test(&recycler);
+    packed_buffer_array_test(&recycler);
+    buffer_array_sort_test(&recycler);
+    mapped_buffer_array_test(&recycler);
+    file_reader_test(&recycler);
+    file_writer_test(&recycler);
     recycler_test(&recycler);
     buffer_split_test(&recycler);
     hash_table_test(&recycler);
+    hash_table_batch_test(&recycler);
+    hash_table_image_test(&recycler);
+    frozen_hash_table_test(&recycler);
+    typed_hash_table_test(&recycler);
+    hash_table_stats_test(&recycler);
+    filter_test(&recycler);
+    hash_set_test(&recycler);
+    cache_test(&recycler);
+    hash_table_merge_test(&recycler);
+    hash_table_build_test(&recycler);
+    fst_test(&recycler);
+    art_test(&recycler);
+    sorted_dict_test(&recycler);
     hash_value_test(&recycler);
     buffer_cleanse_test(&recycler);
 